@@ -815,6 +815,23 @@ void *SBUF2_FUNC(sbuf2getuserptr)(SBUF2 *sb)
     return sb->userptr;
 }
 
+int SBUF2_FUNC(sbuf2pending)(SBUF2 *sb)
+{
+    if (sb == NULL)
+        return 0;
+#if SBUF2_UNGETC
+    if (sb->ungetc_buf_len > 0)
+        return 1;
+#endif
+    if (sb->rhd != sb->rtl)
+        return 1;
+#if WITH_SSL
+    if (sb->ssl != NULL && SSL_pending(sb->ssl) > 0)
+        return 1;
+#endif
+    return 0;
+}
+
 #if SBUF2_SERVER
 #include <lockmacro.h> /* LOCK & UNLOCK */
 #include <plhash.h>    /* hash_t */
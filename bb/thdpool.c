@@ -564,13 +564,13 @@ static int get_work_ll(struct thd *thd, struct workitem *work)
     } else {
         while ((next = listc_rtl(&thd->pool->queue)) != NULL) {
             if (thd->pool->maxqueueagems > 0 &&
-                comdb2_time_epochms() - work->queue_time_ms >
+                comdb2_time_epochms() - next->queue_time_ms >
                     thd->pool->maxqueueagems) {
                 if (next->persistent_info) {
                     free(next->persistent_info);
                     next->persistent_info = NULL;
                 }
-                thd->work.work_fn(thd->pool, next->work, NULL, THD_FREE);
+                next->work_fn(thd->pool, next->work, NULL, THD_FREE);
                 pool_relablk(thd->pool->pool, next);
                 thd->pool->num_timeout++;
                 continue;
@@ -54,4 +54,12 @@ struct comdb2_appsock {
 };
 typedef struct comdb2_appsock comdb2_appsock_t;
 
+/* Continues a parked connection on an appsock thread; drop is set if the
+ * connection must be closed instead, and thr_self is NULL if there's no
+ * thread to run on. */
+typedef void appsock_resume_fn(struct thr_handle *thr_self, void *arg,
+                               int drop);
+int appsock_park(SBUF2 *sb, int idle_timeout, int minbytes,
+                 appsock_resume_fn *resume, void *arg);
+
 #endif /* ! __INCLUDED_COMDB2_APPSOCK_H */
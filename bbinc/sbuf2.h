@@ -167,6 +167,10 @@ void SBUF2_FUNC(sbuf2setuserptr)(SBUF2 *sb, void *userptr);
 void *SBUF2_FUNC(sbuf2getuserptr)(SBUF2 *sb);
 #define sbuf2getuserptr SBUF2_FUNC(sbuf2getuserptr)
 
+/* non-0 if bytes were read from the socket but not consumed yet */
+int SBUF2_FUNC(sbuf2pending)(SBUF2 *sb);
+#define sbuf2pending SBUF2_FUNC(sbuf2pending)
+
 #if SBUF2_UNGETC
 int SBUF2_FUNC(sbuf2ungetc)(char c, SBUF2 *sb);
 #  define sbuf2ungetc SBUF2_FUNC(sbuf2ungetc)
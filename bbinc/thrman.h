@@ -44,6 +44,7 @@ enum thrtype {
     THRTYPE_PURGEFILES = 20,
     THRTYPE_BULK_IMPORT = 21,
     THRTYPE_TRIGGER = 22,
+    THRTYPE_DEFRAG = 23,
     THRTYPE_MAX
 };
 
@@ -126,6 +126,14 @@ DEF_ATTR(MEMPTRICKLEPERCENT, memptricklepercent, PERCENT, 99,
          "pages periodically until that's achieved.")
 DEF_ATTR(MEMPTRICKLEMSECS, memptricklemsecs, MSECS, 1000,
          "Pause for this many ms between runs of the cache flusher.")
+DEF_ATTR(WARM_CACHE, warm_cache, BOOLEAN, 0,
+         "Save the list of pages in the cache periodically, and read them "
+         "back into the cache in the background on startup.")
+DEF_ATTR(WARM_CACHE_SAVE_INTERVAL, warm_cache_save_interval, SECS, 300,
+         "Save the list of pages in the cache this often (see warm_cache).")
+DEF_ATTR(WARM_CACHE_THREADS, warm_cache_threads, QUANTITY, 8,
+         "Number of threads reading pages into the cache on startup (see "
+         "warm_cache).")
 DEF_ATTR(CHECKSUMS, checksums, BOOLEAN, 1,
          "Checksum data pages. Turning this off is highly discouraged.")
 DEF_ATTR(LITTLE_ENDIAN_BTREES, little_endian_btrees, BOOLEAN, 1,
@@ -224,6 +232,12 @@ DEF_ATTR(FSTDUMP_MAXTHREADS, fstdump_maxthreads, QUANTITY, 0,
          "maximum database thrashing)")
 DEF_ATTR(VERIFY_THREAD_STACKSZ, verify_thread_stacksz, BYTES, 2 * 1024 * 1024,
          "Size of the verify thread stack.")
+DEF_ATTR(VERIFY_THREADS, verify_threads, QUANTITY, 1,
+         "Number of threads that verify data stripes, indexes and blob files "
+         "in parallel.")
+DEF_ATTR(VERIFY_PAGE_ORDER, verify_page_order, BOOLEAN, 0,
+         "Verify reads data, index and blob files in page order rather than "
+         "key order. Not used when verify fixes records.")
 DEF_ATTR(REP_LONGREQ, rep_longreq, SECS, 1,
          "Warn if replication events are taking this long to process.")
 DEF_ATTR(COMMITDELAYBEHINDTHRESH, commitdelaybehindthresh, BYTES, 1048576,
@@ -344,6 +358,19 @@ DEF_ATTR(PAGE_EXTENT_SIZE, page_extent_size, QUANTITY, 0,
 DEF_ATTR(DELAYED_OLDFILE_CLEANUP, delayed_oldfile_cleanup, BOOLEAN, 1,
          "If set, don't delete unused data/index files in the critical path of "
          "schema change; schedule them for deletion later.")
+DEF_ATTR(OLDFILE_TRUNCATE_CHUNK, oldfile_truncate_chunk, MBYTES, 0,
+         "If set, shrink unused data/index files by this many megabytes at a "
+         "time before deleting them, spreading the I/O of large deletions. "
+         "Replicants shrink the files they remove the same way.")
+DEF_ATTR(OLDFILE_TRUNCATE_PAUSE, oldfile_truncate_pause, MSECS, 100,
+         "Pause between the steps of shrinking an unused file (see "
+         "oldfile_truncate_chunk).")
+DEF_ATTR(LLMETA_CACHE, llmeta_cache, BOOLEAN, 1,
+         "Serve llmeta reads made outside a transaction from an in-memory "
+         "copy, dropped whenever llmeta changes.")
+DEF_ATTR(SNAPISOL_SHARED_IMAGES, snapisol_shared_images, BOOLEAN, 0,
+         "Reconstruct the before-image of an undo record once and share it "
+         "between all the snapshot transactions that need it.")
 DEF_ATTR(DISABLE_PAGEORDER_RECSZ_CHK, disable_pageorder_recsz_chk, BOOLEAN, 0,
          "If set, allow page-order table scans even for larger record sizes "
          "where they don't necessarily lead to improvement.")
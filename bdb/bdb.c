@@ -241,6 +241,15 @@ void bdb_make_seqnum(seqnum_type *seqnum, uint32_t logfile, uint32_t logbyte)
     memcpy(seqnum, &lsn, sizeof(DB_LSN));
 }
 
+void bdb_get_seqnum_lsn(const seqnum_type *seqnum, uint32_t *logfile,
+                        uint32_t *logbyte)
+{
+    DB_LSN lsn;
+    memcpy(&lsn, seqnum, sizeof(DB_LSN));
+    *logfile = lsn.file;
+    *logbyte = lsn.offset;
+}
+
 void bdb_get_txn_stats(bdb_state_type *bdb_state, int *txn_commits)
 {
     DB_TXN_STAT *txn_stats;
@@ -541,6 +541,8 @@ int bdb_handle_dbp_add_hash(bdb_state_type *bdb_state, int szkb);
 int bdb_handle_dbp_drop_hash(bdb_state_type *bdb_state);
 int bdb_handle_dbp_hash_stat(bdb_state_type *bdb_state);
 int bdb_handle_dbp_hash_stat_reset(bdb_state_type *bdb_state);
+void bdb_handle_dbp_ix_hash(bdb_state_type *bdb_state, int ixnum, int szkb);
+void bdb_handle_dbp_ix_hash_stat(bdb_state_type *bdb_state);
 int bdb_close_temp_state(bdb_state_type *bdb_state, int *bdberr);
 
 /* get file sizes for indexes and data files */
@@ -946,6 +948,8 @@ int bdb_seqnum_compare(void *inbdb_state, seqnum_type *seqnum1,
 char *bdb_format_seqnum(const seqnum_type *seqnum, char *buf, size_t bufsize);
 int bdb_get_seqnum(bdb_state_type *bdb_state, seqnum_type *seqnum);
 void bdb_make_seqnum(seqnum_type *seqnum, uint32_t logfile, uint32_t logbyte);
+void bdb_get_seqnum_lsn(const seqnum_type *seqnum, uint32_t *logfile,
+                        uint32_t *logbyte);
 
 int bdb_wait_for_seqnum_from_all(bdb_state_type *bdb_state,
                                  seqnum_type *seqnum);
@@ -1530,6 +1534,22 @@ int bdb_summarize_table(bdb_state_type *bdb_state, int ixnum, int comp_pct,
                         struct temp_table **outtbl, unsigned long long *outrecs,
                         unsigned long long *cmprecs, int *bdberr);
 
+/* Leaf page fill of a btree file, see bdb_defrag_file() */
+struct bdb_fill {
+    unsigned int nleaf;       /* leaf pages */
+    unsigned long long used;  /* bytes in use on the leaves */
+    unsigned long long total; /* bytes available on the leaves */
+};
+
+/* Called with the number of pages about to be touched; non-0 stops */
+typedef int (*bdb_defrag_tick_t)(void *arg, int npages);
+
+int bdb_defrag_file(bdb_state_type *bdb_state, int fileno, double ff,
+                    double tgtff, unsigned *pgno, unsigned npages,
+                    bdb_defrag_tick_t tick, void *arg, char *name,
+                    int namelen, struct bdb_fill *fill, unsigned *nmerged,
+                    int *bdberr);
+
 void bdb_bdblock_debug(void);
 int bdb_env_init_after_llmeta(bdb_state_type *bdb_state);
 
@@ -1622,8 +1642,8 @@ int bdb_verify(
                                                   void *blob_parm),
     void *callback_parm, 
     int (*lua_callback)(void *, const char *), void *lua_params, 
-    void *callback_blob_buf, int progress_report_seconds,
-    int attempt_fix);
+    void *callback_blob_buf, size_t blob_buf_size,
+    int progress_report_seconds, int attempt_fix);
 
 void bdb_set_instant_schema_change(bdb_state_type *bdb_state, int isc);
 void bdb_set_inplace_updates(bdb_state_type *bdb_state, int ipu);
@@ -1680,6 +1700,8 @@ int bdb_flush_up_to_lsn(bdb_state_type *bdb_state, unsigned file,
 int bdb_set_parallel_recovery_threads(bdb_state_type *bdb_state, int nthreads);
 unsigned long long bdb_get_commit_genid(bdb_state_type *bdb_state, void *plsn);
 void bdb_set_commit_lsn_gen(bdb_state_type *bdb_state, const void *lsn, uint32_t gen);
+int bdb_wait_for_commit_lsn(bdb_state_type *bdb_state, unsigned int file,
+                            unsigned int offset, int timeout_ms);
 unsigned long long bdb_get_commit_genid_generation(bdb_state_type *bdb_state,
                                                    void *plsn,
                                                    uint32_t *generation);
@@ -1723,6 +1745,8 @@ void bdb_newsi_stat_init();
 int bdb_gbl_pglogs_init(bdb_state_type *bdb_state);
 int bdb_gbl_pglogs_mem_init(bdb_state_type *bdb_state);
 
+void bdb_shrink_unused_files(bdb_state_type *bdb_state);
+void bdb_shrink_removed_files(bdb_state_type *bdb_state);
 int bdb_purge_unused_files(bdb_state_type *bdb_state, tran_type *tran,
                            int *bdberr);
 int bdb_have_unused_files(void);
@@ -1730,6 +1754,8 @@ int bdb_have_unused_files(void);
 int bdb_nlocks_for_locker(bdb_state_type *bdb_state, int lid);
 
 int bdb_llmeta_list_records(bdb_state_type *bdb_state, int *bdberr);
+void bdb_llmeta_cache_stats(unsigned long long *hits,
+                            unsigned long long *reads);
 
 int bdb_have_ipu(bdb_state_type *bdb_state);
 
@@ -801,6 +801,7 @@ struct seen_blkseq {
 };
 
 struct temp_table;
+struct lite_cache;
 
 struct bdb_state_tag {
     pthread_attr_t pthread_attr_detach;
@@ -1038,6 +1039,8 @@ struct bdb_state_tag {
     uint16_t *fld_hints;
 
     int hellofd;
+
+    struct lite_cache *lite_cache; /* read cache for lite tables, see lite.c */
 };
 
 /* define our net user types */
@@ -1836,6 +1839,9 @@ int bdb_lite_list_records(bdb_state_type *bdb_state,
                                           int keylen, void *data, int datalen,
                                           int *bdberr),
                           int *bdberr);
+int bdb_lite_cache_init(bdb_state_type *bdb_state);
+void bdb_lite_cache_stats(bdb_state_type *bdb_state, unsigned long long *hits,
+                          unsigned long long *reads);
 
 int bdb_osql_cache_table_versions(bdb_state_type *bdb_state, tran_type *tran,
                                   int trak, int *bdberr);
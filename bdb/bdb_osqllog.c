@@ -99,6 +99,12 @@ typedef struct bdb_osql_log_rec {
     struct bdb_osql_log_rec *comprec;
     LINKC_T(struct bdb_osql_log_rec) lnk; /* link to next record */
 
+    /* before-image, shared by all snapshots (see bdb_osql_rec_image_get) */
+    char *img;     /* key followed by data */
+    int imgkeylen; /* key part of img */
+    int imgdtalen; /* data part of img */
+    int imgpage;
+    int imgindex;
 } bdb_osql_log_rec_t;
 
 /**
@@ -1055,6 +1061,8 @@ int bdb_osql_log_destroy(bdb_osql_log_t *log)
         }
         if (rec->table)
             free(rec->table);
+        if (rec->img)
+            free(rec->img);
         free(rec);
     }
     free(log->impl);
@@ -3532,6 +3540,154 @@ done:
     return rc;
 }
 
+/**
+ * The before-image of an undo record is the same for every snapshot
+ * transaction that needs it.  The first one to reconstruct it from the log
+ * keeps a copy on the log record, which is shared by all transactions, and
+ * the others copy it from there instead of walking the log again.  The copy
+ * goes away with the log, once the oldest snapshot no longer needs it.
+ * The image is that of the record just before rec->lsn, so it is the same
+ * whatever the age of the snapshot that asks for it.
+ *
+ * Records are spread over REC_IMAGE_NLOCKS locks by lsn, so that snapshots
+ * reconstructing different records don't wait on each other.
+ *
+ */
+#define REC_IMAGE_NLOCKS 256
+static pthread_mutex_t rec_image_lks[REC_IMAGE_NLOCKS];
+static pthread_once_t rec_image_once = PTHREAD_ONCE_INIT;
+
+static void rec_image_init(void)
+{
+    int i;
+    for (i = 0; i < REC_IMAGE_NLOCKS; i++)
+        pthread_mutex_init(&rec_image_lks[i], NULL);
+}
+
+static pthread_mutex_t *rec_image_lk(bdb_osql_log_rec_t *rec)
+{
+    unsigned int h = rec->lsn.file * 2654435761U ^ rec->lsn.offset;
+
+    pthread_once(&rec_image_once, rec_image_init);
+    return &rec_image_lks[(h ^ (h >> 16)) % REC_IMAGE_NLOCKS];
+}
+
+static int bdb_osql_rec_image_get(bdb_state_type *bdb_state,
+                                  bdb_osql_log_rec_t *rec, int *page,
+                                  int *index, void *key, int keylen,
+                                  void *data, int datalen, int *outdatalen)
+{
+    pthread_mutex_t *lk;
+    int found = 0;
+
+    if (!bdb_state->attr->snapisol_shared_images)
+        return 0;
+
+    lk = rec_image_lk(rec);
+    pthread_mutex_lock(lk);
+    if (rec->img && rec->imgkeylen == keylen && rec->imgdtalen <= datalen) {
+        if (page)
+            *page = rec->imgpage;
+        if (index)
+            *index = rec->imgindex;
+        if (keylen)
+            memcpy(key, rec->img, keylen);
+        memcpy(data, rec->img + keylen, rec->imgdtalen);
+        if (outdatalen)
+            *outdatalen = rec->imgdtalen;
+        found = 1;
+    }
+    pthread_mutex_unlock(lk);
+
+    return found;
+}
+
+static void bdb_osql_rec_image_put(bdb_state_type *bdb_state,
+                                   bdb_osql_log_rec_t *rec, int *page,
+                                   int *index, void *key, int keylen,
+                                   void *data, int datalen)
+{
+    pthread_mutex_t *lk;
+    char *img;
+
+    if (!bdb_state->attr->snapisol_shared_images)
+        return;
+
+    img = malloc(keylen + datalen);
+    if (!img)
+        return; /* next transaction will reconstruct it again */
+    if (keylen)
+        memcpy(img, key, keylen);
+    memcpy(img + keylen, data, datalen);
+
+    lk = rec_image_lk(rec);
+    pthread_mutex_lock(lk);
+    if (!rec->img) {
+        rec->img = img;
+        rec->imgkeylen = keylen;
+        rec->imgdtalen = datalen;
+        rec->imgpage = page ? *page : 0;
+        rec->imgindex = index ? *index : 0;
+        img = NULL;
+    }
+    pthread_mutex_unlock(lk);
+
+    free(img); /* someone else stored it first */
+}
+
+static int bdb_osql_reconstruct_delete(bdb_state_type *bdb_state,
+                                       bdb_osql_log_rec_t *rec, int *page,
+                                       int *index, void *key, int keylen,
+                                       void *data, int datalen,
+                                       int *outdatalen)
+{
+    int rc;
+
+    if (bdb_osql_rec_image_get(bdb_state, rec, page, index, key, keylen, data,
+                               datalen, outdatalen))
+        return 0;
+
+    rc = bdb_reconstruct_delete(bdb_state, &rec->lsn, page, index, key, keylen,
+                                data, datalen, outdatalen);
+    if (!rc)
+        bdb_osql_rec_image_put(bdb_state, rec, page, index, key, keylen, data,
+                               outdatalen ? *outdatalen : datalen);
+
+    return rc;
+}
+
+static int bdb_osql_reconstruct_update(bdb_state_type *bdb_state,
+                                       bdb_osql_log_rec_t *rec, int inplace,
+                                       int *page, int *index, void *data,
+                                       int datalen)
+{
+    int offset;
+    int updlen;
+    int rc;
+
+    if (bdb_osql_rec_image_get(bdb_state, rec, page, index, NULL, 0, data,
+                               datalen, NULL))
+        return 0;
+
+    if (inplace) {
+        rc = bdb_reconstruct_inplace_update(bdb_state, &rec->lsn, data,
+                                            datalen, &offset, &updlen, page,
+                                            index);
+
+        /* Sanity check results. */
+        if (0 == rc)
+            assert(offset == 0 && updlen == datalen);
+    } else {
+        rc = bdb_reconstruct_update(bdb_state, &rec->lsn, page, index, NULL, 0,
+                                    data, datalen);
+    }
+    if (!rc)
+        bdb_osql_rec_image_put(bdb_state, rec, page, index, NULL, 0, data,
+                               datalen);
+
+    return rc;
+}
+
 static int bdb_osql_log_run_unoptimized(bdb_cursor_impl_t *cur, DB_LOGC *curlog,
                                         bdb_osql_log_t *log,
                                         bdb_osql_log_rec_t *rec, DBT *inlogdta,
@@ -3561,7 +3717,6 @@ static int bdb_osql_log_run_unoptimized(bdb_cursor_impl_t *cur, DB_LOGC *curlog,
     int inplace = 0;
     void *keybuf;
     int keylen;
-    int updlen;
     void *dtabuf;
     void *freeme;
     int page;
@@ -3680,8 +3835,8 @@ static int bdb_osql_log_run_unoptimized(bdb_cursor_impl_t *cur, DB_LOGC *curlog,
         }
 
         /* Reconstruct the delete. */
-        rc = bdb_reconstruct_delete(bdb_state, &rec->lsn, &page, &index, NULL,
-                                    0, dtabuf, dtalen, NULL);
+        rc = bdb_osql_reconstruct_delete(bdb_state, rec, &page, &index, NULL, 0,
+                                         dtabuf, dtalen, NULL);
         if (rc) {
             if (rc == BDBERR_NO_LOG)
                 *bdberr = rc;
@@ -3774,8 +3929,8 @@ static int bdb_osql_log_run_unoptimized(bdb_cursor_impl_t *cur, DB_LOGC *curlog,
         keybuf = malloc(keylen);
         dtabuf = malloc(dtalen + 4 * bdb_state->ixcollattr[ix]);
         outdatalen = 0;
-        rc = bdb_reconstruct_delete(
-            bdb_state, &rec->lsn, NULL, NULL, keybuf, keylen, dtabuf,
+        rc = bdb_osql_reconstruct_delete(
+            bdb_state, rec, NULL, NULL, keybuf, keylen, dtabuf,
             dtalen + 4 * bdb_state->ixcollattr[ix], &outdatalen);
         if (rc) {
             if (rc == BDBERR_NO_LOG)
@@ -3978,21 +4133,11 @@ static int bdb_osql_log_run_unoptimized(bdb_cursor_impl_t *cur, DB_LOGC *curlog,
             freeme = dtabuf;
         }
 
-        /* If this is inplace, search for a berkley repl log entry.  */
-        if (inplace && old_dta_len > 0) {
-            rc = bdb_reconstruct_inplace_update(bdb_state, &rec->lsn, dtabuf,
-                                                old_dta_len, &offset, &updlen,
-                                                &page, &index);
-
-            /* Sanity check results. */
-            if (0 == rc)
-                assert(offset == 0 && updlen == old_dta_len);
-        }
-        /* Get the addrem's which correlate to this logical update. */
-        else {
-            rc = bdb_reconstruct_update(bdb_state, &rec->lsn, &page, &index,
-                                        NULL, 0, dtabuf, old_dta_len);
-        }
+        /* If this is inplace, search for a berkley repl log entry; otherwise
+           get the addrem's which correlate to this logical update. */
+        rc = bdb_osql_reconstruct_update(bdb_state, rec,
+                                         inplace && old_dta_len > 0, &page,
+                                         &index, dtabuf, old_dta_len);
         if (rc) {
             if (rc == BDBERR_NO_LOG)
                 *bdberr = rc;
@@ -21,6 +21,7 @@
 #include <stddef.h>
 #include <strings.h>
 #include <alloca.h>
+#include <pthread.h>
 #include <sys/poll.h>
 #include <unistd.h>
 
@@ -35,39 +36,128 @@
 #include "genid.h"
 #include "logmsg.h"
 
+/* A verify is split into parts: one per data stripe, one per index and one
+ * per blob file stripe.  Each part is a sequential walk of one btree, so with
+ * verify_threads > 1 they are handed out to a pool of workers, and with
+ * verify_page_order they walk their btree in page order. */
+enum { VERIFY_DATA, VERIFY_INDEX, VERIFY_BLOB };
+
+typedef struct verify_part {
+    int type;
+    int num;    /* index or blob number */
+    int stripe; /* data or blob stripe */
+    /* checked so far, only touched by the worker that has the part */
+    int64_t nrecs;
+    /* how many of those are already in par->nrecs, under lk */
+    int64_t nrecs_merged;
+} verify_part_t;
+
+/* records a part checks between looks at the shared state */
+#define VERIFY_TICK_RECS 1000
+
+typedef struct verify_common {
+    SBUF2 *sb;
+    bdb_state_type *bdb_state;
+    int (*formkey_callback)(void *parm, void *dta, void *blob_parm, int ix,
+                            void *keyout, int *keysz);
+    int (*get_blob_sizes_callback)(void *parm, void *dta, int blobs[16],
+                                   int bloboffs[16], int *nblobs);
+    int (*vtag_callback)(void *parm, void *dta, int *dtasz, uint8_t ver);
+    int (*add_blob_buffer_callback)(void *parm, void *dta, int dtasz,
+                                    int blobno);
+    void (*free_blob_buffer_callback)(void *parm);
+    unsigned long long (*verify_indexes_callback)(void *parm, void *dta,
+                                                  void *blob_parm);
+    void *callback_parm;
+    int (*lua_callback)(void *, const char *);
+    void *lua_params;
+    void *callback_blob_buf;
+    size_t blob_buf_size;
+    int progress_report_seconds;
+    int attempt_fix;
+    int page_order;
+
+    /* everything below, and all output, is under lk */
+    pthread_mutex_t lk;
+    verify_part_t *parts;
+    int nparts;
+    int next_part;
+    int parts_done;
+    int64_t nrecs; /* records, keys and blobs checked */
+    int64_t nrecs_last;
+    int last_report;
+    int last_poll;
+    int stop; /* client went away, or a part failed */
+    int ret;  /* found an inconsistency */
+    int rc;   /* first part that failed */
+} verify_common_t;
+
+static int locprint_int(verify_common_t *par, const char *lbuf)
+{
+    int rc = -1;
+    if (par->sb) {
+        rc = sbuf2printf(par->sb, "%s", lbuf);
+        sbuf2flush(par->sb);
+    } else if (par->lua_callback)
+        rc = par->lua_callback(par->lua_params, lbuf);
+    return rc;
+}
+
 /* print to sb if available lua callback otherwise */
-static int locprint(SBUF2 *sb, int (*lua_callback)(void *, const char *), 
-        void *lua_params, char *fmt, ...)
+static int locprint(verify_common_t *par, char *fmt, ...)
 {
     char lbuf[1024];
     va_list ap;
+    int rc;
     va_start(ap, fmt);
     vsnprintf(lbuf, sizeof(lbuf), fmt, ap);
     va_end(ap);
 
-    if(sb) 
-        return sbuf2printf(sb, lbuf);
-    else if(lua_callback)
-        return lua_callback(lua_params, lbuf);
-    return -1;
+    pthread_mutex_lock(&par->lk);
+    rc = locprint_int(par, lbuf);
+    pthread_mutex_unlock(&par->lk);
+    return rc;
 }
 
-static int bdb_verify_ll(
-    SBUF2 *sb, bdb_state_type *bdb_state,
-    int (*formkey_callback)(void *parm, void *dta, void *blob_parm, int ix,
-                            void *keyout, int *keysz),
-    int (*get_blob_sizes_callback)(void *parm, void *dta, int blobs[16],
-                                   int bloboffs[16], int *nblobs),
-    int (*vtag_callback)(void *parm, void *dta, int *dtasz, uint8_t ver),
-    int (*add_blob_buffer_callback)(void *parm, void *dta, int dtasz,
-                                    int blobno),
-    void (*free_blob_buffer_callback)(void *parm),
-    unsigned long long (*verify_indexes_callback)(void *parm, void *dta,
-                                                  void *blob_parm),
-    void *callback_parm, 
-    int (*lua_callback)(void *, const char *), void *lua_params, 
-    void *callback_blob_buf, int progress_report_seconds,
-    int attempt_fix, unsigned int lid);
+/* print an inconsistency */
+static void verify_error(verify_common_t *par, char *fmt, ...)
+{
+    char lbuf[1024];
+    va_list ap;
+    va_start(ap, fmt);
+    vsnprintf(lbuf, sizeof(lbuf), fmt, ap);
+    va_end(ap);
+
+    pthread_mutex_lock(&par->lk);
+    par->ret = 1;
+    locprint_int(par, lbuf);
+    pthread_mutex_unlock(&par->lk);
+}
+
+static void verify_parts(verify_common_t *par, void *blob_buf);
+
+static void *verify_worker(void *arg)
+{
+    verify_common_t *par = arg;
+    bdb_state_type *bdb_state = par->bdb_state;
+    void *blob_buf;
+
+    bdb_thread_event(bdb_state, BDBTHR_EVENT_START_RDONLY);
+    BDB_READLOCK("bdb_verify_worker");
+
+    blob_buf = calloc(1, par->blob_buf_size);
+    if (blob_buf == NULL) {
+        logmsg(LOGMSG_ERROR, "%s: failed to malloc %zu\n", __func__,
+               par->blob_buf_size);
+    } else {
+        verify_parts(par, blob_buf);
+        free(blob_buf);
+    }
+
+    BDB_RELLOCK();
+    bdb_thread_event(bdb_state, BDBTHR_EVENT_DONE_RDONLY);
+    return NULL;
+}
 
 int bdb_verify(
     SBUF2 *sb, bdb_state_type *bdb_state,
@@ -83,38 +173,113 @@ int bdb_verify(
                                                   void *blob_parm),
     void *callback_parm, 
     int (*lua_callback)(void *, const char *), void *lua_params, 
-    void *callback_blob_buf, int progress_report_seconds,
-    int attempt_fix)
+    void *callback_blob_buf, size_t blob_buf_size,
+    int progress_report_seconds, int attempt_fix)
 {
-    int rc;
-    DB_LOCKREQ rq = {0};
-    unsigned int flags = DB_LOCK_ID_READONLY;
-    unsigned int lid;
+    verify_common_t par = {0};
+    int nthreads;
+    int start;
+    int nblobs;
+    int i, j;
 
     BDB_READLOCK("bdb_verify");
 
-    if ((rc = bdb_state->dbenv->lock_id_flags(bdb_state->dbenv, &lid,
-                                              DB_LOCK_ID_READONLY)) != 0) {
+    par.sb = sb;
+    par.bdb_state = bdb_state;
+    par.formkey_callback = formkey_callback;
+    par.get_blob_sizes_callback = get_blob_sizes_callback;
+    par.vtag_callback = vtag_callback;
+    par.add_blob_buffer_callback = add_blob_buffer_callback;
+    par.free_blob_buffer_callback = free_blob_buffer_callback;
+    par.verify_indexes_callback = verify_indexes_callback;
+    par.callback_parm = callback_parm;
+    par.lua_callback = lua_callback;
+    par.lua_params = lua_params;
+    par.callback_blob_buf = callback_blob_buf;
+    par.blob_buf_size = blob_buf_size;
+    par.progress_report_seconds = progress_report_seconds;
+    par.attempt_fix = attempt_fix;
+    /* fixing a record repositions the data cursor by genid */
+    par.page_order = bdb_state->attr->verify_page_order && !attempt_fix;
+    pthread_mutex_init(&par.lk, NULL);
+
+    /* data stripes first, then indexes, then blobs: in the serial case this
+     * is the order verify has always reported in */
+    nblobs = bdb_state->numdtafiles - 1;
+    par.parts = calloc(bdb_state->attr->dtastripe * (nblobs + 1) +
+                           bdb_state->numix + 1,
+                       sizeof(verify_part_t));
+    if (par.parts == NULL) {
         BDB_RELLOCK();
-        logmsg(LOGMSG_ERROR, "%s: error getting a lockid, %d\n", __func__, rc);
-        return rc;
+        pthread_mutex_destroy(&par.lk);
+        logmsg(LOGMSG_ERROR, "%s: failed to malloc parts\n", __func__);
+        return ENOMEM;
+    }
+    for (i = 0; i < bdb_state->attr->dtastripe; i++)
+        par.parts[par.nparts++] = (verify_part_t){VERIFY_DATA, 0, i};
+    for (i = 0; i < bdb_state->numix; i++)
+        par.parts[par.nparts++] = (verify_part_t){VERIFY_INDEX, i, 0};
+    for (i = 0; i < nblobs; i++) {
+        for (j = 0; j < bdb_get_datafile_num_files(bdb_state, i + 1); j++)
+            par.parts[par.nparts++] = (verify_part_t){VERIFY_BLOB, i, j};
     }
 
-    rc = bdb_verify_ll(sb, bdb_state, formkey_callback, get_blob_sizes_callback,
-                       vtag_callback, add_blob_buffer_callback,
-                       free_blob_buffer_callback, verify_indexes_callback,
-                       callback_parm, 
-                       lua_callback, lua_params,
-                       callback_blob_buf,
-                       progress_report_seconds, attempt_fix, lid);
-
-    rq.op = DB_LOCK_PUT_ALL;
-    bdb_state->dbenv->lock_vec(bdb_state->dbenv, lid, 0, &rq, 1, NULL);
-    bdb_state->dbenv->lock_id_free(bdb_state->dbenv, lid);
+    nthreads = bdb_state->attr->verify_threads;
+    if (nthreads > par.nparts)
+        nthreads = par.nparts;
+
+    start = par.last_report = par.last_poll = comdb2_time_epochms();
+
+    if (nthreads <= 1) {
+        verify_parts(&par, callback_blob_buf);
+    } else {
+        pthread_t tids[nthreads];
+        pthread_attr_t attr;
+        int nstarted = 0;
+        int rc;
+
+        pthread_attr_init(&attr);
+        pthread_attr_setstacksize(&attr,
+                                  bdb_state->attr->verify_thread_stacksz);
+        for (i = 0; i < nthreads; i++) {
+            rc = pthread_create(&tids[nstarted], &attr, verify_worker, &par);
+            if (rc) {
+                logmsg(LOGMSG_ERROR, "%s: pthread_create rc %d\n", __func__,
+                       rc);
+                break;
+            }
+            nstarted++;
+        }
+        /* whatever is left if no worker could start */
+        if (nstarted == 0)
+            verify_parts(&par, callback_blob_buf);
+        for (i = 0; i < nstarted; i++)
+            pthread_join(tids[i], NULL);
+        pthread_attr_destroy(&attr);
+    }
 
     BDB_RELLOCK();
 
-    return rc;
+    {
+        char lbuf[256];
+        int ms = comdb2_time_epochms() - start;
+        snprintf(lbuf, sizeof(lbuf),
+                 "!verified %d of %d parts, %lld records in %d.%03ds, %lld "
+                 "per second, %s order, %d threads\n",
+                 par.parts_done, par.nparts, (long long)par.nrecs, ms / 1000,
+                 ms % 1000, ms ? (long long)(par.nrecs * 1000 / ms) : 0,
+                 par.page_order ? "page" : "key", nthreads > 1 ? nthreads : 1);
+        logmsg(LOGMSG_INFO, "%s: table %s %s", __func__, bdb_state->name,
+               lbuf + 1);
+        /* the serial key order verify has always been silent here */
+        if (progress_report_seconds && (nthreads > 1 || par.page_order))
+            locprint(&par, "%s", lbuf);
+    }
+
+    free(par.parts);
+    pthread_mutex_destroy(&par.lk);
+
+    return par.rc ? par.rc : par.ret;
 }
 
 static int dropped_connection(SBUF2 *sb)
@@ -262,67 +427,114 @@ ret:
     return rc;
 }
 
-static void printhex(SBUF2 *sb, int (*lua_callback)(void *, const char *),
-        void *lua_params, uint8_t *hex, int sz)
+static void tohex(char *out, int outlen, uint8_t *hex, int sz)
 {
     const char hexbytes[] = "0123456789abcdef";
-    for (int i = 0; i < sz; i++)
-        locprint(sb, lua_callback, lua_params, "%c%c", 
-                hexbytes[(hex[i] & 0xf0) >> 4], hexbytes[hex[i] & 0xf]);
+    int i;
+    for (i = 0; i < sz && (i + 1) * 2 < outlen; i++) {
+        out[i * 2] = hexbytes[(hex[i] & 0xf0) >> 4];
+        out[i * 2 + 1] = hexbytes[hex[i] & 0xf];
+    }
+    out[i * 2] = 0;
+}
+
+static const char *part_name(int type)
+{
+    switch (type) {
+    case VERIFY_DATA:
+        return "dtastripe";
+    case VERIFY_INDEX:
+        return "index";
+    default:
+        return "blob";
+    }
+}
+
+/* add what a part checked since the last merge to the total; under lk */
+static void verify_merge(verify_common_t *par, verify_part_t *part)
+{
+    par->nrecs += part->nrecs - part->nrecs_merged;
+    part->nrecs_merged = part->nrecs;
+}
+
+/* Count one record of a part.  Every VERIFY_TICK_RECS records, merge the
+ * count, report progress and watch for the client going away.  Returns 1 if
+ * the part should stop. */
+static int verify_tick(verify_common_t *par, verify_part_t *part)
+{
+    int now;
+    int stop;
+
+    if (++part->nrecs % VERIFY_TICK_RECS)
+        return 0;
+
+    now = comdb2_time_epochms();
+
+    pthread_mutex_lock(&par->lk);
+    verify_merge(par, part);
+
+    /* check if comdb2sc is killed */
+    if ((now - par->last_poll) > 1000) {
+        par->last_poll = now;
+        if (dropped_connection(par->sb)) {
+            logmsg(LOGMSG_WARN, "condb2sc connection closed, stopped verify\n");
+            par->stop = 1;
+        }
+    }
+
+    if (!par->stop && par->progress_report_seconds &&
+        ((now - par->last_report) >= (par->progress_report_seconds * 1000))) {
+        char lbuf[256];
+        int ms = now - par->last_report;
+        snprintf(lbuf, sizeof(lbuf),
+                 "!verifying %s %d, did %lld records, %lld per second, %d of "
+                 "%d parts done\n",
+                 part_name(part->type),
+                 part->type == VERIFY_DATA ? part->stripe : part->num,
+                 (long long)part->nrecs,
+                 (long long)((par->nrecs - par->nrecs_last) * 1000 / ms),
+                 par->parts_done, par->nparts);
+        if (locprint_int(par, lbuf) < 0)
+            par->stop = 1; /* dropped connection */
+        par->last_report = now;
+        par->nrecs_last = par->nrecs;
+    }
+    stop = par->stop;
+    pthread_mutex_unlock(&par->lk);
+    return stop;
 }
 
 extern int gbl_expressions_indexes;
 int is_comdb2_index_expression(const char *dbname);
+
+/* scan 1 - run through a data stripe, verify all the keys and blobs */
 /* TODO: handle deadlock, get rowlocks if db in rowlocks mode */
-static int bdb_verify_ll(
-    SBUF2 *sb, bdb_state_type *bdb_state,
-    int (*formkey_callback)(void *parm, void *dta, void *blob_parm, int ix,
-                            void *keyout, int *keysz),
-    int (*get_blob_sizes_callback)(void *parm, void *dta, int blobs[16],
-                                   int bloboffs[16], int *nblobs),
-    int (*vtag_callback)(void *parm, void *dta, int *dtasz, uint8_t ver),
-    int (*add_blob_buffer_callback)(void *parm, void *dta, int dtasz,
-                                    int blobno),
-    void (*free_blob_buffer_callback)(void *parm),
-    unsigned long long (*verify_indexes_callback)(void *parm, void *dta,
-                                                  void *blob_parm),
-    void *callback_parm, 
-    int (*lua_callback)(void *, const char *), void *lua_params, 
-    void *callback_blob_buf, int progress_report_seconds,
-    int attempt_fix, unsigned int lid)
+static int verify_dtastripe(verify_common_t *par, verify_part_t *part,
+                            void *callback_blob_buf, unsigned int lid)
 {
+    bdb_state_type *bdb_state = par->bdb_state;
+    void *callback_parm = par->callback_parm;
+    int dtastripe = part->stripe;
     DBC *cdata = NULL;
     DBC *ckey = NULL;
     DB *db;
-    DBC *cblob;
     unsigned char databuf[17 * 1024];
     unsigned char keybuf[18 * 1024];
     unsigned char expected_keybuf[18 * 1024];
-    unsigned char verify_keybuf[18 * 1024];
-    int dtastripe;
     DBT dbt_data = {0};
     DBT dbt_key = {0};
     DBT dbt_blob_key = {0}, dbt_blob_data = {0};
-    DBT dbt_dta_check_key = {0}, dbt_dta_check_data = {0};
     int rc;
     int ix;
-    int keylen, expected_keylen;
+    int keylen;
     unsigned long long has_keys;
     unsigned long long genid, verify_genid;
     int blobsizes[16];
     int bloboffs[16];
     int nblobs = 0;
     int blobno;
-    char dumbuf;
     uint8_t ver;
-    int now, last;
-    int64_t nrecs = 0;
-    int nrecs_progress = 0;
     unsigned long long genid_flipped;
-    int ret = 0;
-
-    bzero(&dbt_data, sizeof(DBT));
-    bzero(&dbt_key, sizeof(DBT));
 
     dbt_data.flags = DB_DBT_USERMEM;
     dbt_data.ulen = sizeof(databuf);
@@ -331,69 +543,33 @@ static int bdb_verify_ll(
     dbt_key.ulen = sizeof(keybuf);
     dbt_key.data = keybuf;
 
-    bzero(&dbt_blob_key, sizeof(DBT));
-    bzero(&dbt_blob_data, sizeof(DBT));
-
-    now = last = comdb2_time_epochms();
-
-    /* scan 1 - run through data, verify all the keys and blobs */
-    for (dtastripe = 0; dtastripe < bdb_state->attr->dtastripe; dtastripe++) {
-        nrecs = 0;
-        nrecs_progress = 0;
-        dbt_data.flags = DB_DBT_USERMEM;
-        dbt_data.ulen = sizeof(databuf);
-        dbt_data.data = databuf;
-        dbt_key.flags = DB_DBT_USERMEM;
-        dbt_key.ulen = sizeof(keybuf);
-        dbt_key.data = keybuf;
+    db = bdb_state->dbp_data[0][dtastripe];
+    rc = db->paired_cursor_from_lid(
+        db, lid, &cdata,
+        par->page_order ? (DB_PAGE_ORDER | DB_DISCARD_PAGES) : 0);
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "dtastripe %d cursor rc %d\n", dtastripe, rc);
+        return rc;
+    }
+    rc = bdb_cget_unpack(bdb_state, cdata, &dbt_key, &dbt_data, &ver,
+                         DB_FIRST);
+    if (rc == DB_NOTFOUND) {
+        cdata->c_close(cdata);
+        return 0;
+    }
 
-        db = bdb_state->dbp_data[0][dtastripe];
-        rc = db->paired_cursor_from_lid(db, lid, &cdata, 0);
-        if (rc) {
-            logmsg(LOGMSG_ERROR, "dtastripe %d cursor rc %d\n", dtastripe, rc);
-            return rc;
-        }
-        rc = bdb_cget_unpack(bdb_state, cdata, &dbt_key, &dbt_data, &ver,
-                             DB_FIRST);
-        if (rc == DB_NOTFOUND) {
+    while (rc == 0) {
+        if (verify_tick(par, part)) {
             cdata->c_close(cdata);
-            continue;
+            return 0;
         }
 
-        while (rc == 0) {
-            nrecs++;
-            nrecs_progress++;
-
-            now = comdb2_time_epochms();
-
-            /* check if comdb2sc is killed */
-            if ((now - last) > 1000) {
-                if (dropped_connection(sb)) {
-                    cdata->c_close(cdata);
-                    logmsg(LOGMSG_WARN, "condb2sc connection closed, stopped verify\n");
-                    return rc;
-                }
-            }
-
-            if (progress_report_seconds &&
-                ((now - last) >= (progress_report_seconds * 1000))) {
-                rc = locprint(sb, lua_callback, lua_params, "!verifying dtastripe %d, did %lld records, %d "
-                                "per second\n",
-                            dtastripe, nrecs,
-                            nrecs_progress / progress_report_seconds);
-                if(rc) return ret; //dropped connection
-                last = now;
-                nrecs_progress = 0;
-                sbuf2flush(sb);
-            }
-
-            /* is it the right size? */
-            if (dbt_key.size != sizeof(genid)) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!bad genid sz %d\n", dbt_key.size);
-                goto next_record;
-            }
-            memcpy(&genid, dbt_key.data, sizeof(genid));
+        /* is it the right size? */
+        if (dbt_key.size != sizeof(genid)) {
+            verify_error(par, "!bad genid sz %d\n", dbt_key.size);
+            goto next_record;
+        }
+        memcpy(&genid, dbt_key.data, sizeof(genid));
 
 /* why do we open a cursor for each record/blob?
    1) cursors are cheap - berkeley opens one for every cursor
@@ -402,233 +578,243 @@ static int bdb_verify_ll(
       locking up db operations
    */
 #ifdef _LINUX_SOURCE
-            buf_put(&genid, sizeof(unsigned long long),
-                    (uint8_t *)&genid_flipped,
-                    (uint8_t *)&genid_flipped + sizeof(unsigned long long));
+        buf_put(&genid, sizeof(unsigned long long), (uint8_t *)&genid_flipped,
+                (uint8_t *)&genid_flipped + sizeof(unsigned long long));
 #else
-            genid_flipped = genid;
+        genid_flipped = genid;
 #endif
-            vtag_callback(callback_parm, dbt_data.data, (int *)&dbt_data.size,
-                          ver);
-
-            rc = get_blob_sizes_callback(callback_parm, dbt_data.data,
-                                         blobsizes, bloboffs, &nblobs);
-            if (rc) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!%016llx blob size rc %d\n", genid, rc);
-            } else {
-                /* verify blobs */
-                int realblobsz[16];
-                int had_errors, had_irrecoverable_errors;
+        par->vtag_callback(callback_parm, dbt_data.data,
+                           (int *)&dbt_data.size, ver);
 
-                had_errors = 0;
+        rc = par->get_blob_sizes_callback(callback_parm, dbt_data.data,
+                                          blobsizes, bloboffs, &nblobs);
+        if (rc) {
+            verify_error(par, "!%016llx blob size rc %d\n", genid, rc);
+        } else {
+            /* verify blobs */
+            int realblobsz[16];
+            int had_errors, had_irrecoverable_errors;
+
+            had_errors = 0;
+            had_irrecoverable_errors = 0;
+            for (blobno = 0; blobno < nblobs; blobno++) {
+                DBC *cblob;
+                DB *blobdb;
+                unsigned long long blob_genid = genid;
+                int dtafile;
+
+                realblobsz[blobno] = -1;
                 had_irrecoverable_errors = 0;
-                for (blobno = 0; blobno < nblobs; blobno++) {
-                    DBC *cblob;
-                    DB *blobdb;
-                    unsigned long long blob_genid = genid;
-                    int dtafile;
+                had_errors = 0;
 
-                    realblobsz[blobno] = -1;
-                    had_irrecoverable_errors = 0;
-                    had_errors = 0;
+                dtafile = get_dtafile_from_genid(genid);
+                if (dtafile < 0) {
+                    verify_error(par, "!%016llx unknown dtafile\n",
+                                 genid_flipped);
+                    continue;
+                }
+                blobdb = get_dbp_from_genid(bdb_state, blobno + 1, genid, NULL);
 
-                    dtafile = get_dtafile_from_genid(genid);
-                    if (dtafile < 0) {
-                        ret = 1;
-                        locprint(sb, lua_callback, lua_params, "!%016llx unknown dtafile\n",
-                                    genid_flipped);
-                        continue;
-                    }
-                    blobdb =
-                        get_dbp_from_genid(bdb_state, blobno + 1, genid, NULL);
+                rc = blobdb->paired_cursor_from_lid(blobdb, lid, &cblob, 0);
+                if (rc) {
+                    verify_error(par, "!%016llx cursor on blob %d rc %d\n",
+                                 genid_flipped, blobno, rc);
+                    continue;
+                }
 
-                    rc = blobdb->paired_cursor_from_lid(blobdb, lid, &cblob, 0);
-                    if (rc) {
-                        ret = 1;
-                        locprint(sb, lua_callback, lua_params, "!%016llx cursor on blob %d rc %d\n",
-                                    genid_flipped, blobno, rc);
-                        continue;
+                /* Note: we have to fetch the whole blob here because with
+                   ondisk headers + compression
+                   the size of the blob will not match what's stored in the
+                   record so a partial find
+                   won't do.  I guess we could optimize for the more common
+                   case of no headers/compression. */
+                dbt_blob_key.data = &blob_genid;
+                dbt_blob_key.size = sizeof(unsigned long long);
+                dbt_blob_data.flags = DB_DBT_MALLOC;
+                dbt_blob_data.data = NULL;
+
+                rc = bdb_cget_unpack_blob(bdb_state, cblob, &dbt_blob_key,
+                                          &dbt_blob_data, &ver, DB_SET);
+                if (rc == DB_NOTFOUND) {
+                    realblobsz[blobno] = -1;
+                    if (blobsizes[blobno] != -1 && blobsizes[blobno] != -2) {
+                        had_errors = 1;
+                        verify_error(
+                            par, "!%016llx no blob %d found expected sz %d\n",
+                            genid_flipped, blobno, blobsizes[blobno]);
                     }
+                } else if (rc) {
+                    had_irrecoverable_errors = 1;
+                    verify_error(par, "!%016llx blob %d rc %d\n",
+                                 genid_flipped, blobno, rc);
+                    had_errors = 1;
+                }
 
-                    /* Note: we have to fetch the whole blob here because with
-                       ondisk headers + compression
-                       the size of the blob will not match what's stored in the
-                       record so a partial find
-                       won't do.  I guess we could optimize for the more common
-                       case of no headers/compression. */
-                    dbt_blob_key.data = &blob_genid;
-                    dbt_blob_key.size = sizeof(unsigned long long);
-                    dbt_blob_data.flags = DB_DBT_MALLOC;
-                    dbt_blob_data.data = NULL;
-
-                    rc = bdb_cget_unpack_blob(bdb_state, cblob, &dbt_blob_key,
-                                              &dbt_blob_data, &ver, DB_SET);
-                    if (rc == DB_NOTFOUND) {
-                        realblobsz[blobno] = -1;
-                        if (blobsizes[blobno] != -1 &&
-                            blobsizes[blobno] != -2) {
-                            had_errors = 1;
-                            ret = 1;
-                            locprint(sb, lua_callback, lua_params,
-                                "!%016llx no blob %d found expected sz %d\n",
-                                genid_flipped, blobno, blobsizes[blobno]);
-                        }
-                    } else if (rc) {
-                        had_irrecoverable_errors = 1;
-                        ret = 1;
-                        locprint(sb, lua_callback, lua_params, "!%016llx blob %d rc %d\n",
-                                    genid_flipped, blobno, rc);
+                if (rc == 0) {
+                    realblobsz[blobno] = dbt_blob_data.size;
+                    if (blobsizes[blobno] == -1 && rc != DB_NOTFOUND) {
+                        verify_error(par,
+                                     "!%016llx blob %d null but found blob\n",
+                                     genid_flipped, blobno);
+                    } else if (blobsizes[blobno] == -2) {
+                        verify_error(par, "!%016llx blob %d size %d expected "
+                                          "none (inline vutf8)\n",
+                                     genid_flipped, blobno, realblobsz[blobno]);
+                    } else if (blobsizes[blobno] != -1 &&
+                               dbt_blob_data.size != blobsizes[blobno]) {
+                        verify_error(par, "!%016llx blob %d size mismatch "
+                                          "got %d expected %d\n",
+                                     genid_flipped, blobno, dbt_blob_data.size,
+                                     blobsizes[blobno]);
                         had_errors = 1;
                     }
 
-                    if (rc == 0) {
-                        realblobsz[blobno] = dbt_blob_data.size;
-                        if (blobsizes[blobno] == -1 && rc != DB_NOTFOUND) {
-                            ret = 1;
-                            locprint(sb, lua_callback, lua_params,
-                                "!%016llx blob %d null but found blob\n",
-                                genid_flipped, blobno);
-                        } else if (blobsizes[blobno] == -2) {
-                            ret = 1;
-                            locprint(sb, lua_callback, lua_params, "!%016llx blob %d size %d expected "
-                                            "none (inline vutf8)\n",
-                                        genid_flipped, blobno,
-                                        realblobsz[blobno]);
-                        } else if (blobsizes[blobno] != -1 &&
-                                   dbt_blob_data.size != blobsizes[blobno]) {
-                            ret = 1;
-                            locprint(sb, lua_callback, lua_params, "!%016llx blob %d size mismatch "
-                                            "got %d expected %d\n",
-                                        genid_flipped, blobno,
-                                        dbt_blob_data.size, blobsizes[blobno]);
-                            had_errors = 1;
-                        }
-
-                        if (blobsizes[blobno] >= 0 && realblobsz[blobno] >= 0) {
-                            rc = add_blob_buffer_callback(
-                                callback_blob_buf, dbt_blob_data.data,
-                                dbt_blob_data.size, blobno);
-                            if (rc)
-                                return rc;
+                    if (blobsizes[blobno] >= 0 && realblobsz[blobno] >= 0) {
+                        rc = par->add_blob_buffer_callback(
+                            callback_blob_buf, dbt_blob_data.data,
+                            dbt_blob_data.size, blobno);
+                        if (rc) {
+                            cblob->c_close(cblob);
+                            cdata->c_close(cdata);
+                            return rc;
                         }
-
-                        if (dbt_blob_data.data && had_errors == 0)
-                            free(dbt_blob_data.data);
-                    }
-                    cblob->c_close(cblob);
-                }
-                if (attempt_fix && had_errors && !had_irrecoverable_errors) {
-                    rc = fix_blobs(bdb_state, db, &cdata, genid, nblobs,
-                                   bloboffs, realblobsz, lid);
-                    if (rc) {
-                        logmsg(LOGMSG_ERROR, "fix_blobs rc %d\n", rc);
-                        /* close? */
-                        free_blob_buffer_callback(callback_blob_buf);
-                        return rc;
                     }
+
+                    if (dbt_blob_data.data && had_errors == 0)
+                        free(dbt_blob_data.data);
                 }
+                cblob->c_close(cblob);
             }
-
-            has_keys = verify_indexes_callback(callback_parm, dbt_data.data,
-                                               callback_blob_buf);
-            for (ix = 0; ix < bdb_state->numix; ix++) {
-                rc = bdb_state->dbp_ix[ix]->paired_cursor_from_lid(
-                    bdb_state->dbp_ix[ix], lid, &ckey, 0);
+            if (par->attempt_fix && had_errors && !had_irrecoverable_errors) {
+                rc = fix_blobs(bdb_state, db, &cdata, genid, nblobs, bloboffs,
+                               realblobsz, lid);
                 if (rc) {
-                    ckey = NULL;
-                    free_blob_buffer_callback(callback_blob_buf);
-                    logmsg(LOGMSG_ERROR, "unexpected rc opening cursor for ix %d: %d\n", ix,
-                           rc);
+                    logmsg(LOGMSG_ERROR, "fix_blobs rc %d\n", rc);
+                    /* close? */
+                    par->free_blob_buffer_callback(callback_blob_buf);
                     return rc;
                 }
+            }
+        }
 
-                rc = formkey_callback(callback_parm, databuf, callback_blob_buf,
-                                      ix, expected_keybuf, &keylen);
-                if (rc) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx ix %d formkey rc %d\n",
-                                genid_flipped, rc);
-                    ckey->c_close(ckey);
-                    continue;
-                }
+        has_keys = par->verify_indexes_callback(callback_parm, dbt_data.data,
+                                                callback_blob_buf);
+        for (ix = 0; ix < bdb_state->numix; ix++) {
+            rc = bdb_state->dbp_ix[ix]->paired_cursor_from_lid(
+                bdb_state->dbp_ix[ix], lid, &ckey, 0);
+            if (rc) {
+                ckey = NULL;
+                par->free_blob_buffer_callback(callback_blob_buf);
+                logmsg(LOGMSG_ERROR,
+                       "unexpected rc opening cursor for ix %d: %d\n", ix, rc);
+                cdata->c_close(cdata);
+                return rc;
+            }
 
-                /* set up key */
+            rc = par->formkey_callback(callback_parm, databuf,
+                                       callback_blob_buf, ix, expected_keybuf,
+                                       &keylen);
+            if (rc) {
+                verify_error(par, "!%016llx ix %d formkey rc %d\n",
+                             genid_flipped, ix, rc);
+                ckey->c_close(ckey);
+                continue;
+            }
 
-                memcpy(dbt_key.data, expected_keybuf, keylen);
-                dbt_key.size = keylen;
-                if (bdb_state->ixdups[ix]) {
-                    unsigned long long masked_genid =
-                        get_search_genid(bdb_state, genid);
-                    memcpy((char *)dbt_key.data + keylen, &masked_genid,
-                           sizeof(unsigned long long));
-                    dbt_key.size += sizeof(unsigned long long);
-                }
+            /* set up key */
 
-                /* just fetch the genid portion, we'll verify dtacopy in the key
-                 * passes */
-                verify_genid = 0;
-                dbt_data.data = &verify_genid;
-                dbt_data.size = sizeof(unsigned long long);
-                dbt_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
-                dbt_data.ulen = sizeof(unsigned long long);
-                dbt_data.doff = 0;
-                dbt_data.dlen = sizeof(unsigned long long);
-
-                rc = ckey->c_get(ckey, &dbt_key, &dbt_data, DB_SET);
-                if (!(has_keys & (1ULL << ix))) {
-                    if (!rc) {
-                        ret = 1;
-                        locprint(
-                            sb, lua_callback, lua_params,
-                            "!%016llx ix %d expect notfound but got an index\n",
-                            genid_flipped, ix);
-                    }
-                } else if (rc == DB_NOTFOUND) {
-                    ret = 1;
-                    locprint(sb,  lua_callback, lua_params,
-                            "!%016llx ix %d missing key\n", genid_flipped, ix);
-                }
-                else if (rc) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx ix %d fetch rc %d\n",
-                                genid_flipped, ix, rc);
-                }
-                else if (genid != verify_genid) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx ix %d genid mismatch %016llx\n",
-                                genid_flipped, ix, verify_genid);
-                }
+            memcpy(dbt_key.data, expected_keybuf, keylen);
+            dbt_key.size = keylen;
+            if (bdb_state->ixdups[ix]) {
+                unsigned long long masked_genid =
+                    get_search_genid(bdb_state, genid);
+                memcpy((char *)dbt_key.data + keylen, &masked_genid,
+                       sizeof(unsigned long long));
+                dbt_key.size += sizeof(unsigned long long);
+            }
 
-                ckey->c_close(ckey);
+            /* just fetch the genid portion, we'll verify dtacopy in the key
+             * passes */
+            verify_genid = 0;
+            dbt_data.data = &verify_genid;
+            dbt_data.size = sizeof(unsigned long long);
+            dbt_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+            dbt_data.ulen = sizeof(unsigned long long);
+            dbt_data.doff = 0;
+            dbt_data.dlen = sizeof(unsigned long long);
+
+            rc = ckey->c_get(ckey, &dbt_key, &dbt_data, DB_SET);
+            if (!(has_keys & (1ULL << ix))) {
+                if (!rc) {
+                    verify_error(
+                        par,
+                        "!%016llx ix %d expect notfound but got an index\n",
+                        genid_flipped, ix);
+                }
+            } else if (rc == DB_NOTFOUND) {
+                verify_error(par, "!%016llx ix %d missing key\n",
+                             genid_flipped, ix);
+            } else if (rc) {
+                verify_error(par, "!%016llx ix %d fetch rc %d\n",
+                             genid_flipped, ix, rc);
+            } else if (genid != verify_genid) {
+                verify_error(par, "!%016llx ix %d genid mismatch %016llx\n",
+                             genid_flipped, ix, verify_genid);
             }
-            free_blob_buffer_callback(callback_blob_buf);
 
-            sbuf2flush(sb);
-        next_record:
+            ckey->c_close(ckey);
+        }
+        par->free_blob_buffer_callback(callback_blob_buf);
 
-            dbt_data.flags = DB_DBT_USERMEM;
-            dbt_data.ulen = sizeof(databuf);
-            dbt_data.data = databuf;
-            dbt_key.flags = DB_DBT_USERMEM;
-            dbt_key.ulen = sizeof(keybuf);
-            dbt_key.data = keybuf;
+    next_record:
 
-            rc = bdb_cget_unpack(bdb_state, cdata, &dbt_key, &dbt_data, &ver,
-                                 DB_NEXT);
-        }
-        if (rc != DB_NOTFOUND) {
-            cdata->c_close(cdata);
-            ret = 1;
-            locprint(sb, lua_callback, lua_params, "!dtastripe %d c_get unexpected rc %d\n", dtastripe,
-                        rc);
-            return rc;
-        }
+        dbt_data.flags = DB_DBT_USERMEM;
+        dbt_data.ulen = sizeof(databuf);
+        dbt_data.data = databuf;
+        dbt_key.flags = DB_DBT_USERMEM;
+        dbt_key.ulen = sizeof(keybuf);
+        dbt_key.data = keybuf;
+
+        rc = bdb_cget_unpack(bdb_state, cdata, &dbt_key, &dbt_data, &ver,
+                             DB_NEXT);
+    }
+    if (rc != DB_NOTFOUND) {
         cdata->c_close(cdata);
+        verify_error(par, "!dtastripe %d c_get unexpected rc %d\n", dtastripe,
+                     rc);
+        return rc;
     }
+    cdata->c_close(cdata);
+    return 0;
+}
 
-    bzero(&dbt_key, sizeof(DBT));
-    bzero(&dbt_data, sizeof(DBT));
+/* scan 2: scan an index, verify data exists */
+static int verify_index(verify_common_t *par, verify_part_t *part,
+                        void *callback_blob_buf, unsigned int lid)
+{
+    bdb_state_type *bdb_state = par->bdb_state;
+    void *callback_parm = par->callback_parm;
+    int ix = part->num;
+    DBC *cdata = NULL;
+    DBC *ckey = NULL;
+    DB *db;
+    unsigned char databuf[17 * 1024];
+    unsigned char keybuf[18 * 1024];
+    unsigned char expected_keybuf[18 * 1024];
+    unsigned char verify_keybuf[18 * 1024];
+    DBT dbt_data = {0};
+    DBT dbt_key = {0};
+    DBT dbt_blob_key = {0}, dbt_blob_data = {0};
+    DBT dbt_dta_check_key = {0}, dbt_dta_check_data = {0};
+    int rc;
+    int keylen;
+    unsigned long long genid;
+    int blobsizes[16];
+    int bloboffs[16];
+    int nblobs = 0;
+    int blobno;
+    uint8_t ver;
+    unsigned long long genid_flipped;
 
     dbt_key.data = keybuf;
     dbt_key.ulen = sizeof(keybuf);
@@ -647,428 +833,434 @@ static int bdb_verify_ll(
     dbt_dta_check_data.ulen = sizeof(verify_keybuf);
     dbt_dta_check_data.flags = DB_DBT_USERMEM;
 
-    /* scan 2: scan each key, verify data exists */
-    for (ix = 0; ix < bdb_state->numix; ix++) {
-        nrecs = 0;
-        nrecs_progress = 0;
-        rc = bdb_state->dbp_ix[ix]->paired_cursor_from_lid(
-            bdb_state->dbp_ix[ix], lid, &ckey, 0);
-        if (rc) {
-            ret = 1;
-            locprint(sb, lua_callback, lua_params, "!ix %d cursor rc %d\n", ix, rc);
-            continue;
-        }
-        rc = ckey->c_get(ckey, &dbt_key, &dbt_data, DB_FIRST);
-        if (rc && rc != DB_NOTFOUND) {
-            ret = 1;
-            locprint(sb, lua_callback, lua_params, "!ix %d first rc %d\n", ix, rc);
+    rc = bdb_state->dbp_ix[ix]->paired_cursor_from_lid(
+        bdb_state->dbp_ix[ix], lid, &ckey,
+        par->page_order ? (DB_PAGE_ORDER | DB_DISCARD_PAGES) : 0);
+    if (rc) {
+        verify_error(par, "!ix %d cursor rc %d\n", ix, rc);
+        return 0;
+    }
+    rc = ckey->c_get(ckey, &dbt_key, &dbt_data, DB_FIRST);
+    if (rc && rc != DB_NOTFOUND) {
+        verify_error(par, "!ix %d first rc %d\n", ix, rc);
+    }
+    while (rc == 0) {
+        if (verify_tick(par, part)) {
+            ckey->c_close(ckey);
+            return 0;
         }
-        while (rc == 0) {
-            nrecs++;
-            nrecs_progress++;
-
-            now = comdb2_time_epochms();
 
-            /* check if comdb2sc is killed */
-            if ((now - last) > 1000) {
-                if (dropped_connection(sb)) {
-                    cdata->c_close(cdata);
-                    logmsg(LOGMSG_WARN, "condb2sc connection closed, stopped verify\n");
-                    return rc;
-                }
-            }
-
-            if (progress_report_seconds &&
-                ((now - last) >= (progress_report_seconds * 1000))) {
-                locprint(sb, lua_callback, lua_params,
-                    "!verifying index %d, did %lld records, %d per second\n",
-                    ix, nrecs, (int)(nrecs_progress / progress_report_seconds));
-                last = now;
-                nrecs_progress = 0;
-                sbuf2flush(sb);
-            }
-
-            if (dbt_data.size < sizeof(unsigned long long)) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params,
-                         "!ix %d unexpected length %d\n", dbt_data.size);
-                goto next_key;
-            }
-            memcpy(&genid, dbt_data.data, sizeof(unsigned long long));
+        if (dbt_data.size < sizeof(unsigned long long)) {
+            verify_error(par, "!ix %d unexpected length %d\n", ix,
+                         dbt_data.size);
+            goto next_key;
+        }
+        memcpy(&genid, dbt_data.data, sizeof(unsigned long long));
 
 #ifdef _LINUX_SOURCE
-            buf_put(&genid, sizeof(unsigned long long),
-                    (uint8_t *)&genid_flipped,
-                    (uint8_t *)&genid_flipped + sizeof(unsigned long long));
+        buf_put(&genid, sizeof(unsigned long long), (uint8_t *)&genid_flipped,
+                (uint8_t *)&genid_flipped + sizeof(unsigned long long));
 #else
-            genid_flipped = genid;
+        genid_flipped = genid;
 #endif
 
-            /* make sure the data entry exists: */
-            db = get_dbp_from_genid(bdb_state, 0, genid, NULL);
-            rc = db->paired_cursor_from_lid(db, lid, &cdata, 0);
+        /* make sure the data entry exists: */
+        db = get_dbp_from_genid(bdb_state, 0, genid, NULL);
+        rc = db->paired_cursor_from_lid(db, lid, &cdata, 0);
+        if (rc) {
+            verify_error(par, "!%016llx ix %d rc %d\n", genid_flipped, ix, rc);
+            goto next_key;
+        }
+        rc = bdb_cget_unpack(bdb_state, cdata, &dbt_dta_check_key,
+                             &dbt_dta_check_data, &ver, DB_SET);
+        cdata->c_close(cdata);
+        if (rc == DB_NOTFOUND) {
+            char hex[512];
+            tohex(hex, sizeof(hex), dbt_key.data, dbt_key.size);
+            verify_error(par, "!%016llx ix %d orphaned %s\n", genid_flipped,
+                         ix, hex);
+            goto next_key;
+        } else if (rc) {
+            verify_error(par, "!%016llx ix %d dta rc %d\n", genid_flipped, ix,
+                         rc);
+            goto next_key;
+        }
+
+        par->vtag_callback(callback_parm, dbt_dta_check_data.data, &keylen,
+                           ver);
+        if (gbl_expressions_indexes &&
+            is_comdb2_index_expression(bdb_state->name)) {
+            /* indexes expressions may need blobs */
+            rc = par->get_blob_sizes_callback(callback_parm,
+                                              dbt_dta_check_data.data,
+                                              blobsizes, bloboffs, &nblobs);
             if (rc) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!%016llx ix %d rc %d\n", genid_flipped, ix,
-                            rc);
-                goto next_key;
-            }
-            rc = bdb_cget_unpack(bdb_state, cdata, &dbt_dta_check_key,
-                                 &dbt_dta_check_data, &ver, DB_SET);
-            if (rc == DB_NOTFOUND) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!%016llx ix %d orphaned ", genid_flipped, ix);
-                printhex(sb, lua_callback, lua_params, dbt_key.data, dbt_key.size);
-                locprint(sb, lua_callback, lua_params, "\n");
+                locprint(par, "!%016llx blob size rc %d\n", genid, rc);
+            } else {
+                /* verify blobs */
+                for (blobno = 0; blobno < nblobs; blobno++) {
+                    DBC *cblob;
+                    DB *blobdb;
+                    unsigned long long blob_genid = genid;
+                    int dtafile;
 
-                goto next_key;
-            } else if (rc) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!%016llx ix %d dta rc %d\n", genid_flipped, ix,
-                            rc);
-                goto next_key;
-            }
-            cdata->c_close(cdata);
+                    dtafile = get_dtafile_from_genid(genid);
+                    if (dtafile < 0) {
+                        locprint(par, "!%016llx unknown dtafile\n",
+                                 genid_flipped);
+                        continue;
+                    }
+                    blobdb =
+                        get_dbp_from_genid(bdb_state, blobno + 1, genid, NULL);
 
-            vtag_callback(callback_parm, dbt_dta_check_data.data, &keylen, ver);
-            if (gbl_expressions_indexes &&
-                is_comdb2_index_expression(bdb_state->name)) {
-                /* indexes expressions may need blobs */
-                rc = get_blob_sizes_callback(callback_parm,
-                                             dbt_dta_check_data.data, blobsizes,
-                                             bloboffs, &nblobs);
-                if (rc) {
-                    sbuf2printf(sb, "!%016llx blob size rc %d\n", genid, rc);
-                } else {
-                    /* verify blobs */
-                    int realblobsz[16];
-                    int had_errors, had_irrecoverable_errors;
-
-                    had_errors = 0;
-                    had_irrecoverable_errors = 0;
-                    for (blobno = 0; blobno < nblobs; blobno++) {
-                        DBC *cblob;
-                        DB *blobdb;
-                        unsigned long long blob_genid = genid;
-                        int dtafile;
-
-                        realblobsz[blobno] = -1;
-                        had_irrecoverable_errors = 0;
-                        had_errors = 0;
-
-                        dtafile = get_dtafile_from_genid(genid);
-                        if (dtafile < 0) {
-                            sbuf2printf(sb, "!%016llx unknown dtafile\n",
-                                        genid_flipped);
-                            continue;
-                        }
-                        blobdb = get_dbp_from_genid(bdb_state, blobno + 1,
-                                                    genid, NULL);
+                    rc = blobdb->paired_cursor_from_lid(blobdb, lid, &cblob,
+                                                        0);
+                    if (rc) {
+                        locprint(par, "!%016llx cursor on blob %d rc %d\n",
+                                 genid_flipped, blobno, rc);
+                        continue;
+                    }
 
-                        rc = blobdb->paired_cursor_from_lid(blobdb, lid, &cblob,
-                                                            0);
-                        if (rc) {
-                            sbuf2printf(sb,
-                                        "!%016llx cursor on blob %d rc %d\n",
-                                        genid_flipped, blobno, rc);
-                            continue;
-                        }
+                    /* Note: we have to fetch the whole blob here because
+                       with ondisk headers + compression
+                       the size of the blob will not match what's stored in
+                       the record so a partial find
+                       won't do.  I guess we could optimize for the more
+                       common case of no headers/compression. */
+                    dbt_blob_key.data = &blob_genid;
+                    dbt_blob_key.size = sizeof(unsigned long long);
+                    dbt_blob_data.flags = DB_DBT_MALLOC;
+                    dbt_blob_data.data = NULL;
 
-                        /* Note: we have to fetch the whole blob here because
-                           with ondisk headers + compression
-                           the size of the blob will not match what's stored in
-                           the record so a partial find
-                           won't do.  I guess we could optimize for the more
-                           common case of no headers/compression. */
-                        dbt_blob_key.data = &blob_genid;
-                        dbt_blob_key.size = sizeof(unsigned long long);
-                        dbt_blob_data.flags = DB_DBT_MALLOC;
-                        dbt_blob_data.data = NULL;
-
-                        rc = bdb_cget_unpack_blob(bdb_state, cblob,
-                                                  &dbt_blob_key, &dbt_blob_data,
-                                                  &ver, DB_SET);
-                        if (rc == DB_NOTFOUND) {
-                            realblobsz[blobno] = -1;
-                            if (blobsizes[blobno] != -1 &&
-                                blobsizes[blobno] != -2) {
-                                had_errors = 1;
-                                sbuf2printf(sb, "!%016llx no blob %d found "
-                                                "expected sz %d\n",
-                                            genid_flipped, blobno,
-                                            blobsizes[blobno]);
-                            }
-                        } else if (rc) {
-                            had_irrecoverable_errors = 1;
-                            sbuf2printf(sb, "!%016llx blob %d rc %d\n",
-                                        genid_flipped, blobno, rc);
-                            had_errors = 1;
+                    rc = bdb_cget_unpack_blob(bdb_state, cblob, &dbt_blob_key,
+                                              &dbt_blob_data, &ver, DB_SET);
+                    if (rc == DB_NOTFOUND) {
+                        if (blobsizes[blobno] != -1 &&
+                            blobsizes[blobno] != -2) {
+                            locprint(par, "!%016llx no blob %d found "
+                                          "expected sz %d\n",
+                                     genid_flipped, blobno, blobsizes[blobno]);
                         }
+                    } else if (rc) {
+                        locprint(par, "!%016llx blob %d rc %d\n",
+                                 genid_flipped, blobno, rc);
+                    }
 
-                        if (rc == 0) {
-                            realblobsz[blobno] = dbt_blob_data.size;
-                            if (blobsizes[blobno] == -1 && rc != DB_NOTFOUND) {
-                                sbuf2printf(
-                                    sb,
-                                    "!%016llx blob %d null but found blob\n",
-                                    genid_flipped, blobno);
-                            } else if (blobsizes[blobno] == -2) {
-                                sbuf2printf(
-                                    sb, "!%016llx blob %d size %d expected "
-                                        "none (inline vutf8)\n",
-                                    genid_flipped, blobno, realblobsz[blobno]);
-                            } else if (blobsizes[blobno] != -1 &&
-                                       dbt_blob_data.size !=
-                                           blobsizes[blobno]) {
-                                sbuf2printf(sb, "!%016llx blob %d size "
-                                                "mismatch got %d expected %d\n",
-                                            genid_flipped, blobno,
-                                            dbt_blob_data.size,
-                                            blobsizes[blobno]);
-                                had_errors = 1;
-                            }
-
-                            if (blobsizes[blobno] >= 0 &&
-                                realblobsz[blobno] >= 0) {
-                                rc = add_blob_buffer_callback(
-                                    callback_blob_buf, dbt_blob_data.data,
-                                    dbt_blob_data.size, blobno);
-                                if (rc)
-                                    return rc;
-                            }
+                    if (rc == 0) {
+                        if (blobsizes[blobno] == -1) {
+                            locprint(par,
+                                     "!%016llx blob %d null but found blob\n",
+                                     genid_flipped, blobno);
+                        } else if (blobsizes[blobno] == -2) {
+                            locprint(par, "!%016llx blob %d size %d expected "
+                                          "none (inline vutf8)\n",
+                                     genid_flipped, blobno,
+                                     dbt_blob_data.size);
+                        } else if (dbt_blob_data.size != blobsizes[blobno]) {
+                            locprint(par, "!%016llx blob %d size "
+                                          "mismatch got %d expected %d\n",
+                                     genid_flipped, blobno,
+                                     dbt_blob_data.size, blobsizes[blobno]);
+                        }
 
-                            if (dbt_blob_data.data && had_errors == 0)
+                        if (blobsizes[blobno] >= 0) {
+                            rc = par->add_blob_buffer_callback(
+                                callback_blob_buf, dbt_blob_data.data,
+                                dbt_blob_data.size, blobno);
+                            if (rc) {
                                 free(dbt_blob_data.data);
+                                cblob->c_close(cblob);
+                                ckey->c_close(ckey);
+                                return rc;
+                            }
                         }
-                        cblob->c_close(cblob);
+
+                        free(dbt_blob_data.data);
                     }
+                    cblob->c_close(cblob);
                 }
             }
+        }
 
-            rc = formkey_callback(callback_parm, dbt_dta_check_data.data,
-                                  callback_blob_buf, ix, expected_keybuf,
-                                  &keylen);
-            free_blob_buffer_callback(callback_blob_buf);
+        rc = par->formkey_callback(callback_parm, dbt_dta_check_data.data,
+                                   callback_blob_buf, ix, expected_keybuf,
+                                   &keylen);
+        par->free_blob_buffer_callback(callback_blob_buf);
 
-            if (dbt_key.size < keylen) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!%016llx ix %d key size %d < formed key %d\n",
-                            genid_flipped, ix, dbt_key.size, keylen);
-                goto next_key;
+        if (dbt_key.size < keylen) {
+            verify_error(par, "!%016llx ix %d key size %d < formed key %d\n",
+                         genid_flipped, ix, dbt_key.size, keylen);
+            goto next_key;
+        }
+
+        if (memcmp(expected_keybuf, dbt_key.data, keylen)) {
+            verify_error(par, "!%016llx ix %d key mismatch\n", genid_flipped,
+                         ix);
+            goto next_key;
+        }
+
+        if (bdb_state->ixdups[ix])
+            keylen += sizeof(unsigned long long);
+        if (keylen != dbt_key.size) {
+            verify_error(par,
+                         "!%016llx ix %d key size mismatch expected %d got %d\n",
+                         genid_flipped, ix, keylen, dbt_key.size);
+            goto next_key;
+        }
+
+        unsigned long long genid_left, genid_right, masked_genid;
+
+        if (bdb_state->ixdta[ix]) {
+            /*  if dtacopy, does data payload in the key match the data
+             * payload in the dta file? */
+            int expected_size;
+            uint8_t *expected_data;
+            uint8_t datacopy_buffer[bdb_state->lrl];
+            if (bdb_state->datacopy_odh) {
+                int odhlen;
+                unpack_index_odh(bdb_state, &dbt_data, &genid_right,
+                                 datacopy_buffer, sizeof(datacopy_buffer),
+                                 &odhlen, &ver);
+                par->vtag_callback(callback_parm, datacopy_buffer,
+                                   &expected_size, ver);
+                expected_data = datacopy_buffer;
+            } else {
+                expected_size = dbt_data.size - sizeof(genid);
+                expected_data = (uint8_t *)dbt_data.data + sizeof(genid);
+                memcpy(&genid_right, (uint8_t *)dbt_data.data, sizeof(genid));
             }
 
-            if (memcmp(expected_keybuf, dbt_key.data, keylen)) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "!%016llx ix %d key mismatch\n", genid_flipped,
-                            ix);
+            if (expected_size != bdb_state->lrl) {
+                verify_error(par, "!%016llx ix %d dtacpy payload wrong size "
+                                  "expected %d got %d\n",
+                             genid_flipped, ix, bdb_state->lrl, expected_size);
                 goto next_key;
             }
 
-            if (bdb_state->ixdups[ix])
-                keylen += sizeof(unsigned long long);
-            if (keylen != dbt_key.size) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params,
-                    "!%016llx ix %d key size mismatch expected %d got %d\n",
-                    genid_flipped, ix, keylen, dbt_key.size);
+            if (memcmp(expected_data, dbt_dta_check_data.data,
+                       bdb_state->lrl)) {
+                verify_error(par, "!%016llx ix %d dtacpy data mismatch\n",
+                             genid_flipped, ix);
                 goto next_key;
             }
 
-            unsigned long long genid_left, genid_right, masked_genid;
-
-            if (bdb_state->ixdta[ix]) {
-                /*  if dtacopy, does data payload in the key match the data
-                 * payload in the dta file? */
-                int expected_size;
-                uint8_t *expected_data;
-                uint8_t datacopy_buffer[bdb_state->lrl];
-                if (bdb_state->datacopy_odh) {
-                    int odhlen;
-                    unpack_index_odh(bdb_state, &dbt_data, &genid_right,
-                                     datacopy_buffer, sizeof(datacopy_buffer),
-                                     &odhlen, &ver);
-                    vtag_callback(callback_parm, datacopy_buffer,
-                                  &expected_size, ver);
-                    expected_data = datacopy_buffer;
-                } else {
-                    expected_size = dbt_data.size - sizeof(genid);
-                    expected_data = (uint8_t *)dbt_data.data + sizeof(genid);
-                    memcpy(&genid_right, (uint8_t *)dbt_data.data,
-                           sizeof(genid));
-                }
-
-                if (expected_size != bdb_state->lrl) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx ix %d dtacpy payload wrong size "
-                                    "expected %d got %d\n",
-                                genid_flipped, ix, bdb_state->lrl,
-                                expected_size);
-                    goto next_key;
-                }
-
-                if (memcmp(expected_data, dbt_dta_check_data.data,
-                           bdb_state->lrl)) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx ix %d dtacpy data mismatch\n",
-                                genid_flipped, ix);
-                    goto next_key;
-                }
-
-            } else if (bdb_state->ixcollattr[ix]) {
-                if (dbt_data.size != (sizeof(unsigned long long) +
-                                      4 * bdb_state->ixcollattr[ix])) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params,
-                             "!%016llx ix %d decimal payload wrong size "
-                             "expected %d got %d\n",
+        } else if (bdb_state->ixcollattr[ix]) {
+            if (dbt_data.size !=
+                (sizeof(unsigned long long) + 4 * bdb_state->ixcollattr[ix])) {
+                verify_error(par, "!%016llx ix %d decimal payload wrong size "
+                                  "expected %d got %d\n",
                              genid_flipped, ix,
-                             sizeof(unsigned long long) +
-                                 4 * bdb_state->ixcollattr[ix],
+                             (int)(sizeof(unsigned long long) +
+                                   4 * bdb_state->ixcollattr[ix]),
                              dbt_data.size);
-                    goto next_key;
-                }
-                memcpy(&genid_right, (uint8_t *)dbt_data.data, sizeof(genid));
-            } else {
-                if (dbt_data.size != sizeof(unsigned long long)) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params,
-                        "!%016llx ix %d payload wrong size expected 8 got %d\n",
-                        genid_flipped, ix, dbt_data.size);
-                    goto next_key;
-                }
-                memcpy(&genid_right, (uint8_t *)dbt_data.data, sizeof(genid));
+                goto next_key;
             }
-
-            if (bdb_state->ixdups[ix]) {
-                memcpy(&genid_left, (uint8_t *)dbt_key.data + keylen - 8,
-                       sizeof(genid_left));
-                masked_genid = get_search_genid(bdb_state, genid);
-                if (memcmp(&genid_left, &masked_genid, sizeof(genid))) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx ix %d dupe key genid != dta "
-                                    "genid %016llx (%016llx)\n",
-                                genid_left, ix, masked_genid, genid);
-                }
+            memcpy(&genid_right, (uint8_t *)dbt_data.data, sizeof(genid));
+        } else {
+            if (dbt_data.size != sizeof(unsigned long long)) {
+                verify_error(
+                    par, "!%016llx ix %d payload wrong size expected 8 got %d\n",
+                    genid_flipped, ix, dbt_data.size);
+                goto next_key;
             }
+            memcpy(&genid_right, (uint8_t *)dbt_data.data, sizeof(genid));
+        }
 
-            if (memcmp(&genid_right, &genid, sizeof(genid))) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params,
-                    "!%016llx ix %d dupe key genid != dta genid %016llx\n",
-                    genid_right, ix, genid);
+        if (bdb_state->ixdups[ix]) {
+            memcpy(&genid_left, (uint8_t *)dbt_key.data + keylen - 8,
+                   sizeof(genid_left));
+            masked_genid = get_search_genid(bdb_state, genid);
+            if (memcmp(&genid_left, &masked_genid, sizeof(genid))) {
+                verify_error(par, "!%016llx ix %d dupe key genid != dta "
+                                  "genid %016llx (%016llx)\n",
+                             genid_left, ix, masked_genid, genid);
             }
-
-        next_key:
-            rc = ckey->c_get(ckey, &dbt_key, &dbt_data, DB_NEXT);
-        }
-        if (rc && rc != DB_NOTFOUND) {
-            ret = 1;
-            locprint(sb, lua_callback, lua_params, "!ix %d first rc %d\n", ix, rc);
         }
-        rc = ckey->c_close(ckey);
-        if (rc) {
-            ret = 1;
-            locprint(sb, lua_callback, lua_params, "!%016llx ix %d close cursor rc %d\n", genid, ix,
-                        rc);
+
+        if (memcmp(&genid_right, &genid, sizeof(genid))) {
+            verify_error(par,
+                         "!%016llx ix %d dupe key genid != dta genid %016llx\n",
+                         genid_right, ix, genid);
         }
-    }
 
-    /* scan 3: scan each blob, verify data exists */
-    for (blobno = 0; blobno < nblobs; blobno++) {
-        for (dtastripe = 0; dtastripe < bdb_state->attr->blobstripe;
-             dtastripe++) {
-            db = bdb_state->dbp_data[blobno + 1][dtastripe];
-
-            if (!db) {
-                ret = 1;
-                locprint(sb, lua_callback, lua_params, "incorrect number of blobs? blob index %d "
-                                "stripe %d has no DB\n",
-                            blobno, dtastripe);
-                continue;
-            }
+    next_key:
+        rc = ckey->c_get(ckey, &dbt_key, &dbt_data, DB_NEXT);
+    }
+    if (rc && rc != DB_NOTFOUND) {
+        verify_error(par, "!ix %d next rc %d\n", ix, rc);
+    }
+    rc = ckey->c_close(ckey);
+    if (rc) {
+        verify_error(par, "!ix %d close cursor rc %d\n", ix, rc);
+    }
+    return 0;
+}
 
-            rc = db->paired_cursor_from_lid(db, lid, &cblob, 0);
-            if (rc) {
-                logmsg(LOGMSG_ERROR, "dtastripe %d blobno %d cursor rc %d\n", dtastripe,
-                       blobno, rc);
-                continue;
-            }
+/* scan 3: scan a blob file, verify data exists */
+static int verify_blob(verify_common_t *par, verify_part_t *part,
+                       unsigned int lid)
+{
+    bdb_state_type *bdb_state = par->bdb_state;
+    int blobno = part->num;
+    int dtastripe = part->stripe;
+    int striped = bdb_get_datafile_num_files(bdb_state, blobno + 1) > 1;
+    DBC *cdata = NULL;
+    DBC *cblob;
+    DB *db;
+    DBT dbt_data = {0};
+    DBT dbt_key = {0};
+    DBT dbt_dta_check_key = {0}, dbt_dta_check_data = {0};
+    unsigned long long genid;
+    char dumbuf;
+    int rc;
 
-            dbt_key.ulen = dbt_key.size = sizeof(unsigned long long);
-            dbt_key.data = &genid;
-            dbt_key.flags = DB_DBT_USERMEM;
-            dbt_data.data = &dumbuf;
-            dbt_data.ulen = 1;
-            dbt_data.doff = 0;
-            dbt_data.dlen = 0;
-            dbt_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+    db = bdb_state->dbp_data[blobno + 1][dtastripe];
+    if (!db) {
+        verify_error(par, "incorrect number of blobs? blob index %d "
+                          "stripe %d has no DB\n",
+                     blobno, dtastripe);
+        return 0;
+    }
 
-            dbt_dta_check_key.ulen = sizeof(int);
-            dbt_dta_check_key.data = &genid;
-            dbt_dta_check_key.flags = DB_DBT_USERMEM;
-            dbt_dta_check_data.data = &dumbuf;
-            dbt_dta_check_data.ulen = 1;
-            dbt_dta_check_data.doff = 0;
-            dbt_dta_check_data.dlen = 0;
-            dbt_dta_check_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+    rc = db->paired_cursor_from_lid(
+        db, lid, &cblob,
+        par->page_order ? (DB_PAGE_ORDER | DB_DISCARD_PAGES) : 0);
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "dtastripe %d blobno %d cursor rc %d\n",
+               dtastripe, blobno, rc);
+        return 0;
+    }
 
-            rc = cblob->c_get(cblob, &dbt_key, &dbt_data, DB_FIRST);
-            while (rc == 0) {
-                int stripe;
-                unsigned long long genid_flipped;
+    dbt_key.ulen = dbt_key.size = sizeof(unsigned long long);
+    dbt_key.data = &genid;
+    dbt_key.flags = DB_DBT_USERMEM;
+    dbt_data.data = &dumbuf;
+    dbt_data.ulen = 1;
+    dbt_data.doff = 0;
+    dbt_data.dlen = 0;
+    dbt_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+
+    dbt_dta_check_key.ulen = dbt_dta_check_key.size =
+        sizeof(unsigned long long);
+    dbt_dta_check_key.data = &genid;
+    dbt_dta_check_key.flags = DB_DBT_USERMEM;
+    dbt_dta_check_data.data = &dumbuf;
+    dbt_dta_check_data.ulen = 1;
+    dbt_dta_check_data.doff = 0;
+    dbt_dta_check_data.dlen = 0;
+    dbt_dta_check_data.flags = DB_DBT_USERMEM | DB_DBT_PARTIAL;
+
+    rc = cblob->c_get(cblob, &dbt_key, &dbt_data, DB_FIRST);
+    while (rc == 0) {
+        int stripe;
+        unsigned long long genid_flipped;
+
+        if (verify_tick(par, part)) {
+            cblob->c_close(cblob);
+            return 0;
+        }
 
 #ifdef _LINUX_SOURCE
-                buf_put(&genid, sizeof(unsigned long long),
-                        (uint8_t *)&genid_flipped,
-                        (uint8_t *)&genid_flipped + sizeof(unsigned long long));
+        buf_put(&genid, sizeof(unsigned long long), (uint8_t *)&genid_flipped,
+                (uint8_t *)&genid_flipped + sizeof(unsigned long long));
 #else
-                genid_flipped = genid;
+        genid_flipped = genid;
 #endif
 
-                stripe = get_dtafile_from_genid(genid);
-
-                if (!bdb_state->blobstripe_convert_genid ||
-                    bdb_check_genid_is_newer(
-                        bdb_state, genid,
-                        bdb_state->blobstripe_convert_genid)) {
-                    /* verify blobstripe and datastripe is the same */
-                    if (dtastripe != stripe)
-                        locprint(sb, lua_callback, lua_params,
-                                 "!%016llx blobstripe %d != datastripe %d\n",
-                                 genid_flipped, dtastripe, stripe);
-                }
+        stripe = get_dtafile_from_genid(genid);
 
-                rc = bdb_state->dbp_data[0][stripe]->paired_cursor_from_lid(
-                    bdb_state->dbp_data[0][stripe], lid, &cdata, 0);
-                if (rc) {
-                    logmsg(LOGMSG_ERROR, "dtastripe %d genid %016llx cursor rc %d\n", stripe,
-                           genid_flipped, rc);
-                    rc = cblob->c_get(cblob, &dbt_key, &dbt_data, DB_NEXT);
-                    continue;
-                }
-                rc = cdata->c_get(cdata, &dbt_dta_check_key,
-                                  &dbt_dta_check_data, DB_SET);
-                if (rc == DB_NOTFOUND) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx orphaned blob\n", genid_flipped);
-                }
-                else if (rc) {
-                    ret = 1;
-                    locprint(sb, lua_callback, lua_params, "!%016llx get rc %d\n", genid_flipped, rc);
-                }
+        if (striped && (!bdb_state->blobstripe_convert_genid ||
+                        bdb_check_genid_is_newer(
+                            bdb_state, genid,
+                            bdb_state->blobstripe_convert_genid))) {
+            /* verify blobstripe and datastripe is the same */
+            if (dtastripe != stripe)
+                locprint(par, "!%016llx blobstripe %d != datastripe %d\n",
+                         genid_flipped, dtastripe, stripe);
+        }
 
-                rc = cdata->c_close(cdata);
-                if (rc)
-                    logmsg(LOGMSG_ERROR, "close rc %d\n", rc);
+        rc = bdb_state->dbp_data[0][stripe]->paired_cursor_from_lid(
+            bdb_state->dbp_data[0][stripe], lid, &cdata, 0);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "dtastripe %d genid %016llx cursor rc %d\n",
+                   stripe, genid_flipped, rc);
+            rc = cblob->c_get(cblob, &dbt_key, &dbt_data, DB_NEXT);
+            continue;
+        }
+        rc = cdata->c_get(cdata, &dbt_dta_check_key, &dbt_dta_check_data,
+                          DB_SET);
+        if (rc == DB_NOTFOUND) {
+            verify_error(par, "!%016llx orphaned blob\n", genid_flipped);
+        } else if (rc) {
+            verify_error(par, "!%016llx get rc %d\n", genid_flipped, rc);
+        }
 
-                rc = cblob->c_get(cblob, &dbt_key, &dbt_data, DB_NEXT);
-            }
-            if (rc != DB_NOTFOUND)
-                logmsg(LOGMSG_ERROR, "fetch blob rc %d\n", rc);
+        rc = cdata->c_close(cdata);
+        if (rc)
+            logmsg(LOGMSG_ERROR, "close rc %d\n", rc);
 
-            cblob->c_close(cblob);
+        rc = cblob->c_get(cblob, &dbt_key, &dbt_data, DB_NEXT);
+    }
+    if (rc != DB_NOTFOUND)
+        logmsg(LOGMSG_ERROR, "fetch blob rc %d\n", rc);
+
+    cblob->c_close(cblob);
+    return 0;
+}
+
+/* Take parts off the queue until there are none left, or verify stops. */
+static void verify_parts(verify_common_t *par, void *blob_buf)
+{
+    bdb_state_type *bdb_state = par->bdb_state;
+    DB_LOCKREQ rq = {0};
+    verify_part_t *part;
+    unsigned int lid;
+    int rc;
+
+    if ((rc = bdb_state->dbenv->lock_id_flags(bdb_state->dbenv, &lid,
+                                              DB_LOCK_ID_READONLY)) != 0) {
+        logmsg(LOGMSG_ERROR, "%s: error getting a lockid, %d\n", __func__, rc);
+        pthread_mutex_lock(&par->lk);
+        if (par->rc == 0)
+            par->rc = rc;
+        par->stop = 1;
+        pthread_mutex_unlock(&par->lk);
+        return;
+    }
+
+    for (;;) {
+        pthread_mutex_lock(&par->lk);
+        if (par->stop || par->next_part >= par->nparts) {
+            pthread_mutex_unlock(&par->lk);
+            break;
+        }
+        part = &par->parts[par->next_part++];
+        pthread_mutex_unlock(&par->lk);
+
+        switch (part->type) {
+        case VERIFY_DATA:
+            rc = verify_dtastripe(par, part, blob_buf, lid);
+            break;
+        case VERIFY_INDEX:
+            rc = verify_index(par, part, blob_buf, lid);
+            break;
+        default:
+            rc = verify_blob(par, part, lid);
+            break;
         }
+
+        pthread_mutex_lock(&par->lk);
+        verify_merge(par, part);
+        par->parts_done++;
+        if (rc) {
+            if (par->rc == 0)
+                par->rc = rc;
+            par->stop = 1;
+        }
+        pthread_mutex_unlock(&par->lk);
     }
 
-    return ret;
+    rq.op = DB_LOCK_PUT_ALL;
+    bdb_state->dbenv->lock_vec(bdb_state->dbenv, lid, 0, &rq, 1, NULL);
+    bdb_state->dbenv->lock_id_free(bdb_state->dbenv, lid);
 }
@@ -44,6 +44,11 @@
 #include <plbitlib.h> /* for bset/btst */
 #include <logmsg.h>
 
+#include <build/db_int.h>
+#include "dbinc/db_page.h"
+#include <dbinc/db_am.h>
+#include "dbinc/log.h"
+
 #ifdef BERKDB_46
 
 #define DEADLOCK_RETRIES 100
@@ -274,3 +279,149 @@ for %d:%d\n",
 }
 */
 #endif
+
+/****** online defragmentation BEGIN ******/
+
+struct defrag_walk {
+    bdb_state_type *bdb_state;
+    int32_t fileid;
+    double tgtff;
+    bdb_defrag_tick_t tick;
+    void *arg;
+    unsigned nmerged;
+    int stopped; /* BDBERR_* that stopped the walk */
+};
+
+static int defrag_walk_tick(DB *db, void *arg)
+{
+    struct defrag_walk *w = arg;
+    bdb_state_type *bdb_state = w->bdb_state;
+
+    /* Don't hold up upgrades, downgrades and the like */
+    if (bdb_lock_desired(bdb_state)) {
+        w->stopped = BDBERR_LOCK_DESIRED;
+        return -1;
+    }
+    if (w->tick && w->tick(w->arg, 1)) {
+        w->stopped = BDBERR_CALLBACK;
+        return -1;
+    }
+    return 0;
+}
+
+static int defrag_walk_compact(DB *db, DBT *key, void *arg)
+{
+    struct defrag_walk *w = arg;
+    int rc;
+
+    /* A merge rewrites the leaf, the sibling it absorbs and their parent */
+    if (w->tick && w->tick(w->arg, 3)) {
+        w->stopped = BDBERR_CALLBACK;
+        return -1;
+    }
+
+    /* Same logged, recoverable merge as the sparse page hints take */
+    rc = __dbenv_pgcompact(w->bdb_state->dbenv, w->fileid, key, w->tgtff,
+                           w->tgtff);
+    if (rc == 0)
+        w->nmerged++;
+    return 0;
+}
+
+/* Files of a table in the order bdb_defrag_file() numbers them: data
+ * stripes, then blob stripes, then indexes. */
+static DB *defrag_file_db(bdb_state_type *bdb_state, int fileno, char *name,
+                          int namelen)
+{
+    int bdberr, dtafile, nstripes;
+
+    for (dtafile = 0; dtafile < bdb_state->numdtafiles; dtafile++) {
+        nstripes = bdb_get_datafile_num_files(bdb_state, dtafile);
+        if (fileno < nstripes) {
+            bdb_get_data_filename(bdb_state, fileno, dtafile, name, namelen,
+                                  &bdberr);
+            return bdb_state->dbp_data[dtafile][fileno];
+        }
+        fileno -= nstripes;
+    }
+    if (fileno < bdb_state->numix) {
+        bdb_get_index_filename(bdb_state, fileno, name, namelen, &bdberr);
+        return bdb_state->dbp_ix[fileno];
+    }
+    return NULL;
+}
+
+/* Measure the leaf fill of file number fileno of a table and, if ff > 0,
+ * merge every leaf filled less than ff with its siblings until it is
+ * filled to tgtff. Pages are read in page order, at most npages of them
+ * (0 for all) starting at *pgno (0 for the first); *pgno is left where
+ * the next call should pick up, 0 once the whole file has been walked.
+ * The pages walked are added to fill and the merges to nmerged, so a
+ * caller can drop its locks between batches. tick is called with the
+ * number of pages about to be touched and stops the walk if it returns
+ * non-0 (bdberr BDBERR_CALLBACK). The walk also stops when somebody wants
+ * the bdb lock (bdberr BDBERR_LOCK_DESIRED). Past the last file, returns
+ * -1 with bdberr BDBERR_BADARGS. */
+int bdb_defrag_file(bdb_state_type *bdb_state, int fileno, double ff,
+                    double tgtff, unsigned *pgno, unsigned npages,
+                    bdb_defrag_tick_t tick, void *arg, char *name,
+                    int namelen, struct bdb_fill *fill, unsigned *nmerged,
+                    int *bdberr)
+{
+    struct defrag_walk w = {0};
+    db_pgno_t next = *pgno;
+    u_int32_t nleaf;
+    u_int64_t used, total;
+    DB *db;
+    int rc;
+
+    *bdberr = BDBERR_NOERROR;
+
+    BDB_READLOCK("bdb_defrag_file");
+
+    db = defrag_file_db(bdb_state, fileno, name, namelen);
+    if (db == NULL) {
+        BDB_RELLOCK();
+        *bdberr = BDBERR_BADARGS;
+        return -1;
+    }
+
+    w.bdb_state = bdb_state;
+    w.tgtff = tgtff;
+    w.tick = tick;
+    w.arg = arg;
+    if (ff > 0) {
+        if (db->log_filename == NULL ||
+            db->log_filename->id == DB_LOGFILEID_INVALID) {
+            BDB_RELLOCK();
+            *bdberr = BDBERR_BADARGS;
+            return -1;
+        }
+        w.fileid = db->log_filename->id;
+    }
+
+    rc = __db_pgfill(db, ff, &next, npages, &nleaf, &used, &total,
+                     ff > 0 ? defrag_walk_compact : NULL, defrag_walk_tick,
+                     &w);
+
+    BDB_RELLOCK();
+
+    *pgno = next;
+    fill->nleaf += nleaf;
+    fill->used += used;
+    fill->total += total;
+    if (nmerged)
+        *nmerged += w.nmerged;
+
+    if (w.stopped) {
+        *bdberr = w.stopped;
+        return -1;
+    }
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "%s: %s rc %d\n", __func__, name, rc);
+        *bdberr = rc == DB_LOCK_DEADLOCK ? BDBERR_DEADLOCK : BDBERR_MISC;
+        return -1;
+    }
+    return 0;
+}
+/****** online defragmentation END ******/
@@ -8807,6 +8807,7 @@ static int bdb_cursor_collattrlen(bdb_cursor_ifn_t *cur)
 
 struct count_arg {
     DB *db;
+    u_int32_t flags;
     int64_t count;
     int rc;
 };
@@ -8828,7 +8829,7 @@ static void *db_count(void *varg)
 
     DB *db = arg->db;
     DBC *dbc;
-    if ((rc = db->cursor(db, NULL, &dbc, 0)) != 0) {
+    if ((rc = db->cursor(db, NULL, &dbc, arg->flags)) != 0) {
         arg->rc = rc;
         return NULL;
     }
@@ -8851,10 +8852,12 @@ static void *db_count(void *varg)
 }
 
 int gbl_parallel_count = 0;
+int gbl_page_order_count = 0;
 int bdb_direct_count(bdb_cursor_ifn_t *cur, int ixnum, int64_t *rcnt)
 {
     int64_t count = 0;
     int parallel_count;
+    u_int32_t flags = 0;
     bdb_state_type *state = cur->impl->state;
     DB **db;
     int stripes;
@@ -8874,10 +8877,16 @@ int bdb_direct_count(bdb_cursor_ifn_t *cur, int ixnum, int64_t *rcnt)
         stripes = 1;
         parallel_count = 0;
     }
+    /* Leaf pages are read in file order, so a fragmented btree is read
+     * sequentially instead of seeking for every page. */
+    if (gbl_page_order_count && state->attr->page_order_tablescan &&
+        !state->disable_page_order_tablescan)
+        flags = DB_PAGE_ORDER | DB_DISCARD_PAGES;
     struct count_arg args[stripes];
     pthread_t thds[stripes];
     for (int i = 0; i < stripes; ++i) {
         args[i].db = db[i];
+        args[i].flags = flags;
         if (parallel_count) {
             pthread_create(&thds[i], &attr, db_count, &args[i]);
         } else {
@@ -1691,6 +1691,56 @@ int bdb_handle_dbp_hash_stat_reset(bdb_state_type *bdb_state)
     return 0;
 }
 
+/* Start (szkb > 0) or stop keeping leaf page hints for point lookups on an
+ * index.  A running hash is kept as is; hints are only ever a shortcut.
+ * __bam_search reads dbp->ix_hash without a lock, so a hash that is turned
+ * off stays allocated until the handle closes, and is reused if it is turned
+ * back on. */
+void bdb_handle_dbp_ix_hash(bdb_state_type *bdb_state, int ixnum, int szkb)
+{
+    DB *dbp;
+
+    if (ixnum < 0 || ixnum >= bdb_state->numix)
+        return;
+    dbp = bdb_state->dbp_ix[ixnum];
+    if (dbp == NULL)
+        return;
+
+    if (szkb <= 0) {
+        if (dbp->ix_hash) {
+            dbp->ix_hash_off = dbp->ix_hash;
+            dbp->ix_hash = NULL;
+        }
+    } else if (dbp->ix_hash == NULL && dbp->ix_hash_off) {
+        dbp->ix_hash = dbp->ix_hash_off;
+        dbp->ix_hash_off = NULL;
+    } else if (dbp->ix_hash == NULL) {
+        dbp->ix_hash = key_hash_init(bdb_state->dbenv, szkb);
+        if (dbp->ix_hash == NULL)
+            logmsg(LOGMSG_ERROR, "%s: can't allocate %dkb hash for %s ix %d\n",
+                   __func__, szkb, bdb_state->name, ixnum);
+    }
+}
+
+void bdb_handle_dbp_ix_hash_stat(bdb_state_type *bdb_state)
+{
+    key_hash *hp;
+    key_hash_stat st;
+    int ix;
+
+    for (ix = 0; ix < bdb_state->numix; ix++) {
+        if (bdb_state->dbp_ix[ix] == NULL ||
+            (hp = bdb_state->dbp_ix[ix]->ix_hash) == NULL)
+            continue;
+        key_hash_stat_sum(hp, &st);
+        logmsg(LOGMSG_USER,
+               "table %s ix %d entries %u lookups %" PRIu64 " hits %" PRIu64
+               " stale %" PRIu64 "\n",
+               bdb_state->name, ix, hp->ntbl, st.n_lookup, st.n_hit,
+               st.n_stale);
+    }
+}
+
 int bdb_close_env(bdb_state_type *bdb_state)
 {
     return bdb_close_int(bdb_state, 1);
@@ -1712,6 +1762,9 @@ void *watcher_thread(void *arg);
 void *checkpoint_thread(void *arg);
 void *logdelete_thread(void *arg);
 void *memp_trickle_thread(void *arg);
+void *log_prealloc_thread(void *arg);
+int __log_recycle(DB_ENV *, const char *);
+void *warm_cache_thread(void *arg);
 void *deadlockdetect_thread(void *arg);
 
 void make_lsn(DB_LSN *logseqnum, unsigned int filenum, unsigned int offsetnum)
@@ -2566,6 +2619,8 @@ static DB_ENV *dbenv_open(bdb_state_type *bdb_state)
     dbenv->set_num_recovery_processor_threads(dbenv,
                                               bdb_state->attr->rep_processors);
     dbenv->set_num_recovery_worker_threads(dbenv, bdb_state->attr->rep_workers);
+    extern int gbl_parallel_recovery_threads;
+    dbenv->set_num_recovery_redo_threads(dbenv, gbl_parallel_recovery_threads);
     dbenv->set_recovery_memsize(dbenv, bdb_state->attr->rep_memsize);
     dbenv->set_page_extent_size(dbenv, bdb_state->attr->page_extent_size);
     dbenv->set_comdb2_dirs(dbenv, bdb_state->dir, bdb_state->txndir,
@@ -3123,6 +3178,13 @@ again:
             logmsg(LOGMSG_DEBUG, "waiting for rep_verify to complete\n");
         }
 
+        /* an interrupted page catch-up left pages newer than our log */
+        while (bdb_state->dbenv->rep_pgcatchup_pending(bdb_state->dbenv)) {
+            sleep(1);
+            logmsg(LOGMSG_DEBUG, "waiting for the log to pass the pages of "
+                                 "a page catch-up\n");
+        }
+
         rc = net_send(bdb_state->repinfo->netinfo,
                       bdb_state->repinfo->master_host,
                       USER_TYPE_COMMITDELAYNONE, NULL, 0, 1);
@@ -3646,7 +3708,11 @@ low_headroom:
                                                  sb.st_mtime);
                 }
 
-                rc = unlink(logname);
+                /* keep it as a spare log file unless we need the space */
+                if (is_low_headroom)
+                    rc = unlink(logname);
+                else
+                    rc = __log_recycle(bdb_state->dbenv, logname);
                 if (rc != 0) {
                     logmsg(LOGMSG_ERROR, "delete_log_files: unlink for <%s>"
                                     " returned %d %d\n",
@@ -5575,6 +5641,25 @@ bdb_open_int(int envonly, const char name[], const char dir[], int lrl,
                 return NULL;
             }
 
+            /* keep spare log files ready for the log to move into */
+            rc = pthread_create(&dummy_tid, &(bdb_state->pthread_attr_detach),
+                                log_prealloc_thread, bdb_state);
+            if (rc != 0) {
+                logmsg(LOGMSG_ERROR, "unable to create log prealloc thread - "
+                                     "rc=%d errno=%d %s\n",
+                       rc, errno, strerror(errno));
+            }
+
+            /* reload the cache we had before we went down, and keep track
+               of what's in it from here on */
+            rc = pthread_create(&dummy_tid, &(bdb_state->pthread_attr_detach),
+                                warm_cache_thread, bdb_state);
+            if (rc != 0) {
+                logmsg(LOGMSG_ERROR, "unable to create warm cache thread - "
+                                     "rc=%d errno=%d %s\n",
+                       rc, errno, strerror(errno));
+            }
+
             /* create the deadlock detect thread if we arent doing auto
                deadlock detection */
             if (!bdb_state->attr->autodeadlockdetect) {
@@ -7224,6 +7309,21 @@ char *oldfile_list_rem(int *lognum)
     return ret;
 }
 
+/* Copy of the next file to purge, which stays on the list */
+static char *oldfile_list_peek(int *lognum)
+{
+    char *ret = NULL;
+
+    Pthread_mutex_lock(&of_list_mtx);
+    if (list_tl != list_hd) {
+        ret = strdup(of_list[list_tl].fname);
+        *lognum = of_list[list_tl].lognum;
+    }
+    Pthread_mutex_unlock(&of_list_mtx);
+
+    return ret;
+}
+
 int oldfile_list_empty(void)
 {
     int ret = 1;
@@ -7504,13 +7604,33 @@ int bdb_list_unused_files(bdb_state_type *bdb_state, int *bdberr, char *powner)
 
 int bdb_have_unused_files(void) { return oldfile_list_empty() != 1; }
 
-int bdb_purge_unused_files(bdb_state_type *bdb_state, tran_type *tran,
-                           int *bdberr)
+/* Unlinking a large file can stall the filesystem while all its extents are
+ * freed.  The file is not referenced anymore, so free its tail a chunk at a
+ * time, pausing in between, and unlink what is left. */
+static void bdb_shrink_unused_file(bdb_state_type *bdb_state, const char *path,
+                                   off_t size)
 {
-    char *munged_name = NULL;
-    int rc;
-    unsigned lognum = 0, lowfilenum = 0;
-    struct stat sb;
+    off_t chunk = (off_t)bdb_state->attr->oldfile_truncate_chunk * 1024 * 1024;
+    int pausems = bdb_state->attr->oldfile_truncate_pause;
+
+    while (size > chunk) {
+        size -= chunk;
+        if (truncate(path, size)) {
+            logmsg(LOGMSG_ERROR, "%s: truncate %s to %lld errno %d\n",
+                   __func__, path, (long long)size, errno);
+            return;
+        }
+        if (pausems > 0)
+            poll(NULL, 0, pausems);
+    }
+}
+
+/* Lowest log file still needed by the cluster; files removed in later logs
+ * have to be kept around */
+static int oldfile_lowfilenum(bdb_state_type *bdb_state, unsigned *lowfilenum,
+                              int *bdberr)
+{
+    *lowfilenum = 0;
 
     if (bdb_state->attr->keep_referenced_files) {
         int ourlowfilenum;
@@ -7518,15 +7638,140 @@ int bdb_purge_unused_files(bdb_state_type *bdb_state, tran_type *tran,
         /* if there's no cluster, use our log file, otherwise use the cluster
          * low watermark,
          * or our low watermark, whichever is lower */
-        lowfilenum = get_lowfilenum_sanclist(bdb_state);
+        *lowfilenum = get_lowfilenum_sanclist(bdb_state);
 
         ourlowfilenum = bdb_get_first_logfile(bdb_state, bdberr);
         if (ourlowfilenum == -1) return -1;
-        if (lowfilenum == 0) lowfilenum = ourlowfilenum;
+        if (*lowfilenum == 0) *lowfilenum = ourlowfilenum;
+
+        if (ourlowfilenum < *lowfilenum) *lowfilenum = ourlowfilenum;
+    }
+
+    return 0;
+}
 
-        if (ourlowfilenum < lowfilenum) lowfilenum = ourlowfilenum;
+/* Shrink the next file to purge ahead of the transaction that deletes it,
+ * so no locks are held while its extents are freed */
+void bdb_shrink_unused_files(bdb_state_type *bdb_state)
+{
+    char *munged_name;
+    char path[PATH_MAX];
+    unsigned lognum = 0, lowfilenum = 0;
+    struct stat sb;
+    int bdberr;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    if (bdb_state->attr->oldfile_truncate_chunk <= 0)
+        return;
+
+    if (oldfile_lowfilenum(bdb_state, &lowfilenum, &bdberr))
+        return;
+
+    munged_name = oldfile_list_peek((int *)&lognum);
+    if (!munged_name)
+        return;
+
+    bdb_trans(munged_name, path);
+    if ((!lognum || !lowfilenum || lognum < lowfilenum) && !stat(path, &sb))
+        bdb_shrink_unused_file(bdb_state, path, sb.st_size);
+
+    free(munged_name);
+}
+
+/* Files a replicant removed while applying the master's purge, kept under a
+ * second name in the tmp dir so that the apply thread only drops a link */
+struct removed_file {
+    char *path;
+    struct removed_file *next;
+};
+
+static struct removed_file *removed_files;
+static pthread_mutex_t removed_files_mtx = PTHREAD_MUTEX_INITIALIZER;
+
+/* Called from the replication apply of a file remove, before the file is
+ * unlinked. A file bigger than oldfile_truncate_chunk is linked into the tmp
+ * dir, and its extents are freed later by bdb_shrink_removed_files at the
+ * same pace as the master's. */
+void bdb_keep_removed_file(void *arg, const char *path)
+{
+    bdb_state_type *bdb_state = arg;
+    struct removed_file *f;
+    char tmppath[PATH_MAX];
+    const char *base;
+    struct stat sb;
+    off_t chunk;
+
+    if (bdb_state == NULL)
+        return;
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    chunk = (off_t)bdb_state->attr->oldfile_truncate_chunk * 1024 * 1024;
+    if (chunk <= 0 || stat(path, &sb) || sb.st_size <= chunk)
+        return;
+
+    base = strrchr(path, '/');
+    snprintf(tmppath, sizeof(tmppath), "%s/_removed_%s", bdb_state->tmpdir,
+             base ? base + 1 : path);
+    unlink(tmppath);
+    if (link(path, tmppath)) {
+        logmsg(LOGMSG_ERROR, "%s: link %s to %s errno %d\n", __func__, path,
+               tmppath, errno);
+        return;
     }
 
+    if ((f = malloc(sizeof(struct removed_file))) == NULL ||
+        (f->path = strdup(tmppath)) == NULL) {
+        free(f);
+        unlink(tmppath);
+        return;
+    }
+    Pthread_mutex_lock(&removed_files_mtx);
+    f->next = removed_files;
+    removed_files = f;
+    Pthread_mutex_unlock(&removed_files_mtx);
+}
+
+/* Shrink and unlink the files bdb_keep_removed_file held on to */
+void bdb_shrink_removed_files(bdb_state_type *bdb_state)
+{
+    struct removed_file *f;
+    struct stat sb;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    for (;;) {
+        Pthread_mutex_lock(&removed_files_mtx);
+        if ((f = removed_files) != NULL)
+            removed_files = f->next;
+        Pthread_mutex_unlock(&removed_files_mtx);
+        if (f == NULL)
+            break;
+
+        if (!stat(f->path, &sb))
+            bdb_shrink_unused_file(bdb_state, f->path, sb.st_size);
+        if (unlink(f->path))
+            logmsg(LOGMSG_ERROR, "%s: unlink %s errno %d\n", __func__,
+                   f->path, errno);
+        free(f->path);
+        free(f);
+    }
+}
+
+int bdb_purge_unused_files(bdb_state_type *bdb_state, tran_type *tran,
+                           int *bdberr)
+{
+    char *munged_name = NULL;
+    int rc;
+    unsigned lognum = 0, lowfilenum = 0;
+    struct stat sb;
+
+    if (oldfile_lowfilenum(bdb_state, &lowfilenum, bdberr))
+        return -1;
+
     *bdberr = 0;
 
     if (bdb_state->parent)
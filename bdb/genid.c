@@ -69,6 +69,8 @@ int gbl_block_set_commit_genid_trace = 0;
 static unsigned long long commit_genid;
 static DB_LSN commit_lsn;
 static uint32_t commit_generation;
+/* broadcast under gblcontext_lock when commit_lsn moves */
+static pthread_cond_t commit_lsn_cond = PTHREAD_COND_INITIALIZER;
 
 unsigned long long get_lowest_genid_for_datafile(int stripe)
 {
@@ -390,7 +392,10 @@ static inline void set_commit_genid_lsn_gen(bdb_state_type *bdb_state,
         return;
     }
     commit_genid = genid;
-    if (lsn) commit_lsn = *lsn;
+    if (lsn) {
+        commit_lsn = *lsn;
+        pthread_cond_broadcast(&commit_lsn_cond);
+    }
     if (generation) commit_generation = *generation;
 
     set_gblcontext_int(bdb_state, genid);
@@ -1073,7 +1078,70 @@ void bdb_set_commit_lsn_gen(bdb_state_type *bdb_state, const void *inlsn, uint32
     Pthread_mutex_lock(&(bdb_state->gblcontext_lock));
     commit_lsn = *lsn;
     commit_generation = gen;
+    pthread_cond_broadcast(&commit_lsn_cond);
+    Pthread_mutex_unlock(&(bdb_state->gblcontext_lock));
+}
+
+/* Wait up to timeout_ms for this node to apply commits up to file:offset.
+ * Returns 0 once it has, -1 on timeout.  Before the first commit is seen the
+ * current lsn comes from the log (see bdb_get_current_lsn), which nobody
+ * signals, so waits are sliced to look again now and then. */
+int bdb_wait_for_commit_lsn(bdb_state_type *bdb_state, unsigned int file,
+                            unsigned int offset, int timeout_ms)
+{
+    struct timespec deadline, slice;
+    unsigned int curfile, curoffset;
+    int rc = 0;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_sec += timeout_ms / 1000;
+    deadline.tv_nsec += (timeout_ms % 1000) * 1000000;
+    if (deadline.tv_nsec >= 1000000000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1000000000;
+    }
+
+    Pthread_mutex_lock(&(bdb_state->gblcontext_lock));
+    for (;;) {
+        if (commit_lsn.file == 0 || commit_lsn.offset == 1) {
+            Pthread_mutex_unlock(&(bdb_state->gblcontext_lock));
+            bdb_get_current_lsn(bdb_state, &curfile, &curoffset);
+            Pthread_mutex_lock(&(bdb_state->gblcontext_lock));
+        } else {
+            curfile = commit_lsn.file;
+            curoffset = commit_lsn.offset;
+        }
+        if (curfile > file || (curfile == file && curoffset >= offset)) {
+            rc = 0;
+            break;
+        }
+        if (rc == ETIMEDOUT) {
+            rc = -1;
+            break;
+        }
+
+        clock_gettime(CLOCK_REALTIME, &slice);
+        slice.tv_nsec += 100 * 1000000;
+        if (slice.tv_nsec >= 1000000000) {
+            slice.tv_sec++;
+            slice.tv_nsec -= 1000000000;
+        }
+        if (slice.tv_sec > deadline.tv_sec ||
+            (slice.tv_sec == deadline.tv_sec &&
+             slice.tv_nsec > deadline.tv_nsec))
+            slice = deadline;
+        rc = pthread_cond_timedwait(&commit_lsn_cond,
+                                    &(bdb_state->gblcontext_lock), &slice);
+        if (rc == ETIMEDOUT && slice.tv_sec == deadline.tv_sec &&
+            slice.tv_nsec == deadline.tv_nsec)
+            continue; /* one last look */
+        rc = 0;
+    }
     Pthread_mutex_unlock(&(bdb_state->gblcontext_lock));
+    return rc;
 }
 
 unsigned long long bdb_get_commit_genid(bdb_state_type *bdb_state, void *plsn)
@@ -132,10 +132,14 @@ static void txn_stats(FILE *out, bdb_state_type *bdb_state)
     free(stats);
 }
 
+extern void __db_mutex_class_stat_print(FILE *);
+extern int __db_mutex_bench(DB_ENV *, int, int, FILE *);
+
 static void log_stats(FILE *out, bdb_state_type *bdb_state)
 {
     DB_LOG_STAT *stats;
     char str[100];
+    int i;
 
     bdb_state->dbenv->log_stat(bdb_state->dbenv, &stats, 0);
 
@@ -169,6 +173,13 @@ static void log_stats(FILE *out, bdb_state_type *bdb_state)
     prn_stat(st_in_region_get);
     prn_stat(st_part_region_get);
     prn_stat(st_ondisk_get);
+    prn_stat(st_prealloc_used);
+    prn_stat(st_recycled);
+    for (i = 0; i < DB_LOG_FSYNC_BUCKETS - 1; i++)
+        logmsgf(LOGMSG_USER, out, "st_fsync_hist[<%uus]: %u\n", 32U << i,
+                stats->st_fsync_hist[i]);
+    logmsgf(LOGMSG_USER, out, "st_fsync_hist[>=%uus]: %u\n", 32U << i,
+            stats->st_fsync_hist[i]);
 
     if (bdb_state->attr->logsegments > 1) {
         prn_stat(st_wrap_copy);
@@ -1255,6 +1266,9 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
         "*logstat        - log stats", "*txnstat        - transaction stats",
         "*ltranstat      - logical transaction stats",
         "*lockstat       - lock subsystem stats",
+        "*mutexstat      - mutex contention by mutex class",
+        " mutexbench # # - time # threads taking a mutex # times each, "
+        "blocking and adaptive",
         " fulldiag       - dump loads of stuff - please use with f prefix",
         "*sanc           - list 'sanctioned' cluster members",
         " repdbg[yn]     - verbose replication yes/no",
@@ -1295,7 +1309,8 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
     static char *safecmds[] = {
         "bdbstat",  "cluster",   "cachestat", "repstat",     "logstat",
         "txnstat",  "ltranstat", "sanc",      "log_archive", "help",
-        "bdbstate", "lockstat",  "attr",      "bbstat",      "bdblockdump"};
+        "bdbstate", "lockstat",  "attr",      "bbstat",      "bdblockdump",
+        "mutexstat"};
 
     /* if we were passed a child, find his parent */
     if (bdb_state->parent)
@@ -1403,6 +1418,19 @@ void bdb_process_user_command(bdb_state_type *bdb_state, char *line, int lline,
         log_stats(out, bdb_state);
     else if (tokcmp(tok, ltok, "lockstat") == 0)
         lock_stats(out, bdb_state);
+    else if (tokcmp(tok, ltok, "mutexstat") == 0)
+        __db_mutex_class_stat_print(out);
+    else if (tokcmp(tok, ltok, "mutexbench") == 0) {
+        int nthreads, nops;
+        tok = segtok(line, lline, &st, &ltok);
+        nthreads = toknum(tok, ltok);
+        tok = segtok(line, lline, &st, &ltok);
+        nops = toknum(tok, ltok);
+        if (nops <= 0)
+            nops = 100000;
+        if (__db_mutex_bench(bdb_state->dbenv, nthreads, nops, out))
+            logmsgf(LOGMSG_USER, out, "usage: mutexbench <threads> [ops]\n");
+    }
     else if (tokcmp(tok, ltok, "lockinfo") == 0)
         lock_info(out, bdb_state, line, st, lline);
     else if (tokcmp(tok, ltok, "activelocks") == 0)
@@ -51,14 +51,151 @@
 
 #include <plbitlib.h> /* for bset/btst */
 #include <logmsg.h>
+#include <memory_sync.h>
+
+extern void __memp_count_mods(DB_MPOOLFILE *);
+extern u_int32_t __memp_mod_count(DB_MPOOLFILE *);
+
+/*
+ * Read cache for lite tables (llmeta).
+ *
+ * Exact fetches made outside a transaction are served from a fixed array of
+ * slots hashed on the key, including fetches of keys that aren't there.
+ * A slot is stamped with the file's page modification count as of just
+ * before the btree read that filled it, and is good only while the count
+ * hasn't moved, so any change to the file, local or replicated, drops the
+ * whole cache.  The count goes up while the changed page is still locked, so
+ * a reader that read the count after a change blocks on that lock and reads
+ * the new value.
+ *
+ * Readers take no locks: a slot's sequence number is odd while the slot is
+ * being refilled, and a reader that sees it move while copying the slot out
+ * goes to the btree instead.
+ */
+enum {
+    LITE_CACHE_SLOTS = 1024,
+    LITE_CACHE_MAXKEY = 128,
+    LITE_CACHE_MAXDTA = 256
+};
+
+struct lite_cache_slot {
+    volatile unsigned seq; /* 0 if never filled, odd while being filled */
+    u_int32_t gen;         /* mod count before the read that filled it */
+    int len;               /* -1 if the key isn't there */
+    unsigned char key[LITE_CACHE_MAXKEY];
+    unsigned char dta[LITE_CACHE_MAXDTA];
+};
+
+struct lite_cache {
+    pthread_mutex_t lk; /* serializes fills */
+    DB_MPOOLFILE *mpf;
+    int ixlen;
+    /* not protected, a count may get lost */
+    unsigned long long hits;
+    unsigned long long reads;
+    struct lite_cache_slot slots[LITE_CACHE_SLOTS];
+};
+
+int bdb_lite_cache_init(bdb_state_type *bdb_state)
+{
+    struct lite_cache *c;
+
+    if (bdb_state->ixlen[0] > LITE_CACHE_MAXKEY)
+        return -1;
+    if ((c = calloc(1, sizeof(struct lite_cache))) == NULL)
+        return -1;
+    pthread_mutex_init(&c->lk, NULL);
+    c->mpf = bdb_state->dbp_data[0][0]->mpf;
+    c->ixlen = bdb_state->ixlen[0];
+    __memp_count_mods(c->mpf);
+    bdb_state->lite_cache = c;
+    return 0;
+}
+
+void bdb_lite_cache_stats(bdb_state_type *bdb_state, unsigned long long *hits,
+                          unsigned long long *reads)
+{
+    struct lite_cache *c = bdb_state->lite_cache;
+    *hits = c ? c->hits : 0;
+    *reads = c ? c->reads : 0;
+}
+
+static struct lite_cache *lite_cache(bdb_state_type *bdb_state,
+                                     tran_type *tran)
+{
+    if (tran || bdb_state->lite_cache == NULL ||
+        !bdb_state->attr->llmeta_cache)
+        return NULL;
+    return bdb_state->lite_cache;
+}
+
+static struct lite_cache_slot *lite_cache_slot(struct lite_cache *c,
+                                               const unsigned char *key)
+{
+    unsigned h = 2166136261u;
+    for (int i = 0; i < c->ixlen; i++)
+        h = (h ^ key[i]) * 16777619u;
+    return &c->slots[h % LITE_CACHE_SLOTS];
+}
+
+/* Copy out a cached value that fits in maxlen.  Returns 1 on a hit, with
+ * *len -1 if the key isn't there. */
+static int lite_cache_get(struct lite_cache *c, const void *key, void *dta,
+                          int maxlen, int *len)
+{
+    struct lite_cache_slot *s = lite_cache_slot(c, key);
+    unsigned seq = s->seq;
+    int l;
+
+    if (seq == 0 || (seq & 1))
+        return 0;
+    MEMORY_SYNC;
+    if (s->gen != __memp_mod_count(c->mpf) || memcmp(s->key, key, c->ixlen))
+        return 0;
+    l = s->len;
+    if (l > maxlen || l > LITE_CACHE_MAXDTA)
+        return 0;
+    if (l > 0)
+        memcpy(dta, s->dta, l);
+    MEMORY_SYNC;
+    if (s->seq != seq)
+        return 0;
+
+    c->hits++;
+    *len = l;
+    return 1;
+}
+
+static void lite_cache_put(struct lite_cache *c, const void *key,
+                           u_int32_t gen, const void *dta, int len)
+{
+    struct lite_cache_slot *s = lite_cache_slot(c, key);
+
+    if (len > LITE_CACHE_MAXDTA || gen != __memp_mod_count(c->mpf))
+        return;
+
+    pthread_mutex_lock(&c->lk);
+    s->seq++;
+    MEMORY_SYNC;
+    s->gen = gen;
+    s->len = len;
+    memcpy(s->key, key, c->ixlen);
+    if (len > 0)
+        memcpy(s->dta, dta, len);
+    MEMORY_SYNC;
+    s->seq++;
+    pthread_mutex_unlock(&c->lk);
+}
 
 static int bdb_lite_exact_fetch_int(bdb_state_type *bdb_state, tran_type *tran,
                                     void *key, void *fnddta, int maxlen,
                                     int *fndlen, int *bdberr)
 {
-    int rc, outrc = 0, ixlen;
+    int rc, outrc = 0, ixlen, len;
     DBT dbt_key, dbt_data;
     DB_TXN *tid = NULL;
+    struct lite_cache *c;
+    u_int32_t gen = 0;
 
     *bdberr = BDBERR_NOERROR;
 
@@ -66,6 +203,19 @@ static int bdb_lite_exact_fetch_int(bdb_state_type *bdb_state, tran_type *tran,
         tid = tran->tid;
     }
 
+    if ((c = lite_cache(bdb_state, tran)) != NULL) {
+        if (lite_cache_get(c, key, fnddta, maxlen, &len)) {
+            if (len < 0) {
+                *bdberr = BDBERR_FETCH_DTA;
+                return -1;
+            }
+            *fndlen = len;
+            return 0;
+        }
+        gen = __memp_mod_count(c->mpf);
+        c->reads++;
+    }
+
     memset(&dbt_key, 0, sizeof(dbt_key));
     memset(&dbt_data, 0, sizeof(dbt_data));
 
@@ -90,8 +240,12 @@ static int bdb_lite_exact_fetch_int(bdb_state_type *bdb_state, tran_type *tran,
             (memcmp(dbt_key.data, key, ixlen) != 0)) {
             *bdberr = BDBERR_FETCH_DTA;
             outrc = -1;
+        } else if (c) {
+            lite_cache_put(c, key, gen, fnddta, *fndlen);
         }
     } else {
+        if (c && rc == DB_NOTFOUND)
+            lite_cache_put(c, key, gen, NULL, -1);
         bdb_get_error(bdb_state, tid, rc, BDBERR_FETCH_DTA, bdberr,
                       "bdb_lite_exact_fetch_int");
         outrc = -1;
@@ -177,9 +331,12 @@ static int bdb_lite_exact_var_fetch_int(bdb_state_type *bdb_state,
                                         tran_type *tran, void *key,
                                         void **fnddta, int *fndlen, int *bdberr)
 {
-    int rc, outrc = 0, ixlen;
+    int rc, outrc = 0, ixlen, len;
     DBT dbt_key, dbt_data;
     DB_TXN *tid = NULL;
+    struct lite_cache *c;
+    unsigned char buf[LITE_CACHE_MAXDTA];
+    u_int32_t gen = 0;
 
     *bdberr = BDBERR_NOERROR;
     *fndlen = 0;
@@ -189,6 +346,24 @@ static int bdb_lite_exact_var_fetch_int(bdb_state_type *bdb_state,
         tid = tran->tid;
     }
 
+    if ((c = lite_cache(bdb_state, tran)) != NULL) {
+        if (lite_cache_get(c, key, buf, sizeof(buf), &len)) {
+            if (len < 0) {
+                *bdberr = BDBERR_FETCH_DTA;
+                return -1;
+            }
+            if ((*fnddta = malloc(len ? len : 1)) == NULL) {
+                *bdberr = BDBERR_MALLOC;
+                return -1;
+            }
+            memcpy(*fnddta, buf, len);
+            *fndlen = len;
+            return 0;
+        }
+        gen = __memp_mod_count(c->mpf);
+        c->reads++;
+    }
+
     memset(&dbt_key, 0, sizeof(dbt_key));
     memset(&dbt_data, 0, sizeof(dbt_data));
 
@@ -214,8 +389,12 @@ static int bdb_lite_exact_var_fetch_int(bdb_state_type *bdb_state,
             outrc = -1;
         } else {
             *fnddta = dbt_data.data;
+            if (c)
+                lite_cache_put(c, key, gen, *fnddta, *fndlen);
         }
     } else {
+        if (c && rc == DB_NOTFOUND)
+            lite_cache_put(c, key, gen, NULL, -1);
         bdb_get_error(bdb_state, tid, rc, BDBERR_FETCH_DTA, bdberr,
                       "bdb_lite_exact_fetch_int");
         outrc = -1;
@@ -1257,6 +1257,9 @@ int bdb_llmeta_open(char name[], char dir[], bdb_state_type *parent_bdb_handle,
         llmeta_bdb_state = bdb_open_more_lite(name, dir, 0, LLMETA_IXLEN, 0,
                                               parent_bdb_handle, bdberr);
 
+    if (llmeta_bdb_state && bdb_lite_cache_init(llmeta_bdb_state))
+        logmsg(LOGMSG_WARN, "%s: can't cache llmeta\n", __func__);
+
     BDB_RELLOCK();
 
     if (llmeta_bdb_state)
@@ -1265,6 +1268,15 @@ int bdb_llmeta_open(char name[], char dir[], bdb_state_type *parent_bdb_handle,
         return -1;
 }
 
+/* Reads served from the llmeta cache, and reads that went to the btree
+ * because they missed it */
+void bdb_llmeta_cache_stats(unsigned long long *hits, unsigned long long *reads)
+{
+    *hits = *reads = 0;
+    if (llmeta_bdb_state)
+        bdb_lite_cache_stats(llmeta_bdb_state, hits, reads);
+}
+
 /* change the list of tables that are stored in the low level meta table
  * returns <0 on failure or 0 on success */
 int bdb_llmeta_set_tables(
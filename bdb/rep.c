@@ -3563,6 +3563,16 @@ static int process_berkdb(bdb_state_type *bdb_state, char *host, DBT *control,
         got_writelock = 1;
     }
 
+    /* Page catch-up installs all its pages and restarts the log at its end;
+       until then it only spools them. */
+    if (rectype == REP_PLIST && !got_writelock &&
+        bdb_is_open(bdb_state) &&
+        bdb_state->dbenv->rep_pgcatchup_will_install(bdb_state->dbenv,
+                                                     control, rec)) {
+        BDB_WRITELOCK_REP("bdb_rep_page_catchup");
+        got_writelock = 1;
+    }
+
     bdb_state->repinfo->in_rep_process_message = 1;
 
     bdb_state->repinfo->rep_process_message_start_time = comdb2_time_epoch();
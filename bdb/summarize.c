@@ -120,71 +120,25 @@ static DB *dbp_from_meta(DB *dbp, DBMETA *meta)
     return dbp;
 }
 
-int bdb_summarize_table(bdb_state_type *bdb_state, int ixnum, int comp_pct,
-                        struct temp_table **outtbl, unsigned long long *outrecs,
-                        unsigned long long *cmprecs, int *bdberr)
+/* add comp_pct percent of the keys of one btree file to outtbl */
+static int summarize_file(bdb_state_type *bdb_state, const char *fname,
+                          int comp_pct, struct temp_table *outtbl, int *nrecs,
+                          unsigned long long *recs_looked_at, int *bdberr)
 {
     DB_ENV *dbenv = bdb_state->dbenv;
     int is_hmac = CRYPTO_ON(dbenv);
     uint8_t pfxbuf[KEYBUF];
-    char tmpname[PATH_MAX];
     char tran_tmpname[PATH_MAX];
     int rc = 0;
     DB dbp_ = {0}, *dbp;
     PAGE *page = NULL;
     unsigned char metabuf[512];
     int pgsz;
-    int created_temp_table = 0;
-    int nrecs = 0;
-    unsigned long long recs_looked_at = 0;
-    int have_checksums = 0;
     unsigned int pgno = 0;
     int fd = -1;
     int last, now;
 
-    if (comp_pct > 100 || comp_pct < 1) {
-        *bdberr = BDBERR_BADARGS;
-        rc = -1;
-        goto done;
-    }
-
-    if (!bdb_state->parent) {
-        *bdberr = BDBERR_BADARGS;
-        rc = -1;
-        goto done;
-    }
-
-    rc = check_free_space(bdb_state->dir);
-    if (rc != BDBERR_NOERROR) {
-        *bdberr = rc;
-        rc = -1;
-        goto done;
-    }
-
-    if (*outtbl == NULL) {
-        *outtbl = bdb_temp_table_create(bdb_state->parent, bdberr);
-        if (*outtbl == NULL) {
-            rc = -1;
-            goto done;
-        }
-        created_temp_table = 1;
-    }
-
-    *bdberr = BDBERR_NOERROR;
-
-    if (ixnum < 0) {
-        /* we only support this for indices - no need to summarize data */
-        *bdberr = BDBERR_BADARGS;
-        goto done;
-    }
-    rc = bdb_get_index_filename(bdb_state, ixnum, tmpname, sizeof(tmpname),
-                                bdberr);
-    if (rc) {
-        if (rc == DB_LOCK_DEADLOCK)
-            rc = BDBERR_DEADLOCK;
-        goto done;
-    }
-    bdb_trans(tmpname, tran_tmpname);
+    bdb_trans(fname, tran_tmpname);
     logmsg(LOGMSG_DEBUG, "open %s\n", tran_tmpname);
 
     fd = open(tran_tmpname, O_RDONLY);
@@ -320,13 +274,13 @@ int bdb_summarize_table(bdb_state_type *bdb_state, int ixnum, int comp_pct,
                     }
                     ASSIGN_ALIGN(db_indx_t, len, data->len);
                     rc = bdb_temp_table_put(
-                        bdb_state->parent, *outtbl, data->data, len, &c,
+                        bdb_state->parent, outtbl, data->data, len, &c,
                         sizeof(unsigned long long), NULL, bdberr);
                     if (rc)
                         goto done;
-                    nrecs++;
+                    (*nrecs)++;
                 }
-                recs_looked_at++;
+                (*recs_looked_at)++;
             }
         }
 
@@ -350,13 +304,79 @@ int bdb_summarize_table(bdb_state_type *bdb_state, int ixnum, int comp_pct,
         rc = -1;
         goto done;
     }
-    logmsg(LOGMSG_INFO, "summarize added %d records, traversed %lld\n", nrecs,
-           recs_looked_at);
 done:
     if (fd != -1)
         close(fd);
     if (page)
         free(page);
+    return rc;
+}
+
+/* Summarize index ixnum, or with ixnum -1 the data stripes; their keys are
+   the genids of the sampled records. */
+int bdb_summarize_table(bdb_state_type *bdb_state, int ixnum, int comp_pct,
+                        struct temp_table **outtbl, unsigned long long *outrecs,
+                        unsigned long long *cmprecs, int *bdberr)
+{
+    char tmpname[PATH_MAX];
+    int rc = 0;
+    int created_temp_table = 0;
+    int nrecs = 0;
+    unsigned long long recs_looked_at = 0;
+    int nfiles, i;
+
+    if (comp_pct > 100 || comp_pct < 1) {
+        *bdberr = BDBERR_BADARGS;
+        rc = -1;
+        goto done;
+    }
+
+    if (!bdb_state->parent) {
+        *bdberr = BDBERR_BADARGS;
+        rc = -1;
+        goto done;
+    }
+
+    rc = check_free_space(bdb_state->dir);
+    if (rc != BDBERR_NOERROR) {
+        *bdberr = rc;
+        rc = -1;
+        goto done;
+    }
+
+    if (*outtbl == NULL) {
+        *outtbl = bdb_temp_table_create(bdb_state->parent, bdberr);
+        if (*outtbl == NULL) {
+            rc = -1;
+            goto done;
+        }
+        created_temp_table = 1;
+    }
+
+    *bdberr = BDBERR_NOERROR;
+
+    nfiles = ixnum < 0 ? bdb_get_datafile_num_files(bdb_state, 0) : 1;
+    for (i = 0; i < nfiles; i++) {
+        if (ixnum < 0)
+            rc = bdb_get_data_filename(bdb_state, i, 0, tmpname,
+                                       sizeof(tmpname), bdberr);
+        else
+            rc = bdb_get_index_filename(bdb_state, ixnum, tmpname,
+                                        sizeof(tmpname), bdberr);
+        if (rc) {
+            if (rc == DB_LOCK_DEADLOCK)
+                rc = BDBERR_DEADLOCK;
+            goto done;
+        }
+
+        rc = summarize_file(bdb_state, tmpname, comp_pct, *outtbl, &nrecs,
+                            &recs_looked_at, bdberr);
+        if (rc)
+            goto done;
+    }
+    logmsg(LOGMSG_INFO, "summarize added %d records, traversed %lld\n", nrecs,
+           recs_looked_at);
+done:
     if (rc && *outtbl && created_temp_table) {
         int crc;
         int cbdberr;
@@ -370,4 +390,3 @@ done:
     *cmprecs = recs_looked_at;
     return rc;
 }
-
@@ -1858,7 +1858,9 @@ static int bdb_temp_table_insert_put(bdb_state_type *bdb_state,
             free(hash_data);
         }
 
-        if (tbl->num_mem_entries > tbl->max_mem_entries) {
+        /* Move to disk when full, or when the statement is over its
+         * memory budget */
+        if (tbl->num_mem_entries > tbl->max_mem_entries || comdb2ma_spill()) {
             rc = bdb_hash_table_copy_to_temp_db(bdb_state, tbl, bdberr);
             if (unlikely(rc)) {
                 return -1;
@@ -85,12 +85,18 @@ void *udpbackup_and_autoanalyze_thd(void *arg)
         if (repinfo->master_host != repinfo->myhost) { // not master
             if (gbl_udp)
                 send_myseqnum_to_master(bdb_state, 1);
-        } else if (bdb_state->attr->autoanalyze &&
-                   count % ((bdb_state->attr->chk_aa_time * 1000) / pollms) ==
-                       0) { // do this is on master if autoanalyze on
-            pthread_t autoanalyze;
-            pthread_create(&autoanalyze, &gbl_pthread_attr_detached,
-                           auto_analyze_main, NULL);
+        } else if (count % ((bdb_state->attr->chk_aa_time * 1000) /
+                            pollms) == 0) {
+            if (bdb_state->attr->autoanalyze) { // on master if autoanalyze on
+                pthread_t autoanalyze;
+                pthread_create(&autoanalyze, &gbl_pthread_attr_detached,
+                               auto_analyze_main, NULL);
+            }
+            if (gbl_incremental_stats) {
+                pthread_t incrstats;
+                pthread_create(&incrstats, &gbl_pthread_attr_detached,
+                               incr_stats_main, NULL);
+            }
         }
 
         poll(NULL, 0, pollms);
@@ -153,6 +159,109 @@ void *memp_trickle_thread(void *arg)
     logmsg(LOGMSG_DEBUG, "memp_trickle_thread: exiting\n");
 }
 
+extern int __memp_save_pagelist(DB_ENV *, const char *, u_int32_t *);
+extern int __memp_load_pagelist(DB_ENV *, const char *, int, int (*)(void *),
+                                void *, u_int32_t *);
+
+static int warm_cache_stop(void *unused)
+{
+    return db_is_stopped();
+}
+
+/* Read the pages that were in the cache when we went down back in, then
+ * keep the list on disk up to date. */
+void *warm_cache_thread(void *arg)
+{
+    bdb_state_type *bdb_state = arg;
+    char path[PATH_MAX];
+    u_int32_t npages;
+    int start, last, rc;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    /* tables are open after this */
+    while (!bdb_state->after_llmeta_init_done && !db_is_stopped())
+        sleep(1);
+
+    thread_started("bdb warm cache");
+    bdb_thread_event(bdb_state, 1);
+
+    snprintf(path, sizeof(path), "%s/%s.pagelist", bdb_state->dir,
+             bdb_state->name);
+
+    if (bdb_state->attr->warm_cache && access(path, F_OK) == 0) {
+        /* No bdb lock: this can take a while, and the mpool file handles
+         * are held open by the load itself. */
+        start = comdb2_time_epochms();
+        rc = __memp_load_pagelist(bdb_state->dbenv, path,
+                                  bdb_state->attr->warm_cache_threads,
+                                  warm_cache_stop, NULL, &npages);
+        if (rc)
+            logmsg(LOGMSG_WARN, "warm cache: can't load %s rc %d\n", path, rc);
+        else
+            logmsg(LOGMSG_USER, "warm cache: loaded %u pages in %d ms\n",
+                   npages, comdb2_time_epochms() - start);
+    }
+
+    last = comdb2_time_epoch();
+    while (!db_is_stopped()) {
+        sleep(1);
+        if (!bdb_state->attr->warm_cache ||
+            comdb2_time_epoch() - last <
+                bdb_state->attr->warm_cache_save_interval)
+            continue;
+        last = comdb2_time_epoch();
+        BDB_READLOCK("warm_cache_thread");
+        rc = __memp_save_pagelist(bdb_state->dbenv, path, &npages);
+        BDB_RELLOCK();
+        if (rc)
+            logmsg(LOGMSG_WARN, "warm cache: can't save %s rc %d\n", path, rc);
+        else
+            logmsg(LOGMSG_DEBUG, "warm cache: saved %u pages\n", npages);
+    }
+
+    bdb_thread_event(bdb_state, 0);
+    logmsg(LOGMSG_DEBUG, "warm_cache_thread: exiting\n");
+    return NULL;
+}
+
+extern int gbl_log_prealloc_files;
+extern int __log_prealloc(DB_ENV *, int *);
+
+/* Keep log_prealloc_files spare log files ready */
+void *log_prealloc_thread(void *arg)
+{
+    bdb_state_type *bdb_state = arg;
+    int nmade, rc;
+
+    if (bdb_state->parent)
+        bdb_state = bdb_state->parent;
+
+    while (!bdb_state->passed_dbenv_open && !db_is_stopped())
+        sleep(1);
+
+    thread_started("bdb log prealloc");
+    bdb_thread_event(bdb_state, 1);
+
+    while (!db_is_stopped()) {
+        if (gbl_log_prealloc_files > 0) {
+            rc = __log_prealloc(bdb_state->dbenv, &nmade);
+            if (nmade)
+                logmsg(LOGMSG_DEBUG, "log prealloc: made %d spare log files\n",
+                       nmade);
+            /* don't spin on a full or broken disk */
+            if (rc)
+                sleep(10);
+        }
+        sleep(1);
+    }
+
+    bdb_thread_event(bdb_state, 0);
+    logmsg(LOGMSG_DEBUG, "log_prealloc_thread: exiting\n");
+    return NULL;
+}
+
 void *deadlockdetect_thread(void *arg)
 {
     bdb_state_type *bdb_state;
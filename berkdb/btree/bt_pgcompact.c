@@ -1470,3 +1470,110 @@ error_out:
 
 	return (ret);
 }
+
+/*
+ * __bam_pgfill --
+ *	Walk the file in page order and measure its leaf pages.
+ *	See __db_pgfill().
+ *
+ * PUBLIC: int __bam_pgfill __P((DBC *, double, db_pgno_t *, u_int32_t,
+ * PUBLIC:     u_int32_t *, u_int64_t *, u_int64_t *,
+ * PUBLIC:     int (*)(DB *, DBT *, void *), int (*)(DB *, void *), void *));
+ */
+int
+__bam_pgfill(dbc, ff, pgnop, npages, nleafp, nusedp, ntotalp, cb, tick, arg)
+	DBC *dbc;
+	double ff;
+	db_pgno_t *pgnop;
+	u_int32_t npages;
+	u_int32_t *nleafp;
+	u_int64_t *nusedp;
+	u_int64_t *ntotalp;
+	int (*cb) __P((DB *, DBT *, void *));
+	int (*tick) __P((DB *, void *));
+	void *arg;
+{
+	int ret, t_ret, sparse;
+	u_int32_t n, ntb, nub, kbuflen;
+	void *kbuf;
+	DB *dbp;
+	DB_ENV *dbenv;
+	DB_MPOOLFILE *dbmfp;
+	DB_LOCK lock;
+	DBT dbt;
+	PAGE *h;
+	db_pgno_t pgno, last_pgno;
+
+	dbp = dbc->dbp;
+	dbenv = dbp->dbenv;
+	dbmfp = dbp->mpf;
+	kbuf = NULL;
+	kbuflen = 0;
+	ntb = dbp->pgsize - SIZEOF_PAGE;
+
+	*nleafp = 0;
+	*nusedp = *ntotalp = 0;
+
+	if ((ret = __memp_fget(dbmfp, &last_pgno, DB_MPOOL_LAST, &h)) != 0)
+		return (ret);
+	if ((ret = __memp_fput(dbmfp, h, 0)) != 0)
+		return (ret);
+
+	/* Page 0 is the meta page. */
+	pgno = *pgnop == PGNO_INVALID ? 1 : *pgnop;
+	for (n = 0; pgno <= last_pgno; ++pgno, ++n) {
+		if (npages != 0 && n == npages)
+			break;
+		if (tick != NULL && (ret = tick(dbp, arg)) != 0)
+			break;
+
+		/* Don't queue up behind writers. A page we can't lock
+		   is left out of the totals and picked up next time. */
+		ret = __db_lget(dbc, 0, pgno, DB_LOCK_READ, DB_LOCK_NOWAIT, &lock);
+		if (ret == DB_LOCK_NOTGRANTED || ret == DB_LOCK_DEADLOCK) {
+			ret = 0;
+			continue;
+		}
+		if (ret != 0)
+			break;
+
+		if ((ret = __memp_fget(dbmfp, &pgno, 0, &h)) != 0) {
+			(void)__LPUT(dbc, lock);
+			break;
+		}
+
+		sparse = 0;
+		if (TYPE(h) == P_LBTREE) {
+			nub = ntb - P_FREESPACE(dbp, h);
+			++*nleafp;
+			*nusedp += nub;
+			*ntotalp += ntb;
+
+			/* Same rules as __bam_ispgcompactible(): we need
+			   the 1st key of a non-empty, non-root leaf. */
+			if (cb != NULL && NUM_ENT(h) != 0 &&
+			    pgno != dbc->internal->root &&
+			    nub < (u_int32_t)(ff * ntb)) {
+				memset(&dbt, 0, sizeof(dbt));
+				if (__db_ret(dbp, h, 0, &dbt, &kbuf, &kbuflen) == 0)
+					sparse = 1;
+			}
+		}
+
+		t_ret = __memp_fput(dbmfp, h, 0);
+		if ((ret = __LPUT(dbc, lock)) == 0)
+			ret = t_ret;
+		if (ret != 0)
+			break;
+
+		/* Nothing is held here, so the callback is free to
+		   compact the page. */
+		if (sparse && (ret = cb(dbp, &dbt, arg)) != 0)
+			break;
+	}
+
+	*pgnop = pgno > last_pgno ? PGNO_INVALID : pgno;
+	if (kbuf != NULL)
+		__os_free(dbenv, kbuf);
+	return (ret);
+}
@@ -65,6 +65,7 @@ static const char revid[] = "$Id: bt_search.c,v 11.47 2003/06/30 17:19:35 bostic
 #include <btree/bt_cache.h>
 
 #include <btree/bt_pf.h>
+#include <crc32c.h>
 
 
 #include <stdbool.h>
@@ -257,6 +258,143 @@ genid_hash_free(DB_ENV *dbenv, genid_hash * hp)
 	__os_free(dbenv, hp);
 }
 
+/* key-pgno hashtable */
+key_hash *
+key_hash_init(DB_ENV *dbenv, int szkb)
+{
+	key_hash *h;
+
+	if (szkb <= 0)
+		return NULL;
+
+	if (__os_calloc(dbenv, 1, sizeof(key_hash), &h) != 0)
+		return NULL;
+
+	h->ntbl = ((unsigned int)szkb << 10) / sizeof(u_int64_t);
+	if (__os_calloc(dbenv, h->ntbl, sizeof(u_int64_t), &(h->tbl)) != 0) {
+		__os_free(dbenv, h);
+		return NULL;
+	}
+	/* one extra slot to line up the rest */
+	if (__os_calloc(dbenv, KEY_HASH_NSTAT + 1, sizeof(key_hash_stat),
+	    &(h->stat_buf)) != 0) {
+		__os_free(dbenv, h->tbl);
+		__os_free(dbenv, h);
+		return NULL;
+	}
+	h->stat = (key_hash_stat *)(((uintptr_t)h->stat_buf +
+	    sizeof(key_hash_stat) - 1) & ~(uintptr_t)(sizeof(key_hash_stat) - 1));
+	return h;
+}
+
+void
+key_hash_free(DB_ENV *dbenv, key_hash * hp)
+{
+	if (!hp)
+		return;
+	__os_free(dbenv, hp->stat_buf);
+	__os_free(dbenv, hp->tbl);
+	__os_free(dbenv, hp);
+}
+
+void
+key_hash_stat_sum(key_hash * hp, key_hash_stat * sum)
+{
+	int i;
+
+	memset(sum, 0, sizeof(*sum));
+	for (i = 0; i < KEY_HASH_NSTAT; i++) {
+		sum->n_lookup += hp->stat[i].n_lookup;
+		sum->n_hit += hp->stat[i].n_hit;
+		sum->n_stale += hp->stat[i].n_stale;
+	}
+}
+
+/* Threads take stat slots round robin; past KEY_HASH_NSTAT threads some
+   share a slot, which is why the counts are atomic adds. */
+static __thread int ixhash_slot = -1;
+static int ixhash_next_slot;
+
+static inline key_hash_stat *
+__bam_ixhash_stat(hp)
+	key_hash *hp;
+{
+	if (ixhash_slot < 0)
+		ixhash_slot = __sync_fetch_and_add(&ixhash_next_slot, 1) %
+		    KEY_HASH_NSTAT;
+	return (&hp->stat[ixhash_slot]);
+}
+
+/*
+ * Look up the leaf page hinted for key, and return it read-locked if the
+ * key sorts between the first and last keys on it.  A key's items never span
+ * leaf pages, so that leaf is then the only page which can hold the key, and
+ * the one a descent from the root would reach.
+ */
+static int
+__bam_ixhash_get(dbc, hp, key, tagp, lockp, pagep)
+	DBC *dbc;
+	key_hash *hp;
+	const DBT *key;
+	u_int32_t *tagp;
+	DB_LOCK *lockp;
+	PAGE **pagep;
+{
+	DB *dbp;
+	DB_MPOOLFILE *mpf;
+	PAGE *h;
+	key_hash_stat *st;
+	db_pgno_t pg;
+	u_int64_t ent;
+	uint8_t buf[KEYBUF];
+	int cmp;
+	int (*func) __P((DB *, const DBT *, const DBT *));
+
+	dbp = dbc->dbp;
+	mpf = dbp->mpf;
+	func = ((BTREE *)dbp->bt_internal)->bt_compare;
+	st = __bam_ixhash_stat(hp);
+
+	*tagp = crc32c(key->data, key->size);
+	ent = ((volatile u_int64_t *)hp->tbl)[*tagp % hp->ntbl];
+	(void)__sync_fetch_and_add(&st->n_lookup, 1);
+	if (ent == 0 || (u_int32_t)(ent >> 32) != *tagp)
+		return (DB_NOTFOUND);
+
+	pg = (db_pgno_t)ent;
+	if (__db_lget(dbc, 0, pg, DB_LOCK_READ, 0, lockp) != 0)
+		return (DB_NOTFOUND);
+	if (__memp_fget(mpf, &pg, 0, &h) != 0) {
+		(void)__LPUT(dbc, *lockp);
+		return (DB_NOTFOUND);
+	}
+
+	if (TYPE(h) != P_LBTREE || LEVEL(h) != LEAFLEVEL || NUM_ENT(h) == 0 ||
+	    __bam_cmp_inline(dbp, key, h, 0, func, &cmp, buf) != 0 ||
+	    cmp < 0 ||
+	    __bam_cmp_inline(dbp, key, h, NUM_ENT(h) - P_INDX,
+		func, &cmp, buf) != 0 || cmp > 0) {
+		(void)__sync_fetch_and_add(&st->n_stale, 1);
+		(void)__memp_fput(mpf, h, 0);
+		(void)__LPUT(dbc, *lockp);
+		return (DB_NOTFOUND);
+	}
+
+	(void)__sync_fetch_and_add(&st->n_hit, 1);
+	*pagep = h;
+	return (0);
+}
+
+static inline void
+__bam_ixhash_put(hp, tag, pgno)
+	key_hash *hp;
+	u_int32_t tag;
+	db_pgno_t pgno;
+{
+	((volatile u_int64_t *)hp->tbl)[tag % hp->ntbl] =
+	    (u_int64_t)tag << 32 | pgno;
+}
+
 enum { PRIME = 8388013 };
 
 unsigned int
@@ -358,6 +496,9 @@ __bam_search(dbc, root_pgno, key, flags, stop, recnop, exactp)
 	db_pgno_t hash_pg;
 	db_pgno_t pg_copy;
 	int mutex_rc = 0;
+	key_hash *ixhash = NULL;
+	u_int32_t ixtag = 0;
+	int add_to_ixhash = 0;
 
 	struct timeval before, after, diff;
 
@@ -399,6 +540,22 @@ try_again:
 	dbp->pg_hash_stat.n_bt_search++;
 	gettimeofday(&before, NULL);
 
+	/*
+	 * Indexes declared with the hash key flag keep a hint of the leaf page
+	 * that a search for each key ended on.  On a read search we try the
+	 * hinted leaf first, and only descend from the root if it no longer
+	 * covers the key; the descent then refreshes the hint.  The hints are
+	 * checked under the page lock every time, so they are never logged
+	 * and need no recovery: they are rebuilt by the searches themselves.
+	 */
+	if (!stack && ixhash == NULL && (ixhash = dbp->ix_hash) != NULL &&
+	    root_pgno == PGNO_INVALID && recnop == NULL && LF_ISSET(S_READ) &&
+	    !LF_ISSET(S_WRITE | S_PARENT | S_STK_ONLY | S_APPEND)) {
+		if (__bam_ixhash_get(dbc, ixhash, key, &ixtag, &lock, &h) == 0)
+			goto got_pg;
+		add_to_ixhash = 1;
+	}
+
 	extern bool gbl_rcache;
 
 	if (gbl_rcache && pg == 1 && bfpool_pg == NULL &&
@@ -646,6 +803,8 @@ got_pg:func = t->bt_compare;
 			 * to find an undeleted record.  This is handled by the
 			 * calling routine.
 			 */
+			if (add_to_ixhash && TYPE(h) == P_LBTREE)
+				__bam_ixhash_put(ixhash, ixtag, h->pgno);
 			BT_STK_ENTER(dbp->dbenv,
 			    cp, h, base, lock, lock_mode, ret);
 			if (ret != 0)
@@ -906,6 +1065,9 @@ found:	*exactp = 1;
 	// ########################################
 #endif
 
+	if (add_to_ixhash && TYPE(h) == P_LBTREE)
+		__bam_ixhash_put(ixhash, ixtag, h->pgno);
+
 	// only save non-root page
 	if (add_to_hash && h->pgno != 1) {
 		mutex_rc = pthread_mutex_lock(&(hash->mutex));
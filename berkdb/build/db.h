@@ -694,6 +694,10 @@ struct __db_log_stat {
 	u_int32_t st_ondisk_get;	/* On-disk log_get. */
 	u_int32_t st_inmem_trav;	/* Mem-log steps for partial reads. */
 	u_int32_t st_wrap_copy;		/* Count of wrapped copies. */
+	u_int32_t st_prealloc_used;	/* New log files that were spares. */
+	u_int32_t st_recycled;		/* Old log files kept as spares. */
+#define	DB_LOG_FSYNC_BUCKETS	16
+	u_int32_t st_fsync_hist[DB_LOG_FSYNC_BUCKETS]; /* Syncs by duration. */
 };
 
 /*******************************************************
@@ -1330,6 +1334,30 @@ typedef struct
    struct timeval t_bt_search;
 } dbp_bthash_stat;
 
+/* key_hash counters, a cache line each; a thread only counts in its own
+   slot, so lookups don't bounce a shared line between CPUs */
+#define KEY_HASH_NSTAT 64
+typedef struct key_hash_stat
+{
+   u_int64_t n_lookup;		/* searches that consulted the hash */
+   u_int64_t n_hit;		/* searches that started at the hinted leaf */
+   u_int64_t n_stale;		/* hints that no longer held the key */
+   u_int8_t pad[64 - 3 * sizeof(u_int64_t)];
+} key_hash_stat;
+
+/* key-pgno hashtable - leaf page hints for point lookups on an index */
+typedef struct key_hash
+{
+   unsigned int ntbl;		/* num entries in this table */
+   u_int64_t *tbl;		/* crc32c of key << 32 | leaf pgno */
+   key_hash_stat *stat;		/* KEY_HASH_NSTAT slots, line aligned */
+   void *stat_buf;		/* allocation behind stat */
+} key_hash;
+
+key_hash *key_hash_init(DB_ENV *dbenv, int szkb);
+void key_hash_free(DB_ENV *dbenv, key_hash *hp);
+void key_hash_stat_sum(key_hash *hp, key_hash_stat *sum);
+
 genid_hash *genid_hash_init(DB_ENV *dbenv, int sz);
 void genid_hash_resize(DB_ENV *dbenv, genid_hash **hpp, int szkb);
 void genid_hash_free(DB_ENV *dbenv, genid_hash *hp);
@@ -1645,6 +1673,9 @@ struct __db {
 
 	dbp_bthash_stat pg_hash_stat;
 
+	key_hash *ix_hash;
+	key_hash *ix_hash_off;	/* turned off, may still be read */
+
 	LINKC_T(DB) adjlnk;
 	int inadjlist;
 
@@ -2291,6 +2322,8 @@ struct __db_env {
 	int  (*rep_process_message) __P((DB_ENV *, DBT *, DBT *,
 	    char **, DB_LSN *, uint32_t *));
 	int  (*rep_verify_will_recover) __P((DB_ENV *, DBT *, DBT *));
+	int  (*rep_pgcatchup_will_install) __P((DB_ENV *, DBT *, DBT *));
+	int  (*rep_pgcatchup_pending) __P((DB_ENV *));
 	int  (*rep_truncate_repdb) __P((DB_ENV *));
 	int  (*rep_start) __P((DB_ENV *, DBT *, u_int32_t));
 	int  (*rep_stat) __P((DB_ENV *, DB_REP_STAT **, u_int32_t));
@@ -2388,6 +2421,8 @@ struct __db_env {
 		__P((DB_ENV *env, int nthreads));
 	int  (*set_num_recovery_worker_threads)
 		__P((DB_ENV *env, int nthreads));
+	int  (*set_num_recovery_redo_threads)
+		__P((DB_ENV *env, int nthreads));
 	void  (*set_recovery_memsize) __P((DB_ENV *env, int sz));
 	int  (*get_recovery_memsize) __P((DB_ENV *env));
 	int (*get_page_extent_size) __P((DB_ENV *env));
@@ -2413,6 +2448,9 @@ struct __db_env {
 	struct thdpool *recovery_processors;
 	struct thdpool *recovery_workers;
 
+	/* Threads for the forward pass of crash recovery, see __db_apprec */
+	int num_recovery_redo_threads;
+
 	LISTC_T(struct __recovery_processor) inflight_transactions;
 	LISTC_T(struct __recovery_processor) inactive_transactions;
 	pthread_mutex_t recover_lk;
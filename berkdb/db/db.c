@@ -711,6 +711,10 @@ __db_close(dbp, txn, flags)
 	/* Free bthash. */
 	if (F_ISSET(dbp, DB_AM_HASH) && dbp->pg_hash)
 		genid_hash_free(dbenv, dbp->pg_hash);
+	if (dbp->ix_hash)
+		key_hash_free(dbenv, dbp->ix_hash);
+	if (dbp->ix_hash_off)
+		key_hash_free(dbenv, dbp->ix_hash_off);
 
 	/* Free the database handle. */
 	memset(dbp, CLEAR_BYTE, sizeof(*dbp));
@@ -159,6 +159,8 @@ db_create(dbpp, dbenv, flags)
 		goto err;
 
 	dbp->pg_hash = NULL;
+	dbp->ix_hash = NULL;
+	dbp->ix_hash_off = NULL;
 
 	dbp->type = DB_UNKNOWN;
 	*dbpp = dbp;
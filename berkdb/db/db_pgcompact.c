@@ -120,3 +120,60 @@ done:
 		ret = t_ret;
 	return (ret);
 }
+
+/*
+ * __db_pgfill --
+ *	Walk a btree in page order and measure how full its leaf pages are:
+ *	the number of leaves, and the bytes used and available on them.
+ *	If cb is not NULL, it is called with the 1st key of every non-root
+ *	leaf filled less than ff, with no page or lock held. tick is called
+ *	before every page is read; a non-0 return stops the walk and is
+ *	returned. Pages locked by somebody else are skipped.
+ *
+ *	The walk starts at *pgnop (PGNO_INVALID for the start of the file)
+ *	and reads at most npages pages (0 for no limit). On return *pgnop
+ *	is where the next batch starts, or PGNO_INVALID once the file has
+ *	been walked. The counts cover this batch only.
+ *
+ * PUBLIC: int __db_pgfill __P((DB *, double, db_pgno_t *, u_int32_t,
+ * PUBLIC:     u_int32_t *, u_int64_t *, u_int64_t *,
+ * PUBLIC:     int (*)(DB *, DBT *, void *), int (*)(DB *, void *), void *));
+ */
+int
+__db_pgfill(dbp, ff, pgnop, npages, nleafp, nusedp, ntotalp, cb, tick, arg)
+	DB *dbp;
+	double ff;
+	db_pgno_t *pgnop;
+	u_int32_t npages;
+	u_int32_t *nleafp;
+	u_int64_t *nusedp;
+	u_int64_t *ntotalp;
+	int (*cb) __P((DB *, DBT *, void *));
+	int (*tick) __P((DB *, void *));
+	void *arg;
+{
+	int ret, t_ret;
+	DBC *dbc;
+	DB_ENV *dbenv;
+
+	dbenv = dbp->dbenv;
+
+	if ((ret = __db_cursor(dbp, NULL, &dbc, 0)) != 0) {
+		__db_err(dbenv, "__db_cursor: %s", strerror(ret));
+		return (ret);
+	}
+
+	if (dbc->dbtype == DB_BTREE) {
+		ret = __bam_pgfill(dbc, ff, pgnop, npages,
+		    nleafp, nusedp, ntotalp, cb, tick, arg);
+	} else {
+		__db_err(dbenv, "__db_pgfill: %s",
+				"Wrong access method. Expect BTREE.");
+		ret = EINVAL;
+	}
+
+	if ((t_ret = __db_c_close(dbc)) != 0 && ret == 0)
+		ret = t_ret;
+
+	return (ret);
+}
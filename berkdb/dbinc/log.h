@@ -241,6 +241,16 @@ struct __log {
 	 */
 	DB_LSN	cached_ckp_lsn;
 
+	/*
+	 * The LSN of the last record that created, removed or renamed a file
+	 * or finished a schema change, as far as we know: fileop_from is the
+	 * end of the log when the region was created, and we don't know about
+	 * any records before it.  Replication uses these to decide if a client
+	 * can catch up by page.  Protected by the region lock.
+	 */
+	DB_LSN	fileop_lsn;
+	DB_LSN	fileop_from;
+
 	roff_t	  buffer_off;		/* Log buffer offset in the region. */
 	u_int32_t buffer_size;		/* Log buffer size. */
 	u_int32_t segment_size;		/* Size of a buffer segment. */
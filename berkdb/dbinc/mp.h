@@ -273,6 +273,14 @@ struct __mpoolfile {
 	int32_t	  no_backing_file;	/* Never open a backing file. */
 	int32_t	  unlink_on_close;	/* Unlink file on last close. */
 
+	/*
+	 * If count_mods is set, mod_count goes up every time a page of the
+	 * file is marked dirty.  Readers that cache the file's contents use
+	 * it to tell that their copy is stale, see __memp_count_mods.
+	 */
+	int32_t	  count_mods;
+	u_int32_t mod_count;
+
 	/*
 	 * We do not protect the statistics in "stat" because of the cost of
 	 * the mutex in the get/put routines.  There is a chance that a count
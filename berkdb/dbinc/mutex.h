@@ -837,6 +837,31 @@ typedef unsigned char tsl_t;
 #define	MUTEX_NO_RLOCK		0x0040	/* Do not acquire region lock */
 #define	MUTEX_SELF_BLOCK	0x0080	/* Must block self. */
 #define	MUTEX_THREAD		0x0100	/* Thread-only mutex. */
+#define	MUTEX_MP_HASH		0x0200	/* Mpool hash bucket mutex. */
+#define	MUTEX_MP_BH		0x0400	/* Mpool buffer mutex. */
+#define	MUTEX_ADAPTIVE		0x0800	/* Always spin adaptively. */
+#define	MUTEX_NO_ADAPTIVE	0x1000	/* Never spin adaptively. */
+
+/*
+ * Mutex classes, for contention statistics.  __db_mutex_setup picks the
+ * class from the region and the MUTEX_MP_XXX flags.
+ */
+#define	MUTEX_CLASS_OTHER	0
+#define	MUTEX_CLASS_ENV		1
+#define	MUTEX_CLASS_LOCK	2
+#define	MUTEX_CLASS_LOG		3
+#define	MUTEX_CLASS_MPOOL	4
+#define	MUTEX_CLASS_MP_HASH	5
+#define	MUTEX_CLASS_MP_BH	6
+#define	MUTEX_CLASS_TXN		7
+#define	MUTEX_CLASS_MAX		8
+
+struct __db_mutex_class_stat {
+	u_int64_t spin;			/* Granted after spinning. */
+	u_int64_t spins;		/* Total spins. */
+	u_int64_t wait;			/* Granted after blocking. */
+};
+extern struct __db_mutex_class_stat __db_mutex_class_stats[MUTEX_CLASS_MAX];
 
 /* Mutex. */
 struct __mutex_t {
@@ -855,6 +880,8 @@ struct __mutex_t {
 	u_int32_t mutex_set_nowait;	/* Granted without waiting. */
 	u_int32_t mutex_set_spin;	/* Granted without spinning. */
 	u_int32_t mutex_set_spins;	/* Total number of spins. */
+	u_int32_t spin_limit;		/* Learned adaptive spin count. */
+	u_int32_t mclass;		/* MUTEX_CLASS_XXX */
 #ifdef HAVE_MUTEX_SYSTEM_RESOURCES
 	roff_t	  reg_off;		/* Shared lock info offset. */
 #endif
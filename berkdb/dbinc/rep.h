@@ -116,6 +116,14 @@ typedef struct __rep {
 	int		w_tiebreaker;	/* Winner tiebreaking value. */
 	int		votes;		/* Number of votes for this site. */
 
+	/* Client page catch-up (rep_page.c). */
+	DB_LSN		pgc_lsn;	/* Last record we kept. */
+	DB_LSN		pgc_maxlsn;	/* Newest page received. */
+	u_int32_t	pgc_locker;	/* Locker for page locks. */
+	u_int32_t	pgc_npages;	/* Pages received. */
+	int		pgc_ok;		/* Pages can still be used. */
+	time_t		pgc_time;	/* Last catch-up message. */
+
 	/* Statistics. */
 	DB_REP_STAT	stat;
 
@@ -129,6 +137,7 @@ typedef struct __rep {
 #define	REP_F_RECOVER		0x080		/* In recovery. */
 #define	REP_F_TALLY		0x100		/* Tallied vote before elect. */
 #define	REP_F_UPGRADE		0x200		/* Upgradeable replica. */
+#define	REP_F_PGCATCHUP		0x400		/* Catching up by page. */
 #define	REP_ISCLIENT	(REP_F_UPGRADE | REP_F_LOGSONLY)
 	u_int32_t	flags;
 } REP;
@@ -215,6 +224,24 @@ typedef struct __rep_control {
 	u_int32_t	flags;		/* log_put flag value. */
 } REP_CONTROL;
 
+/*
+ * Page catch-up: the header of a REP_PLIST message, and the header before
+ * the page image in a REP_PAGE message.
+ */
+typedef struct __rep_plist_info {
+#define	REP_PLIST_START		1	/* Pages follow. */
+#define	REP_PLIST_DONE		2	/* All pages sent; lsn starts the log. */
+#define	REP_PLIST_DECLINE	3	/* Catch up from the log. */
+	u_int32_t	op;
+	u_int32_t	lorder;		/* Master's byte order. */
+	u_int32_t	npages;		/* Pages sent, with REP_PLIST_DONE. */
+} REP_PLIST_INFO;
+
+typedef struct __rep_page_info {
+	u_int8_t	fileid[DB_FILE_ID_LEN];
+	db_pgno_t	pgno;
+} REP_PAGE_INFO;
+
 /* Election vote information. */
 typedef struct __rep_vote {
 	u_int32_t	egen;		/* Election generation. */
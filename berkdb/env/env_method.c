@@ -72,6 +72,7 @@ static int __dbenv_set_deadlock_override __P((DB_ENV *, u_int32_t));
 static int __dbenv_set_tran_lowpri __P((DB_ENV *, u_int32_t));
 static int __dbenv_set_num_recovery_processor_threads __P((DB_ENV *, int));
 static int __dbenv_set_num_recovery_worker_threads __P((DB_ENV *, int));
+static int __dbenv_set_num_recovery_redo_threads __P((DB_ENV *, int));
 static void __dbenv_set_recovery_memsize __P((DB_ENV *, int));
 static int __dbenv_get_recovery_memsize __P((DB_ENV *));
 static int __dbenv_get_rep_master __P((DB_ENV *, char **, u_int32_t *));
@@ -244,6 +245,8 @@ __dbenv_init(dbenv)
 		    __dbenv_set_num_recovery_processor_threads;
 		dbenv->set_num_recovery_worker_threads =
 		    __dbenv_set_num_recovery_worker_threads;
+		dbenv->set_num_recovery_redo_threads =
+		    __dbenv_set_num_recovery_redo_threads;
 		dbenv->set_recovery_memsize = __dbenv_set_recovery_memsize;
 		dbenv->get_recovery_memsize = __dbenv_get_recovery_memsize;
 		dbenv->memp_dump_bufferpool_info =
@@ -1163,6 +1166,15 @@ __dbenv_set_num_recovery_worker_threads(dbenv, num)
 	return 0;
 }
 
+static int
+__dbenv_set_num_recovery_redo_threads(dbenv, num)
+	DB_ENV *dbenv;
+	int num;
+{
+	dbenv->num_recovery_redo_threads = num;
+	return 0;
+}
+
 
 static int
 __dbenv_set_deadlock_override(dbenv, opt)
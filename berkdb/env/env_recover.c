@@ -48,10 +48,13 @@ static const char revid[] =
 #include <printformats.h>
 
 #include "dbinc/btree.h"
+#include "dbinc/hash.h"
 #include "dbinc/lock.h"
 
 #include "list.h"
 #include "logmsg.h"
+#include <epochlib.h>
+#include <pthread.h>
 
 #ifndef TESTSUITE
 void bdb_get_writelock(void *bdb_state,
@@ -618,6 +621,271 @@ void log_recovery_progress(int stage, int progress)
 }
 
 
+/*
+ * Parallel redo for the forward pass.
+ *
+ * Records of committed transactions that touch pages of one file go to the
+ * worker that owns the file (fileid % nworkers), so each page sees its records
+ * in log order, and records that touch several pages (splits, relinks) only
+ * ever touch pages of their own file.  Whether a transaction committed is
+ * still decided here, in log order, since the transaction list isn't
+ * thread-safe.  Everything else runs on this thread, and waits for the
+ * workers to drain first if it may touch pages or files.
+ */
+#define REDO_MAX_QUEUED 4096
+
+struct redo_rec {
+	struct redo_rec *next;
+	DB_LSN lsn;
+	DBT dbt;
+	u_int32_t rectype;
+};
+
+struct redo_worker {
+	pthread_t tid;
+	pthread_mutex_t lk;
+	pthread_cond_t cond;
+	struct redo_rec *head, *tail;
+	int nqueued;
+	int stop;
+	int ret;
+	DB_LSN err_lsn;
+	DB_ENV *dbenv;
+	void *txninfo;
+};
+
+static void *
+redo_worker_thd(arg)
+	void *arg;
+{
+	struct redo_worker *w = arg;
+	DB_ENV *dbenv = w->dbenv;
+	struct redo_rec *r;
+	DB_LSN lsn;
+	int ret;
+
+	pthread_mutex_lock(&w->lk);
+	for (;;) {
+		while (w->head == NULL && !w->stop)
+			pthread_cond_wait(&w->cond, &w->lk);
+		if ((r = w->head) == NULL)
+			break;
+		if ((w->head = r->next) == NULL)
+			w->tail = NULL;
+		pthread_mutex_unlock(&w->lk);
+
+		/* Stop redoing once something failed, the caller will bail. */
+		ret = 0;
+		lsn = r->lsn;
+		if (w->ret == 0)
+			ret = dbenv->recover_dtab[r->rectype](dbenv, &r->dbt,
+			    &lsn, DB_TXN_FORWARD_ROLL, w->txninfo);
+		if (ret == DB_TXN_CKP)
+			ret = 0;
+
+		pthread_mutex_lock(&w->lk);
+		if (ret != 0 && w->ret == 0) {
+			w->ret = ret;
+			w->err_lsn = r->lsn;
+		}
+		w->nqueued--;
+		pthread_cond_broadcast(&w->cond);
+		__os_free(dbenv, r);
+	}
+	pthread_mutex_unlock(&w->lk);
+	return NULL;
+}
+
+/* Start up to nworkers threads, returns how many started in *nstartedp. */
+static int
+redo_workers_start(dbenv, txninfo, nworkers, workersp, nstartedp)
+	DB_ENV *dbenv;
+	void *txninfo;
+	int nworkers;
+	struct redo_worker **workersp;
+	int *nstartedp;
+{
+	struct redo_worker *workers;
+	int i, ret;
+
+	if ((ret = __os_calloc(dbenv,
+	    nworkers, sizeof(struct redo_worker), &workers)) != 0)
+		return (ret);
+	for (i = 0; i < nworkers; i++) {
+		struct redo_worker *w = &workers[i];
+		pthread_mutex_init(&w->lk, NULL);
+		pthread_cond_init(&w->cond, NULL);
+		w->dbenv = dbenv;
+		w->txninfo = txninfo;
+		if ((ret = pthread_create(&w->tid,
+		    NULL, redo_worker_thd, w)) != 0) {
+			__db_err(dbenv,
+			    "can't start recovery redo thread, ret %d", ret);
+			pthread_mutex_destroy(&w->lk);
+			pthread_cond_destroy(&w->cond);
+			break;
+		}
+	}
+	/* Run with what we have. */
+	if (i == 0) {
+		__os_free(dbenv, workers);
+		return (ret);
+	}
+	*workersp = workers;
+	*nstartedp = i;
+	return (0);
+}
+
+static int
+redo_enqueue(dbenv, w, rectype, dbt, lsnp)
+	DB_ENV *dbenv;
+	struct redo_worker *w;
+	u_int32_t rectype;
+	DBT *dbt;
+	DB_LSN *lsnp;
+{
+	struct redo_rec *r;
+	int ret;
+
+	if ((ret = __os_malloc(dbenv, sizeof(*r) + dbt->size, &r)) != 0)
+		return (ret);
+	r->next = NULL;
+	r->lsn = *lsnp;
+	r->rectype = rectype;
+	memset(&r->dbt, 0, sizeof(r->dbt));
+	r->dbt.data = (u_int8_t *)(r + 1);
+	r->dbt.size = dbt->size;
+	memcpy(r->dbt.data, dbt->data, dbt->size);
+
+	pthread_mutex_lock(&w->lk);
+	while (w->nqueued >= REDO_MAX_QUEUED)
+		pthread_cond_wait(&w->cond, &w->lk);
+	if (w->tail)
+		w->tail->next = r;
+	else
+		w->head = r;
+	w->tail = r;
+	w->nqueued++;
+	ret = w->ret;
+	pthread_cond_broadcast(&w->cond);
+	pthread_mutex_unlock(&w->lk);
+	return (ret);
+}
+
+/* Wait for every worker to go idle.  Returns the first error of any. */
+static int
+redo_drain(dbenv, workers, nworkers)
+	DB_ENV *dbenv;
+	struct redo_worker *workers;
+	int nworkers;
+{
+	int i, ret = 0;
+
+	for (i = 0; i < nworkers; i++) {
+		struct redo_worker *w = &workers[i];
+		pthread_mutex_lock(&w->lk);
+		while (w->nqueued > 0)
+			pthread_cond_wait(&w->cond, &w->lk);
+		if (w->ret != 0 && ret == 0) {
+			ret = w->ret;
+			__db_err(dbenv, "Recovery redo failed at %lu:%lu, ret %d",
+			    (u_long)w->err_lsn.file, (u_long)w->err_lsn.offset,
+			    ret);
+		}
+		pthread_mutex_unlock(&w->lk);
+	}
+	return (ret);
+}
+
+static void
+redo_workers_stop(dbenv, workers, nworkers)
+	DB_ENV *dbenv;
+	struct redo_worker *workers;
+	int nworkers;
+{
+	int i;
+
+	for (i = 0; i < nworkers; i++) {
+		struct redo_worker *w = &workers[i];
+		pthread_mutex_lock(&w->lk);
+		w->stop = 1;
+		pthread_cond_broadcast(&w->cond);
+		pthread_mutex_unlock(&w->lk);
+		pthread_join(w->tid, NULL);
+		pthread_mutex_destroy(&w->lk);
+		pthread_cond_destroy(&w->cond);
+	}
+	__os_free(dbenv, workers);
+}
+
+/* Records that never touch a page or a file */
+static int
+redo_no_pages(rectype)
+	u_int32_t rectype;
+{
+	switch (rectype) {
+	case DB___txn_regop:
+	case DB___txn_regop_gen:
+	case DB___txn_regop_rowlocks:
+	case DB___txn_ckp:
+	case DB___txn_child:
+	case DB___txn_xa_regop:
+	case DB___txn_recycle:
+	case DB___db_debug:
+		return (1);
+	default:
+		return (0);
+	}
+}
+
+/*
+ * Hand a record of the forward pass to a worker if it can be redone out of
+ * line.  Returns 1 if the record was taken care of (queued, or skipped
+ * because __db_dispatch would skip it too), 0 if the caller must dispatch it.
+ */
+static int
+redo_parallel(dbenv, workers, nworkers, txninfo, dbt, lsnp, retp)
+	DB_ENV *dbenv;
+	struct redo_worker *workers;
+	int nworkers;
+	void *txninfo;
+	DBT *dbt;
+	DB_LSN *lsnp;
+	int *retp;
+{
+	u_int32_t fileid, rectype, txnid;
+	int ret;
+
+	LOGCOPY_32(&rectype, dbt->data);
+	LOGCOPY_32(&txnid, (u_int8_t *)dbt->data + sizeof(rectype));
+
+	if (rectype >= DB_user_BEGIN || rectype >= dbenv->recover_dtab_size ||
+	    dbenv->recover_dtab[rectype] == NULL)
+		return (0);
+	if ((fileid = file_id_for_recovery_record(dbenv,
+	    NULL, rectype, dbt)) == UINT32_MAX)
+		return (0);
+
+	/* Same decision as __db_dispatch's forward roll. */
+	ret = 0;
+	if (txnid != 0 &&
+	    (ret = __db_txnlist_find(dbenv, txninfo, txnid)) == TXN_COMMIT) {
+		/* pg_new puts pages in limbo, which lives in the txn list */
+		if (rectype == DB___db_pg_new)
+			return (0);
+		*retp = redo_enqueue(dbenv,
+		    &workers[fileid % nworkers], rectype, dbt, lsnp);
+		return (1);
+	}
+	/* Allocations are redone whether they committed or not */
+	if (ret != TXN_IGNORE && (rectype == DB___ham_metagroup ||
+	    rectype == DB___ham_groupalloc || rectype == DB___db_pg_alloc))
+		return (0);
+	*retp = 0;
+	return (1);
+}
+
+
 /*
  * __db_apprec --
  *	Perform recovery.  If max_lsn is non-NULL, then we are trying
@@ -653,12 +921,17 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 	void *bdb_state = dbenv->app_private;
 	DB_LSN logged_checkpoint_lsn;
 	int start_recovery_at_dbregs;
+	struct redo_worker *workers;
+	int nworkers, nredone, nredo_threads;
+	int redo_start;
 
 	COMPQUIET(nfiles, (double)0);
 
 	logc = NULL;
 	ckp_args = NULL;
 	dtab = NULL;
+	workers = NULL;
+	nworkers = 0;
 
 	hi_txn = TXN_MAXIMUM;
 	txninfo = NULL;
@@ -1115,6 +1388,11 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 	logmsg(LOGMSG_WARN, "running forward pass from %u:%u -> %u:%u\n",
 	    lsn.file, lsn.offset, stop_lsn.file, stop_lsn.offset);
+	if (dbenv->num_recovery_redo_threads > 1)
+		(void)redo_workers_start(dbenv, txninfo,
+		    dbenv->num_recovery_redo_threads, &workers, &nworkers);
+	nredone = 0;
+	redo_start = comdb2_time_epochms();
 	for (ret = __log_c_get(logc, &lsn, &data, DB_NEXT);
 	    ret == 0; ret = __log_c_get(logc, &lsn, &data, DB_NEXT)) {
 		/*
@@ -1137,6 +1415,20 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 			dbenv->db_feedback(dbenv, DB_RECOVER, progress);
 		}
 
+		nredone++;
+		if (nworkers) {
+			if (redo_parallel(dbenv, workers, nworkers,
+			    txninfo, &data, &lsn, &ret)) {
+				if (ret != 0)
+					break;
+				continue;
+			}
+			LOGCOPY_32(&rectype, data.data);
+			if (!redo_no_pages(rectype) &&
+			    (ret = redo_drain(dbenv, workers, nworkers)) != 0)
+				break;
+		}
+
 		ret = __db_dispatch(dbenv, dbenv->recover_dtab,
 		    dbenv->recover_dtab_size, &data, &lsn,
 		    DB_TXN_FORWARD_ROLL, txninfo);
@@ -1149,6 +1441,19 @@ __db_apprec(dbenv, max_lsn, trunclsn, update, flags)
 
 	}
 
+	nredo_threads = nworkers ? nworkers : 1;
+	if (nworkers) {
+		t_ret = redo_drain(dbenv, workers, nworkers);
+		redo_workers_stop(dbenv, workers, nworkers);
+		workers = NULL;
+		nworkers = 0;
+		if (t_ret != 0 && (ret == 0 || ret == DB_NOTFOUND))
+			ret = t_ret;
+	}
+	logmsg(LOGMSG_WARN, "forward pass read %d records in %d ms, "
+	    "%d redo threads\n", nredone,
+	    comdb2_time_epochms() - redo_start, nredo_threads);
+
 	if (ret != 0 && ret != DB_NOTFOUND)
 		goto err;
 	dbenv->recovery_pass = DB_TXN_NOT_IN_RECOVERY;
@@ -1333,7 +1638,10 @@ msgerr:	__db_err(dbenv,
 		    (u_long) lsn.file, (u_long) lsn.offset, pass);
 	}
 
-err:	if (logc != NULL && (t_ret = __log_c_close(logc)) != 0 && ret == 0)
+err:	if (workers != NULL)
+		redo_workers_stop(dbenv, workers, nworkers);
+
+	if (logc != NULL && (t_ret = __log_c_close(logc)) != 0 && ret == 0)
 		ret = t_ret;
 
 	if (txninfo != NULL)
@@ -21,10 +21,13 @@ static const char revid[] = "$Id: fop_rec.c,v 1.27 2003/10/07 20:23:28 ubell Exp
 #include "dbinc/db_page.h"
 #include "dbinc/db_shash.h"
 #include "dbinc/fop.h"
+#include "dbinc/log.h"
 #include "dbinc/db_am.h"
 #include "dbinc/mp.h"
 #include "dbinc/txn.h"
 
+void bdb_keep_removed_file(void *bdb_state, const char *path);
+
 /*
  * __fop_create_recover --
  *	Recovery function for create.
@@ -101,9 +104,17 @@ __fop_remove_recover(dbenv, dbtp, lsnp, op, info)
 		goto out;
 
 	/* Its ok if the file is not there. */
-	if (DB_REDO(op))
+	if (DB_REDO(op)) {
+		/*
+		 * Unlinking a big file frees all its extents; on a replicant
+		 * that would stall the apply thread.  Keep another link to it
+		 * for the purge thread to shrink.
+		 */
+		if (!IS_RECOVERING(dbenv))
+			bdb_keep_removed_file(dbenv->app_private, real_name);
 		(void)__memp_nameop(dbenv,
 		    (u_int8_t *)argp->fid.data, NULL, real_name, NULL);
+	}
 
 	*lsnp = argp->prev_lsn;
 out:	if (real_name != NULL)
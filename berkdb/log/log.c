@@ -128,6 +128,7 @@ __log_open(dbenv)
 
 		/* Initialize replication's next-expected LSN value. */
 		lp->ready_lsn = lp->lsn;
+		lp->fileop_lsn = lp->fileop_from = lp->lsn;
 
 		/*
 		fprintf(stderr,
@@ -682,6 +683,12 @@ __log_valid(dblp, number, set_persist, fhpp, flags, statusp)
 		goto err;
 	}
 
+	/* A preallocated log file nothing was written to (log_prealloc.c) */
+	if (hdr->prev == 0 && hdr->len == 0 && persist->magic == 0) {
+		status = DB_LV_INCOMPLETE;
+		goto err;
+	}
+
 	if (LOG_SWAPPED())
 		__log_hdrswap(hdr, CRYPTO_ON(dbenv));
 
@@ -1124,6 +1131,79 @@ err:	R_UNLOCK(dbenv, &dblp->reginfo);
 	return (ret);
 }
 
+/*
+ * __log_vrestart --
+ *	Throw away the whole log and start a new one at log file lsn->file.
+ * lsn is the first record of that file in the master's log; it must be
+ * where our first record goes too.  This is used when a replication
+ * client has caught up by page and gets the master's log from there.
+ *
+ * PUBLIC: int __log_vrestart __P((DB_ENV *, DB_LSN *));
+ */
+int
+__log_vrestart(dbenv, lsn)
+	DB_ENV *dbenv;
+	DB_LSN *lsn;
+{
+	DB_LOG *dblp;
+	DB_MUTEX *flush_mutexp;
+	LOG *lp;
+	u_int32_t fn;
+	char *fname;
+	int ret;
+
+	dblp = (DB_LOG *)dbenv->lg_handle;
+	lp = (LOG *)dblp->reginfo.primary;
+
+	R_LOCK(dbenv, &dblp->reginfo);
+	if ((ret = __log_flush_int(dblp, NULL, 0)) != 0)
+		goto err;
+	if (dblp->lfhp != NULL) {
+		(void)__os_closehandle(dbenv, dblp->lfhp);
+		dblp->lfhp = NULL;
+	}
+
+	/* Remove the old log files, newest first. */
+	for (fn = lp->lsn.file; fn > 0; --fn) {
+		if ((ret = __log_name(dblp, fn, &fname, NULL, 0)) != 0)
+			goto err;
+		if (__os_exists(fname, NULL) != 0) {
+			__os_free(dbenv, fname);
+			break;
+		}
+		ret = __os_unlink(dbenv, fname);
+		__os_free(dbenv, fname);
+		if (ret != 0)
+			goto err;
+	}
+
+	lp->lsn.file = lsn->file;
+	lp->lsn.offset = 0;
+	lp->len = 0;
+	lp->w_off = 0;
+	ZERO_LSN(lp->f_lsn);
+	ZERO_LSN(lp->cached_ckp_lsn);
+	flush_mutexp = R_ADDR(&dblp->reginfo, lp->flush_mutex_off);
+	MUTEX_LOCK(dbenv, flush_mutexp);
+	lp->s_lsn = lp->lsn;
+	MUTEX_UNLOCK(dbenv, flush_mutexp);
+
+	if ((ret = __log_newfile(dblp, NULL)) != 0)
+		goto err;
+	if (log_compare(&lp->lsn, lsn) != 0) {
+		__db_err(dbenv,
+		    "log restart at %lu:%lu but first record is at %lu:%lu",
+		    (u_long)lsn->file, (u_long)lsn->offset,
+		    (u_long)lp->lsn.file, (u_long)lp->lsn.offset);
+		ret = EINVAL;
+		goto err;
+	}
+	lp->fileop_lsn = lp->fileop_from = lp->lsn;
+
+err:	R_UNLOCK(dbenv, &dblp->reginfo);
+	return (ret);
+}
+
 /*
  * __log_is_outdated --
  *	Used by the replication system to identify if a client's logs
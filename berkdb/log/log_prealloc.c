@@ -0,0 +1,279 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1996-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <errno.h>
+#include <stdio.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+#include <pthread.h>
+
+#include "db_int.h"
+#include "dbinc/log.h"
+
+/*
+ * Log file preallocation.
+ *
+ * Writing into a new log file allocates its blocks and grows it, so the
+ * fsyncs on the commit path also wait for the filesystem to journal that.
+ * With gbl_log_prealloc_files set we keep that many spare log files around,
+ * each already written out with zeros to the log file size.  When the log
+ * moves to a new file it renames a spare to the new name, and log writes
+ * only overwrite blocks that exist.  The zeros read as the end of the log,
+ * as they do after __log_vtruncate.
+ *
+ * A spare is prepared under the "recycle" name and renamed to the "spare"
+ * name once it's all zeros and synced.  With gbl_log_recycle, log files that
+ * are no longer needed are renamed to a free "recycle" slot instead of being
+ * removed; the next __log_prealloc zeros them over in place.
+ *
+ * Every rename is followed by a sync of the log directory.  The new log file
+ * holds synced commits as soon as the log writes into it, and without the
+ * directory sync a crash could bring it back under its spare name.
+ */
+#define	LOG_SPARE_MAX		64
+#define	LOG_SPARE_NAME		"__dblog.spare.%02d"
+#define	LOG_RECYCLE_NAME	"__dblog.recycle.%02d"
+
+int gbl_log_prealloc_files = 0;
+int gbl_log_recycle = 0;
+
+/* Serializes preparing spares with recycling old log files into them */
+static pthread_mutex_t log_spare_lk = PTHREAD_MUTEX_INITIALIZER;
+
+static int
+__log_spare_name(dbenv, fmt, slot, namep)
+	DB_ENV *dbenv;
+	const char *fmt;
+	int slot;
+	char **namep;
+{
+	char buf[32];
+
+	(void)snprintf(buf, sizeof(buf), fmt, slot);
+	return (__db_appname(dbenv, DB_APP_LOG, buf, 0, NULL, namep));
+}
+
+static int
+__log_spare_nslots()
+{
+	int n;
+
+	n = gbl_log_prealloc_files;
+	return (n < 0 ? 0 : n > LOG_SPARE_MAX ? LOG_SPARE_MAX : n);
+}
+
+/*
+ * Sync the log directory, so that the renames in it survive a crash.
+ */
+static int
+__log_sync_dir(dbenv)
+	DB_ENV *dbenv;
+{
+	char *dir;
+	int ret;
+
+	if ((ret = __db_appname(dbenv, DB_APP_LOG, NULL, 0, NULL, &dir)) != 0)
+		return (ret);
+	ret = __os_fsync_dir(dbenv, dir);
+	__os_free(dbenv, dir);
+	return (ret);
+}
+
+/*
+ * Write zeros over all of the file at path, and at least len bytes of it,
+ * then sync it.
+ */
+static int
+__log_zero_file(dbenv, path, len, mode)
+	DB_ENV *dbenv;
+	const char *path;
+	u_int32_t len;
+	int mode;
+{
+	DB_FH *fhp;
+	u_int32_t mbytes, bytes;
+	size_t nbytes, nw;
+	u_int64_t size;
+	void *buf;
+	int ret, t_ret;
+
+	if ((ret = __os_open(dbenv, path, DB_OSO_CREATE, mode, &fhp)) != 0)
+		return (ret);
+	if ((ret = __os_ioinfo(dbenv, path, fhp, &mbytes, &bytes, NULL)) != 0)
+		goto err;
+	size = (u_int64_t)mbytes * MEGABYTE + bytes;
+	if (size < len)
+		size = len;
+	if ((ret = __os_calloc(dbenv, 1, MEGABYTE, &buf)) != 0)
+		goto err;
+	if ((ret = __os_seek(dbenv, fhp, 0, 0, 0, 0, DB_OS_SEEK_SET)) != 0)
+		goto done;
+	while (size > 0) {
+		nbytes = size > MEGABYTE ? MEGABYTE : (size_t)size;
+		if ((ret = __os_write(dbenv, fhp, buf, nbytes, &nw)) != 0)
+			goto done;
+		size -= nbytes;
+	}
+	ret = __os_fsync(dbenv, fhp);
+done:	__os_free(dbenv, buf);
+err:	if ((t_ret = __os_closehandle(dbenv, fhp)) != 0 && ret == 0)
+		ret = t_ret;
+	return (ret);
+}
+
+/*
+ * __log_prealloc --
+ *	Prepare spare log files until there are gbl_log_prealloc_files of them.
+ *	Sets *nmadep to the number prepared.
+ *
+ * PUBLIC: int __log_prealloc __P((DB_ENV *, int *));
+ */
+int
+__log_prealloc(dbenv, nmadep)
+	DB_ENV *dbenv;
+	int *nmadep;
+{
+	DB_LOG *dblp;
+	LOG *lp;
+	char *spare, *recycle;
+	int nslots, ret, slot;
+
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+	*nmadep = 0;
+	ret = 0;
+
+	nslots = __log_spare_nslots();
+	for (slot = 0; slot < nslots && ret == 0; ++slot) {
+		spare = recycle = NULL;
+		if ((ret = __log_spare_name(dbenv,
+		    LOG_SPARE_NAME, slot, &spare)) != 0 ||
+		    (ret = __log_spare_name(dbenv,
+		    LOG_RECYCLE_NAME, slot, &recycle)) != 0)
+			goto next;
+		if (__os_exists(spare, NULL) == 0)
+			goto next;
+
+		pthread_mutex_lock(&log_spare_lk);
+		if ((ret = __log_zero_file(dbenv,
+		    recycle, lp->log_size, lp->persist.mode)) == 0 &&
+		    (ret = __os_rename(dbenv, recycle, spare, 0)) == 0 &&
+		    (ret = __log_sync_dir(dbenv)) == 0)
+			++*nmadep;
+		pthread_mutex_unlock(&log_spare_lk);
+		if (ret != 0)
+			__db_err(dbenv, "can't prepare spare log file %s: %s",
+			    spare, db_strerror(ret));
+
+next:		if (spare != NULL)
+			__os_free(dbenv, spare);
+		if (recycle != NULL)
+			__os_free(dbenv, recycle);
+	}
+	return (ret);
+}
+
+/*
+ * __log_recycle --
+ *	Log file path is no longer needed.  Keep it to be made into a spare if
+ *	there is room for it, otherwise remove it.
+ *
+ * PUBLIC: int __log_recycle __P((DB_ENV *, const char *));
+ */
+int
+__log_recycle(dbenv, path)
+	DB_ENV *dbenv;
+	const char *path;
+{
+	DB_LOG *dblp;
+	LOG *lp;
+	char *spare, *recycle;
+	int nslots, ret, slot;
+
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+
+	nslots = gbl_log_recycle ? __log_spare_nslots() : 0;
+	pthread_mutex_lock(&log_spare_lk);
+	for (slot = 0; slot < nslots; ++slot) {
+		spare = recycle = NULL;
+		if (__log_spare_name(dbenv, LOG_SPARE_NAME, slot, &spare) != 0 ||
+		    __log_spare_name(dbenv,
+		    LOG_RECYCLE_NAME, slot, &recycle) != 0 ||
+		    __os_exists(spare, NULL) == 0 ||
+		    __os_exists(recycle, NULL) == 0)
+			ret = EEXIST;
+		else if ((ret = __os_rename(dbenv, path, recycle, 0)) == 0) {
+			(void)__log_sync_dir(dbenv);
+			R_LOCK(dbenv, &dblp->reginfo);
+			++lp->stat.st_recycled;
+			R_UNLOCK(dbenv, &dblp->reginfo);
+		}
+		if (spare != NULL)
+			__os_free(dbenv, spare);
+		if (recycle != NULL)
+			__os_free(dbenv, recycle);
+		if (ret == 0)
+			break;
+	}
+	pthread_mutex_unlock(&log_spare_lk);
+
+	if (slot < nslots)
+		return (0);
+	return (unlink(path) != 0 ? __os_get_errno() : 0);
+}
+
+/*
+ * __log_use_spare --
+ *	Log file number is about to be created; if there is a spare, rename it
+ *	to that file and sync the directory before the log writes into it.
+ *	Called with the region locked.
+ *
+ * PUBLIC: void __log_use_spare __P((DB_LOG *, u_int32_t));
+ */
+void
+__log_use_spare(dblp, number)
+	DB_LOG *dblp;
+	u_int32_t number;
+{
+	DB_ENV *dbenv;
+	LOG *lp;
+	char *name, *spare;
+	int slot;
+
+	dbenv = dblp->dbenv;
+	lp = dblp->reginfo.primary;
+
+	if (__log_spare_nslots() == 0)
+		return;
+	if (__log_name(dblp, number, &name, NULL, 0) != 0)
+		return;
+	if (__os_exists(name, NULL) == 0) {
+		__os_free(dbenv, name);
+		return;
+	}
+	for (slot = 0; slot < LOG_SPARE_MAX; ++slot) {
+		if (__log_spare_name(dbenv, LOG_SPARE_NAME, slot, &spare) != 0)
+			break;
+		if (__os_exists(spare, NULL) == 0 &&
+		    __os_rename(dbenv, spare, name, 0) == 0) {
+			(void)__log_sync_dir(dbenv);
+			++lp->stat.st_prealloc_used;
+			__os_free(dbenv, spare);
+			break;
+		}
+		__os_free(dbenv, spare);
+	}
+	__os_free(dbenv, name);
+}
@@ -38,6 +38,7 @@ static const char revid[] = "$Id: log_put.c,v 11.145 2003/09/13 19:20:39 bostic
 #include "dbinc/log.h"
 #include "dbinc/db_swap.h"
 #include "dbinc/txn.h"
+#include "dbinc_auto/fileops_auto.h"
 #include <pthread.h>
 
 #include <alloca.h>
@@ -57,6 +58,7 @@ static int __log_fill_segments __P((DB_LOG *, DB_LSN *, DB_LSN *, void *,
 	u_int32_t));
 static int __log_flush_commit __P((DB_ENV *, const DB_LSN *, u_int32_t));
 static int __log_newfh __P((DB_LOG *));
+static void __log_fsync_hist __P((LOG *, uint64_t));
 static int __log_put_next __P((DB_ENV *,
 	DB_LSN *, u_int64_t *, DBT *, const DBT *, HDR *, DB_LSN *, int,
 	u_int8_t *key, u_int32_t));
@@ -559,6 +561,29 @@ __log_txn_lsn(dbenv, lsnp, mbytesp, bytesp)
 	R_UNLOCK(dbenv, &dblp->reginfo);
 }
 
+/*
+ * Note records that create, remove or rename files, and schema change
+ * records (10002, see __rep_classify_type), in fileop_lsn.  Called with
+ * the region locked.
+ */
+static inline void
+__log_note_fileop(lp, rectype, lsnp)
+	LOG *lp;
+	u_int32_t rectype;
+	DB_LSN *lsnp;
+{
+	switch (rectype) {
+	case DB___fop_create:
+	case DB___fop_remove:
+	case DB___fop_write:
+	case DB___fop_rename:
+	case DB___fop_file_remove:
+	case 10002:
+		lp->fileop_lsn = *lsnp;
+		break;
+	}
+}
+
 /*
  * __log_put_next --
  *	Put the given record as the next in the log, wherever that may
@@ -642,6 +667,7 @@ __log_put_next(dbenv, lsn, context, dbt, udbt, hdr, old_lsnp, off_context, key,
 
 	pp = udbt->data;
 	LOGCOPY_32(&rectype, pp);
+	__log_note_fileop(lp, rectype, lsn);
 
 	/* we have the log lsn value, can get context */
 	if (off_context >= 0) {
@@ -1237,6 +1263,24 @@ __log_lwr_lsn(dblp)
 	}
 }
 
+/*
+ * __log_fsync_hist --
+ *	Count a log sync that took usecs microseconds.  Bucket i counts syncs
+ *	under 32 << i usecs, the last bucket everything longer.
+ */
+static void
+__log_fsync_hist(lp, usecs)
+	LOG *lp;
+	uint64_t usecs;
+{
+	int i;
+
+	for (i = 0; i < DB_LOG_FSYNC_BUCKETS - 1 &&
+	    usecs >= ((uint64_t)32 << i); ++i)
+		;
+	++lp->stat.st_fsync_hist[i];
+}
+
 /*
  * __log_flush_int --
  *	Write all records less than or equal to the specified LSN; internal
@@ -1262,6 +1306,7 @@ __log_flush_int(dblp, lsnp, release)
 	size_t b_off;
 	u_int32_t ncommit, w_off, listcnt;
 	int do_flush, first, ret, wrote_inmem;
+	uint64_t sync_start;
 
 	dbenv = dblp->dbenv;
 	lp = dblp->reginfo.primary;
@@ -1488,6 +1533,7 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 		R_UNLOCK(dbenv, &dblp->reginfo);
 
 	/* Sync all writes to disk. */
+	sync_start = bb_berkdb_fasttime();
 	if ((ret = __os_fsync(dbenv, dblp->lfhp)) != 0) {
 		MUTEX_UNLOCK(dbenv, flush_mutexp);
 		if (release)
@@ -1520,6 +1566,7 @@ flush:	MUTEX_LOCK(dbenv, flush_mutexp);
 
 	lp->in_flush--;
 	++lp->stat.st_scount;
+	__log_fsync_hist(lp, bb_berkdb_fasttime() - sync_start);
 
 	/*
 	 * How many flush calls (usually commits) did this call actually sync?
@@ -2044,6 +2091,7 @@ __log_newfh(dblp)
 
 	/* Get the path of the new file and open it. */
 	dblp->lfname = lp->lsn.file;
+	__log_use_spare(dblp, dblp->lfname);
 	if ((ret = __log_valid(dblp, dblp->lfname, 0, &dblp->lfhp,
 	    flags, &status)) != 0)
 		__db_err(dbenv,
@@ -2170,6 +2218,7 @@ __log_rep_put(dbenv, lsnp, rec)
 	HDR hdr;
 	DBT *dbt, t;
 	LOG *lp;
+	u_int32_t rectype;
 	int need_free, ret;
 
 	dblp = dbenv->lg_handle;
@@ -2199,6 +2248,8 @@ __log_rep_put(dbenv, lsnp, rec)
 	    (CRYPTO_ON(dbenv)) ? db_cipher->mac_key : NULL, hdr.chksum);
 
 	DB_ASSERT(log_compare(lsnp, &lp->lsn) == 0);
+	LOGCOPY_32(&rectype, rec->data);
+	__log_note_fileop(lp, rectype, lsnp);
 	ret = __log_putr(dblp, lsnp, dbt, lp->lsn.offset - lp->len, &hdr);
 err:
 	/*
@@ -291,6 +291,85 @@ __dir_pgread(dbmfp, pgno, page)
 	return __dir_pgread_multi(dbmfp, pgno, &numpages, page);
 }
 
+/*
+ * __dir_pgwrite --
+ *  Write a page, as it is on disk, to a file without going through the
+ *  buffer-pool, and drop any cached copy.  Nothing checks that the log
+ *  covers the page; the caller must.  Returns EBUSY, without writing, if
+ *  the cached copy is in use or dirty.
+ *
+ * PUBLIC: int __dir_pgwrite __P((DB_MPOOLFILE *, db_pgno_t pgno, u_int8_t *page ));
+ */
+int
+__dir_pgwrite(dbmfp, pgno, page)
+	DB_MPOOLFILE *dbmfp;
+	db_pgno_t pgno;
+	u_int8_t *page;
+{
+	BH *bhp;
+	DB_ENV *dbenv;
+	DB_MPOOL *dbmp;
+	DB_MPOOL_HASH *hp;
+	MPOOL *c_mp, *mp;
+	MPOOLFILE *mfp;
+	roff_t mf_offset;
+	size_t nw, pagesize;
+	u_int32_t n_cache;
+	int ret;
+
+	dbenv = dbmfp->dbenv;
+	dbmp = dbenv->mp_handle;
+	mp = dbmp->reginfo[0].primary;
+	mfp = dbmfp->mfp;
+	mf_offset = R_OFFSET(dbmp->reginfo, mfp);
+	pagesize = mfp->stat.st_pagesize;
+
+	if (dbmfp->fhp == NULL || F_ISSET(dbmfp, MP_READONLY))
+		return (EINVAL);
+
+	n_cache = NCACHE(mp, mf_offset, pgno);
+	c_mp = dbmp->reginfo[n_cache].primary;
+	hp = R_ADDR(&dbmp->reginfo[n_cache], c_mp->htab);
+	hp = &hp[NBUCKET(c_mp, mf_offset, pgno)];
+
+	/*
+	 * Hold the hash bucket across the write, so no one can read the old
+	 * page back into the cache between dropping it and writing the new one.
+	 */
+	MUTEX_LOCK(dbenv, &hp->hash_mutex);
+	for (bhp = SH_TAILQ_FIRST(&hp->hash_bucket, __bh);
+	    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh))
+		if (bhp->pgno == pgno && bhp->mf_offset == mf_offset)
+			break;
+	if (bhp != NULL && (bhp->ref != 0 ||
+	    F_ISSET(bhp, BH_DIRTY | BH_DIRTY_CREATE | BH_LOCKED))) {
+		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+		return (EBUSY);
+	}
+
+	if ((ret = __os_io(dbenv, DB_IO_WRITE,
+	    dbmfp->fhp, pgno, pagesize, page, &nw)) != 0) {
+		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+		__db_err(dbenv, "%s: write failed for page %lu",
+		    __memp_fn(dbmfp), (u_long)pgno);
+		return (ret);
+	}
+
+	if (bhp != NULL)
+		__memp_bhfree(dbmp, hp, bhp, 1);
+	else
+		MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+
+	R_LOCK(dbenv, dbmp->reginfo);
+	if (pgno > mfp->last_pgno)
+		mfp->last_pgno = pgno;
+	R_UNLOCK(dbenv, dbmp->reginfo);
+
+	mfp->file_written = 1;
+	++mfp->stat.st_page_out;
+	return (0);
+}
+
 /*
  * __memp_recover_page --
  *  Search the recovery-page cache for the latest version of this page.
@@ -735,7 +735,7 @@ alloc:		/*
 		 * will call __memp_bhfree.
 		 */
 		if ((ret = __db_mutex_setup(dbenv,
-		    &dbmp->reginfo[n_cache], &bhp->mutex, 0)) != 0)
+		    &dbmp->reginfo[n_cache], &bhp->mutex, MUTEX_MP_BH)) != 0)
 			goto err;
 	}
 
@@ -135,6 +135,9 @@ __memp_fput_internal(dbmfp, pgaddr, flags, pgorder)
 	/* Convert a page address to a buffer header and hash bucket. */
 	bhp = (BH *)((u_int8_t *)pgaddr - SSZA(BH, buf));
 
+	if (LF_ISSET(DB_MPOOL_DIRTY) && dbmfp->mfp->count_mods)
+		ATOMIC_ADD(dbmfp->mfp->mod_count, 1);
+
 	if ((flags & DB_MPOOL_DIRTY)&&dbenv->attr.check_zero_lsn_writes &&
 	    (dbenv->open_flags & DB_INIT_TXN)) {
 		static const char zerobuf[32] = { 0 };
@@ -91,6 +91,9 @@ __memp_fset(dbmfp, pgaddr, flags)
 	dbenv = dbmfp->dbenv;
 	dbmp = dbenv->mp_handle;
 
+	if (LF_ISSET(DB_MPOOL_DIRTY) && dbmfp->mfp->count_mods)
+		ATOMIC_ADD(dbmfp->mfp->mod_count, 1);
+
 	/* Convert the page address to a buffer header and hash bucket. */
 	bhp = (BH *)((u_int8_t *)pgaddr - SSZA(BH, buf));
 	n_cache = NCACHE(dbmp->reginfo[0].primary, bhp->mf_offset, bhp->pgno);
@@ -122,3 +125,32 @@ __memp_fset(dbmfp, pgaddr, flags)
 	MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
 	return (0);
 }
+
+/*
+ * __memp_count_mods --
+ *	Start counting the pages of a file that get marked dirty.  The count
+ *	goes up while the page is still locked by the transaction (or the
+ *	replication apply) changing it.
+ *
+ * PUBLIC: void __memp_count_mods __P((DB_MPOOLFILE *));
+ */
+void
+__memp_count_mods(dbmfp)
+	DB_MPOOLFILE *dbmfp;
+{
+	dbmfp->mfp->count_mods = 1;
+}
+
+/*
+ * __memp_mod_count --
+ *	Return the number of pages of a file marked dirty since
+ *	__memp_count_mods.
+ *
+ * PUBLIC: u_int32_t __memp_mod_count __P((DB_MPOOLFILE *));
+ */
+u_int32_t
+__memp_mod_count(dbmfp)
+	DB_MPOOLFILE *dbmfp;
+{
+	return (((volatile MPOOLFILE *)dbmfp->mfp)->mod_count);
+}
@@ -267,7 +267,8 @@ __mpool_init(dbenv, dbmp, reginfo_off, htab_buckets)
 	mp->htab = R_OFFSET(reginfo, htab);
 	for (i = 0; i < htab_buckets; i++) {
 		if ((ret = __db_mutex_setup(dbenv,
-			    reginfo, &htab[i].hash_mutex, MUTEX_NO_RLOCK)) != 0)
+			    reginfo, &htab[i].hash_mutex,
+			    MUTEX_NO_RLOCK | MUTEX_MP_HASH)) != 0)
 			return (ret);
 		SH_TAILQ_INIT(&htab[i].hash_bucket);
 		htab[i].hash_priority = 0;
@@ -0,0 +1,420 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1996-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <errno.h>
+#include <limits.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#endif
+
+#include <pthread.h>
+
+#include "db_int.h"
+#include "dbinc/db_shash.h"
+#include "dbinc/mp.h"
+
+#include <logmsg.h>
+
+/*
+ * Warm restart.
+ *
+ * __memp_save_pagelist writes the pages resident in the cache to a file: the
+ * unique ids of their files, then the file, page number and LRU priority of
+ * every page, hottest first.  __memp_load_pagelist reads that list back into
+ * the cache on startup.  Pages are read in batches of the hottest pages left,
+ * each batch in file and page order, by several threads at once.
+ */
+#define	PAGELIST_MAGIC		0x50474c53	/* "PGLS" */
+#define	PAGELIST_VERSION	1
+#define	PAGELIST_BATCH		256
+
+struct pagelist_hdr {
+	u_int32_t magic;
+	u_int32_t version;
+	u_int32_t nfiles;
+	u_int32_t npages;
+};
+
+struct pagelist_ent {
+	u_int32_t fidx;
+	u_int32_t pgno;
+	u_int32_t priority;
+};
+
+struct pagelist_file {
+	roff_t mf_offset;
+	u_int8_t fileid[DB_FILE_ID_LEN];
+	DB_MPOOLFILE *dbmfp;
+	u_int32_t pagesize;
+};
+
+static int
+pagelist_cmp_mfoff(a, b)
+	const void *a, *b;
+{
+	roff_t x = ((const struct pagelist_file *)a)->mf_offset;
+	roff_t y = ((const struct pagelist_file *)b)->mf_offset;
+
+	return (x < y ? -1 : x > y);
+}
+
+static int
+pagelist_cmp_priority(a, b)
+	const void *a, *b;
+{
+	u_int32_t x = ((const struct pagelist_ent *)a)->priority;
+	u_int32_t y = ((const struct pagelist_ent *)b)->priority;
+
+	return (x > y ? -1 : x < y);
+}
+
+static int
+pagelist_cmp_page(a, b)
+	const void *a, *b;
+{
+	const struct pagelist_ent *x = a, *y = b;
+
+	if (x->fidx != y->fidx)
+		return (x->fidx < y->fidx ? -1 : 1);
+	return (x->pgno < y->pgno ? -1 : x->pgno > y->pgno);
+}
+
+/*
+ * __memp_save_pagelist --
+ *	Write the list of pages in the cache to path.
+ *
+ * PUBLIC: int __memp_save_pagelist __P((DB_ENV *, const char *, u_int32_t *));
+ */
+int
+__memp_save_pagelist(dbenv, path, npagesp)
+	DB_ENV *dbenv;
+	const char *path;
+	u_int32_t *npagesp;
+{
+	BH *bhp;
+	DB_MPOOL *dbmp;
+	DB_MPOOL_HASH *hp;
+	FILE *fp;
+	MPOOL *mp, *c_mp;
+	MPOOLFILE *mfp;
+	struct pagelist_file *files, key, *f;
+	struct pagelist_ent *pages;
+	struct pagelist_hdr hdr;
+	u_int32_t bucket, i, nfiles, npages, maxpages;
+	char tmp[PATH_MAX];
+	int ret;
+
+	dbmp = dbenv->mp_handle;
+	mp = dbmp->reginfo[0].primary;
+	files = NULL;
+	pages = NULL;
+	fp = NULL;
+	nfiles = npages = maxpages = 0;
+	*npagesp = 0;
+
+	/* Files with a backing file, and an id that survives a restart */
+	R_LOCK(dbenv, dbmp->reginfo);
+	for (mfp = SH_TAILQ_FIRST(&mp->mpfq, __mpoolfile);
+	    mfp != NULL; mfp = SH_TAILQ_NEXT(mfp, q, __mpoolfile))
+		++nfiles;
+	if ((ret = __os_calloc(dbenv,
+	    nfiles ? nfiles : 1, sizeof(*files), &files)) != 0) {
+		R_UNLOCK(dbenv, dbmp->reginfo);
+		return (ret);
+	}
+	nfiles = 0;
+	for (mfp = SH_TAILQ_FIRST(&mp->mpfq, __mpoolfile);
+	    mfp != NULL; mfp = SH_TAILQ_NEXT(mfp, q, __mpoolfile)) {
+		if (mfp->deadfile || mfp->no_backing_file ||
+		    F_ISSET(mfp, MP_TEMP) || mfp->fileid_off == 0)
+			continue;
+		files[nfiles].mf_offset = R_OFFSET(dbmp->reginfo, mfp);
+		memcpy(files[nfiles].fileid,
+		    R_ADDR(dbmp->reginfo, mfp->fileid_off), DB_FILE_ID_LEN);
+		++nfiles;
+	}
+	R_UNLOCK(dbenv, dbmp->reginfo);
+	qsort(files, nfiles, sizeof(*files), pagelist_cmp_mfoff);
+
+	for (i = 0; i < mp->nreg; ++i) {
+		c_mp = dbmp->reginfo[i].primary;
+		for (hp = R_ADDR(&dbmp->reginfo[i], c_mp->htab), bucket = 0;
+		    bucket < c_mp->htab_buckets; ++hp, ++bucket) {
+			if (SH_TAILQ_FIRST(&hp->hash_bucket, __bh) == NULL)
+				continue;
+			MUTEX_LOCK(dbenv, &hp->hash_mutex);
+			for (bhp = SH_TAILQ_FIRST(&hp->hash_bucket, __bh);
+			    bhp != NULL; bhp = SH_TAILQ_NEXT(bhp, hq, __bh)) {
+				if (F_ISSET(bhp, BH_TRASH | BH_DISCARD))
+					continue;
+				key.mf_offset = bhp->mf_offset;
+				if ((f = bsearch(&key, files, nfiles,
+				    sizeof(*files), pagelist_cmp_mfoff)) == NULL)
+					continue;
+				if (npages == maxpages) {
+					maxpages = maxpages ? maxpages * 2 : 1024;
+					if ((ret = __os_realloc(dbenv,
+					    maxpages * sizeof(*pages),
+					    &pages)) != 0) {
+						MUTEX_UNLOCK(dbenv,
+						    &hp->hash_mutex);
+						goto err;
+					}
+				}
+				pages[npages].fidx = (u_int32_t)(f - files);
+				pages[npages].pgno = bhp->pgno;
+				pages[npages].priority = bhp->priority;
+				++npages;
+			}
+			MUTEX_UNLOCK(dbenv, &hp->hash_mutex);
+		}
+	}
+	if (npages)
+		qsort(pages, npages, sizeof(*pages), pagelist_cmp_priority);
+
+	/* Write it next to the old list, then swap */
+	snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+	if ((fp = fopen(tmp, "w")) == NULL) {
+		ret = errno;
+		__db_err(dbenv, "can't open %s: %s", tmp, strerror(ret));
+		goto err;
+	}
+	hdr.magic = PAGELIST_MAGIC;
+	hdr.version = PAGELIST_VERSION;
+	hdr.nfiles = nfiles;
+	hdr.npages = npages;
+	if (fwrite(&hdr, sizeof(hdr), 1, fp) != 1)
+		goto werr;
+	for (i = 0; i < nfiles; ++i)
+		if (fwrite(files[i].fileid, DB_FILE_ID_LEN, 1, fp) != 1)
+			goto werr;
+	if (npages && fwrite(pages, sizeof(*pages), npages, fp) != npages)
+		goto werr;
+	if (fflush(fp) != 0 || fsync(fileno(fp)) != 0)
+		goto werr;
+	fclose(fp);
+	fp = NULL;
+	if (rename(tmp, path) != 0) {
+		ret = errno;
+		__db_err(dbenv, "can't rename %s: %s", tmp, strerror(ret));
+		goto err;
+	}
+	*npagesp = npages;
+	ret = 0;
+
+	if (0) {
+werr:		ret = errno ? errno : EIO;
+		__db_err(dbenv, "can't write %s: %s", tmp, strerror(ret));
+	}
+err:	if (fp != NULL) {
+		fclose(fp);
+		unlink(tmp);
+	}
+	if (pages != NULL)
+		__os_free(dbenv, pages);
+	__os_free(dbenv, files);
+	return (ret);
+}
+
+struct pagelist_load {
+	DB_ENV *dbenv;
+	struct pagelist_file *files;
+	struct pagelist_ent *pages;
+	u_int32_t npages;
+	u_int32_t next;		/* next batch to read */
+	u_int64_t budget;	/* bytes we may still read in */
+	u_int32_t nloaded;
+	int (*stop) __P((void *));
+	void *arg;
+	pthread_mutex_t lk;
+};
+
+static void *
+pagelist_load_thd(arg)
+	void *arg;
+{
+	struct pagelist_load *ld = arg;
+	struct pagelist_ent *e;
+	struct pagelist_file *f;
+	u_int32_t first, last, i, nloaded;
+	db_pgno_t pgno;
+	void *pagep;
+
+	for (;;) {
+		pthread_mutex_lock(&ld->lk);
+		first = ld->next;
+		if (first >= ld->npages || ld->budget == 0 ||
+		    (ld->stop != NULL && ld->stop(ld->arg))) {
+			pthread_mutex_unlock(&ld->lk);
+			break;
+		}
+		last = first + PAGELIST_BATCH;
+		if (last > ld->npages)
+			last = ld->npages;
+		ld->next = last;
+		pthread_mutex_unlock(&ld->lk);
+
+		/* The batch's pages in file order */
+		qsort(&ld->pages[first], last - first,
+		    sizeof(struct pagelist_ent), pagelist_cmp_page);
+		nloaded = 0;
+		for (i = first; i < last; ++i) {
+			e = &ld->pages[i];
+			f = &ld->files[e->fidx];
+			if (f->dbmfp == NULL)
+				continue;
+			pgno = e->pgno;
+			if (__memp_fget(f->dbmfp,
+			    &pgno, DB_MPOOL_PFGET, &pagep) != 0)
+				continue;
+			(void)__memp_fput(f->dbmfp, pagep, 0);
+			++nloaded;
+		}
+
+		pthread_mutex_lock(&ld->lk);
+		ld->nloaded += nloaded;
+		for (i = first; i < last; ++i) {
+			f = &ld->files[ld->pages[i].fidx];
+			if (f->dbmfp == NULL)
+				continue;
+			if (ld->budget <= f->pagesize) {
+				ld->budget = 0;
+				break;
+			}
+			ld->budget -= f->pagesize;
+		}
+		pthread_mutex_unlock(&ld->lk);
+	}
+	return (NULL);
+}
+
+/*
+ * __memp_load_pagelist --
+ *	Read the pages listed in path into the cache with nthreads threads.
+ *	Only files this process has open are loaded.  Gives up when stop
+ *	returns non-zero, or when it has read a cache worth of pages.
+ *
+ * PUBLIC: int __memp_load_pagelist __P((DB_ENV *, const char *, int,
+ * PUBLIC:     int (*)(void *), void *, u_int32_t *));
+ */
+int
+__memp_load_pagelist(dbenv, path, nthreads, stop, arg, nloadedp)
+	DB_ENV *dbenv;
+	const char *path;
+	int nthreads;
+	int (*stop) __P((void *));
+	void *arg;
+	u_int32_t *nloadedp;
+{
+	DB_MPOOL *dbmp;
+	DB_MPOOLFILE *dbmfp;
+	FILE *fp;
+	struct pagelist_hdr hdr;
+	struct pagelist_load ld;
+	pthread_t *tids;
+	u_int32_t i;
+	int nstarted, ret;
+
+	dbmp = dbenv->mp_handle;
+	*nloadedp = 0;
+	tids = NULL;
+	memset(&ld, 0, sizeof(ld));
+
+	if ((fp = fopen(path, "r")) == NULL)
+		return (errno);
+	if (fread(&hdr, sizeof(hdr), 1, fp) != 1 ||
+	    hdr.magic != PAGELIST_MAGIC || hdr.version != PAGELIST_VERSION) {
+		__db_err(dbenv, "%s is not a page list", path);
+		fclose(fp);
+		return (EINVAL);
+	}
+	if ((ret = __os_calloc(dbenv, hdr.nfiles ? hdr.nfiles : 1,
+	    sizeof(struct pagelist_file), &ld.files)) != 0 ||
+	    (ret = __os_malloc(dbenv, (hdr.npages ? hdr.npages : 1) *
+	    sizeof(struct pagelist_ent), &ld.pages)) != 0)
+		goto err;
+	for (i = 0; i < hdr.nfiles; ++i)
+		if (fread(ld.files[i].fileid, DB_FILE_ID_LEN, 1, fp) != 1)
+			goto rerr;
+	if (hdr.npages && fread(ld.pages,
+	    sizeof(struct pagelist_ent), hdr.npages, fp) != hdr.npages)
+		goto rerr;
+	for (i = 0; i < hdr.npages; ++i)
+		if (ld.pages[i].fidx >= hdr.nfiles)
+			goto rerr;
+	fclose(fp);
+	fp = NULL;
+
+	/* Hold a reference to our handle of every file we know */
+	MUTEX_THREAD_LOCK(dbenv, dbmp->mutexp);
+	for (i = 0; i < hdr.nfiles; ++i) {
+		for (dbmfp = TAILQ_FIRST(&dbmp->dbmfq);
+		    dbmfp != NULL; dbmfp = TAILQ_NEXT(dbmfp, q)) {
+			if (!F_ISSET(dbmfp, MP_OPEN_CALLED) ||
+			    dbmfp->mfp == NULL || dbmfp->mfp->deadfile ||
+			    dbmfp->mfp->fileid_off == 0)
+				continue;
+			if (memcmp(R_ADDR(dbmp->reginfo, dbmfp->mfp->fileid_off),
+			    ld.files[i].fileid, DB_FILE_ID_LEN) == 0)
+				break;
+		}
+		if (dbmfp != NULL) {
+			++dbmfp->ref;
+			ld.files[i].dbmfp = dbmfp;
+			ld.files[i].pagesize = dbmfp->mfp->stat.st_pagesize;
+		}
+	}
+	MUTEX_THREAD_UNLOCK(dbenv, dbmp->mutexp);
+
+	ld.dbenv = dbenv;
+	ld.npages = hdr.npages;
+	ld.budget = (u_int64_t)dbenv->mp_gbytes * GIGABYTE + dbenv->mp_bytes;
+	ld.stop = stop;
+	ld.arg = arg;
+	pthread_mutex_init(&ld.lk, NULL);
+
+	if (nthreads < 1)
+		nthreads = 1;
+	nstarted = 0;
+	if ((ret = __os_calloc(dbenv, nthreads, sizeof(*tids), &tids)) == 0)
+		for (; nstarted < nthreads; ++nstarted)
+			if (pthread_create(&tids[nstarted],
+			    NULL, pagelist_load_thd, &ld) != 0)
+				break;
+	/* No threads, read them ourselves */
+	if (nstarted == 0)
+		(void)pagelist_load_thd(&ld);
+	for (i = 0; i < (u_int32_t)nstarted; ++i)
+		pthread_join(tids[i], NULL);
+	pthread_mutex_destroy(&ld.lk);
+	*nloadedp = ld.nloaded;
+	ret = 0;
+
+	for (i = 0; i < hdr.nfiles; ++i)
+		if (ld.files[i].dbmfp != NULL)
+			(void)__memp_fclose(ld.files[i].dbmfp, 0);
+
+	if (0) {
+rerr:		__db_err(dbenv, "%s is truncated", path);
+		ret = EINVAL;
+	}
+err:	if (fp != NULL)
+		fclose(fp);
+	if (tids != NULL)
+		__os_free(dbenv, tids);
+	if (ld.pages != NULL)
+		__os_free(dbenv, ld.pages);
+	if (ld.files != NULL)
+		__os_free(dbenv, ld.files);
+	return (ret);
+}
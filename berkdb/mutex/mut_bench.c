@@ -0,0 +1,139 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 1999-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <stdio.h>
+#include <string.h>
+#endif
+
+#include <pthread.h>
+
+#include "db_int.h"
+
+#include <logmsg.h>
+
+/*
+ * Mutex benchmark: nthreads threads take one mutex nops times each, hold it
+ * for a few cache line writes (like an mpool hash bucket) and do a little
+ * work between takes.  It is run once with the mutex blocking right away as
+ * it always has, and once spinning adaptively.
+ */
+#define	BENCH_HELD_WORK		16
+#define	BENCH_FREE_WORK		64
+
+struct mutex_bench {
+	DB_ENV *dbenv;
+	DB_MUTEX *mutexp;
+	int nops;
+	volatile u_int64_t shared[8];
+};
+
+static void *
+__db_mutex_bench_thd(arg)
+	void *arg;
+{
+	struct mutex_bench *b = arg;
+	volatile u_int64_t local;
+	int i, j;
+
+	local = 0;
+	for (i = 0; i < b->nops; ++i) {
+		MUTEX_LOCK(b->dbenv, b->mutexp);
+		for (j = 0; j < BENCH_HELD_WORK; ++j)
+			++b->shared[j % 8];
+		MUTEX_UNLOCK(b->dbenv, b->mutexp);
+		for (j = 0; j < BENCH_FREE_WORK; ++j)
+			local += j;
+	}
+	return (NULL);
+}
+
+static int
+__db_mutex_bench_run(dbenv, nthreads, nops, flags, usecsp, st)
+	DB_ENV *dbenv;
+	int nthreads, nops;
+	u_int32_t flags;
+	u_int64_t *usecsp;
+	DB_MUTEX *st;
+{
+	struct mutex_bench b;
+	pthread_t *tids;
+	u_int64_t start;
+	int i, nstarted, ret;
+
+	memset(&b, 0, sizeof(b));
+	b.dbenv = dbenv;
+	b.nops = nops;
+	if ((ret = __os_calloc(dbenv, 1, sizeof(DB_MUTEX), &b.mutexp)) != 0)
+		return (ret);
+	if ((ret = __db_pthread_mutex_init(dbenv, b.mutexp, 0)) != 0)
+		goto err;
+	F_SET(b.mutexp, flags);
+	if ((ret = __os_calloc(dbenv, nthreads, sizeof(*tids), &tids)) != 0)
+		goto done;
+
+	start = bb_berkdb_fasttime();
+	for (nstarted = 0; nstarted < nthreads; ++nstarted)
+		if ((ret = pthread_create(&tids[nstarted],
+		    NULL, __db_mutex_bench_thd, &b)) != 0)
+			break;
+	for (i = 0; i < nstarted; ++i)
+		pthread_join(tids[i], NULL);
+	*usecsp = bb_berkdb_fasttime() - start;
+	*st = *b.mutexp;
+
+	__os_free(dbenv, tids);
+done:	(void)__db_pthread_mutex_destroy(b.mutexp);
+err:	__os_free(dbenv, b.mutexp);
+	return (ret);
+}
+
+/*
+ * __db_mutex_bench --
+ *	Run the mutex benchmark with nthreads threads, blocking and adaptive.
+ *
+ * PUBLIC: int __db_mutex_bench __P((DB_ENV *, int, int, FILE *));
+ */
+int
+__db_mutex_bench(dbenv, nthreads, nops, out)
+	DB_ENV *dbenv;
+	int nthreads, nops;
+	FILE *out;
+{
+	static const struct {
+		const char *name;
+		u_int32_t flags;
+	} modes[] = {
+		{ "blocking", MUTEX_NO_ADAPTIVE },
+		{ "adaptive", MUTEX_ADAPTIVE }
+	};
+	DB_MUTEX st;
+	u_int64_t usecs;
+	int i, ret;
+
+	if (nthreads < 1 || nops < 1)
+		return (EINVAL);
+	for (i = 0; i < 2; ++i) {
+		if ((ret = __db_mutex_bench_run(dbenv,
+		    nthreads, nops, modes[i].flags, &usecs, &st)) != 0)
+			return (ret);
+		logmsgf(LOGMSG_USER, out,
+		    "mutexbench %s threads %d ops %llu usecs %llu "
+		    "ops/sec %llu nowait %u spin %u spins %u wait %u "
+		    "spin_limit %u\n", modes[i].name, nthreads,
+		    (unsigned long long)nthreads * nops,
+		    (unsigned long long)usecs,
+		    usecs ? (unsigned long long)nthreads * nops * 1000000 /
+		    usecs : 0ULL, st.mutex_set_nowait, st.mutex_set_spin,
+		    st.mutex_set_spins, st.mutex_set_wait, st.spin_limit);
+	}
+	return (0);
+}
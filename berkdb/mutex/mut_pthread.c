@@ -58,6 +58,76 @@ static const char revid[] = "$Id: mut_pthread.c,v 11.57 2003/05/05 19:55:03 bost
 
 #define	PTHREAD_UNLOCK_ATTEMPTS	5
 
+/*
+ * Adaptive mutexes.
+ *
+ * With gbl_berkdb_mutex_adaptive, a thread that finds a mutex held spins for
+ * it before blocking in pthread_mutex_lock (a futex wait on Linux).  It waits
+ * for the mutex to look free, pausing 1, 2, 4 .. MUTEX_BACKOFF_MAX times
+ * between looks, and tries to take it when it does.  Each mutex learns how
+ * long to spin: getting the mutex after s spins moves its limit toward 2s,
+ * having to block cuts it by a quarter.  Short critical sections (mpool
+ * hash buckets and buffers) settle on spinning; oversubscribed or long held
+ * ones settle on blocking almost at once.
+ */
+#define	MUTEX_SPIN_MIN		16
+#define	MUTEX_BACKOFF_MAX	64
+
+#if defined(__x86_64__) || defined(__i386__)
+#define	MUTEX_SPIN_PAUSE()	__asm__ __volatile__("pause")
+#elif defined(__aarch64__)
+#define	MUTEX_SPIN_PAUSE()	__asm__ __volatile__("yield")
+#else
+#define	MUTEX_SPIN_PAUSE()
+#endif
+
+int gbl_berkdb_mutex_adaptive = 0;
+int gbl_berkdb_mutex_spin_max = 2000;
+
+static int
+__db_pthread_mutex_lock_adaptive(mutexp)
+	DB_MUTEX *mutexp;
+{
+	struct __db_mutex_class_stat *st;
+	u_int32_t delay, i, limit, spins;
+
+	if (pthread_mutex_trylock(&mutexp->mutex) == 0) {
+		++mutexp->mutex_set_nowait;
+		return (0);
+	}
+
+	limit = mutexp->spin_limit;
+	if (limit > (u_int32_t)gbl_berkdb_mutex_spin_max)
+		limit = gbl_berkdb_mutex_spin_max;
+	if (limit < MUTEX_SPIN_MIN)
+		limit = MUTEX_SPIN_MIN;
+	st = &__db_mutex_class_stats[mutexp->mclass];
+
+	for (spins = 0, delay = 1; spins < limit;) {
+		for (i = 0; i < delay; ++i)
+			MUTEX_SPIN_PAUSE();
+		spins += delay;
+		if (((volatile DB_MUTEX *)mutexp)->locked == 0 &&
+		    pthread_mutex_trylock(&mutexp->mutex) == 0) {
+			++mutexp->mutex_set_spin;
+			mutexp->mutex_set_spins += spins;
+			mutexp->spin_limit = limit +
+			    ((int)(2 * spins) - (int)limit) / 8;
+			(void)__sync_fetch_and_add(&st->spin, 1);
+			(void)__sync_fetch_and_add(&st->spins, spins);
+			return (0);
+		}
+		if (delay < MUTEX_BACKOFF_MAX)
+			delay <<= 1;
+	}
+
+	/* Spinning didn't pay this time */
+	mutexp->spin_limit = limit - limit / 4;
+	++mutexp->mutex_set_wait;
+	(void)__sync_fetch_and_add(&st->wait, 1);
+	return (pthread_mutex_lock(&mutexp->mutex));
+}
+
 /*
  * __db_pthread_mutex_init --
  *	Initialize a DB_MUTEX.
@@ -230,6 +300,12 @@ __db_pthread_mutex_lock(dbenv, mutexp)
 	if (nspins == 0 && (ret = pthread_mutex_lock(&mutexp->mutex)) != 0)
 		goto err;
 #else
+	if (!F_ISSET(mutexp, MUTEX_SELF_BLOCK | MUTEX_NO_ADAPTIVE) &&
+	    (gbl_berkdb_mutex_adaptive || F_ISSET(mutexp, MUTEX_ADAPTIVE))) {
+		if ((ret = __db_pthread_mutex_lock_adaptive(mutexp)) != 0)
+			goto err;
+		goto locked;
+	}
 	/*
 	 * We want to know which mutexes are contentious, but don't want to
 	 * do an interlocked test here -- that's slower when the underlying
@@ -244,6 +320,7 @@ __db_pthread_mutex_lock(dbenv, mutexp)
 	if ((ret = pthread_mutex_lock(&mutexp->mutex)) != 0) {
 		goto err;
 	}
+locked:
 #endif
 
 	if (F_ISSET(mutexp, MUTEX_SELF_BLOCK)) {
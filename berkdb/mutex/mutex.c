@@ -14,11 +14,14 @@ static const char revid[] = "$Id: mutex.c,v 11.39 2003/04/23 19:43:37 bostic Exp
 #ifndef NO_SYSTEM_INCLUDES
 #include <sys/types.h>
 
+#include <stdio.h>
 #include <string.h>
 #endif
 
 #include "db_int.h"
 
+#include <logmsg.h>
+
 #if	defined(MUTEX_NO_MALLOC_LOCKS) || defined(HAVE_MUTEX_SYSTEM_RESOURCES)
 #include "dbinc/db_shash.h"
 #include "dbinc/lock.h"
@@ -28,10 +31,66 @@ static const char revid[] = "$Id: mutex.c,v 11.39 2003/04/23 19:43:37 bostic Exp
 #endif
 
 static int __db_mutex_alloc_int __P((DB_ENV *, REGINFO *, DB_MUTEX **));
+static u_int32_t __db_mutex_class __P((REGINFO *, u_int32_t));
 #ifdef	HAVE_MUTEX_SYSTEM_RESOURCES
 static REGMAINT * __db_mutex_maint __P((DB_ENV *, REGINFO *));
 #endif
 
+struct __db_mutex_class_stat __db_mutex_class_stats[MUTEX_CLASS_MAX];
+
+static const char *__db_mutex_class_names[MUTEX_CLASS_MAX] = {
+	"other", "env", "lock", "log", "mpool", "mpool_hash", "mpool_buffer",
+	"txn"
+};
+
+static u_int32_t
+__db_mutex_class(infop, flags)
+	REGINFO *infop;
+	u_int32_t flags;
+{
+	if (LF_ISSET(MUTEX_MP_HASH))
+		return (MUTEX_CLASS_MP_HASH);
+	if (LF_ISSET(MUTEX_MP_BH))
+		return (MUTEX_CLASS_MP_BH);
+	switch (infop->type) {
+	case REGION_TYPE_ENV:
+		return (MUTEX_CLASS_ENV);
+	case REGION_TYPE_LOCK:
+		return (MUTEX_CLASS_LOCK);
+	case REGION_TYPE_LOG:
+		return (MUTEX_CLASS_LOG);
+	case REGION_TYPE_MPOOL:
+		return (MUTEX_CLASS_MPOOL);
+	case REGION_TYPE_TXN:
+		return (MUTEX_CLASS_TXN);
+	default:
+		return (MUTEX_CLASS_OTHER);
+	}
+}
+
+/*
+ * __db_mutex_class_stat_print --
+ *	Print the contention counters of each mutex class.
+ *
+ * PUBLIC: void __db_mutex_class_stat_print __P((FILE *));
+ */
+void
+__db_mutex_class_stat_print(out)
+	FILE *out;
+{
+	struct __db_mutex_class_stat *st;
+	int i;
+
+	for (i = 0; i < MUTEX_CLASS_MAX; ++i) {
+		st = &__db_mutex_class_stats[i];
+		logmsgf(LOGMSG_USER, out,
+		    "%-14s spin %llu spins %llu wait %llu\n",
+		    __db_mutex_class_names[i], (unsigned long long)st->spin,
+		    (unsigned long long)st->spins,
+		    (unsigned long long)st->wait);
+	}
+}
+
 /*
  * __db_mutex_setup --
  *	External interface to allocate, and/or initialize, record
@@ -94,6 +153,8 @@ __db_mutex_setup(dbenv, infop, ptr, flags)
 #endif
 
 	ret = __db_mutex_init(dbenv, mutex, offset, iflags, infop, maint);
+	if (ret == 0)
+		mutex->mclass = __db_mutex_class(infop, flags);
 err:
 #if	defined(MUTEX_NO_MALLOC_LOCKS) || defined(HAVE_MUTEX_SYSTEM_RESOURCES)
 	if (!LF_ISSET(MUTEX_NO_RLOCK))
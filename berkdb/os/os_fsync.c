@@ -191,3 +191,40 @@ __os_fsync(dbenv, fhp)
 	return (ret);
 
 }
+
+/*
+ * __os_fsync_dir --
+ *	Flush a directory, so that the files created, renamed or removed in
+ *	it stay that way after a crash.
+ *
+ * PUBLIC: int __os_fsync_dir __P((DB_ENV *, const char *));
+ */
+int
+__os_fsync_dir(dbenv, dir)
+	DB_ENV *dbenv;
+	const char *dir;
+{
+	int fd, ret, retries;
+
+	if (dir == NULL || dir[0] == '\0')
+		dir = ".";
+	if ((fd = open(dir, O_RDONLY)) == -1) {
+		ret = __os_get_errno();
+		__db_err(dbenv, "open %s: %s", dir, strerror(ret));
+		return (ret);
+	}
+	retries = 0;
+	do {
+		ret = fsync(fd);
+	} while (ret != 0 &&
+	    ((ret = __os_get_errno()) == EINTR || ret == EBUSY) &&
+	    ++retries < DB_RETRY);
+	(void)close(fd);
+
+	if (__berkdb_num_fsyncs)
+		(*__berkdb_num_fsyncs)++;
+
+	if (ret != 0)
+		__db_err(dbenv, "fsync %s: %s", dir, strerror(ret));
+	return (ret);
+}
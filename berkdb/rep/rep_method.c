@@ -103,6 +103,9 @@ __rep_dbenv_create(dbenv)
 		dbenv->rep_flush = __rep_flush;
 		dbenv->rep_process_message = __rep_process_message;
 		dbenv->rep_verify_will_recover = __rep_verify_will_recover;
+		dbenv->rep_pgcatchup_will_install =
+		    __rep_pgcatchup_will_install;
+		dbenv->rep_pgcatchup_pending = __rep_pgcatchup_pending;
 		dbenv->rep_start = __rep_start;
 		dbenv->rep_stat = __rep_stat;
 		dbenv->get_rep_gen = __rep_get_gen;
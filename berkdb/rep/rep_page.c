@@ -0,0 +1,1167 @@
+/*-
+ * See the file LICENSE for redistribution information.
+ *
+ * Copyright (c) 2001-2003
+ *	Sleepycat Software.  All rights reserved.
+ */
+
+#include "db_config.h"
+
+#ifndef NO_SYSTEM_INCLUDES
+#include <sys/types.h>
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+#endif
+
+#include <pthread.h>
+
+#include "db_int.h"
+#include "dbinc/db_page.h"
+#include "dbinc/db_swap.h"
+#include "dbinc/lock.h"
+#include "dbinc/log.h"
+#include "dbinc/mp.h"
+#include "dbinc/txn.h"
+#include "dbinc_auto/txn_auto.h"
+
+#include <logmsg.h>
+
+/*
+ * Page catch-up.
+ *
+ * A client that has verified its log against the master normally asks for
+ * every log record after its last one (REP_ALL_REQ) and applies them.  When
+ * it is far behind, that takes as long as the master took to write them.
+ * With gbl_rep_page_catchup_mb set, the client asks to catch up by page
+ * instead (REP_PLIST_REQ, lsn is its last record).  If the master is at
+ * least that many MB of log ahead, it answers REP_PLIST_START and sends
+ * every page whose LSN is newer than the client's last record (REP_PAGE),
+ * then REP_PLIST_DONE.  Otherwise it answers REP_PLIST_DECLINE and the
+ * client asks for the log as it always has.
+ *
+ * The master reads pages from its files, not its buffer pool, as a hot copy
+ * would: a page in the buffer pool may be newer than the master's durable
+ * log, and a file page never is.  Before it starts reading, the master picks
+ * where the client's log will start: the first record of the log file
+ * holding its last checkpoint's ckp_lsn, the same log files it keeps for its
+ * own recovery.  Every change before ckp_lsn is in the files, and every
+ * change after it is in that log.  REP_PLIST_DONE carries that LSN.
+ *
+ * The client's log ends before the pages it gets, so it must not let its
+ * buffer pool write them (that would flush the log up to each page's LSN).
+ * It spools the pages to a file as they come, and installs them all once the
+ * master is done, under one bdb writelock: it writes each page straight to
+ * its file, under a page write lock, and drops any cached copy.  Then it
+ * syncs the files, throws its log away, starts a new log there, and asks for
+ * the log from there.  Redo skips records a page already has, as it does
+ * after a checkpoint.  Pages the master doesn't send were not changed since
+ * the client's last record, so the client's copy is current as of that
+ * record.
+ *
+ * From the first page it installs until its log passes the newest of them,
+ * the client's files are ahead of its log.  Before installing it writes that
+ * LSN to a marker file, and a client that starts with the marker doesn't
+ * come up until its log gets there (__rep_pgcatchup_pending).
+ *
+ * Skipping the log between the client's last record and the new start
+ * means the client never sees those records.  The master declines if any
+ * of them created, removed or renamed a file or finished a schema change,
+ * or if it doesn't know (they are from before it opened its log region).
+ *
+ * A client that gets a new master while its pages are newer than its log
+ * can't roll back to agree with it, and says it is outdated.
+ */
+int gbl_rep_page_catchup_mb = 0;
+
+#define	REP_PGCATCHUP_RETRIES	1000	/* Tries to send a message, 10ms apart */
+#define	REP_PGCATCHUP_KEEPALIVE	10	/* Seconds between master's STARTs */
+#define	REP_PGCATCHUP_TIMEOUT	60	/* Seconds a client waits for one */
+#define	REP_PGCATCHUP_REREADS	10	/* Reads of a page that must agree */
+
+#define	REP_PGCATCHUP_LORDER	(__db_isbigendian() ? 4321 : 1234)
+
+extern int gbl_passed_repverify;
+
+struct rep_pgc {
+	DB_ENV *dbenv;
+	char *eid;
+	DB_LSN lsn;		/* The client's last record */
+	DB_LSN tail;		/* Where the client's new log starts */
+};
+
+struct rep_pgc_file {
+	DB_MPOOLFILE *dbmfp;
+	u_int8_t fileid[DB_FILE_ID_LEN];
+	u_int32_t pagesize;
+};
+
+static pthread_mutex_t rep_pgc_lk = PTHREAD_MUTEX_INITIALIZER;
+static int rep_pgc_running;
+
+/* Client: the pages received so far, and the marker while they're ahead. */
+#define	REP_PGCATCHUP_SPOOL	"__db.pgcatchup.spool"
+#define	REP_PGCATCHUP_MARKER	"__db.pgcatchup"
+
+static pthread_mutex_t rep_pgc_spool_lk = PTHREAD_MUTEX_INITIALIZER;
+static DB_FH *rep_pgc_spool;
+
+static int
+__rep_pgc_lock(dbenv, locker, fileid, pgno, mode, lockp)
+	DB_ENV *dbenv;
+	u_int32_t locker;
+	u_int8_t *fileid;
+	db_pgno_t pgno;
+	db_lockmode_t mode;
+	DB_LOCK *lockp;
+{
+	DBT lock_dbt;
+	DB_LOCK_ILOCK lock_obj;
+
+	lock_obj.pgno = pgno;
+	memcpy(lock_obj.fileid, fileid, DB_FILE_ID_LEN);
+	lock_obj.type = DB_PAGE_LOCK;
+
+	memset(&lock_dbt, 0, sizeof(lock_dbt));
+	lock_dbt.data = &lock_obj;
+	lock_dbt.size = sizeof(lock_obj);
+
+	return (__lock_get(dbenv, locker, 0, &lock_dbt, mode, lockp));
+}
+
+/*
+ * Send a catch-up message, waiting out a full net queue for a while.
+ */
+static int
+__rep_pgc_send(dbenv, eid, rtype, lsnp, dbtp)
+	DB_ENV *dbenv;
+	char *eid;
+	u_int32_t rtype;
+	DB_LSN *lsnp;
+	const DBT *dbtp;
+{
+	int i, ret;
+
+	for (i = 0; i < REP_PGCATCHUP_RETRIES; ++i) {
+		if ((ret = __rep_send_message(dbenv,
+		    eid, rtype, lsnp, dbtp, DB_REP_NOBUFFER, NULL)) == 0)
+			return (0);
+		__os_sleep(dbenv, 0, 10000);
+	}
+	return (ret);
+}
+
+static int
+__rep_pgc_send_plist(dbenv, eid, op, lsnp, npages)
+	DB_ENV *dbenv;
+	char *eid;
+	u_int32_t op;
+	DB_LSN *lsnp;
+	u_int32_t npages;
+{
+	DBT dbt;
+	REP_PLIST_INFO info;
+
+	info.op = op;
+	info.lorder = REP_PGCATCHUP_LORDER;
+	info.npages = npages;
+	if (LOG_SWAPPED()) {
+		M_32_SWAP(info.op);
+		M_32_SWAP(info.lorder);
+		M_32_SWAP(info.npages);
+	}
+	memset(&dbt, 0, sizeof(dbt));
+	dbt.data = &info;
+	dbt.size = sizeof(info);
+	return (__rep_pgc_send(dbenv, eid, REP_PLIST, lsnp, &dbt));
+}
+
+/*
+ * Find where a client's new log starts: the first record of the log file
+ * with the last checkpoint's ckp_lsn.
+ */
+static int
+__rep_pgc_tail(dbenv, tailp)
+	DB_ENV *dbenv;
+	DB_LSN *tailp;
+{
+	DBT rec;
+	DB_LOGC *logc;
+	DB_LSN lsn;
+	__txn_ckp_args *ckp_args;
+	int ret, t_ret;
+
+	if ((ret = __txn_getckp(dbenv, &lsn)) != 0)
+		return (ret);
+	if ((ret = __log_cursor(dbenv, &logc)) != 0)
+		return (ret);
+	memset(&rec, 0, sizeof(rec));
+	if ((ret = __log_c_get(logc, &lsn, &rec, DB_SET)) != 0 ||
+	    (ret = __txn_ckp_read(dbenv, rec.data, &ckp_args)) != 0)
+		goto err;
+	lsn.file = ckp_args->ckp_lsn.file;
+	lsn.offset = 0;
+	__os_free(dbenv, ckp_args);
+	/* The file's header record, then its first record. */
+	if ((ret = __log_c_get(logc, &lsn, &rec, DB_SET)) == 0 &&
+	    (ret = __log_c_get(logc, &lsn, &rec, DB_NEXT)) == 0)
+		*tailp = lsn;
+err:	if ((t_ret = __log_c_close(logc)) != 0 && ret == 0)
+		ret = t_ret;
+	return (ret);
+}
+
+/*
+ * Take a reference to each database file we have open, once each.
+ */
+static int
+__rep_pgc_files(dbenv, filesp, nfilesp)
+	DB_ENV *dbenv;
+	struct rep_pgc_file **filesp;
+	int *nfilesp;
+{
+	DB_MPOOL *dbmp;
+	DB_MPOOLFILE *dbmfp;
+	struct rep_pgc_file *files;
+	int i, n, nfiles, ret;
+
+	dbmp = dbenv->mp_handle;
+	*filesp = NULL;
+	*nfilesp = 0;
+
+	MUTEX_THREAD_LOCK(dbenv, dbmp->mutexp);
+	n = 0;
+	for (dbmfp = TAILQ_FIRST(&dbmp->dbmfq);
+	    dbmfp != NULL; dbmfp = TAILQ_NEXT(dbmfp, q))
+		++n;
+	if ((ret = __os_calloc(dbenv,
+	    n ? n : 1, sizeof(*files), &files)) != 0) {
+		MUTEX_THREAD_UNLOCK(dbenv, dbmp->mutexp);
+		return (ret);
+	}
+	nfiles = 0;
+	for (dbmfp = TAILQ_FIRST(&dbmp->dbmfq);
+	    dbmfp != NULL; dbmfp = TAILQ_NEXT(dbmfp, q)) {
+		if (!F_ISSET(dbmfp, MP_OPEN_CALLED) || dbmfp->mfp == NULL ||
+		    dbmfp->fhp == NULL || dbmfp->mfp->deadfile ||
+		    dbmfp->mfp->no_backing_file ||
+		    F_ISSET(dbmfp->mfp, MP_TEMP) || dbmfp->mfp->fileid_off == 0)
+			continue;
+		for (i = 0; i < nfiles; ++i)
+			if (files[i].dbmfp->mfp == dbmfp->mfp)
+				break;
+		if (i < nfiles)
+			continue;
+		++dbmfp->ref;
+		files[nfiles].dbmfp = dbmfp;
+		memcpy(files[nfiles].fileid,
+		    R_ADDR(dbmp->reginfo, dbmfp->mfp->fileid_off),
+		    DB_FILE_ID_LEN);
+		files[nfiles].pagesize = dbmfp->mfp->stat.st_pagesize;
+		++nfiles;
+	}
+	MUTEX_THREAD_UNLOCK(dbenv, dbmp->mutexp);
+
+	*filesp = files;
+	*nfilesp = nfiles;
+	return (0);
+}
+
+/*
+ * Take a reference to our handle of the file with this id.
+ */
+static DB_MPOOLFILE *
+__rep_pgc_file(dbenv, fileid)
+	DB_ENV *dbenv;
+	u_int8_t *fileid;
+{
+	DB_MPOOL *dbmp;
+	DB_MPOOLFILE *dbmfp;
+
+	dbmp = dbenv->mp_handle;
+	MUTEX_THREAD_LOCK(dbenv, dbmp->mutexp);
+	for (dbmfp = TAILQ_FIRST(&dbmp->dbmfq);
+	    dbmfp != NULL; dbmfp = TAILQ_NEXT(dbmfp, q)) {
+		if (!F_ISSET(dbmfp, MP_OPEN_CALLED) || dbmfp->mfp == NULL ||
+		    dbmfp->mfp->deadfile || dbmfp->mfp->fileid_off == 0)
+			continue;
+		if (memcmp(R_ADDR(dbmp->reginfo, dbmfp->mfp->fileid_off),
+		    fileid, DB_FILE_ID_LEN) == 0) {
+			++dbmfp->ref;
+			break;
+		}
+	}
+	MUTEX_THREAD_UNLOCK(dbenv, dbmp->mutexp);
+	return (dbmfp);
+}
+
+/*
+ * Read a page as it is on disk.  Nothing stops the buffer pool writing it
+ * while we read, so read it until two reads agree.  Returns DB_PAGE_NOTFOUND
+ * past the end of the file.
+ */
+static int
+__rep_pgc_read(dbenv, f, pgno, buf, tmp)
+	DB_ENV *dbenv;
+	struct rep_pgc_file *f;
+	db_pgno_t pgno;
+	u_int8_t *buf, *tmp;
+{
+	size_t nr;
+	int i, ret;
+
+	if ((ret = __os_io(dbenv, DB_IO_READ,
+	    f->dbmfp->fhp, pgno, f->pagesize, buf, &nr)) != 0)
+		return (ret);
+	for (i = 0; i < REP_PGCATCHUP_REREADS; ++i) {
+		if (nr < f->pagesize)
+			return (DB_PAGE_NOTFOUND);
+		if ((ret = __os_io(dbenv, DB_IO_READ,
+		    f->dbmfp->fhp, pgno, f->pagesize, tmp, &nr)) != 0)
+			return (ret);
+		if (nr == f->pagesize && memcmp(buf, tmp, f->pagesize) == 0)
+			return (0);
+		memcpy(buf, tmp, f->pagesize);
+	}
+	__db_err(dbenv, "page catch-up: page %lu keeps changing as we read it",
+	    (u_long)pgno);
+	return (EAGAIN);
+}
+
+static void *
+__rep_pgc_thd(arg)
+	void *arg;
+{
+	struct rep_pgc *pc = arg;
+	struct rep_pgc_file *files, *f;
+	DB_ENV *dbenv;
+	DB_LSN lsn;
+	DB_REP *db_rep;
+	DBT dbt;
+	REP *rep;
+	REP_PAGE_INFO *info;
+	db_pgno_t last, pgno;
+	u_int32_t nscanned, nsent;
+	u_int8_t *buf, *page, *tmp;
+	time_t last_msg, start;
+	int i, nfiles, ret;
+
+	dbenv = pc->dbenv;
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+	files = NULL;
+	nfiles = 0;
+	buf = tmp = NULL;
+	nscanned = nsent = 0;
+	start = last_msg = time(NULL);
+
+	if ((ret = __rep_pgc_send_plist(dbenv,
+	    pc->eid, REP_PLIST_START, &pc->lsn, 0)) != 0)
+		goto err;
+	if ((ret = __rep_pgc_files(dbenv, &files, &nfiles)) != 0)
+		goto err;
+
+	for (i = 0; i < nfiles && ret == 0; ++i) {
+		f = &files[i];
+		if ((ret = __os_malloc(dbenv,
+		    sizeof(REP_PAGE_INFO) + f->pagesize, &buf)) != 0 ||
+		    (ret = __os_malloc(dbenv, f->pagesize, &tmp)) != 0)
+			break;
+		info = (REP_PAGE_INFO *)buf;
+		page = buf + sizeof(REP_PAGE_INFO);
+		memcpy(info->fileid, f->fileid, DB_FILE_ID_LEN);
+		__memp_last_pgno(f->dbmfp, &last);
+		for (pgno = 0; pgno <= last; ++pgno) {
+			if (!F_ISSET(rep, REP_F_MASTER)) {
+				ret = DB_REP_STALEMASTER;
+				break;
+			}
+			if ((ret = __rep_pgc_read(dbenv,
+			    f, pgno, page, tmp)) == DB_PAGE_NOTFOUND) {
+				ret = 0;
+				break;
+			}
+			if (ret != 0)
+				break;
+			++nscanned;
+
+			if (log_compare(&LSN(page), &pc->lsn) > 0) {
+				info->pgno = pgno;
+				if (LOG_SWAPPED())
+					M_32_SWAP(info->pgno);
+				lsn = LSN(page);
+				memset(&dbt, 0, sizeof(dbt));
+				dbt.data = buf;
+				dbt.size = sizeof(REP_PAGE_INFO) + f->pagesize;
+				if ((ret = __rep_pgc_send(dbenv,
+				    pc->eid, REP_PAGE, &lsn, &dbt)) != 0)
+					break;
+				++nsent;
+				last_msg = time(NULL);
+			} else if (time(NULL) - last_msg >=
+			    REP_PGCATCHUP_KEEPALIVE) {
+				/* Still reading; tell the client to wait. */
+				if ((ret = __rep_pgc_send_plist(dbenv, pc->eid,
+				    REP_PLIST_START, &pc->lsn, 0)) != 0)
+					break;
+				last_msg = time(NULL);
+			}
+		}
+		__os_free(dbenv, buf);
+		__os_free(dbenv, tmp);
+		buf = tmp = NULL;
+	}
+
+	if (ret == 0)
+		ret = __rep_pgc_send_plist(dbenv,
+		    pc->eid, REP_PLIST_DONE, &pc->tail, nsent);
+
+err:	if (ret == 0)
+		logmsg(LOGMSG_INFO, "page catch-up for %s from %u:%u: "
+		    "read %u pages, sent %u, log from %u:%u, %ld seconds\n",
+		    pc->eid, pc->lsn.file, pc->lsn.offset, nscanned, nsent,
+		    pc->tail.file, pc->tail.offset, (long)(time(NULL) - start));
+	else {
+		logmsg(LOGMSG_ERROR, "page catch-up for %s from %u:%u "
+		    "failed after sending %u pages: %s\n", pc->eid,
+		    pc->lsn.file, pc->lsn.offset, nsent, db_strerror(ret));
+		if (ret != DB_REP_STALEMASTER)
+			(void)__rep_pgc_send_plist(dbenv,
+			    pc->eid, REP_PLIST_DECLINE, &pc->lsn, nsent);
+	}
+	if (buf != NULL)
+		__os_free(dbenv, buf);
+	if (tmp != NULL)
+		__os_free(dbenv, tmp);
+	for (i = 0; i < nfiles; ++i)
+		(void)__memp_fclose(files[i].dbmfp, 0);
+	if (files != NULL)
+		__os_free(dbenv, files);
+	__os_free(dbenv, pc);
+
+	pthread_mutex_lock(&rep_pgc_lk);
+	rep_pgc_running = 0;
+	pthread_mutex_unlock(&rep_pgc_lk);
+	return (NULL);
+}
+
+/*
+ * __rep_pgcatchup_req --
+ *	Master: the client eid, whose last log record is at lsnp, asks to
+ *	catch up by page.  Start sending it pages, or tell it to use the log.
+ *
+ * PUBLIC: int __rep_pgcatchup_req __P((DB_ENV *, char *, DB_LSN *));
+ */
+int
+__rep_pgcatchup_req(dbenv, eid, lsnp)
+	DB_ENV *dbenv;
+	char *eid;
+	DB_LSN *lsnp;
+{
+	DB_LOG *dblp;
+	DB_LSN end, from, fileop, tail;
+	LOG *lp;
+	pthread_attr_t attr;
+	pthread_t tid;
+	struct rep_pgc *pc;
+	u_int64_t behind;
+	u_int32_t log_size;
+	const char *why;
+	int mb, ret;
+
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+	pc = NULL;
+
+	R_LOCK(dbenv, &dblp->reginfo);
+	end = lp->lsn;
+	from = lp->fileop_from;
+	fileop = lp->fileop_lsn;
+	log_size = lp->log_size;
+	R_UNLOCK(dbenv, &dblp->reginfo);
+
+	behind = 0;
+	if (log_compare(lsnp, &end) < 0)
+		behind = (u_int64_t)(end.file - lsnp->file) * log_size +
+		    end.offset - lsnp->offset;
+
+	if ((mb = gbl_rep_page_catchup_mb) <= 0) {
+		why = "not enabled";
+		goto decline;
+	}
+	if (behind < ((u_int64_t)mb << 20)) {
+		why = "not far enough behind";
+		goto decline;
+	}
+	if (log_compare(lsnp, &from) < 0 || log_compare(&fileop, lsnp) > 0) {
+		why = "files or schemas changed since";
+		goto decline;
+	}
+	if (__rep_pgc_tail(dbenv, &tail) != 0 ||
+	    log_compare(&tail, lsnp) <= 0) {
+		why = "client has the log from our last checkpoint";
+		goto decline;
+	}
+
+	pthread_mutex_lock(&rep_pgc_lk);
+	if (rep_pgc_running) {
+		pthread_mutex_unlock(&rep_pgc_lk);
+		why = "already sending pages to a client";
+		goto decline;
+	}
+	rep_pgc_running = 1;
+	pthread_mutex_unlock(&rep_pgc_lk);
+
+	if ((ret = __os_calloc(dbenv, 1, sizeof(*pc), &pc)) != 0)
+		goto err;
+	pc->dbenv = dbenv;
+	pc->eid = eid;
+	pc->lsn = *lsnp;
+	pc->tail = tail;
+	pthread_attr_init(&attr);
+	pthread_attr_setdetachstate(&attr, PTHREAD_CREATE_DETACHED);
+	ret = pthread_create(&tid, &attr, __rep_pgc_thd, pc);
+	pthread_attr_destroy(&attr);
+	if (ret == 0) {
+		logmsg(LOGMSG_INFO, "page catch-up for %s from %u:%u, "
+		    "%llu MB behind\n", eid, lsnp->file, lsnp->offset,
+		    (unsigned long long)(behind >> 20));
+		return (0);
+	}
+	__os_free(dbenv, pc);
+err:	pthread_mutex_lock(&rep_pgc_lk);
+	rep_pgc_running = 0;
+	pthread_mutex_unlock(&rep_pgc_lk);
+	why = "can't start a thread";
+
+decline:
+	if (mb > 0)
+		logmsg(LOGMSG_INFO, "%s catches up from the log at %u:%u, "
+		    "%llu MB behind: %s\n", eid, lsnp->file, lsnp->offset,
+		    (unsigned long long)(behind >> 20), why);
+	return (__rep_pgc_send_plist(dbenv, eid, REP_PLIST_DECLINE, lsnp, 0));
+}
+
+/*
+ * Client: add a REP_PAGE message to the spool.
+ */
+static int
+__rep_pgc_spool_add(dbenv, rec)
+	DB_ENV *dbenv;
+	DBT *rec;
+{
+	char *path;
+	size_t nw;
+	u_int32_t size;
+	int ret;
+
+	pthread_mutex_lock(&rep_pgc_spool_lk);
+	if (rep_pgc_spool == NULL) {
+		if ((ret = __db_appname(dbenv, DB_APP_NONE,
+		    REP_PGCATCHUP_SPOOL, 0, NULL, &path)) != 0)
+			goto err;
+		ret = __os_open(dbenv, path,
+		    DB_OSO_CREATE | DB_OSO_TRUNC, 0, &rep_pgc_spool);
+		__os_free(dbenv, path);
+		if (ret != 0)
+			goto err;
+	}
+	size = rec->size;
+	if ((ret = __os_write(dbenv,
+	    rep_pgc_spool, &size, sizeof(size), &nw)) == 0)
+		ret = __os_write(dbenv, rep_pgc_spool, rec->data, size, &nw);
+err:	pthread_mutex_unlock(&rep_pgc_spool_lk);
+	return (ret);
+}
+
+/*
+ * Client: throw the spool away.
+ */
+static void
+__rep_pgc_spool_discard(dbenv)
+	DB_ENV *dbenv;
+{
+	char *path;
+
+	pthread_mutex_lock(&rep_pgc_spool_lk);
+	if (rep_pgc_spool != NULL) {
+		(void)__os_closehandle(dbenv, rep_pgc_spool);
+		rep_pgc_spool = NULL;
+		if (__db_appname(dbenv, DB_APP_NONE,
+		    REP_PGCATCHUP_SPOOL, 0, NULL, &path) == 0) {
+			(void)__os_unlink(dbenv, path);
+			__os_free(dbenv, path);
+		}
+	}
+	pthread_mutex_unlock(&rep_pgc_spool_lk);
+}
+
+/*
+ * Client: read the marker's LSN.  Returns ENOENT if there is no marker.
+ */
+static int
+__rep_pgc_marker_read(dbenv, lsnp)
+	DB_ENV *dbenv;
+	DB_LSN *lsnp;
+{
+	FILE *fp;
+	char *path;
+	int ret;
+
+	if ((ret = __db_appname(dbenv, DB_APP_NONE,
+	    REP_PGCATCHUP_MARKER, 0, NULL, &path)) != 0)
+		return (ret);
+	if ((fp = fopen(path, "r")) == NULL)
+		ret = ENOENT;
+	else {
+		if (fscanf(fp, "%u:%u", &lsnp->file, &lsnp->offset) != 2)
+			ret = EINVAL;
+		(void)fclose(fp);
+	}
+	if (ret == EINVAL)
+		__db_err(dbenv, "page catch-up marker %s is unreadable", path);
+	__os_free(dbenv, path);
+	return (ret);
+}
+
+/*
+ * Client: note that our files will be ahead of our log until it passes lsnp,
+ * and make sure the note survives a crash.
+ */
+static int
+__rep_pgc_marker_write(dbenv, lsnp)
+	DB_ENV *dbenv;
+	DB_LSN *lsnp;
+{
+	DB_FH *fhp;
+	DB_LSN old;
+	char buf[32], *path;
+	size_t nw;
+	int ret, t_ret;
+
+	/* An earlier catch-up we haven't passed yet may go further. */
+	if (__rep_pgc_marker_read(dbenv, &old) == 0 &&
+	    log_compare(&old, lsnp) > 0)
+		lsnp = &old;
+	if ((ret = __db_appname(dbenv, DB_APP_NONE,
+	    REP_PGCATCHUP_MARKER, 0, NULL, &path)) != 0)
+		return (ret);
+	if ((ret = __os_open(dbenv, path,
+	    DB_OSO_CREATE | DB_OSO_TRUNC, 0, &fhp)) != 0)
+		goto err;
+	(void)snprintf(buf, sizeof(buf), "%u:%u\n", lsnp->file, lsnp->offset);
+	if ((ret = __os_write(dbenv, fhp, buf, strlen(buf), &nw)) == 0)
+		ret = __os_fsync(dbenv, fhp);
+	if ((t_ret = __os_closehandle(dbenv, fhp)) != 0 && ret == 0)
+		ret = t_ret;
+	if (ret == 0)
+		ret = __os_fsync_dir(dbenv, dbenv->db_home);
+err:	__os_free(dbenv, path);
+	return (ret);
+}
+
+/*
+ * Client: write a spooled page to its file.
+ */
+static int
+__rep_pgc_install_page(dbenv, locker, data, size)
+	DB_ENV *dbenv;
+	u_int32_t locker;
+	u_int8_t *data;
+	u_int32_t size;
+{
+	DB_LOCK lock;
+	DB_MPOOLFILE *dbmfp;
+	REP_PAGE_INFO info;
+	int ret;
+
+	if (size <= sizeof(info))
+		return (EINVAL);
+	memcpy(&info, data, sizeof(info));
+	if (LOG_SWAPPED())
+		M_32_SWAP(info.pgno);
+	size -= sizeof(info);
+
+	if ((dbmfp = __rep_pgc_file(dbenv, info.fileid)) == NULL)
+		return (ENOENT);
+	if (size != dbmfp->mfp->stat.st_pagesize) {
+		ret = EINVAL;
+		goto done;
+	}
+	/*
+	 * The page is as it was on the master's disk.  Write it to ours the
+	 * same way: the buffer pool would flush our log up to its LSN first,
+	 * and our log doesn't go that far.
+	 */
+	if ((ret = __rep_pgc_lock(dbenv, locker,
+	    info.fileid, info.pgno, DB_LOCK_WRITE, &lock)) != 0)
+		goto done;
+	ret = __dir_pgwrite(dbmfp, info.pgno, data + sizeof(info));
+	(void)__lock_put(dbenv, &lock);
+done:	(void)__memp_fclose(dbmfp, 0);
+	if (ret != 0)
+		__db_err(dbenv, "page catch-up can't install page %u: %s",
+		    info.pgno, db_strerror(ret));
+	return (ret);
+}
+
+/*
+ * Client: install every spooled page.
+ */
+static int
+__rep_pgc_install(dbenv, locker)
+	DB_ENV *dbenv;
+	u_int32_t locker;
+{
+	size_t nr;
+	u_int32_t size, bufsize;
+	u_int8_t *buf;
+	int ret;
+
+	buf = NULL;
+	bufsize = 0;
+	pthread_mutex_lock(&rep_pgc_spool_lk);
+	if (rep_pgc_spool == NULL) {
+		pthread_mutex_unlock(&rep_pgc_spool_lk);
+		return (0);
+	}
+	if ((ret = __os_seek(dbenv,
+	    rep_pgc_spool, 0, 0, 0, 0, DB_OS_SEEK_SET)) != 0)
+		goto err;
+	for (;;) {
+		if ((ret = __os_read(dbenv,
+		    rep_pgc_spool, &size, sizeof(size), &nr)) != 0)
+			break;
+		if (nr == 0)
+			break;
+		if (nr != sizeof(size)) {
+			ret = EIO;
+			break;
+		}
+		if (size > bufsize) {
+			if ((ret = __os_realloc(dbenv, size, &buf)) != 0)
+				break;
+			bufsize = size;
+		}
+		if ((ret = __os_read(dbenv,
+		    rep_pgc_spool, buf, size, &nr)) != 0)
+			break;
+		if (nr != size) {
+			ret = EIO;
+			break;
+		}
+		if ((ret = __rep_pgc_install_page(dbenv,
+		    locker, buf, size)) != 0)
+			break;
+	}
+err:	pthread_mutex_unlock(&rep_pgc_spool_lk);
+	if (buf != NULL)
+		__os_free(dbenv, buf);
+	return (ret);
+}
+
+/*
+ * Client: give up on pages and ask for the log after our last record.
+ * Nothing is installed yet, so we drop what we have.
+ */
+static void
+__rep_pgc_fallback(dbenv, why)
+	DB_ENV *dbenv;
+	const char *why;
+{
+	DB_LOG *dblp;
+	DB_LSN lsn;
+	DB_REP *db_rep;
+	LOG *lp;
+	REP *rep;
+	char *master;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+
+	MUTEX_LOCK(dbenv, db_rep->db_mutexp);
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	if (!F_ISSET(rep, REP_F_PGCATCHUP)) {
+		MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+		MUTEX_UNLOCK(dbenv, db_rep->db_mutexp);
+		return;
+	}
+	F_CLR(rep, REP_F_PGCATCHUP | REP_F_NOARCHIVE);
+	lsn = rep->pgc_lsn;
+	ZERO_LSN(rep->pgc_maxlsn);
+	master = rep->master_id;
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+	lp->wait_recs = rep->max_gap;
+	MUTEX_UNLOCK(dbenv, db_rep->db_mutexp);
+	__rep_pgc_spool_discard(dbenv);
+
+	logmsg(LOGMSG_INFO, "catching up from the log at %u:%u "
+	    "after %u pages: %s\n", lsn.file, lsn.offset, rep->pgc_npages, why);
+	if (master != db_eid_invalid)
+		(void)__rep_send_message(dbenv,
+		    master, REP_ALL_REQ, &lsn, NULL, 0, NULL);
+	gbl_passed_repverify = 1;
+}
+
+/*
+ * Client: all pages are in the spool.  Install them, start our log where
+ * the master said and ask for the log from there.  Called under the bdb
+ * writelock.
+ */
+static int
+__rep_pgc_finish(dbenv, tailp, nsent)
+	DB_ENV *dbenv;
+	DB_LSN *tailp;
+	u_int32_t nsent;
+{
+	DB_LOG *dblp;
+	DB_REP *db_rep;
+	LOG *lp;
+	REP *rep;
+	char *master;
+	int ret;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+
+	if (rep->pgc_npages != nsent) {
+		__rep_pgc_fallback(dbenv, "pages were lost");
+		return (0);
+	}
+	if (!IS_ZERO_LSN(rep->pgc_maxlsn) &&
+	    (ret = __rep_pgc_marker_write(dbenv, &rep->pgc_maxlsn)) != 0) {
+		__db_err(dbenv, "page catch-up can't write its marker: %s",
+		    db_strerror(ret));
+		__rep_pgc_fallback(dbenv, "can't write the marker");
+		return (0);
+	}
+	/*
+	 * From here our files are ahead of our log; if we can't finish, the
+	 * marker keeps us from coming up until the log catches up.
+	 */
+	if ((ret = __rep_pgc_install(dbenv, rep->pgc_locker)) != 0) {
+		__rep_pgc_spool_discard(dbenv);
+		return (DB_REP_OUTDATED);
+	}
+	__rep_pgc_spool_discard(dbenv);
+	/* The pages are in the files; make them durable before the log goes. */
+	if ((ret = __memp_sync(dbenv, NULL)) != 0) {
+		__db_err(dbenv, "page catch-up can't sync pages: %s",
+		    db_strerror(ret));
+		return (DB_REP_OUTDATED);
+	}
+
+	MUTEX_LOCK(dbenv, db_rep->db_mutexp);
+	if ((ret = __log_vrestart(dbenv, tailp)) != 0) {
+		MUTEX_UNLOCK(dbenv, db_rep->db_mutexp);
+		__db_err(dbenv, "page catch-up can't restart the log at %u:%u",
+		    tailp->file, tailp->offset);
+		return (DB_REP_OUTDATED);
+	}
+	lp->ready_lsn = *tailp;
+	ZERO_LSN(lp->waiting_lsn);
+	ZERO_LSN(lp->max_wait_lsn);
+	lp->rcvd_recs = 0;
+	lp->wait_recs = rep->max_gap;
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	F_CLR(rep, REP_F_PGCATCHUP | REP_F_NOARCHIVE);
+	master = rep->master_id;
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+	MUTEX_UNLOCK(dbenv, db_rep->db_mutexp);
+
+	logmsg(LOGMSG_INFO, "page catch-up from %u:%u installed %u pages, "
+	    "log starts at %u:%u\n", rep->pgc_lsn.file, rep->pgc_lsn.offset,
+	    rep->pgc_npages, tailp->file, tailp->offset);
+	if (master != db_eid_invalid)
+		(void)__rep_send_message(dbenv,
+		    master, REP_ALL_REQ, tailp, NULL, 0, NULL);
+	gbl_passed_repverify = 1;
+	return (0);
+}
+
+/*
+ * __rep_pgcatchup_plist --
+ *	Client: handle a REP_PLIST message.
+ *
+ * PUBLIC: int __rep_pgcatchup_plist __P((DB_ENV *, REP_CONTROL *, DBT *));
+ */
+int
+__rep_pgcatchup_plist(dbenv, rp, rec)
+	DB_ENV *dbenv;
+	REP_CONTROL *rp;
+	DBT *rec;
+{
+	DB_REP *db_rep;
+	REP *rep;
+	REP_PLIST_INFO info;
+	u_int32_t locker;
+	int ok, ret;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+
+	if (rec == NULL || rec->size < sizeof(info))
+		return (EINVAL);
+	memcpy(&info, rec->data, sizeof(info));
+	if (LOG_SWAPPED()) {
+		M_32_SWAP(info.op);
+		M_32_SWAP(info.lorder);
+		M_32_SWAP(info.npages);
+	}
+
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	if (!F_ISSET(rep, REP_F_PGCATCHUP)) {
+		MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+		return (0);
+	}
+	rep->pgc_time = time(NULL);
+	if (info.op == REP_PLIST_START && rep->pgc_ok == 0)
+		rep->pgc_ok = info.lorder == REP_PGCATCHUP_LORDER ? 1 : -1;
+	ok = rep->pgc_ok;
+	locker = rep->pgc_locker;
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+
+	switch (info.op) {
+	case REP_PLIST_START:
+		if (ok == 1 && locker == 0) {
+			/*
+			 * Pages come next.  A dirty cached copy would keep
+			 * one from being written, so write them all now;
+			 * our log covers them.
+			 */
+			if ((ret = __memp_sync(dbenv, NULL)) != 0) {
+				__rep_pgc_fallback(dbenv, "can't sync pages");
+				return (0);
+			}
+			if ((ret = __lock_id(dbenv, &locker)) != 0) {
+				__rep_pgc_fallback(dbenv, "can't get a locker");
+				return (0);
+			}
+			MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+			rep->pgc_locker = locker;
+			MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+		}
+		return (0);
+	case REP_PLIST_DONE:
+		if (ok == 1)
+			return (__rep_pgc_finish(dbenv, &rp->lsn, info.npages));
+		__rep_pgc_fallback(dbenv, ok == 0 ?
+		    "master didn't start" : "pages can't be used");
+		return (0);
+	case REP_PLIST_DECLINE:
+		__rep_pgc_fallback(dbenv, "master declined");
+		return (0);
+	}
+	return (EINVAL);
+}
+
+/*
+ * __rep_pgcatchup_page --
+ *	Client: spool a page from a REP_PAGE message.
+ *
+ * PUBLIC: int __rep_pgcatchup_page __P((DB_ENV *, REP_CONTROL *, DBT *));
+ */
+int
+__rep_pgcatchup_page(dbenv, rp, rec)
+	DB_ENV *dbenv;
+	REP_CONTROL *rp;
+	DBT *rec;
+{
+	DB_REP *db_rep;
+	PAGE *image;
+	REP *rep;
+	int ret;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	if (!F_ISSET(rep, REP_F_PGCATCHUP) ||
+	    rep->pgc_ok != 1 || rep->pgc_locker == 0) {
+		MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+		return (0);
+	}
+	rep->pgc_time = time(NULL);
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+
+	if (rec == NULL || rec->size <= sizeof(REP_PAGE_INFO))
+		return (EINVAL);
+	image = (PAGE *)((u_int8_t *)rec->data + sizeof(REP_PAGE_INFO));
+	ret = __rep_pgc_spool_add(dbenv, rec);
+
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	if (ret != 0) {
+		rep->pgc_ok = -1;
+		MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+		__db_err(dbenv, "page catch-up can't spool the page "
+		    "at %u:%u: %s", rp->lsn.file, rp->lsn.offset,
+		    db_strerror(ret));
+		return (0);
+	}
+	++rep->pgc_npages;
+	if (log_compare(&LSN(image), &rep->pgc_maxlsn) > 0)
+		rep->pgc_maxlsn = LSN(image);
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+	return (0);
+}
+
+/*
+ * __rep_pgcatchup_check --
+ *	Client: a message came while we wait for pages.  If the master has
+ *	been quiet too long, catch up from the log.
+ *
+ * PUBLIC: void __rep_pgcatchup_check __P((DB_ENV *));
+ */
+void
+__rep_pgcatchup_check(dbenv)
+	DB_ENV *dbenv;
+{
+	DB_REP *db_rep;
+	REP *rep;
+	time_t last;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	last = rep->pgc_time;
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+	if (time(NULL) - last > REP_PGCATCHUP_TIMEOUT)
+		__rep_pgc_fallback(dbenv, "no word from the master");
+}
+
+/*
+ * __rep_pgcatchup_newmaster --
+ *	Client: the master changed.  Stop catching up by page, and return
+ *	DB_REP_OUTDATED if we have pages our log doesn't account for.
+ *
+ * PUBLIC: int __rep_pgcatchup_newmaster __P((DB_ENV *));
+ */
+int
+__rep_pgcatchup_newmaster(dbenv)
+	DB_ENV *dbenv;
+{
+	DB_LOG *dblp;
+	DB_LSN end, maxlsn;
+	DB_REP *db_rep;
+	LOG *lp;
+	REP *rep;
+	int catching_up;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	catching_up = F_ISSET(rep, REP_F_PGCATCHUP) != 0;
+	F_CLR(rep, REP_F_PGCATCHUP);
+	maxlsn = rep->pgc_maxlsn;
+	if (catching_up)
+		ZERO_LSN(rep->pgc_maxlsn);
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+	/* Pages still in the spool were never installed. */
+	if (catching_up) {
+		__rep_pgc_spool_discard(dbenv);
+		return (0);
+	}
+	if (IS_ZERO_LSN(maxlsn))
+		return (0);
+
+	R_LOCK(dbenv, &dblp->reginfo);
+	end = lp->lsn;
+	R_UNLOCK(dbenv, &dblp->reginfo);
+	if (log_compare(&end, &maxlsn) > 0)
+		return (0);
+
+	__db_err(dbenv, "master changed before the log reached %u:%u, "
+	    "the newest page we caught up to", maxlsn.file, maxlsn.offset);
+	return (DB_REP_OUTDATED);
+}
+
+/*
+ * __rep_pgcatchup_will_install --
+ *	Client: return non-zero if this message would install the pages and
+ *	restart the log, so the caller can keep readers out while it does.
+ *	That is once per catch-up; pages are only spooled as they come.
+ *
+ * PUBLIC: int __rep_pgcatchup_will_install __P((DB_ENV *, DBT *, DBT *));
+ */
+int
+__rep_pgcatchup_will_install(dbenv, control, rec)
+	DB_ENV *dbenv;
+	DBT *control, *rec;
+{
+	DB_REP *db_rep;
+	REP *rep;
+	REP_CONTROL *rp;
+	REP_PLIST_INFO info;
+	u_int32_t rectype;
+	int catching_up;
+
+	db_rep = dbenv->rep_handle;
+	rep = db_rep->region;
+	rp = (REP_CONTROL *)control->data;
+
+	rectype = rp->rectype;
+	if (LOG_SWAPPED())
+		M_32_SWAP(rectype);
+	if (rectype != REP_PLIST)
+		return (0);
+
+	MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
+	catching_up = F_ISSET(rep, REP_F_PGCATCHUP) && rep->pgc_ok == 1;
+	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
+	if (!catching_up)
+		return (0);
+
+	if (rec == NULL || rec->size < sizeof(info))
+		return (0);
+	memcpy(&info, rec->data, sizeof(info));
+	if (LOG_SWAPPED())
+		M_32_SWAP(info.op);
+	return (info.op == REP_PLIST_DONE);
+}
+
+/*
+ * __rep_pgcatchup_pending --
+ *	Return non-zero while a page catch-up left our files ahead of our log.
+ *	Removes the marker once the log has passed the newest page.
+ *
+ * PUBLIC: int __rep_pgcatchup_pending __P((DB_ENV *));
+ */
+int
+__rep_pgcatchup_pending(dbenv)
+	DB_ENV *dbenv;
+{
+	DB_LOG *dblp;
+	DB_LSN end, lsn;
+	LOG *lp;
+	char *path;
+
+	if (__rep_pgc_marker_read(dbenv, &lsn) == ENOENT)
+		return (0);
+	dblp = dbenv->lg_handle;
+	lp = dblp->reginfo.primary;
+	R_LOCK(dbenv, &dblp->reginfo);
+	end = lp->lsn;
+	R_UNLOCK(dbenv, &dblp->reginfo);
+	if (log_compare(&end, &lsn) <= 0)
+		return (1);
+
+	if (__db_appname(dbenv, DB_APP_NONE,
+	    REP_PGCATCHUP_MARKER, 0, NULL, &path) != 0)
+		return (1);
+	(void)__os_unlink(dbenv, path);
+	(void)__os_fsync_dir(dbenv, dbenv->db_home);
+	__os_free(dbenv, path);
+	logmsg(LOGMSG_INFO, "log passed %u:%u, the newest page we caught up to\n",
+	    lsn.file, lsn.offset);
+	return (0);
+}
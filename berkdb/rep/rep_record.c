@@ -70,6 +70,7 @@ extern int gbl_optimize_truncate_repdb;
 extern int gbl_early;
 extern int gbl_reallyearly;
 extern int gbl_rep_process_txn_time;
+extern int gbl_rep_page_catchup_mb;
 int gbl_rep_badgen_trace;
 
 void hexdump(unsigned char *key, int keylen);
@@ -551,7 +552,7 @@ __rep_process_message(dbenv, control, rec, eidp, ret_lsnp, commit_gen)
 	rep->msg_th++;
 	gen = rep->gen;
 	recovering = rep->in_recovery ||
-	    F_ISSET(rep, REP_F_READY | REP_F_RECOVER);
+	    F_ISSET(rep, REP_F_READY | REP_F_RECOVER | REP_F_PGCATCHUP);
 	savetime = rep->timestamp;
 
 	rep->stat.st_msgs_processed++;
@@ -709,6 +710,11 @@ __rep_process_message(dbenv, control, rec, eidp, ret_lsnp, commit_gen)
 		case REP_GEN_VOTE1:
 		case REP_GEN_VOTE2:
 			break;
+		case REP_PAGE:
+		case REP_PLIST:
+			if (F_ISSET(rep, REP_F_PGCATCHUP))
+				break;
+			goto skip;
 		default:
 skip:				/*
 				 * We don't hold the rep mutex, and could
@@ -716,6 +722,16 @@ skip:				/*
 				 */
 			rep->stat.st_msgs_recover++;
 
+			/*
+			 * Catching up by page: the master sends the log
+			 * when it's done.  Give up if it has gone quiet.
+			 */
+			if (F_ISSET(rep, REP_F_PGCATCHUP)) {
+				__rep_pgcatchup_check(dbenv);
+				fromline = __LINE__;
+				goto errlock;
+			}
+
 			/* Check for need to retransmit. */
 			MUTEX_LOCK(dbenv, db_rep->db_mutexp);
 			MUTEX_LOCK(dbenv, db_rep->rep_mutexp);
@@ -1163,20 +1179,26 @@ send:			if (__rep_send_message(dbenv,
 		ret = __rep_new_master(dbenv, rp, *eidp);
 		fromline = __LINE__;
 		goto errlock;
-	case REP_PAGE:		/* TODO */
+	case REP_PAGE:
 		CLIENT_ONLY(rep, rp);
 		MASTER_CHECK(dbenv, *eidp, rep);
-		break;
+		ret = __rep_pgcatchup_page(dbenv, rp, rec);
+		fromline = __LINE__;
+		goto errlock;
 	case REP_PAGE_REQ:	/* TODO */
 		MASTER_ONLY(rep, rp);
 		break;
-	case REP_PLIST:	/* TODO */
+	case REP_PLIST:
 		CLIENT_ONLY(rep, rp);
 		MASTER_CHECK(dbenv, *eidp, rep);
-		break;
-	case REP_PLIST_REQ:	/* TODO */
+		ret = __rep_pgcatchup_plist(dbenv, rp, rec);
+		fromline = __LINE__;
+		goto errlock;
+	case REP_PLIST_REQ:
 		MASTER_ONLY(rep, rp);
-		break;
+		ret = __rep_pgcatchup_req(dbenv, *eidp, &rp->lsn);
+		fromline = __LINE__;
+		goto errlock;
 	case REP_VERIFY:
 		CLIENT_ONLY(rep, rp);
 		MASTER_CHECK(dbenv, *eidp, rep);
@@ -6216,7 +6238,7 @@ __rep_verify_match(dbenv, rp, savetime)
 	DB_REP *db_rep;
 	LOG *lp;
 	REP *rep;
-	int done, ret, wait_cnt;
+	int done, pgcatchup, ret, wait_cnt;
 	u_int32_t unused;
 	extern int gbl_passed_repverify;
 	char *master;
@@ -6228,6 +6250,7 @@ __rep_verify_match(dbenv, rp, savetime)
 	rep = db_rep->region;
 	lp = dblp->reginfo.primary;
 	ret = 0;
+	pgcatchup = 0;
 
 	/*
 	 * Check if the savetime is different than our current time stamp.
@@ -6380,6 +6403,18 @@ finish:ZERO_LSN(lp->waiting_lsn);
 	rep->in_recovery = 0;
 	F_CLR(rep, REP_F_NOARCHIVE | REP_F_READY | REP_F_RECOVER);
 
+	/*
+	 * Far behind, ask to catch up by page (rep_page.c).  Keep our log
+	 * until the master says how.
+	 */
+	if ((pgcatchup = (gbl_rep_page_catchup_mb > 0))) {
+		F_SET(rep, REP_F_PGCATCHUP | REP_F_NOARCHIVE);
+		rep->pgc_lsn = rp->lsn;
+		ZERO_LSN(rep->pgc_maxlsn);
+		rep->pgc_ok = 0;
+		rep->pgc_npages = 0;
+		rep->pgc_time = time(NULL);
+	}
 
 	if (ret != 0)
 		goto errunlock2;
@@ -6419,8 +6454,9 @@ finish:ZERO_LSN(lp->waiting_lsn);
 		 */
 		lp->wait_recs = rep->max_gap;
 		MUTEX_UNLOCK(dbenv, db_rep->db_mutexp);
-		(void)__rep_send_message(dbenv,
-		    master, REP_ALL_REQ, &rp->lsn, NULL, 0, NULL);
+		(void)__rep_send_message(dbenv, master,
+		    pgcatchup ? REP_PLIST_REQ : REP_ALL_REQ, &rp->lsn,
+		    NULL, 0, NULL);
 	}
 	if (0) {
 errunlock2:	MUTEX_UNLOCK(dbenv, db_rep->db_mutexp);
@@ -6431,8 +6467,9 @@ errunlock:	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
 	/* Purge any in-flight logical transactions.  We hold the bdb writelock. */
 	bdb_purge_logical_transactions(dbenv->app_private, &purge_lsn);
 
-	/* passed verify */
-	gbl_passed_repverify = 1;
+	/* passed verify; with page catch-up, once we have a log again */
+	if (!pgcatchup)
+		gbl_passed_repverify = 1;
 
 err:
 
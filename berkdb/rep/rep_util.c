@@ -355,6 +355,10 @@ __rep_new_master(dbenv, cntrl, eid)
 	}
 	MUTEX_UNLOCK(dbenv, db_rep->rep_mutexp);
 
+	/* A new master can't take back pages we caught up to. */
+	if (change && (ret = __rep_pgcatchup_newmaster(dbenv)) != 0)
+		return (ret);
+
 	dblp = dbenv->lg_handle;
 	lp = dblp->reginfo.primary;
 	R_LOCK(dbenv, &dblp->reginfo);
@@ -732,6 +732,8 @@ struct cdb2_hndl {
     cdb2_query_list *query_list;
     int snapshot_file;
     int snapshot_offset;
+    int commit_file; /* where our last commit was logged */
+    int commit_offset;
     int query_no;
     int retry_all;
     int num_set_commands;
@@ -2298,6 +2300,13 @@ static int cdb2_send_query(cdb2_hndl_tp *hndl, SBUF2 *sb, char *dbname,
         sqlquery.snapshot_info = &snapshotinfo;
     }
 
+    CDB2SQLQUERY__Snapshotinfo commitlsn = CDB2__SQLQUERY__SNAPSHOTINFO__INIT;
+    if (hndl && (hndl->flags & CDB2_READ_YOUR_WRITES) && hndl->commit_file) {
+        commitlsn.file = hndl->commit_file;
+        commitlsn.offset = hndl->commit_offset;
+        sqlquery.read_after_lsn = &commitlsn;
+    }
+
     if (n_features) {
         sqlquery.n_features = n_features;
         sqlquery.features = features;
@@ -2360,6 +2369,17 @@ static int cdb2_send_query(cdb2_hndl_tp *hndl, SBUF2 *sb, char *dbname,
     return 0;
 }
 
+/* Remember the newest commit, to read it on whichever node we go to next */
+static void update_commit_lsn(cdb2_hndl_tp *hndl,
+                              const CDB2SQLRESPONSE__Snapshotinfo *lsn)
+{
+    if (lsn->file > hndl->commit_file ||
+        (lsn->file == hndl->commit_file && lsn->offset > hndl->commit_offset)) {
+        hndl->commit_file = lsn->file;
+        hndl->commit_offset = lsn->offset;
+    }
+}
+
 /* All "soft" errors are retryable .. constraint violation are not */
 static int is_retryable(cdb2_hndl_tp *hndl, int err_val)
 {
@@ -2488,6 +2508,9 @@ retry_next_record:
         hndl->snapshot_offset = hndl->lastresponse->snapshot_info->offset;
     }
 
+    if (hndl->lastresponse->commit_lsn)
+        update_commit_lsn(hndl, hndl->lastresponse->commit_lsn);
+
     if (hndl->lastresponse->response_type == RESPONSE_TYPE__COLUMN_VALUES) {
         // "Good" rcodes are not retryable
         if (is_retryable(hndl, hndl->lastresponse->error_code) &&
@@ -4106,6 +4129,34 @@ int cdb2_snapshot_file(cdb2_hndl_tp *hndl, int *snapshot_file,
     return 0;
 }
 
+/* Where the newest commit of this handle was logged, for another handle
+ * opened with CDB2_READ_YOUR_WRITES to read it (see cdb2_set_commit_lsn) */
+int cdb2_commit_lsn(cdb2_hndl_tp *hndl, int *commit_file, int *commit_offset)
+{
+    if (hndl == NULL) {
+        (*commit_file) = -1;
+        (*commit_offset) = -1;
+        return -1;
+    }
+
+    (*commit_file) = hndl->commit_file;
+    (*commit_offset) = hndl->commit_offset;
+    return 0;
+}
+
+int cdb2_set_commit_lsn(cdb2_hndl_tp *hndl, int commit_file, int commit_offset)
+{
+    CDB2SQLRESPONSE__Snapshotinfo lsn = CDB2__SQLRESPONSE__SNAPSHOTINFO__INIT;
+
+    if (hndl == NULL)
+        return -1;
+
+    lsn.file = commit_file;
+    lsn.offset = commit_offset;
+    update_commit_lsn(hndl, &lsn);
+    return 0;
+}
+
 void cdb2_getinfo(cdb2_hndl_tp *hndl, int *intrans, int *hasql)
 {
     (*intrans) = hndl->in_trans;
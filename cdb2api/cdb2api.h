@@ -35,7 +35,8 @@ enum cdb2_hndl_alloc_flags {
     CDB2_RANDOM = 8,
     CDB2_RANDOMROOM = 16,
     CDB2_ROOM = 32,
-    CDB2_CACHE_SSL_SESSIONS = 64
+    CDB2_CACHE_SSL_SESSIONS = 64,
+    CDB2_READ_YOUR_WRITES = 128
 };
 
 enum cdb2_request_type {
@@ -214,6 +215,8 @@ void cdb2_set_debug_trace(cdb2_hndl_tp *hndl);
 void cdb2_dump_ports(cdb2_hndl_tp *hndl, FILE *out);
 void cdb2_cluster_info(cdb2_hndl_tp *hndl, char **cluster, int *ports, int max, int *count);
 int cdb2_snapshot_file(cdb2_hndl_tp *hndl, int *file, int *offset);
+int cdb2_commit_lsn(cdb2_hndl_tp *hndl, int *file, int *offset);
+int cdb2_set_commit_lsn(cdb2_hndl_tp *hndl, int file, int offset);
 void cdb2_getinfo(cdb2_hndl_tp *hndl, int *intrans, int *hasql);
 void cdb2_set_max_retries(int max_retries);
 void cdb2_set_min_retries(int min_retries);
@@ -218,7 +218,8 @@ enum INDEXFLAGS {
     DUPKEY = 0x00000001,  /* duplicate key flag */
     RECNUMS = 0x00000002, /* index has key sequence numbers (COMDB2) */
     PRIMARY = 0x00000004,
-    DATAKEY = 0x00000008 /* key flag to indicate index has data */
+    DATAKEY = 0x00000008, /* key flag to indicate index has data */
+    HASHKEY = 0x00000010  /* keep a hash of point lookups on this index */
 };
 
 extern int fncs[MAXFUNCS];          /* functions                         */
@@ -309,6 +310,7 @@ void key_add_tag(char *tag, char *exprname, char *where);
 void key_piece_clear();
 void key_setdup();
 void key_setrecnums(void);
+void key_sethash(void);
 void key_setprimary(void);
 void key_setdatakey(void);
 void reset_key_exprtype(void);
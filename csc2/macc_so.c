@@ -801,6 +801,8 @@ void key_setprimary(void) { workkeyflag |= PRIMARY; }
 
 void key_setdatakey(void) { workkeyflag |= DATAKEY; }
 
+void key_sethash(void) { workkeyflag |= HASHKEY; }
+
 void key_piece_clear() /* used by parser, clears work key */
 {
     workkey = 0;          /* clear work key */
@@ -2526,6 +2528,26 @@ int dyns_is_idx_datacopy(int index)
     return 0;
 }
 
+/* does this index keep a hash of point lookups? */
+int dyns_is_idx_hash(int index)
+{
+    int lastix = 0, i = 0;
+    if (index < 0 || index >= numix()) {
+        return -1;
+    }
+    for (lastix = -1, i = 0; i < numkeys(); i++) {
+        if (lastix == keyixnum[i])
+            continue;
+        lastix = keyixnum[i];
+        if (keyixnum[i] != index)
+            continue;
+        if (ixflags[keyixnum[i]] & HASHKEY)
+            return 1;
+        break;
+    }
+    return 0;
+}
+
 /* is key duplicate? */
 int dyns_is_idx_primary(int index)
 {
@@ -57,7 +57,7 @@
 %token T_CONSTRAINTS T_CASCADE
 %token T_CON_ON  T_CON_UPDATE T_CON_DELETE T_RESTRICT
 
-%token T_RECNUMS T_PRIMARY T_DATAKEY 
+%token T_RECNUMS T_PRIMARY T_DATAKEY T_HASHKEY
 %token T_YES T_NO
 
 %token T_ASCEND T_DESCEND T_DUP					/*MODIFIERS*/
@@ -315,6 +315,15 @@ varname:	T_VARNAME
               exit(-1);
             }
             $$=yylval.varname;
+            }
+        | T_HASHKEY
+       {
+            /* 'hash' is a key flag, but still a valid field name */
+            $$=(char*)csc2_strdup("hash");
+            if ($$==0) {
+              csc2_error("ERROR: OUT OF MEMORY\n");
+              exit(-1);
+            }
             }
 		;
 string:		T_STRING
@@ -408,6 +417,7 @@ keyflags:	T_DUP		{ key_setdup(); }
                 | T_RECNUMS     { key_setrecnums(); }
                 | T_PRIMARY     { key_setprimary(); }
                 | T_DATAKEY     { key_setdatakey(); }
+                | T_HASHKEY     { key_sethash(); }
 		;
 
 compoundkey:	keypiece
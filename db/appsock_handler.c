@@ -30,6 +30,13 @@
 #include "comdb2_appsock.h"
 #include "plhash.h"
 #include "comdb2_atomic.h"
+#include "list.h"
+#include "ssl_io.h"
+
+#ifdef _LINUX_SOURCE
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#endif
 
 #ifdef DEBUG
 // was crashing because of the small stack size when debug was on
@@ -64,6 +71,36 @@ static size_t num_commands = 0;
 static void appsock_thd_start(struct thdpool *pool, void *thddata);
 static void appsock_thd_end(struct thdpool *pool, void *thddata);
 
+/*
+ * Parked connections.
+ *
+ * A connection that is waiting for its next request doesn't need an appsock
+ * thread.  The handler can park it instead: its socket goes into an epoll
+ * set watched by a single thread, and the appsock thread goes back to the
+ * pool.  When the next request starts arriving the connection is handed back
+ * to an appsock thread, which calls the handler's resume function.
+ * Connections parked for longer than their idle timeout are resumed with
+ * drop set so the handler closes them, like a read timeout would.
+ */
+int gbl_appsock_park_idle = 0;
+
+struct parked_conn {
+    SBUF2 *sb;
+    appsock_resume_fn *resume;
+    void *arg;
+    int idle_timeout; /* secs, 0 for none */
+    int minbytes;     /* resume once this much of the request is in */
+    int parked_at;
+    int drop;
+    LINKC_T(struct parked_conn) lnk;
+};
+
+static pthread_mutex_t park_lk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t park_once = PTHREAD_ONCE_INIT;
+static LISTC_T(struct parked_conn) parked;
+static int park_fd = -1;
+static unsigned long long total_parks = 0;
+
 void close_appsock(SBUF2 *sb)
 {
     net_end_appsock(sb);
@@ -113,6 +150,10 @@ void appsock_quick_stat(void)
     logmsg(LOGMSG_USER, "num active appsock connections %d\n",
            active_appsock_conns);
     logmsg(LOGMSG_USER, "num appsock commands    %llu\n", total_toks);
+    logmsg(LOGMSG_USER, "num appsock threads     %d\n",
+           thdpool_get_nthds(gbl_appsock_thdpool));
+    logmsg(LOGMSG_USER, "num parked connections  %d\n", parked.count);
+    logmsg(LOGMSG_USER, "num connection parks    %llu\n", total_parks);
 }
 
 void appsock_stat(void)
@@ -287,6 +328,189 @@ static void appsock_work_pp(struct thdpool *pool, void *work, void *thddata,
     }
 }
 
+static void park_resume_pp(struct thdpool *pool, void *work, void *thddata,
+                           int op)
+{
+    struct parked_conn *p = work;
+    struct appsock_thd_state *state = thddata;
+
+    switch (op) {
+    case THD_RUN:
+        thrman_setfd(state->thr_self, sbuf2fileno(p->sb));
+        p->resume(state->thr_self, p->arg, p->drop);
+        thrman_setfd(state->thr_self, -1);
+        thrman_where(state->thr_self, NULL);
+        if (thrman_get_type(state->thr_self) != THRTYPE_APPSOCK_POOL)
+            thrman_change_type(state->thr_self, THRTYPE_APPSOCK_POOL);
+        break;
+
+    case THD_FREE:
+        p->resume(NULL, p->arg, 1);
+        break;
+
+    default:
+        abort();
+    }
+    free(p);
+}
+
+/* Hand a connection taken off the parked list to an appsock thread */
+static void resume_parked(struct parked_conn *p, int drop)
+{
+    p->drop = drop;
+    /* the connection was already accepted, queue it regardless of the
+     * pool's queue limit */
+    if (thdpool_enqueue(gbl_appsock_thdpool, park_resume_pp, p, 1, NULL)) {
+        p->resume(NULL, p->arg, 1);
+        free(p);
+    }
+}
+
+#ifdef _LINUX_SOURCE
+/* Bytes of the next request already in the socket, up to minbytes */
+static int park_peek(struct parked_conn *p)
+{
+    char buf[64];
+    int len = p->minbytes < sizeof(buf) ? p->minbytes : sizeof(buf);
+    int n;
+
+    n = recv(sbuf2fileno(p->sb), buf, len, MSG_PEEK | MSG_DONTWAIT);
+    /* let the reader see the error */
+    return n < 0 && errno != EAGAIN && errno != EWOULDBLOCK ? p->minbytes : n;
+}
+#endif
+
+static void *park_thd(void *unused)
+{
+#ifdef _LINUX_SOURCE
+    struct epoll_event ev[128];
+    struct parked_conn *p, *tmp;
+    LISTC_T(struct parked_conn) expired;
+    int n, now, last = 0;
+
+    thrman_register(THRTYPE_APPSOCK);
+    listc_init(&expired, offsetof(struct parked_conn, lnk));
+
+    while (!db_is_stopped()) {
+        n = epoll_wait(park_fd, ev, sizeof(ev) / sizeof(ev[0]), 1000);
+        for (int i = 0; i < n; i++) {
+            p = ev[i].data.ptr;
+            /* A thread resumed on a partial request would block reading the
+               rest of it; wait for more, the socket is edge triggered.  A
+               closed or broken socket is resumed to be cleaned up. */
+            if (!(ev[i].events & (EPOLLRDHUP | EPOLLHUP | EPOLLERR)) &&
+                park_peek(p) < p->minbytes)
+                continue;
+            LOCK(&park_lk)
+            {
+                listc_rfl(&parked, p);
+                epoll_ctl(park_fd, EPOLL_CTL_DEL, sbuf2fileno(p->sb), NULL);
+            }
+            UNLOCK(&park_lk);
+            resume_parked(p, 0);
+        }
+
+        now = comdb2_time_epoch();
+        if (now == last)
+            continue;
+        last = now;
+
+        LOCK(&park_lk)
+        {
+            LISTC_FOR_EACH_SAFE(&parked, p, tmp, lnk)
+            {
+                if (p->idle_timeout > 0 &&
+                    now - p->parked_at >= p->idle_timeout) {
+                    listc_rfl(&parked, p);
+                    epoll_ctl(park_fd, EPOLL_CTL_DEL, sbuf2fileno(p->sb),
+                              NULL);
+                    listc_abl(&expired, p);
+                }
+            }
+        }
+        UNLOCK(&park_lk);
+        while ((p = listc_rtl(&expired)) != NULL)
+            resume_parked(p, 1);
+    }
+#endif
+    return NULL;
+}
+
+static void park_init(void)
+{
+#ifdef _LINUX_SOURCE
+    pthread_t tid;
+
+    listc_init(&parked, offsetof(struct parked_conn, lnk));
+    if ((park_fd = epoll_create1(EPOLL_CLOEXEC)) == -1) {
+        logmsg(LOGMSG_ERROR, "%s: epoll_create1 %d %s\n", __func__, errno,
+               strerror(errno));
+        return;
+    }
+    if (pthread_create(&tid, &gbl_pthread_attr_detached, park_thd, NULL)) {
+        logmsg(LOGMSG_ERROR, "%s: can't create poller thread\n", __func__);
+        close(park_fd);
+        park_fd = -1;
+    }
+#endif
+}
+
+/* Park a connection until the first minbytes of its next request (its
+ * header) have arrived.  Returns non-0 if the connection can't be parked, in
+ * which case the caller keeps it.  SSL connections are never parked: what
+ * is in the socket is ciphertext, so there's no telling how much of the
+ * request has arrived. */
+int appsock_park(SBUF2 *sb, int idle_timeout, int minbytes,
+                 appsock_resume_fn *resume, void *arg)
+{
+#ifdef _LINUX_SOURCE
+    struct parked_conn *p;
+    struct epoll_event ev = {0};
+    int rc;
+
+    if (!gbl_appsock_park_idle || sbuf2pending(sb) || sslio_has_ssl(sb))
+        return -1;
+
+    pthread_once(&park_once, park_init);
+    if (park_fd == -1)
+        return -1;
+
+    if ((p = calloc(1, sizeof(struct parked_conn))) == NULL)
+        return -1;
+    p->sb = sb;
+    p->resume = resume;
+    p->arg = arg;
+    p->idle_timeout = idle_timeout;
+    p->minbytes = minbytes;
+    p->parked_at = comdb2_time_epoch();
+
+    /* only the poller thread takes connections off the set, so no
+       EPOLLONESHOT; edge triggered so a partial request wakes it up only
+       when more of it arrives */
+    ev.events = EPOLLIN | EPOLLRDHUP | EPOLLET;
+    ev.data.ptr = p;
+
+    LOCK(&park_lk)
+    {
+        listc_abl(&parked, p);
+        rc = epoll_ctl(park_fd, EPOLL_CTL_ADD, sbuf2fileno(sb), &ev);
+        if (rc)
+            listc_rfl(&parked, p);
+        else
+            total_parks++;
+    }
+    UNLOCK(&park_lk);
+
+    if (rc) {
+        free(p);
+        return -1;
+    }
+    return 0;
+#else
+    return -1;
+#endif
+}
+
 int gbl_appsock_connection_warn_threshold = 80;
 
 void dump_appsock_threads(void)
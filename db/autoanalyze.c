@@ -53,6 +53,7 @@ void reset_aa_counter(char *tblname)
 
     tbl->aa_saved_counter = 0;
     tbl->aa_lastepoch = time(NULL);
+    incr_stats_reset(tbl);
 
     if (save_freq > 0 && thedb->master == gbl_mynode) {
         // save updated counter
@@ -292,6 +293,8 @@ void stat_auto_analyze(void)
         loc_print_date(&tbl->aa_lastepoch);
         logmsg(LOGMSG_USER, "\n");
     }
+
+    stat_incr_stats();
 }
 
 /* Update counters for every table
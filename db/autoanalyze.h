@@ -22,4 +22,18 @@ void stat_auto_analyze(void);
 void *auto_analyze_main(void *);
 void *auto_analyze_table(void *arg);
 
+struct dbtable;
+struct ireq;
+extern int gbl_incremental_stats;
+void incr_stats_addkey(struct ireq *iq, struct dbtable *tbl, int ixnum,
+                       const void *key);
+void incr_stats_delkey(struct ireq *iq, struct dbtable *tbl, int ixnum);
+void incr_stats_begin(struct ireq *iq);
+void incr_stats_commit(struct ireq *iq);
+void incr_stats_abort(struct ireq *iq);
+void incr_stats_reset(struct dbtable *tbl);
+void incr_stats_free(struct dbtable *tbl);
+void *incr_stats_main(void *);
+void stat_incr_stats(void);
+
 #endif // INCLUDE_AUTOANALYZE_H
@@ -323,6 +323,7 @@ int gbl_init_with_instant_sc = 1;
 int gbl_init_with_compr = BDB_COMPRESS_CRLE;
 int gbl_init_with_compr_blobs = BDB_COMPRESS_LZ4;
 int gbl_init_with_bthash = 0;
+int gbl_ix_hash_size_kb = 1024;
 
 unsigned int gbl_nsql;
 long long gbl_nsql_steps;
@@ -449,6 +450,11 @@ int gbl_parallel_recovery_threads = 0;
 
 int gbl_fdb_resolve_local = 0;
 int gbl_fdb_allow_cross_classes = 0;
+int gbl_fdb_push_count = 1;
+int gbl_fdb_stream_batch_rows = 64;
+int gbl_fdb_stream_flush_ms = 10;
+int gbl_fdb_table_cache_max_rows = 0;
+int gbl_fdb_table_cache_ttl = 60;
 
 /*---COUNTS---*/
 long n_qtrap;
@@ -723,6 +729,7 @@ extern int gbl_uses_password;
 
 extern int gbl_direct_count;
 extern int gbl_parallel_count;
+extern int gbl_page_order_count;
 extern int gbl_debug_sqlthd_failures;
 extern int gbl_random_get_curtran_failures;
 extern int gbl_random_blkseq_replays;
@@ -1126,6 +1133,12 @@ static void *purge_old_blkseq_thread(void *arg)
         if ((loop % 30) == 0 && gbl_verify_dbreg)
             bdb_verify_dbreg(dbenv->bdb_env);
 
+        /* sample tables for the compression advisor */
+        compr_advisor_check();
+
+        /* rebalance sparse btrees */
+        defrag_check();
+
         sleep(1);
     }
 
@@ -1152,6 +1165,9 @@ static void *purge_old_files_thread(void *arg)
     backend_thread_event(thedb, COMDB2_THR_EVENT_START_RDONLY);
 
     while (!db_is_stopped()) {
+        /* files removed by replicating the master's purge */
+        bdb_shrink_removed_files(dbenv->bdb_env);
+
         /* even though we only add files to be deleted on the master,
          * don't try to delete files, ever, if you're a replicant */
         if (thedb->master != gbl_mynode) {
@@ -1168,6 +1184,9 @@ static void *purge_old_files_thread(void *arg)
         if (db_is_stopped())
             continue;
 
+        /* free most of the next file outside the transaction deleting it */
+        bdb_shrink_unused_files(dbenv->bdb_env);
+
         init_fake_ireq(thedb, &iq);
         iq.use_handle = thedb->bdb_env;
 
@@ -4804,6 +4823,10 @@ static void register_all_int_switches()
     register_int_switch("parallel_count",
                         "When 'direct_count' is on, enable thread-per-stripe",
                         &gbl_parallel_count);
+    register_int_switch("page_order_count",
+                        "When 'direct_count' is on, read the btree in page "
+                        "order",
+                        &gbl_page_order_count);
     register_int_switch("debug_sqlthd_failures",
                         "Force sqlthd failures in unusual places",
                         &gbl_debug_sqlthd_failures);
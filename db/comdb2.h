@@ -720,6 +720,7 @@ struct dbtable {
     time_t aa_lastepoch;
     unsigned aa_counter_upd;   // counter which includes updates
     unsigned aa_counter_noupd; // does not include updates
+    struct incr_stats *incr_stats; // incremental stat1, see incrstats.c
 
     /* This tables constraints */
     constraint_t constraints[MAXCONSTRAINTS];
@@ -1035,6 +1036,8 @@ typedef struct sorese_info {
     int type;   /* type, socksql or recom */
     int nops;   /* if no error, how many updated rows were performed */
     int rcout;  /* store here the block proc main error */
+    unsigned int commit_file;   /* where we logged the commit, sent back */
+    unsigned int commit_offset; /* with the result for read-your-writes */
 
     int verify_retries; /* how many times we verify retried this one */
     bool use_blkseq;    /* used to force a blkseq, for locally retried txn */
@@ -1208,6 +1211,21 @@ typedef struct bpfunc_lstnode {
 typedef LISTC_T(bpfunc_lstnode_t) bpfunc_list_t;
 /*******************************************************************/
 struct llog_scdone;
+/* index keys added and removed by a transaction, see incrstats.c */
+#define MAX_INCR_STATS_HITS_PER_TRANS 8
+struct incr_stats_hit {
+    struct dbtable *db;
+    int ixnum;
+    unsigned nadds;
+    unsigned ndels;
+};
+/* a key prefix hash waiting to go into its sketch */
+struct incr_stats_key {
+    uint64_t hash;
+    uint8_t hit; /* in incr_stats_hits */
+    uint8_t col;
+};
+
 struct ireq {
     /* bzero-ing this entire struct was turning out to be very expensive.
      * So organizing this into 3 regions:
@@ -1283,6 +1301,7 @@ struct ireq {
     struct thread_info *thdinfo;
 
     struct dbtable *queues_hit[MAX_QUEUE_HITS_PER_TRANS];
+    struct incr_stats_hit incr_stats_hits[MAX_INCR_STATS_HITS_PER_TRANS];
 
     /* List of replication objects associated with the ireq/transaction
      * which other subsystems (i.e. queues) may need to wait for. */
@@ -1363,6 +1382,14 @@ struct ireq {
      * we'll have to wake up all queues on commit - oh well. */
     unsigned num_queues_hit;
 
+    /* indexes whose incremental stats counts wait for the commit */
+    unsigned num_incr_stats_hits;
+    /* and their key hashes; only block transactions buffer them */
+    struct incr_stats_key *incr_stats_keys;
+    unsigned num_incr_stats_keys;
+    unsigned max_incr_stats_keys;
+    int incr_stats_tracked;
+
     /* Number of oplog operations logged as part of this transaction */
     int oplog_numops;
     int seqlen;
@@ -1668,6 +1695,7 @@ extern int gbl_init_with_instant_sc;
 extern int gbl_init_with_compr;
 extern int gbl_init_with_compr_blobs;
 extern int gbl_init_with_bthash;
+extern int gbl_ix_hash_size_kb;
 
 extern int gbl_sqlhistsz;
 extern int gbl_replicate_local;
@@ -3356,6 +3384,76 @@ extern int __slow_write_ns;
 
 void handle_testcompr(SBUF2 *sb, const char *table);
 void handle_setcompr(SBUF2 *);
+int setcompr_table(const char *tbl, const char *rec, const char *blob);
+
+/* One row of comdb2_compression_stats: how one algorithm fared on the data or
+ * blobs of a table in the last compression advisor run */
+struct compr_advisor_stat {
+    char *tablename;
+    char *kind; /* "data" or "blob" */
+    char *algorithm;
+    int64_t sampled_rows;
+    int64_t sampled_at;
+    int64_t original_bytes;
+    int64_t compressed_bytes;
+    double percent;
+    double decode_ns_per_byte;
+    char *current;
+    char *recommended;
+    char *switched;
+};
+
+void compr_advisor_run(void);
+void compr_advisor_check(void);
+int compr_advisor_stats(struct compr_advisor_stat **stats, int *nstats);
+void compr_advisor_stats_free(struct compr_advisor_stat *stats, int nstats);
+
+/* One row of comdb2_defrag_stats: leaf fill of one btree file before and after
+ * the last defrag run */
+struct defrag_stat {
+    char *tablename;
+    char *filename;
+    char *status;
+    int64_t leaf_pages_before;
+    double fill_before;
+    int64_t leaf_pages_after;
+    double fill_after;
+    int64_t merges;
+    int64_t defragged_at;
+};
+
+void defrag_run(void);
+void defrag_check(void);
+int defrag_stats(struct defrag_stat **stats, int *nstats);
+void defrag_stats_free(struct defrag_stat *stats, int nstats);
+
+/* Admission control (sql_admit.c) */
+enum { SQL_ADMIT_BY_ARGV0 = 0, SQL_ADMIT_BY_USER = 1, SQL_ADMIT_BY_HOST = 2 };
+extern int gbl_sql_admit;
+int sql_admit_enqueue(struct sqlclntstate *clnt, thdpool_work_fn work_fn,
+                      int queue_override, char *info);
+const char *sql_admit_lane_name(int lane);
+int sql_admit_set_weights(const char *weights);
+void sql_admit_stat(void);
+
+/* Per-query memory accounting (sqlglue.c) */
+extern int gbl_query_mem_limit_mb;
+extern int gbl_query_mem_spill_mb;
+
+struct query_mem_stat {
+    int64_t id;
+    char *origin;
+    char *sql;
+    int64_t used;
+    int64_t peak;
+    int64_t limit;
+    int64_t spills;
+    int64_t connection_peak;
+};
+
+int query_mem_stats(struct query_mem_stat **stats, int *nstats);
+void query_mem_stats_free(struct query_mem_stat *stats, int nstats);
+
 void handle_rowlocks_enable(SBUF2 *);
 void handle_rowlocks_enable_master_only(SBUF2 *);
 void handle_rowlocks_disable(SBUF2 *);
@@ -3478,6 +3576,8 @@ int table_version_set(tran_type *tran, const char *tablename,
 int sc_timepart_add_table(const char *existingTableName,
                           const char *newTableName, struct errstat *err);
 int sc_timepart_drop_table(const char *tableName, struct errstat *err);
+int sc_timepart_freeze_table(const char *tableName, int compress,
+                             struct errstat *err);
 
 /* SCHEMACHANGE DECLARATIONS*/
 
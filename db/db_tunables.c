@@ -63,6 +63,11 @@ extern int gbl_forbid_ulonglong;
 extern int gbl_force_highslot;
 extern int gbl_fdb_allow_cross_classes;
 extern int gbl_fdb_resolve_local;
+extern int gbl_fdb_push_count;
+extern int gbl_fdb_stream_batch_rows;
+extern int gbl_fdb_stream_flush_ms;
+extern int gbl_fdb_table_cache_max_rows;
+extern int gbl_fdb_table_cache_ttl;
 extern int gbl_goslow;
 extern int gbl_heartbeat_send;
 extern int gbl_keycompr;
@@ -140,6 +145,42 @@ extern int gbl_time_rep_apply;
 extern int gbl_incoherent_logput_window;
 extern int gbl_dump_full_net_queue;
 extern int gbl_max_clientstats_cache;
+extern int gbl_compr_advisor_interval;
+extern int gbl_compr_advisor_autoswitch;
+extern int gbl_compr_advisor_max;
+extern int gbl_compr_advisor_cpu_weight;
+extern int gbl_compr_advisor_min_gain;
+extern int gbl_timepart_freeze_shards;
+extern int gbl_timepart_freeze_lag;
+extern int gbl_timepart_freeze_compress;
+extern int gbl_incremental_stats;
+extern int gbl_incremental_stats_min_ops;
+extern int gbl_incremental_stats_interval;
+extern int gbl_analyze_histograms;
+extern int gbl_analyze_hist_buckets;
+extern int gbl_analyze_hist_sample;
+extern int gbl_defrag_interval;
+extern int gbl_defrag_min_pages;
+extern int gbl_defrag_pages_per_sec;
+extern double gbl_defrag_min_ff;
+extern double gbl_defrag_target_ff;
+extern int gbl_osqlpf_readahead;
+extern int gbl_osqlpf_max_inflight;
+extern int gbl_osqlpf_max_bytes;
+extern int gbl_appsock_park_idle;
+extern int gbl_sql_admit_fair_by;
+extern int gbl_sql_admit_long_ms;
+extern int gbl_sql_admit_long_threads;
+extern int gbl_sql_admit_short_threads;
+extern char *gbl_sql_admit_weights;
+extern int gbl_query_mem_limit_mb;
+extern int gbl_query_mem_spill_mb;
+extern int gbl_log_prealloc_files;
+extern int gbl_log_recycle;
+extern int gbl_rep_page_catchup_mb;
+extern int gbl_read_your_writes_timeout_ms;
+extern int gbl_berkdb_mutex_adaptive;
+extern int gbl_berkdb_mutex_spin_max;
 
 extern long long sampling_threshold;
 
@@ -220,6 +261,27 @@ static int init_with_compr_blobs_update(void *context, void *algo)
     return 0;
 }
 
+/* bdb_compr2algo() quietly maps anything it doesn't know to none */
+static int compr_verify(void *context, void *algo)
+{
+    if (strcasecmp((char *)algo, "none") != 0 &&
+        bdb_compr2algo((char *)algo) == BDB_COMPRESS_NONE) {
+        logmsg(LOGMSG_ERROR, "Unknown compression algorithm '%s', expected "
+                             "none, zlib, rle8, crle or lz4.\n",
+               (char *)algo);
+        return 1;
+    }
+    return 0;
+}
+
+static int timepart_freeze_compress_update(void *context, void *algo)
+{
+    gbl_timepart_freeze_compress = bdb_compr2algo((char *)algo);
+    logmsg(LOGMSG_INFO, "Frozen shards will be compressed: %s\n",
+           bdb_algo2compr(gbl_timepart_freeze_compress));
+    return 0;
+}
+
 static int init_with_rowlocks_update(void *context, void *unused)
 {
     gbl_init_with_rowlocks = 1;
@@ -687,6 +749,57 @@ static int sql_tranlevel_default_update(void *context, void *value)
     return 0;
 }
 
+struct sql_admit_fair_by_st {
+    const char *name;
+    int code;
+} sql_admit_fair_by_vals[] = {{"ARGV0", SQL_ADMIT_BY_ARGV0},
+                              {"USER", SQL_ADMIT_BY_USER},
+                              {"HOST", SQL_ADMIT_BY_HOST}};
+
+static int sql_admit_fair_by_update(void *context, void *value)
+{
+    comdb2_tunable *tunable = (comdb2_tunable *)context;
+    char *tok;
+    int st = 0;
+    int ltok;
+
+    tok = segtok(value, strlen(value), &st, &ltok);
+    for (int i = 0; i < (sizeof(sql_admit_fair_by_vals) /
+                         sizeof(struct sql_admit_fair_by_st));
+         i++) {
+        if (tokcmp(tok, ltok, sql_admit_fair_by_vals[i].name) == 0) {
+            *(int *)tunable->var = sql_admit_fair_by_vals[i].code;
+            return 0;
+        }
+    }
+    return 1;
+}
+
+static void *sql_admit_fair_by_value(void *context)
+{
+    comdb2_tunable *tunable = (comdb2_tunable *)context;
+
+    for (int i = 0; i < (sizeof(sql_admit_fair_by_vals) /
+                         sizeof(struct sql_admit_fair_by_st));
+         i++) {
+        if (sql_admit_fair_by_vals[i].code == *(int *)tunable->var) {
+            return (void *)sql_admit_fair_by_vals[i].name;
+        }
+    }
+    return "unknown";
+}
+
+static int sql_admit_weights_update(void *context, void *value)
+{
+    comdb2_tunable *tunable = (comdb2_tunable *)context;
+
+    if (sql_admit_set_weights(value))
+        return 1;
+    free(*(char **)tunable->var);
+    *(char **)tunable->var = strdup(value);
+    return 0;
+}
+
 /* Routines for the tunable system itself - tunable-specific
  * routines belong above */
 
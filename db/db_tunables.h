@@ -49,15 +49,46 @@ REGISTER_TUNABLE("analyze_comp_threshold",
                  "scan the entire index. (Default: 104857600)",
                  TUNABLE_INTEGER, &sampling_threshold, READONLY, NULL, NULL,
                  analyze_set_sampling_threshold, NULL);
+REGISTER_TUNABLE("analyze_histograms",
+                 "Also collect histograms for the numeric columns that do not "
+                 "lead an index, and correlations between them. (Default: "
+                 "off)",
+                 TUNABLE_BOOLEAN, &gbl_analyze_histograms, NOARG, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("analyze_hist_buckets",
+                 "Buckets per column histogram, at most 100. (Default: 32)",
+                 TUNABLE_INTEGER, &gbl_analyze_hist_buckets, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("analyze_hist_sample",
+                 "Rows kept to build column histograms from. (Default: "
+                 "100000)",
+                 TUNABLE_INTEGER, &gbl_analyze_hist_sample, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE("analyze_tbl_threads",
                  "Number of threads to go through generated samples when "
                  "generating index statistics. (Default: 5)",
                  TUNABLE_INTEGER, &analyze_max_table_threads, READONLY, NULL,
                  NULL, analyze_set_max_table_threads, NULL);
+REGISTER_TUNABLE("appsock_park_idle",
+                 "Hand connections waiting for their next request outside a "
+                 "transaction to a poller instead of holding an appsock "
+                 "thread. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_appsock_park_idle, DYNAMIC | NOARG,
+                 NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("badwrite_intvl", NULL, TUNABLE_INTEGER,
                  &gbl_test_badwrite_intvl, READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("bbenv", NULL, TUNABLE_BOOLEAN, &gbl_bbenv,
                  DEPRECATED | READONLY | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("berkdb_mutex_adaptive",
+                 "Spin with backoff, for a learned number of spins, for a held "
+                 "berkdb region mutex before blocking on it. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_berkdb_mutex_adaptive, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("berkdb_mutex_spin_max",
+                 "Most spins for a held mutex with berkdb_mutex_adaptive. "
+                 "(Default: 2000)",
+                 TUNABLE_INTEGER, &gbl_berkdb_mutex_spin_max, 0, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("blob_mem_mb", "Blob allocator: Sets the max "
                                 "memory limit to allow for blob "
                                 "values (in MB). (Default: 0)",
@@ -148,6 +179,32 @@ REGISTER_TUNABLE("default_datetime_precision", NULL,
                  TUNABLE_INTEGER, &gbl_datetime_precision, READONLY, NULL, NULL,
                  NULL, NULL);
 */
+REGISTER_TUNABLE("defrag_interval",
+                 "Measure the leaf fill of every btree and defragment the "
+                 "sparse ones this often, in seconds. Master only. 0 to "
+                 "disable. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_defrag_interval, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("defrag_min_ff",
+                 "Defragment files whose leaves are filled less than this, "
+                 "merging every leaf filled less than this. (Default: 0.7)",
+                 TUNABLE_DOUBLE, &gbl_defrag_min_ff, DYNAMIC, NULL, NULL, NULL,
+                 NULL);
+REGISTER_TUNABLE("defrag_min_pages",
+                 "Leave files with fewer leaf pages than this alone. "
+                 "(Default: 100)",
+                 TUNABLE_INTEGER, &gbl_defrag_min_pages, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("defrag_pages_per_sec",
+                 "I/O budget of the defragmenter, in pages read or rewritten "
+                 "a second. 0 for no limit. (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_defrag_pages_per_sec, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("defrag_target_ff",
+                 "Fill factor the defragmenter packs sparse leaves to. "
+                 "(Default: 0.9)",
+                 TUNABLE_DOUBLE, &gbl_defrag_target_ff, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("dir",
                  "Database directory. (Default: $COMDB2_ROOT/var/cdb2/$DBNAME)",
                  TUNABLE_STRING, &db->basedir, READONLY, NULL, NULL, NULL,
@@ -436,6 +493,31 @@ REGISTER_TUNABLE("foreign_db_allow_cross_class", NULL, TUNABLE_BOOLEAN,
 REGISTER_TUNABLE("foreign_db_resolve_local", NULL, TUNABLE_BOOLEAN,
                  &gbl_fdb_resolve_local, READONLY | NOARG | READEARLY, NULL,
                  NULL, NULL, NULL);
+REGISTER_TUNABLE("foreign_db_push_count",
+                 "Run a bare count(*) on a remote table, one without WHERE "
+                 "or GROUP BY, in the remote database. (Default: on)",
+                 TUNABLE_BOOLEAN, &gbl_fdb_push_count, DYNAMIC | NOARG, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("foreign_db_stream_batch_rows",
+                 "Rows a remote sql query streams back before flushing them "
+                 "to the requester. (Default: 64)",
+                 TUNABLE_INTEGER, &gbl_fdb_stream_batch_rows, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("foreign_db_stream_flush_ms",
+                 "Flush streamed remote sql rows at least this often, in "
+                 "milliseconds. (Default: 10)",
+                 TUNABLE_INTEGER, &gbl_fdb_stream_flush_ms, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("foreign_db_table_cache_max_rows",
+                 "Read remote tables with at most this many rows from a local "
+                 "copy; 0 disables the cache. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_fdb_table_cache_max_rows, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("foreign_db_table_cache_ttl",
+                 "Seconds a local copy of a remote table is used before it "
+                 "is refreshed. (Default: 60)",
+                 TUNABLE_INTEGER, &gbl_fdb_table_cache_ttl, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
 REGISTER_TUNABLE("fullrecovery", "Attempt to run database "
                                  "recovery from the beginning of "
                                  "available logs. (Default : off)",
@@ -517,6 +599,12 @@ REGISTER_TUNABLE("iothreads",
                  "Number of threads to use for I/O prefaulting. (Default: 0)",
                  TUNABLE_INTEGER, &gbl_iothreads, READONLY, NULL, NULL, NULL,
                  NULL);
+REGISTER_TUNABLE("ix_hash_size_kb",
+                 "Size of the leaf page hint table kept for each index "
+                 "declared with the hash key flag; applies when a table is "
+                 "opened or altered. 0 disables the hints. (Default: 1024)",
+                 TUNABLE_INTEGER, &gbl_ix_hash_size_kb, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("keycompr",
                  "Enable index compression (applies to newly allocated index "
                  "pages, rebuild table to force for all pages.",
@@ -555,6 +643,16 @@ REGISTER_TUNABLE(
     "Set log deletion policy to delete logs as soon as possible. (Default: 0)",
     TUNABLE_INTEGER, &db->log_delete_age, READONLY | NOARG | INVERSE_VALUE,
     NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("log_prealloc_files",
+                 "Keep this many spare log files, written out with zeros, "
+                 "for the log to move into. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_log_prealloc_files, 0, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("log_recycle",
+                 "Make deleted log files into spares instead of removing "
+                 "them (see log_prealloc_files). (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_log_recycle, 0, NULL, NULL, NULL,
+                 NULL);
 REGISTER_TUNABLE("loghist", NULL, TUNABLE_INTEGER, &gbl_loghist,
                  READONLY | NOARG, NULL, NULL, loghist_update, NULL);
 REGISTER_TUNABLE("loghist_verbose", NULL, TUNABLE_BOOLEAN, &gbl_loghist_verbose,
@@ -821,6 +919,23 @@ REGISTER_TUNABLE("osql_net_poll",
 REGISTER_TUNABLE("osql_net_portmux_register_interval", NULL, TUNABLE_INTEGER,
                  &gbl_osql_net_portmux_register_interval, READONLY, NULL, NULL,
                  NULL, NULL);
+REGISTER_TUNABLE("osql_prefault_max_bytes",
+                 "Stop queueing osql prefaults while the queued ones hold this "
+                 "many bytes. (Default: 16MB)",
+                 TUNABLE_INTEGER, &gbl_osqlpf_max_bytes, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("osql_prefault_max_inflight",
+                 "Stop queueing osql prefaults while this many are queued or "
+                 "running. (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_osqlpf_max_inflight, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("osql_prefault_readahead",
+                 "Prefault write transactions this many ops ahead of the op "
+                 "being applied, instead of as the ops arrive. Needs "
+                 "osqlprefaultthreads. 0 to prefault as the ops arrive. "
+                 "(Default: 0)",
+                 TUNABLE_INTEGER, &gbl_osqlpf_readahead, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("osqlprefaultthreads",
                  "If set, send prefaulting hints to nodes. (Default: 0)",
                  TUNABLE_INTEGER, &gbl_osqlpfault_threads, READONLY, NULL, NULL,
@@ -856,9 +971,11 @@ REGISTER_TUNABLE("pagesize", NULL, TUNABLE_INTEGER,
                  &placeholder, DEPRECATED|READONLY, NULL, NULL, NULL,
                  NULL);
 */
-REGISTER_TUNABLE("parallel_recovery", NULL, TUNABLE_INTEGER,
-                 &gbl_parallel_recovery_threads, READONLY, NULL, NULL, NULL,
-                 NULL);
+REGISTER_TUNABLE("parallel_recovery",
+                 "Redo the log with this many threads during crash recovery. "
+                 "0 or 1 to redo on the recovering thread. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_parallel_recovery_threads, READONLY,
+                 NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("penaltyincpercent", NULL, TUNABLE_INTEGER,
                  &gbl_penaltyincpercent, READONLY, NULL, NULL, NULL, NULL);
 REGISTER_TUNABLE("perfect_ckp", NULL, TUNABLE_INTEGER, &gbl_use_perfect_ckp,
@@ -882,6 +999,17 @@ REGISTER_TUNABLE("print_syntax_err",
                  "Trace all SQL with syntax errors. (Default: off)",
                  TUNABLE_BOOLEAN, &gbl_print_syntax_err, READONLY | NOARG, NULL,
                  NULL, NULL, NULL);
+REGISTER_TUNABLE("query_mem_limit_mb",
+                 "Fail statements that use more than this much memory, in MB. "
+                 "0 for no limit. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_query_mem_limit_mb, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("query_mem_spill_mb",
+                 "Sorts and hash tables of a statement that uses more than "
+                 "this much memory, in MB, spill to disk. 0 for half of "
+                 "query_mem_limit_mb. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_query_mem_spill_mb, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("queuepoll", "Occasionally wake up and poll "
                               "consumer queues even when no "
                               "events require it. (Default: 5secs)",
@@ -940,6 +1068,19 @@ REGISTER_TUNABLE("deadlkon", "Same as 'report_deadlock_verbose'",
 REGISTER_TUNABLE("deadlkoff", "Disables 'report_deadlock_verbose'",
                  TUNABLE_BOOLEAN, &gbl_disable_deadlock_trace,
                  INVERSE_VALUE | NOARG, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("read_your_writes_timeout_ms",
+                 "How long a node waits to apply a client's last commit "
+                 "before running its next query; after that the client is "
+                 "sent to another node. 0 runs queries without waiting. "
+                 "(Default: 5000)",
+                 TUNABLE_INTEGER, &gbl_read_your_writes_timeout_ms, 0, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("rep_page_catchup_mb",
+                 "A replicant this many MB of log behind the master catches "
+                 "up by copying changed pages instead of replaying the log; "
+                 "both nodes need it set. 0 disables. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_rep_page_catchup_mb, 0, NULL, NULL,
+                 NULL, NULL);
 REGISTER_TUNABLE("rep_process_txn_trace",
                  "If set, report processing time on replicant for all "
                  "transactions. (Default: off)",
@@ -1010,6 +1151,37 @@ REGISTER_TUNABLE("sqlsortermem", "Maximum amount of memory to be "
                  NULL, NULL);
 REGISTER_TUNABLE("sqlsortermult", NULL, TUNABLE_INTEGER, &gbl_sqlite_sortermult,
                  READONLY, NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_admit",
+                 "Queue sql requests per client, in a short and a long lane, "
+                 "before the sql engine pool. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_sql_admit, DYNAMIC | NOARG, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("sql_admit_fair_by",
+                 "Share sql admission fairly between clients by ARGV0, USER "
+                 "or HOST. (Default: ARGV0)",
+                 TUNABLE_ENUM, &gbl_sql_admit_fair_by, DYNAMIC,
+                 sql_admit_fair_by_value, NULL, sql_admit_fair_by_update,
+                 NULL);
+REGISTER_TUNABLE("sql_admit_long_ms",
+                 "Statements averaging this many ms go to the long lane. "
+                 "(Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_sql_admit_long_ms, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("sql_admit_long_threads",
+                 "Most statements of the long lane running at once, 0 for a "
+                 "quarter of the sql engine pool. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_sql_admit_long_threads, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_admit_short_threads",
+                 "Most statements of the short lane running at once, 0 for "
+                 "the rest of the sql engine pool. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_sql_admit_short_threads, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("sql_admit_weights",
+                 "Weights of clients for sql admission, as "
+                 "name:weight,name:weight. (Default: all 1)",
+                 TUNABLE_STRING, &gbl_sql_admit_weights, DYNAMIC, NULL, NULL,
+                 sql_admit_weights_update, NULL);
 REGISTER_TUNABLE("sql_time_threshold",
                  "Sets the threshold time in ms after which queries are "
                  "reported as running a long time. (Default: 5000 ms)",
@@ -1272,4 +1444,63 @@ REGISTER_TUNABLE(
     TUNABLE_INTEGER, &gbl_max_clientstats_cache, DYNAMIC, NULL, NULL, NULL,
     NULL);
 
+REGISTER_TUNABLE("compr_advisor_interval",
+                 "Sample every table and recommend a compression algorithm "
+                 "this often, in seconds. 0 to disable. (Default: 0)",
+                 TUNABLE_INTEGER, &gbl_compr_advisor_interval, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("compr_advisor_autoswitch",
+                 "Switch tables to the recommended compression algorithm for "
+                 "new writes. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_compr_advisor_autoswitch, NOARG, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("compr_advisor_max",
+                 "Max number of records the compression advisor samples per "
+                 "table. (Default: 10000)",
+                 TUNABLE_INTEGER, &gbl_compr_advisor_max, DYNAMIC, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("compr_advisor_cpu_weight",
+                 "Percentage points of size the compression advisor gives up "
+                 "for every ns/byte of decode time. (Default: 1)",
+                 TUNABLE_INTEGER, &gbl_compr_advisor_cpu_weight, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("compr_advisor_min_gain",
+                 "Only recommend a different compression algorithm if it is "
+                 "this many percentage points cheaper. (Default: 5)",
+                 TUNABLE_INTEGER, &gbl_compr_advisor_min_gain, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+
+REGISTER_TUNABLE("timepart_freeze_shards",
+                 "Rebuild time partition shards with timepart_freeze_compress "
+                 "once they are rolled out. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_timepart_freeze_shards, NOARG, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("timepart_freeze_lag",
+                 "Seconds after a rollout before the retired shard is "
+                 "frozen. (Default: 300)",
+                 TUNABLE_INTEGER, &gbl_timepart_freeze_lag, DYNAMIC, NULL,
+                 NULL, NULL, NULL);
+REGISTER_TUNABLE("timepart_freeze_compress",
+                 "Compression algorithm for frozen shards, data and blobs: "
+                 "none, zlib, rle8, crle or lz4. (Default: zlib)",
+                 TUNABLE_ENUM, &gbl_timepart_freeze_compress, DYNAMIC,
+                 init_with_compr_value, compr_verify,
+                 timepart_freeze_compress_update, NULL);
+
+REGISTER_TUNABLE("incremental_stats",
+                 "Keep sqlite_stat1 current between analyzes from sketches of "
+                 "the keys written on the master. (Default: off)",
+                 TUNABLE_BOOLEAN, &gbl_incremental_stats, NOARG, NULL, NULL,
+                 NULL, NULL);
+REGISTER_TUNABLE("incremental_stats_min_ops",
+                 "Keys added or removed from an index before its incremental "
+                 "stats are published again. (Default: 1000)",
+                 TUNABLE_INTEGER, &gbl_incremental_stats_min_ops, DYNAMIC,
+                 NULL, NULL, NULL, NULL);
+REGISTER_TUNABLE("incremental_stats_interval",
+                 "Minimum seconds between publishing the incremental stats "
+                 "of a table. (Default: 60)",
+                 TUNABLE_INTEGER, &gbl_incremental_stats_interval, DYNAMIC,
+                 NULL, NULL, NULL, NULL);
+
 #endif /* _DB_TUNABLES_H */
@@ -0,0 +1,387 @@
+/*
+   Copyright 2018 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+** Online btree defragmentation.
+**
+** Page compaction only hears about sparse pages as they pass through the
+** bufferpool, so after a big delete most of the emptied leaves are never
+** looked at again. Every defrag_interval seconds the master walks every
+** data, blob and index file in page order and measures how full its leaves
+** are. Files whose leaves are less than defrag_min_ff full (and have at
+** least defrag_min_pages leaves) are ranked emptiest first and walked again;
+** every leaf under defrag_min_ff is merged with its key-order siblings until
+** it is defrag_target_ff full, through the same logged page compaction the
+** sparse page hints use. A third walk measures the result. All the walks
+** share an I/O budget of defrag_pages_per_sec pages a second, and take the
+** schema lock DEFRAG_BATCH pages at a time so schema changes don't queue
+** up behind a big file.
+**
+** Merged pages go to the file's free list and are reused by later splits;
+** files don't shrink.
+**
+** The result of the last run is in comdb2_defrag_stats.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <pthread.h>
+
+#include <comdb2.h>
+#include <bdb_api.h>
+#include <logmsg.h>
+#include <epochlib.h>
+
+int gbl_defrag_interval = 0;
+int gbl_defrag_min_pages = 100;
+int gbl_defrag_pages_per_sec = 1000;
+double gbl_defrag_min_ff = 0.7;
+double gbl_defrag_target_ff = 0.9;
+
+struct defrag_file {
+    char *tablename;
+    char filename[256];
+    int fileno;
+    struct bdb_fill before;
+    struct bdb_fill after;
+    unsigned nmerged;
+    const char *status;
+    int64_t defragged_at;
+    struct defrag_file *next;
+};
+
+/* Pages walked per hold of the schema lock */
+#define DEFRAG_BATCH 1000
+
+/* I/O budget shared by all walks of a run */
+struct defrag_budget {
+    int start; /* ms */
+    int npages;
+};
+
+static pthread_mutex_t defrag_lk = PTHREAD_MUTEX_INITIALIZER;
+static struct defrag_file *defrag_files;
+static int defrag_running;
+
+static void free_defrag_list(struct defrag_file *f)
+{
+    while (f) {
+        struct defrag_file *next = f->next;
+        free(f->tablename);
+        free(f);
+        f = next;
+    }
+}
+
+static double fill_ratio(const struct bdb_fill *fill)
+{
+    return fill->total ? (double)fill->used / fill->total : 1;
+}
+
+static int defrag_tick(void *arg, int npages)
+{
+    struct defrag_budget *b = arg;
+    int now, elapsed;
+
+    if (db_is_stopped() || gbl_schema_change_in_progress ||
+        thedb->master != gbl_mynode)
+        return 1;
+
+    if (gbl_defrag_pages_per_sec <= 0)
+        return 0;
+
+    b->npages += npages;
+    if (b->npages < gbl_defrag_pages_per_sec)
+        return 0;
+
+    /* Spent this second's budget, wait for the next one */
+    now = comdb2_time_epochms();
+    elapsed = now - b->start;
+    if (elapsed >= 0 && elapsed < 1000)
+        usleep((1000 - elapsed) * 1000);
+    b->start = comdb2_time_epochms();
+    b->npages = 0;
+    return 0;
+}
+
+/* Walk file fileno of a table, a batch at a time with the schema lock held
+ * for each batch only. fill and nmerged are added to. filename is set by
+ * the first batch; if the table is dropped, or the file renamed by a
+ * rebuild, between batches, returns -1 with bdberr BDBERR_BADARGS, same as
+ * past the last file. */
+static int defrag_walk(const char *tablename, int fileno, double ff,
+                       double tgtff, struct defrag_budget *budget,
+                       char *filename, int namelen, struct bdb_fill *fill,
+                       unsigned *nmerged, int *bdberr)
+{
+    char name[256];
+    unsigned pgno = 0;
+    int rc;
+
+    filename[0] = 0;
+    do {
+        struct dbtable *db;
+
+        rdlock_schema_lk();
+        db = get_dbtable_by_name(tablename);
+        if (db == NULL) {
+            unlock_schema_lk();
+            *bdberr = BDBERR_BADARGS;
+            return -1;
+        }
+        rc = bdb_defrag_file(db->handle, fileno, ff, tgtff, &pgno,
+                             DEFRAG_BATCH, defrag_tick, budget, name,
+                             sizeof(name), fill, nmerged, bdberr);
+        unlock_schema_lk();
+        if (rc)
+            return rc;
+        if (filename[0] == 0) {
+            strncpy(filename, name, namelen - 1);
+            filename[namelen - 1] = 0;
+        } else if (strncmp(filename, name, namelen - 1) != 0) {
+            *bdberr = BDBERR_BADARGS;
+            return -1;
+        }
+    } while (pgno != 0);
+    return 0;
+}
+
+/* Measure every file of a table, add them to the list. Returns non-0 if the
+ * run should stop. */
+static int measure_table(const char *tablename, struct defrag_budget *budget,
+                         struct defrag_file ***tail)
+{
+    for (int fileno = 0;; ++fileno) {
+        struct defrag_file *f;
+        int rc, bdberr;
+
+        if ((f = calloc(1, sizeof(struct defrag_file))) == NULL)
+            return 1;
+        rc = defrag_walk(tablename, fileno, 0, 0, budget, f->filename,
+                         sizeof(f->filename), &f->before, NULL, &bdberr);
+        /* Past the last file, or the table went away */
+        if (rc && bdberr == BDBERR_BADARGS) {
+            free(f);
+            return 0;
+        }
+        f->tablename = strdup(tablename);
+        f->fileno = fileno;
+        if (rc) {
+            f->status = "interrupted";
+        } else if (f->before.nleaf < gbl_defrag_min_pages) {
+            f->status = "small";
+        } else if (fill_ratio(&f->before) >= gbl_defrag_min_ff) {
+            f->status = "full";
+        } else {
+            f->status = "candidate";
+        }
+        **tail = f;
+        *tail = &f->next;
+        if (rc)
+            return 1;
+    }
+}
+
+static void defrag_one(struct defrag_file *f, struct defrag_budget *budget)
+{
+    char name[sizeof(f->filename)];
+    struct bdb_fill during = {0};
+    int rc, bdberr;
+
+    rc = defrag_walk(f->tablename, f->fileno, gbl_defrag_min_ff,
+                     gbl_defrag_target_ff, budget, name, sizeof(name),
+                     &during, &f->nmerged, &bdberr);
+    /* Table was dropped or rebuilt under us */
+    if ((rc && bdberr == BDBERR_BADARGS) ||
+        (rc == 0 && strcmp(name, f->filename) != 0)) {
+        f->status = "dropped";
+        return;
+    }
+    if (rc == 0)
+        rc = defrag_walk(f->tablename, f->fileno, 0, 0, budget, name,
+                         sizeof(name), &f->after, NULL, &bdberr);
+
+    f->defragged_at = time(NULL);
+    f->status = rc ? (bdberr == BDBERR_CALLBACK ||
+                              bdberr == BDBERR_LOCK_DESIRED
+                          ? "interrupted"
+                          : "failed")
+                   : "defragmented";
+
+    logmsg(LOGMSG_INFO,
+           "defrag: %s %s: %u leaves %.1f%% full -> %u leaves %.1f%% full, "
+           "%u merges, %s\n",
+           f->tablename, f->filename, f->before.nleaf,
+           100 * fill_ratio(&f->before), f->after.nleaf,
+           100 * fill_ratio(&f->after), f->nmerged, f->status);
+}
+
+static int cmp_fill(const void *a, const void *b)
+{
+    double fa = fill_ratio(&(*(struct defrag_file **)a)->before);
+    double fb = fill_ratio(&(*(struct defrag_file **)b)->before);
+    return fa < fb ? -1 : fa > fb;
+}
+
+static void *defrag_thd(void *unused)
+{
+    struct defrag_file *head = NULL, **tail = &head, **rank = NULL, *f;
+    struct defrag_budget budget = {0};
+    int ncand = 0;
+
+    thrman_register(THRTYPE_DEFRAG);
+    backend_thread_event(thedb, COMDB2_THR_EVENT_START_RDWR);
+
+    budget.start = comdb2_time_epochms();
+
+    for (int i = 0;; ++i) {
+        char *tablename;
+        int stop;
+
+        rdlock_schema_lk();
+        if (i >= thedb->num_dbs || defrag_tick(&budget, 0)) {
+            unlock_schema_lk();
+            break;
+        }
+        tablename = strdup(thedb->dbs[i]->tablename);
+        unlock_schema_lk();
+        if (tablename == NULL)
+            break;
+        stop = measure_table(tablename, &budget, &tail);
+        free(tablename);
+        if (stop)
+            break;
+    }
+
+    /* Emptiest files first */
+    for (f = head; f; f = f->next)
+        if (strcmp(f->status, "candidate") == 0)
+            ncand++;
+    if (ncand && (rank = malloc(ncand * sizeof(*rank))) != NULL) {
+        int n = 0;
+        for (f = head; f; f = f->next)
+            if (strcmp(f->status, "candidate") == 0)
+                rank[n++] = f;
+        qsort(rank, ncand, sizeof(*rank), cmp_fill);
+        for (n = 0; n < ncand; n++) {
+            if (defrag_tick(&budget, 0))
+                break;
+            defrag_one(rank[n], &budget);
+        }
+        free(rank);
+    }
+
+    /* Publish this run; tables dropped since the last run go away with it */
+    pthread_mutex_lock(&defrag_lk);
+    struct defrag_file *old = defrag_files;
+    defrag_files = head;
+    pthread_mutex_unlock(&defrag_lk);
+    free_defrag_list(old);
+
+    backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDWR);
+    pthread_mutex_lock(&defrag_lk);
+    defrag_running = 0;
+    pthread_mutex_unlock(&defrag_lk);
+    return NULL;
+}
+
+/* Kick off a defrag run, unless one is already going */
+void defrag_run(void)
+{
+    pthread_t t;
+
+    if (gbl_schema_change_in_progress || thedb->master != gbl_mynode)
+        return;
+
+    /* defrag_check() and "exec procedure sys.cmd.send('defrag')" race */
+    pthread_mutex_lock(&defrag_lk);
+    if (defrag_running) {
+        pthread_mutex_unlock(&defrag_lk);
+        return;
+    }
+    defrag_running = 1;
+    pthread_mutex_unlock(&defrag_lk);
+
+    if (pthread_create(&t, &gbl_pthread_attr_detached, defrag_thd, NULL)) {
+        logmsg(LOGMSG_ERROR, "%s: failed to start defrag thread\n",
+               __func__);
+        pthread_mutex_lock(&defrag_lk);
+        defrag_running = 0;
+        pthread_mutex_unlock(&defrag_lk);
+    }
+}
+
+/* Called once per second from the housekeeping thread */
+void defrag_check(void)
+{
+    static int last;
+    int now = comdb2_time_epoch();
+
+    if (gbl_defrag_interval <= 0)
+        return;
+    if (last == 0) {
+        /* don't walk everything the moment we come up */
+        last = now;
+        return;
+    }
+    if (now - last < gbl_defrag_interval)
+        return;
+    last = now;
+    defrag_run();
+}
+
+/* Snapshot of the last run for comdb2_defrag_stats */
+int defrag_stats(struct defrag_stat **stats, int *nstats)
+{
+    struct defrag_file *f;
+    int n = 0, i = 0;
+
+    pthread_mutex_lock(&defrag_lk);
+    for (f = defrag_files; f; f = f->next)
+        n++;
+
+    *stats = calloc(n ? n : 1, sizeof(struct defrag_stat));
+    if (*stats == NULL) {
+        pthread_mutex_unlock(&defrag_lk);
+        return -1;
+    }
+    for (f = defrag_files; f; f = f->next, i++) {
+        struct defrag_stat *s = &(*stats)[i];
+        s->tablename = strdup(f->tablename);
+        s->filename = strdup(f->filename);
+        s->status = (char *)f->status;
+        s->leaf_pages_before = f->before.nleaf;
+        s->fill_before = 100 * fill_ratio(&f->before);
+        s->leaf_pages_after = f->after.nleaf;
+        s->fill_after = f->defragged_at ? 100 * fill_ratio(&f->after) : 0;
+        s->merges = f->nmerged;
+        s->defragged_at = f->defragged_at;
+    }
+    pthread_mutex_unlock(&defrag_lk);
+    *nstats = n;
+    return 0;
+}
+
+void defrag_stats_free(struct defrag_stat *stats, int nstats)
+{
+    for (int i = 0; i < nstats; i++) {
+        free(stats[i].tablename);
+        free(stats[i].filename);
+    }
+    free(stats);
+}
@@ -95,10 +95,11 @@ int fdb_svc_cursor_open_sql(char *tid, char *cid, int code_release, int version,
 
 /**
  * Send back a streamed row with return code (marks also eos)
+ * If flush is not set, the row stays buffered until a later row is flushed
  *
  */
 int fdb_svc_sql_row(SBUF2 *sb, char *cid, char *row, int rowlen, int ret,
-                    int isuuid)
+                    int isuuid, int flush)
 {
     /* NOTE: we assume everything required is embedded in the sqlite row
        including genid and datacopy fields - as generated by select
@@ -113,11 +114,26 @@ int fdb_svc_sql_row(SBUF2 *sb, char *cid, char *row, int rowlen, int ret,
     }
 
     rc = fdb_bend_send_row(sb, NULL, cid, genid, row, rowlen, NULL, 0, ret,
-                           isuuid);
+                           isuuid, flush);
 
     return rc;
 }
 
+/**
+ * Flush the streamed rows still buffered for the remote requester; called
+ * while the local cursor is busy so rows already found don't wait on it
+ *
+ */
+void fdb_svc_sql_flush(struct sqlclntstate *clnt)
+{
+    if (!clnt->fdb_state.remote_sql_sb || !clnt->fdb_state.stream_unflushed)
+        return;
+
+    sbuf2flush(clnt->fdb_state.remote_sql_sb);
+    clnt->fdb_state.stream_unflushed = 0;
+    clnt->fdb_state.stream_flush_ms = comdb2_time_epochms();
+}
+
 /**
  * For requests where we want to avoid a dedicated genid lookup socket, this
  * masks every index as covered index
@@ -29,10 +29,18 @@ int fdb_appsock_work(const char *cid, struct sqlclntstate *clnt, int version,
 
 /**
  * Send back a streamed row with return code (marks also eos)
+ * If flush is not set, the row stays buffered until a later row is flushed
  *
  */
 int fdb_svc_sql_row(SBUF2 *sb, char *cid, char *row, int rowlen, int rc,
-                    int isuuid);
+                    int isuuid, int flush);
+
+/**
+ * Flush the streamed rows still buffered for the remote requester; called
+ * while the local cursor is busy so rows already found don't wait on it
+ *
+ */
+void fdb_svc_sql_flush(struct sqlclntstate *clnt);
 
 /**
  * For requests where we want to avoid a dedicated genid lookup socket, this
@@ -55,6 +55,7 @@
 
 extern int gbl_fdb_resolve_local;
 extern int gbl_fdb_allow_cross_classes;
+extern int gbl_fdb_table_cache_max_rows;
 
 extern int gbl_partial_indexes;
 extern int gbl_expressions_indexes;
@@ -109,6 +110,8 @@ struct fdb_tbl {
 
     int need_version; /* a remote op detected that local is stale, and this
                          hints to the new version */
+
+    fdb_tblcache_t *cache; /* local copy of the rows, if cached */
 };
 
 /* foreign db structure, caches the used tables for the remote db */
@@ -565,6 +568,7 @@ static void destroy_fdb(fdb_t *fdb)
  */
 void __fdb_free_table(fdb_t *fdb, fdb_tbl_t *tbl)
 {
+    fdb_tblcache_destroy(&tbl->cache);
     free(tbl->name);
     pthread_mutex_destroy(&tbl->ents_mtx);
     free(tbl);
@@ -2415,8 +2419,30 @@ done:
     return fdbc_if;
 }
 
+/* read-only table cursors can be served from a local copy of the table */
+static fdb_cursor_if_t *_fdb_cursor_open_cached(struct sqlclntstate *clnt,
+                                                fdb_t *fdb, fdb_tbl_ent_t *ent)
+{
+    fdb_tbl_t *tbl = ent->tbl;
+    fdb_cursor_if_t *fdbc_if;
+
+    pthread_mutex_lock(&tbl->ents_mtx);
+    if (!tbl->cache)
+        tbl->cache = fdb_tblcache_create();
+    pthread_mutex_unlock(&tbl->ents_mtx);
+    if (!tbl->cache)
+        return NULL;
+
+    fdbc_if = fdb_tblcache_cursor_open(clnt, fdb, ent, tbl->version, tbl->cache);
+    if (fdbc_if)
+        fdbc_if->access = fdb_cursor_access;
+
+    return fdbc_if;
+}
+
 /**
- * Create a connection to fdb, or a local sqlite_stat cache
+ * Create a connection to fdb, a local sqlite_stat cache, or a local copy
+ * of a small table
  *
  * NOTE: populates clnt->fdb_state error fields, if any error
  *
@@ -2500,6 +2526,10 @@ fdb_cursor_if_t *fdb_cursor_open(struct sqlclntstate *clnt, BtCursor *pCur,
 
             goto done;
         }
+    } else if (ent && ent->ixnum == -1 && !trans &&
+               gbl_fdb_table_cache_max_rows > 0 &&
+               (fdbc_if = _fdb_cursor_open_cached(clnt, fdb, ent)) != NULL) {
+        pCur->fdbc = fdbc_if;
     } else {
         /* NOTE: we expect x_remote to fill in the error, if any */
         pCur->fdbc = fdbc_if = _fdb_cursor_open_remote(
@@ -4170,6 +4200,7 @@ static int __free_fdb_tbl(void *obj, void *arg)
 
     /* free table itself */
     hash_del(fdb->h_tbls_name, tbl);
+    fdb_tblcache_destroy(&tbl->cache);
     free(tbl->name);
     pthread_mutex_destroy(&tbl->ents_mtx);
     free(tbl);
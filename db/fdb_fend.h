@@ -150,6 +150,10 @@ typedef struct fdb_sqlstat_cache fdb_sqlstat_cache_t;
 typedef struct fdb_sqlstat_table fdb_sqlstat_table_t;
 typedef struct fdb_sqlstat_cursor fdb_sqlstat_cursor_t;
 
+typedef struct fdb_tblcache fdb_tblcache_t;
+typedef struct fdb_tblcache_snap fdb_tblcache_snap_t;
+typedef struct fdb_tblcache_cursor fdb_tblcache_cursor_t;
+
 struct fdb_tran {
     char *tid; /* transaction id */
     char *
@@ -21,6 +21,7 @@
 #include <sql.h>
 #include <bdb_api.h>
 #include <util.h>
+#include <logmsg.h>
 
 #include "fdb_fend.h"
 #include "fdb_fend_cache.h"
@@ -631,3 +632,588 @@ static int fdb_sqlstat_cursor_update(BtCursor *pCur, struct sqlclntstate *clnt,
 {
     abort();
 }
+
+/**
+ * Local copies of small remote tables
+ *
+ * A snapshot holds all the rows of a remote table, sorted by genid; it is
+ * never changed once loaded, so any number of cursors can read it without
+ * locking.  A refresh builds a new snapshot and swaps it in; the old one is
+ * freed when its last cursor closes.  While one sql thread refreshes, the
+ * other ones keep reading the previous snapshot.
+ *
+ * Open cursors also hold the cache itself; when the table is dropped, the
+ * cache is freed by whoever is last, the table or a closing cursor.
+ *
+ */
+
+extern int gbl_fdb_table_cache_max_rows;
+extern int gbl_fdb_table_cache_ttl;
+
+struct fdb_tblcache_row {
+    unsigned long long genid;
+    int len;
+    char *data;
+};
+
+struct fdb_tblcache_snap {
+    unsigned long long version; /* remote table version when loaded */
+    int loaded;                 /* when it was loaded */
+    int nrows;
+    struct fdb_tblcache_row *rows; /* sorted by genid */
+    int users;                     /* cursors reading this snapshot */
+};
+
+struct fdb_tblcache {
+    pthread_mutex_t mtx;       /* protects everything below */
+    fdb_tblcache_snap_t *snap; /* current snapshot, if any */
+    int refreshing;            /* a sql thread is loading a snapshot */
+    int skipped;               /* when a load found too many rows */
+    int users;                 /* cursors open or opening on this cache */
+    int dropped;               /* table is gone, last user frees the cache */
+};
+
+struct fdb_tblcache_cursor {
+    fdb_cursor_if_t *intf; /* pointer to interface */
+    fdb_t *fdb;            /* which foreign db */
+    fdb_tbl_ent_t *ent;    /* which table */
+    fdb_tblcache_t *cache;
+    fdb_tblcache_snap_t *snap; /* snapshot read by this cursor */
+    int pos;                   /* current row */
+};
+
+static void fdb_tblcache_snap_free(fdb_tblcache_snap_t *snap)
+{
+    int i;
+
+    for (i = 0; i < snap->nrows; i++)
+        free(snap->rows[i].data);
+    free(snap->rows);
+    free(snap);
+}
+
+static int fdb_tblcache_row_cmp(const void *a, const void *b)
+{
+    const struct fdb_tblcache_row *ra = a;
+    const struct fdb_tblcache_row *rb = b;
+
+    if (ra->genid < rb->genid)
+        return -1;
+    return (ra->genid > rb->genid) ? 1 : 0;
+}
+
+/* read the whole remote table, giving up if it has more than max_rows */
+static fdb_tblcache_snap_t *fdb_tblcache_load(struct sqlclntstate *clnt,
+                                              fdb_t *fdb, fdb_tbl_ent_t *ent,
+                                              unsigned long long version,
+                                              int *too_big)
+{
+    const char *tblname = fdb_table_entry_tblname(ent);
+    fdb_tblcache_snap_t *snap;
+    fdb_cursor_if_t *fdbc_if;
+    BtCursor *cur;
+    char sql[MAXTABLELEN + 64];
+    int max_rows = gbl_fdb_table_cache_max_rows;
+    int nalloc = 0;
+    int rc;
+
+    *too_big = 0;
+
+    snap = calloc(1, sizeof(*snap));
+    if (!snap) {
+        logmsg(LOGMSG_ERROR, "%s: malloc\n", __func__);
+        return NULL;
+    }
+    snap->version = version;
+    snap->loaded = comdb2_time_epoch();
+
+    /* fake a BtCursor */
+    cur = calloc(1, sizeof(BtCursor) + sizeof(Btree));
+    if (!cur) {
+        logmsg(LOGMSG_ERROR, "%s: malloc\n", __func__);
+        fdb_tblcache_snap_free(snap);
+        return NULL;
+    }
+    init_cursor(cur, NULL, (Btree *)(cur + 1));
+    cur->bt->fdb = fdb;
+    cur->bt->is_remote = 1;
+
+    fdbc_if = fdb_cursor_open(clnt, cur, -1, NULL, NULL, 0);
+    if (!fdbc_if) {
+        logmsg(LOGMSG_ERROR, "%s: failed to connect remote to cache %s.%s\n",
+               __func__, fdb_dbname_name(fdb), tblname);
+        free(cur);
+        fdb_tblcache_snap_free(snap);
+        return NULL;
+    }
+
+    /* same query as a remote table scan, see _build_run_sql_from_hint */
+    snprintf(sql, sizeof(sql), "SELECT *, rowid FROM \"%s\" LIMIT %d", tblname,
+             max_rows + 1);
+    fdbc_if->set_sql(cur, sql);
+    fdb_cursor_use_table(fdbc_if->impl, fdb, tblname);
+
+    rc = fdbc_if->move(cur, CFIRST);
+    while (rc == IX_FND || rc == IX_FNDMORE) {
+        struct fdb_tblcache_row *row;
+
+        if (snap->nrows >= max_rows) {
+            *too_big = 1;
+            break;
+        }
+
+        /* the cap can be well above the actual size, grow as we go */
+        if (snap->nrows == nalloc) {
+            int n = nalloc ? 2 * nalloc : 64;
+            if (n > max_rows)
+                n = max_rows;
+            row = realloc(snap->rows, n * sizeof(struct fdb_tblcache_row));
+            if (!row) {
+                logmsg(LOGMSG_ERROR, "%s: malloc %d rows\n", __func__, n);
+                rc = -1;
+                break;
+            }
+            snap->rows = row;
+            nalloc = n;
+        }
+
+        row = &snap->rows[snap->nrows];
+        row->genid = fdbc_if->genid(cur);
+        row->len = fdbc_if->datalen(cur);
+        row->data = malloc(row->len);
+        if (!row->data) {
+            logmsg(LOGMSG_ERROR, "%s: malloc %d\n", __func__, row->len);
+            rc = -1;
+            break;
+        }
+        memcpy(row->data, fdbc_if->data(cur), row->len);
+        snap->nrows++;
+
+        if (rc == IX_FND)
+            break;
+        rc = fdbc_if->move(cur, CNEXT);
+    }
+
+    fdbc_if->set_sql(cur, NULL); /* not owner of sql hint */
+    if (fdbc_if->close(cur))
+        logmsg(LOGMSG_ERROR, "%s: failed to close cursor\n", __func__);
+    free(cur);
+
+    if (*too_big || (rc != IX_FND && rc != IX_EMPTY)) {
+        if (!*too_big)
+            logmsg(LOGMSG_ERROR, "%s: failed to read %s.%s rc=%d\n", __func__,
+                   fdb_dbname_name(fdb), tblname, rc);
+        fdb_tblcache_snap_free(snap);
+        return NULL;
+    }
+
+    qsort(snap->rows, snap->nrows, sizeof(struct fdb_tblcache_row),
+          fdb_tblcache_row_cmp);
+
+    return snap;
+}
+
+fdb_tblcache_t *fdb_tblcache_create(void)
+{
+    fdb_tblcache_t *cache;
+
+    cache = calloc(1, sizeof(*cache));
+    if (!cache) {
+        logmsg(LOGMSG_ERROR, "%s: malloc\n", __func__);
+        return NULL;
+    }
+    pthread_mutex_init(&cache->mtx, NULL);
+
+    return cache;
+}
+
+static void fdb_tblcache_free(fdb_tblcache_t *cache)
+{
+    pthread_mutex_destroy(&cache->mtx);
+    free(cache);
+}
+
+/* the table is going away; cursors still reading a snapshot keep it, and the
+   cache, until they close */
+void fdb_tblcache_destroy(fdb_tblcache_t **pcache)
+{
+    fdb_tblcache_t *cache = *pcache;
+    fdb_tblcache_snap_t *snap;
+    int unused;
+
+    if (!cache)
+        return;
+
+    pthread_mutex_lock(&cache->mtx);
+    cache->dropped = 1;
+    snap = cache->snap;
+    cache->snap = NULL;
+    if (snap && snap->users == 0)
+        fdb_tblcache_snap_free(snap);
+    unused = (cache->users == 0);
+    pthread_mutex_unlock(&cache->mtx);
+
+    if (unused)
+        fdb_tblcache_free(cache);
+
+    *pcache = NULL;
+}
+
+/* a cursor is done with the cache, and with snap if it got one */
+static void fdb_tblcache_release(fdb_tblcache_t *cache,
+                                 fdb_tblcache_snap_t *snap)
+{
+    int unused;
+
+    pthread_mutex_lock(&cache->mtx);
+    if (snap) {
+        snap->users--;
+        if (snap->users == 0 && snap != cache->snap)
+            fdb_tblcache_snap_free(snap);
+    }
+    cache->users--;
+    unused = (cache->dropped && cache->users == 0);
+    pthread_mutex_unlock(&cache->mtx);
+
+    if (unused)
+        fdb_tblcache_free(cache);
+}
+
+/* pick the snapshot to read, loading a new one if needed; returns it with
+   a user reference, or NULL if the table is read remotely; either way the
+   caller holds a reference on the cache, see fdb_tblcache_release */
+static fdb_tblcache_snap_t *fdb_tblcache_get(struct sqlclntstate *clnt,
+                                             fdb_t *fdb, fdb_tbl_ent_t *ent,
+                                             unsigned long long version,
+                                             fdb_tblcache_t *cache)
+{
+    fdb_tblcache_snap_t *snap;
+    fdb_tblcache_snap_t *old;
+    int now = comdb2_time_epoch();
+    int too_big;
+
+    pthread_mutex_lock(&cache->mtx);
+
+    cache->users++;
+
+    snap = cache->snap;
+    if (!cache->dropped && snap && snap->version == version &&
+        (now - snap->loaded < gbl_fdb_table_cache_ttl || cache->refreshing)) {
+        /* fresh, or being refreshed by someone else */
+        snap->users++;
+        pthread_mutex_unlock(&cache->mtx);
+        return snap;
+    }
+
+    if (cache->dropped || cache->refreshing ||
+        (cache->skipped && now - cache->skipped < gbl_fdb_table_cache_ttl)) {
+        pthread_mutex_unlock(&cache->mtx);
+        return NULL;
+    }
+    cache->refreshing = 1;
+
+    pthread_mutex_unlock(&cache->mtx);
+
+    snap = fdb_tblcache_load(clnt, fdb, ent, version, &too_big);
+
+    pthread_mutex_lock(&cache->mtx);
+
+    cache->refreshing = 0;
+    cache->skipped = too_big ? now : 0;
+    old = cache->snap;
+    if (cache->dropped) {
+        /* dropped while we were loading; this cursor reads the copy alone */
+    } else if (snap || too_big || (old && old->version != version)) {
+        /* the old copy is no longer good */
+        cache->snap = snap;
+        if (old && old->users == 0)
+            fdb_tblcache_snap_free(old);
+    }
+    if (snap)
+        snap->users++;
+
+    pthread_mutex_unlock(&cache->mtx);
+
+    return snap;
+}
+
+static char *fdb_tblcache_cursor_id(BtCursor *pCur)
+{
+    static uuid_t fake = {0};
+
+    return fake;
+}
+
+static struct fdb_tblcache_row *fdb_tblcache_cursor_row(BtCursor *pCur)
+{
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)pCur->fdbc->impl;
+
+    if (fdbc->pos < 0 || fdbc->pos >= fdbc->snap->nrows)
+        return NULL;
+    return &fdbc->snap->rows[fdbc->pos];
+}
+
+static char *fdb_tblcache_cursor_get_data(BtCursor *pCur)
+{
+    struct fdb_tblcache_row *row = fdb_tblcache_cursor_row(pCur);
+
+    return row ? row->data : NULL;
+}
+
+static int fdb_tblcache_cursor_get_datalen(BtCursor *pCur)
+{
+    struct fdb_tblcache_row *row = fdb_tblcache_cursor_row(pCur);
+
+    return row ? row->len : 0;
+}
+
+static unsigned long long fdb_tblcache_cursor_get_genid(BtCursor *pCur)
+{
+    struct fdb_tblcache_row *row = fdb_tblcache_cursor_row(pCur);
+
+    return row ? row->genid : -1ULL;
+}
+
+static void fdb_tblcache_cursor_get_found_data(BtCursor *pCur,
+                                               unsigned long long *genid,
+                                               int *datalen, char **data)
+{
+    struct fdb_tblcache_row *row = fdb_tblcache_cursor_row(pCur);
+
+    *genid = row ? row->genid : -1ULL;
+    *datalen = row ? row->len : 0;
+    *data = row ? row->data : NULL;
+}
+
+/* like a remote stream, IX_FND marks the last row in the direction of the
+   move */
+static int fdb_tblcache_cursor_move(BtCursor *pCur, int how)
+{
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)pCur->fdbc->impl;
+    int nrows = fdbc->snap->nrows;
+
+    if (nrows == 0)
+        return IX_EMPTY;
+
+    switch (how) {
+    case CFIRST:
+        fdbc->pos = 0;
+        break;
+    case CLAST:
+        fdbc->pos = nrows - 1;
+        break;
+    case CNEXT:
+        fdbc->pos++;
+        break;
+    case CPREV:
+        fdbc->pos--;
+        break;
+    }
+
+    if (fdbc->pos < 0 || fdbc->pos >= nrows)
+        return IX_PASTEOF;
+
+    if (how == CFIRST || how == CNEXT)
+        return (fdbc->pos == nrows - 1) ? IX_FND : IX_FNDMORE;
+    return (fdbc->pos == 0) ? IX_FND : IX_FNDMORE;
+}
+
+/* only table cursors are cached, so the key is a genid */
+static int fdb_tblcache_cursor_find(BtCursor *pCur, Mem *key, int nfields,
+                                    int bias)
+{
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)pCur->fdbc->impl;
+    unsigned long long genid = key->u.i;
+    int nrows = fdbc->snap->nrows;
+    int lo = 0;
+    int hi = nrows;
+
+    /* first row with genid >= key */
+    while (lo < hi) {
+        int mid = lo + (hi - lo) / 2;
+        if (fdbc->snap->rows[mid].genid < genid)
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+
+    switch (bias) {
+    case OP_SeekGT:
+        if (lo < nrows && fdbc->snap->rows[lo].genid == genid)
+            lo++;
+        /* fall through */
+    case OP_SeekGE:
+        if (lo >= nrows)
+            return IX_EMPTY;
+        fdbc->pos = lo;
+        return (lo == nrows - 1) ? IX_FND : IX_FNDMORE;
+    case OP_SeekLE:
+        if (lo < nrows && fdbc->snap->rows[lo].genid == genid)
+            lo++;
+        /* fall through */
+    case OP_SeekLT:
+        if (lo == 0)
+            return IX_EMPTY;
+        fdbc->pos = lo - 1;
+        return (lo == 1) ? IX_FND : IX_FNDMORE;
+    default:
+        if (lo >= nrows || fdbc->snap->rows[lo].genid != genid)
+            return IX_EMPTY;
+        fdbc->pos = lo;
+        return IX_FND;
+    }
+}
+
+static int fdb_tblcache_cursor_find_last(BtCursor *pCur, Mem *key,
+                                         int nfields, int bias)
+{
+    /* genids are unique */
+    return fdb_tblcache_cursor_find(pCur, key, nfields, bias);
+}
+
+/* hints are only filters; sqlite checks the rows anyway */
+static int fdb_tblcache_cursor_set_hint(BtCursor *pCur, void *hint)
+{
+    return 0;
+}
+
+static void *fdb_tblcache_cursor_get_hint(BtCursor *pCur) { return NULL; }
+
+/* there is no remote side to run sql */
+static int fdb_tblcache_cursor_set_sql(BtCursor *pCur, const char *sql)
+{
+    return -1;
+}
+
+static char *fdb_tblcache_cursor_name(BtCursor *pCur)
+{
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)pCur->fdbc->impl;
+
+    return (char *)fdb_table_entry_tblname(fdbc->ent);
+}
+
+static int fdb_tblcache_cursor_has_partidx(BtCursor *pCur) { return 0; }
+
+static int fdb_tblcache_cursor_has_expridx(BtCursor *pCur) { return 0; }
+
+static char *fdb_tblcache_cursor_dbname(BtCursor *pCur)
+{
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)pCur->fdbc->impl;
+
+    return (char *)fdb_dbname_name(fdbc->fdb);
+}
+
+static fdb_tbl_ent_t *fdb_tblcache_cursor_table_entry(BtCursor *pCur)
+{
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)pCur->fdbc->impl;
+
+    return fdbc->ent;
+}
+
+/* fdb_cursor_open replaces this with the remote table access check */
+static int fdb_tblcache_cursor_access(BtCursor *pCur, int how) { return 0; }
+
+static int fdb_tblcache_cursor_isuuid(BtCursor *pCur) { return 1; }
+
+static int fdb_tblcache_cursor_insert(BtCursor *pCur,
+                                      struct sqlclntstate *clnt,
+                                      fdb_tran_t *trans,
+                                      unsigned long long genid, int datalen,
+                                      char *data)
+{
+    abort(); /* cached cursors are only opened for reads */
+}
+
+static int fdb_tblcache_cursor_delete(BtCursor *pCur,
+                                      struct sqlclntstate *clnt,
+                                      fdb_tran_t *trans,
+                                      unsigned long long genid)
+{
+    abort();
+}
+
+static int fdb_tblcache_cursor_update(BtCursor *pCur,
+                                      struct sqlclntstate *clnt,
+                                      fdb_tran_t *trans,
+                                      unsigned long long oldgenid,
+                                      unsigned long long genid, int datalen,
+                                      char *data)
+{
+    abort();
+}
+
+static int fdb_tblcache_cursor_close(BtCursor *pCur)
+{
+    fdb_cursor_if_t *fdbc_if = pCur->fdbc;
+    fdb_tblcache_cursor_t *fdbc = (fdb_tblcache_cursor_t *)fdbc_if->impl;
+
+    fdb_tblcache_release(fdbc->cache, fdbc->snap);
+
+    free(fdbc_if);
+
+    return 0;
+}
+
+/**
+ * Open a cursor on the local copy of a remote table
+ *
+ */
+fdb_cursor_if_t *fdb_tblcache_cursor_open(struct sqlclntstate *clnt,
+                                          fdb_t *fdb, fdb_tbl_ent_t *ent,
+                                          unsigned long long version,
+                                          fdb_tblcache_t *cache)
+{
+    fdb_tblcache_cursor_t *fdbc;
+    fdb_cursor_if_t *fdbc_if;
+    fdb_tblcache_snap_t *snap;
+
+    snap = fdb_tblcache_get(clnt, fdb, ent, version, cache);
+    if (!snap) {
+        fdb_tblcache_release(cache, NULL);
+        return NULL;
+    }
+
+    int len = sizeof(fdb_cursor_if_t) + sizeof(fdb_tblcache_cursor_t);
+    fdbc_if = (fdb_cursor_if_t *)calloc(1, len);
+    if (!fdbc_if) {
+        fdb_tblcache_release(cache, snap);
+        return NULL;
+    }
+
+    fdbc_if->impl = (fdb_cursor_t *)((char *)fdbc_if + sizeof(fdb_cursor_if_t));
+    fdbc = (fdb_tblcache_cursor_t *)fdbc_if->impl;
+
+    fdbc->intf = fdbc_if;
+    fdbc->fdb = fdb;
+    fdbc->ent = ent;
+    fdbc->cache = cache;
+    fdbc->snap = snap;
+    fdbc->pos = -1;
+
+    fdbc_if->close = fdb_tblcache_cursor_close;
+    fdbc_if->id = fdb_tblcache_cursor_id;
+    fdbc_if->data = fdb_tblcache_cursor_get_data;
+    fdbc_if->datalen = fdb_tblcache_cursor_get_datalen;
+    fdbc_if->genid = fdb_tblcache_cursor_get_genid;
+    fdbc_if->get_found_data = fdb_tblcache_cursor_get_found_data;
+    fdbc_if->set_hint = fdb_tblcache_cursor_set_hint;
+    fdbc_if->get_hint = fdb_tblcache_cursor_get_hint;
+    fdbc_if->set_sql = fdb_tblcache_cursor_set_sql;
+    fdbc_if->name = fdb_tblcache_cursor_name;
+    fdbc_if->tblname = fdb_tblcache_cursor_name;
+    fdbc_if->tbl_has_partidx = fdb_tblcache_cursor_has_partidx;
+    fdbc_if->tbl_has_expridx = fdb_tblcache_cursor_has_expridx;
+    fdbc_if->dbname = fdb_tblcache_cursor_dbname;
+    fdbc_if->table_entry = fdb_tblcache_cursor_table_entry;
+    fdbc_if->access = fdb_tblcache_cursor_access;
+    fdbc_if->move = fdb_tblcache_cursor_move;
+    fdbc_if->find = fdb_tblcache_cursor_find;
+    fdbc_if->find_last = fdb_tblcache_cursor_find_last;
+
+    fdbc_if->insert = fdb_tblcache_cursor_insert;
+    fdbc_if->delete = fdb_tblcache_cursor_delete;
+    fdbc_if->update = fdb_tblcache_cursor_update;
+    fdbc_if->isuuid = fdb_tblcache_cursor_isuuid;
+
+    return fdbc_if;
+}
@@ -42,4 +42,24 @@ int fdb_sqlstat_cache_create(struct sqlclntstate *clnt, fdb_t *fdb,
  */
 void fdb_sqlstat_cache_destroy(fdb_sqlstat_cache_t **pcache);
 
+/**
+ * Local copies of small remote tables, see foreign_db_table_cache_max_rows
+ *
+ */
+
+/* create an empty table cache; it is loaded by the first cursor open */
+fdb_tblcache_t *fdb_tblcache_create(void);
+
+/* destroy a table cache; there are no open cursors on it */
+void fdb_tblcache_destroy(fdb_tblcache_t **pcache);
+
+/*
+   open a cursor on the local copy of the table "ent", loading or refreshing
+   the copy if it is stale; returns NULL if the table should be read remotely
+ */
+fdb_cursor_if_t *fdb_tblcache_cursor_open(struct sqlclntstate *clnt,
+                                          fdb_t *fdb, fdb_tbl_ent_t *ent,
+                                          unsigned long long version,
+                                          fdb_tblcache_t *cache);
+
 #endif
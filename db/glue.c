@@ -748,6 +748,10 @@ static int trans_commit_int(struct ireq *iq, void *trans, char *source_host,
     if (rc != 0)
         return rc;
 
+    /* the sql thread hands this to its client to read its writes elsewhere */
+    bdb_get_seqnum_lsn((seqnum_type *)&ss, &iq->sorese.commit_file,
+                       &iq->sorese.commit_offset);
+
     rc = trans_wait_for_seqnum_int(bdb_handle, dbenv, iq, source_host,
                                    timeoutms, adaptive, &ss);
     return rc;
@@ -897,8 +901,11 @@ int ix_addk_auxdb(int auxdb, struct ireq *iq, void *trans, void *key, int ixnum,
                                dtalen, 0 /* XXX TODO, are there null values? */,
                                &bdberr);
     iq->gluewhere = "bdb_prim_addkey done";
-    if (rc == 0)
+    if (rc == 0) {
+        if (!auxdb && gbl_incremental_stats)
+            incr_stats_addkey(iq, db, ixnum, key);
         return 0;
+    }
 
     /*translate engine rcodes */
     switch (bdberr) {
@@ -982,8 +989,11 @@ int ix_delk_auxdb(int auxdb, struct ireq *iq, void *trans, void *key, int ixnum,
     rc = bdb_prim_delkey_genid(bdb_handle, trans, key, ixnum, rrn, genid,
                                &bdberr);
     iq->gluewhere = "bdb_prim_delkey done";
-    if (rc == 0)
+    if (rc == 0) {
+        if (!auxdb && gbl_incremental_stats)
+            incr_stats_delkey(iq, db, ixnum);
         return 0;
+    }
     /*translate engine rcodes */
     switch (bdberr) {
     case BDBERR_DEADLOCK:
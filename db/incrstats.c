@@ -0,0 +1,646 @@
+/*
+   Copyright 2018 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+ * Incremental index statistics.
+ *
+ * The master keeps, for every index, a HyperLogLog sketch of each leading
+ * key prefix and counts of the keys added and removed.  ix_addk()/ix_delk()
+ * hash the keys into the transaction, and the sketches and counts take them
+ * when it commits, so they cost a hash and a byte compare per key.
+ *
+ * Every incremental_stats_interval seconds the sketches of the indexes that
+ * changed enough are folded into the sqlite_stat1 row that was current when
+ * tracking started (the "baseline"), and the result is written back the same
+ * way analyze writes it, which makes every node reload its stats.
+ *
+ * The new keys are assumed not to repeat the baseline's keys; that is right
+ * for the ever-growing keys (ids, timestamps) that make plans drift, and
+ * full analyze, which resets the baseline, corrects it for everything else.
+ */
+
+#include <stdio.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include <comdb2.h>
+#include <util.h>
+#include <sql.h>
+#include <analyze.h>
+#include <bdb_api.h>
+#include <ctrace.h>
+#include <autoanalyze.h>
+#include <sqlstat1.h>
+#include <thread_malloc.h>
+#include <comdb2_atomic.h>
+#include <logmsg.h>
+
+int gbl_incremental_stats = 0;
+int gbl_incremental_stats_min_ops = 1000;
+int gbl_incremental_stats_interval = 60;
+
+/* 2^10 one byte registers per sketch, ~3% standard error */
+#define INCR_HLL_BITS 10
+#define INCR_HLL_REGS (1 << INCR_HLL_BITS)
+/* sketch at most this many leading columns of an index */
+#define INCR_MAX_COLS 8
+
+struct incr_ixstats {
+    int ncols;                        /* prefixes sketched */
+    unsigned int plen[INCR_MAX_COLS]; /* byte length of each prefix */
+    unsigned int nadds;               /* keys added since baseline */
+    unsigned int ndels;               /* keys removed since baseline */
+    unsigned int pubops;              /* nadds + ndels at last publish */
+
+    /* sqlite_stat1 row when tracking started; nbase == 0 means none yet */
+    int nbase;
+    double base[INCR_MAX_COLS + 1]; /* nrows, then avg rows per prefix */
+    char *basetail;                 /* tokens we don't maintain */
+
+    uint8_t regs[INCR_MAX_COLS][INCR_HLL_REGS];
+};
+
+struct incr_stats {
+    pthread_mutex_t lk; /* baseline and publishing */
+    int nix;
+    struct incr_ixstats *ix;
+    int lastpub;
+};
+
+static pthread_mutex_t incr_stats_lk = PTHREAD_MUTEX_INITIALIZER;
+static int incr_stats_running = 0;
+
+static inline uint64_t incr_hash_final(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    h ^= h >> 33;
+    return h;
+}
+
+static void incr_hll_add(uint8_t *regs, uint64_t h)
+{
+    unsigned int j = h >> (64 - INCR_HLL_BITS);
+    uint64_t w = h << INCR_HLL_BITS;
+    uint8_t rho = w ? __builtin_clzll(w) + 1 : 64 - INCR_HLL_BITS + 1;
+
+    /* a racing writer may lose an update; sketches are estimates anyway */
+    if (regs[j] < rho)
+        regs[j] = rho;
+}
+
+static double incr_hll_count(const uint8_t *regs)
+{
+    double m = INCR_HLL_REGS;
+    double sum = 0;
+    int zeros = 0;
+
+    for (int i = 0; i < INCR_HLL_REGS; i++) {
+        sum += ldexp(1.0, -regs[i]);
+        if (regs[i] == 0)
+            zeros++;
+    }
+
+    double est = (0.7213 / (1 + 1.079 / m)) * m * m / sum;
+    if (est <= 2.5 * m && zeros)
+        est = m * log(m / zeros);
+    return est;
+}
+
+static struct incr_stats *incr_stats_create(struct dbtable *tbl)
+{
+    struct incr_stats *is = calloc(1, sizeof(struct incr_stats));
+    if (!is)
+        return NULL;
+    is->ix = calloc(tbl->nix, sizeof(struct incr_ixstats));
+    if (!is->ix) {
+        free(is);
+        return NULL;
+    }
+    pthread_mutex_init(&is->lk, NULL);
+    is->nix = tbl->nix;
+    is->lastpub = comdb2_time_epoch();
+
+    for (int i = 0; i < tbl->nix; i++) {
+        struct schema *s = tbl->ixschema[i];
+        struct incr_ixstats *ix = &is->ix[i];
+        for (int c = 0; c < s->nmembers && c < INCR_MAX_COLS; c++) {
+            ix->plen[c] = s->member[c].offset + s->member[c].len;
+            ix->ncols++;
+        }
+    }
+    return is;
+}
+
+void incr_stats_free(struct dbtable *tbl)
+{
+    struct incr_stats *is = tbl->incr_stats;
+    if (!is)
+        return;
+    tbl->incr_stats = NULL;
+    for (int i = 0; i < is->nix; i++)
+        free(is->ix[i].basetail);
+    pthread_mutex_destroy(&is->lk);
+    free(is->ix);
+    free(is);
+}
+
+static struct incr_stats *incr_stats_get(struct dbtable *tbl)
+{
+    struct incr_stats *is = tbl->incr_stats;
+    if (is)
+        return is;
+    if (tbl->nix == 0 || is_sqlite_stat(tbl->tablename))
+        return NULL;
+
+    pthread_mutex_lock(&incr_stats_lk);
+    if (!tbl->incr_stats)
+        tbl->incr_stats = incr_stats_create(tbl);
+    is = tbl->incr_stats;
+    pthread_mutex_unlock(&incr_stats_lk);
+    return is;
+}
+
+/* key hashes a transaction buffers before it feeds the sketches directly */
+#define INCR_MAX_TRANS_KEYS (1 << 16)
+
+/* Count a key against the transaction; the counts reach the table only when
+ * it commits (incr_stats_commit), so aborted and retried transactions don't
+ * inflate them.  Keys of indexes past the ones we can track per transaction
+ * are counted right away.  Returns the transaction's slot for the index, or
+ * NULL. */
+static struct incr_stats_hit *incr_stats_count(struct ireq *iq,
+                                               struct incr_stats *is,
+                                               struct dbtable *tbl, int ixnum,
+                                               int add)
+{
+    struct incr_stats_hit *hit = NULL;
+
+    for (unsigned i = 0; i < iq->num_incr_stats_hits; i++) {
+        if (iq->incr_stats_hits[i].db == tbl &&
+            iq->incr_stats_hits[i].ixnum == ixnum) {
+            hit = &iq->incr_stats_hits[i];
+            break;
+        }
+    }
+    if (!hit && iq->num_incr_stats_hits < MAX_INCR_STATS_HITS_PER_TRANS) {
+        hit = &iq->incr_stats_hits[iq->num_incr_stats_hits++];
+        hit->db = tbl;
+        hit->ixnum = ixnum;
+        hit->nadds = hit->ndels = 0;
+    }
+
+    if (hit) {
+        if (add)
+            hit->nadds++;
+        else
+            hit->ndels++;
+    } else if (add) {
+        ATOMIC_ADD(is->ix[ixnum].nadds, 1);
+    } else {
+        ATOMIC_ADD(is->ix[ixnum].ndels, 1);
+    }
+    return hit;
+}
+
+/* Hold a key prefix hash until the transaction commits.  Returns 0 if the
+ * caller should add it to the sketch now. */
+static int incr_stats_buffer(struct ireq *iq, struct incr_stats_hit *hit,
+                             int col, uint64_t h)
+{
+    if (!hit)
+        return 0;
+    if (iq->num_incr_stats_keys == iq->max_incr_stats_keys) {
+        unsigned max = iq->max_incr_stats_keys ? iq->max_incr_stats_keys * 2
+                                               : 64;
+        struct incr_stats_key *keys;
+        if (max > INCR_MAX_TRANS_KEYS)
+            return 0;
+        keys = realloc(iq->incr_stats_keys, max * sizeof(*keys));
+        if (!keys)
+            return 0;
+        iq->incr_stats_keys = keys;
+        iq->max_incr_stats_keys = max;
+    }
+    struct incr_stats_key *k = &iq->incr_stats_keys[iq->num_incr_stats_keys++];
+    k->hash = h;
+    k->hit = hit - iq->incr_stats_hits;
+    k->col = col;
+    return 1;
+}
+
+void incr_stats_addkey(struct ireq *iq, struct dbtable *tbl, int ixnum,
+                       const void *key)
+{
+    struct incr_stats *is = incr_stats_get(tbl);
+    if (!is || ixnum >= is->nix)
+        return;
+
+    struct incr_stats_hit *hit = incr_stats_count(iq, is, tbl, ixnum, 1);
+
+    /* only block transactions commit their counts; keys added outside
+       them (schema change rebuilds) are covered by the next analyze */
+    if (!iq->incr_stats_tracked)
+        return;
+
+    struct incr_ixstats *ix = &is->ix[ixnum];
+    const uint8_t *p = key;
+    uint64_t h = 0xcbf29ce484222325ULL; /* fnv-1a, one pass for all prefixes */
+    unsigned int off = 0;
+
+    /* the hashes wait for the commit like the counts; past what we buffer,
+       a large transaction feeds the sketches as it goes */
+    for (int c = 0; c < ix->ncols; c++) {
+        for (; off < ix->plen[c]; off++) {
+            h ^= p[off];
+            h *= 0x100000001b3ULL;
+        }
+        uint64_t fh = incr_hash_final(h);
+        if (!incr_stats_buffer(iq, hit, c, fh))
+            incr_hll_add(ix->regs[c], fh);
+    }
+}
+
+void incr_stats_delkey(struct ireq *iq, struct dbtable *tbl, int ixnum)
+{
+    struct incr_stats *is = tbl->incr_stats;
+    if (!is || ixnum >= is->nix)
+        return;
+    incr_stats_count(iq, is, tbl, ixnum, 0);
+}
+
+/* A block transaction (re)starts; forget what an earlier attempt did. */
+void incr_stats_begin(struct ireq *iq)
+{
+    iq->num_incr_stats_hits = 0;
+    iq->num_incr_stats_keys = 0;
+    iq->incr_stats_tracked = 1;
+}
+
+/* The transaction didn't commit; drop its counts and hashes. */
+void incr_stats_abort(struct ireq *iq)
+{
+    free(iq->incr_stats_keys);
+    iq->incr_stats_keys = NULL;
+    iq->num_incr_stats_keys = iq->max_incr_stats_keys = 0;
+    iq->num_incr_stats_hits = 0;
+    iq->incr_stats_tracked = 0;
+}
+
+/* The transaction committed; add its key counts and hashes to the tables. */
+void incr_stats_commit(struct ireq *iq)
+{
+    for (unsigned i = 0; i < iq->num_incr_stats_hits; i++) {
+        struct incr_stats_hit *hit = &iq->incr_stats_hits[i];
+        struct incr_stats *is = hit->db->incr_stats;
+        if (!is || hit->ixnum >= is->nix)
+            continue;
+        if (hit->nadds)
+            ATOMIC_ADD(is->ix[hit->ixnum].nadds, hit->nadds);
+        if (hit->ndels)
+            ATOMIC_ADD(is->ix[hit->ixnum].ndels, hit->ndels);
+    }
+    for (unsigned i = 0; i < iq->num_incr_stats_keys; i++) {
+        struct incr_stats_key *k = &iq->incr_stats_keys[i];
+        struct incr_stats_hit *hit = &iq->incr_stats_hits[k->hit];
+        struct incr_stats *is = hit->db->incr_stats;
+        if (!is || hit->ixnum >= is->nix || k->col >= is->ix[hit->ixnum].ncols)
+            continue;
+        incr_hll_add(is->ix[hit->ixnum].regs[k->col], k->hash);
+    }
+    incr_stats_abort(iq);
+}
+
+/* Full analyze produced a new sqlite_stat1; start over from it. */
+void incr_stats_reset(struct dbtable *tbl)
+{
+    struct incr_stats *is = tbl->incr_stats;
+    if (!is)
+        return;
+
+    pthread_mutex_lock(&is->lk);
+    for (int i = 0; i < is->nix; i++) {
+        struct incr_ixstats *ix = &is->ix[i];
+        memset(ix->regs, 0, sizeof(ix->regs));
+        ix->nadds = ix->ndels = ix->pubops = 0;
+        ix->nbase = 0;
+        free(ix->basetail);
+        ix->basetail = NULL;
+    }
+    is->lastpub = comdb2_time_epoch();
+    pthread_mutex_unlock(&is->lk);
+}
+
+/* Read the sqlite_stat1 'stat' string for an index; caller frees. */
+static char *incr_read_stat1(struct dbtable *tbl, char *ixname)
+{
+    struct ireq iq;
+    tran_type *trans = NULL;
+    char *rec = NULL;
+    char *stat = NULL;
+    unsigned long long genid;
+
+    init_fake_ireq(thedb, &iq);
+    iq.usedb = get_dbtable_by_name("sqlite_stat1");
+    if (!iq.usedb)
+        return NULL;
+
+    if (trans_start(&iq, NULL, &trans))
+        return NULL;
+    if (stat1_ondisk_record(&iq, tbl->tablename, ixname, NULL,
+                            (void **)&rec) == 0 &&
+        sqlstat_find_get_record(&iq, trans, rec, &genid) == IX_FND)
+        stat = get_field_from_sqlite_stat_rec(&iq, rec, "stat");
+    trans_abort(&iq, trans);
+    free(rec);
+    return stat;
+}
+
+/* Split "nrows a1 a2 ... [sz=N] [unordered]" into the baseline. */
+static int incr_set_baseline(struct incr_ixstats *ix, char *stat)
+{
+    char *tok, *lasts = NULL;
+    char tail[256] = {0};
+    int n = 0;
+
+    for (tok = strtok_r(stat, " ", &lasts); tok;
+         tok = strtok_r(NULL, " ", &lasts)) {
+        char *end;
+        double v = strtod(tok, &end);
+        if (*end == '\0' && n <= ix->ncols && !tail[0]) {
+            ix->base[n++] = v;
+        } else {
+            if (tail[0])
+                strncat(tail, " ", sizeof(tail) - strlen(tail) - 1);
+            strncat(tail, tok, sizeof(tail) - strlen(tail) - 1);
+        }
+    }
+    if (n < 2 || ix->base[0] < 1)
+        return -1;
+    ix->nbase = n;
+    ix->basetail = tail[0] ? strdup(tail) : NULL;
+    return 0;
+}
+
+/* Fold the sketches into the baseline and format a sqlite_stat1 string. */
+static void incr_format_stat1(struct incr_ixstats *ix, unsigned int nadds,
+                              unsigned int ndels, char *out, size_t outlen)
+{
+    double grown = ix->base[0] + nadds;
+    double nrows = grown - ndels;
+    long long prev;
+    int len;
+
+    if (nrows < 1)
+        nrows = 1;
+    len = snprintf(out, outlen, "%lld", (long long)nrows);
+    prev = (long long)nrows;
+
+    for (int c = 1; c < ix->nbase; c++) {
+        long long avg;
+        if (c <= ix->ncols) {
+            double base = ix->base[c] >= 1 ? ix->base[c] : 1;
+            double distinct = ix->base[0] / base;
+            if (nadds)
+                distinct += incr_hll_count(ix->regs[c - 1]);
+            /* deletes thin out the prefixes in proportion */
+            distinct *= nrows / grown;
+            avg = (long long)(nrows / distinct + 0.5);
+        } else {
+            avg = (long long)ix->base[c];
+        }
+        if (avg < 1)
+            avg = 1;
+        if (avg > prev)
+            avg = prev;
+        prev = avg;
+        len += snprintf(out + len, outlen - len, " %lld", avg);
+    }
+    if (ix->basetail)
+        snprintf(out + len, outlen - len, " %s", ix->basetail);
+}
+
+struct incr_pub {
+    int ixnum;
+    unsigned int ops; /* nadds + ndels published */
+    char *sql;
+};
+
+/* Build the sqlite_stat1 updates for the indexes of a table that changed
+ * enough; the caller holds the schema lock.  Returns how many. */
+static int incr_prepare_table(struct dbtable *tbl, struct incr_pub *pub)
+{
+    struct incr_stats *is = tbl->incr_stats;
+    char sql[512];
+    char stat[256];
+    int npub = 0;
+
+    pthread_mutex_lock(&is->lk);
+    for (int i = 0; i < is->nix && i < tbl->nix; i++) {
+        struct incr_ixstats *ix = &is->ix[i];
+        unsigned int nadds = ix->nadds;
+        unsigned int ndels = ix->ndels;
+        char *ixname = tbl->ixschema[i]->sqlitetag;
+
+        if (nadds + ndels - ix->pubops < gbl_incremental_stats_min_ops)
+            continue;
+
+        if (ix->nbase == 0) {
+            char *cur = incr_read_stat1(tbl, ixname);
+            int rc = cur ? incr_set_baseline(ix, cur) : -1;
+            free(cur);
+            if (rc) {
+                /* nothing to build on until a full analyze runs */
+                continue;
+            }
+        }
+
+        incr_format_stat1(ix, nadds, ndels, stat, sizeof(stat));
+        snprintf(sql, sizeof(sql),
+                 "update sqlite_stat1 set stat='%s' where tbl='%s' and "
+                 "idx='%s'",
+                 stat, tbl->tablename, ixname);
+        pub[npub].sql = strdup(sql);
+        if (!pub[npub].sql)
+            break;
+        pub[npub].ixnum = i;
+        pub[npub].ops = nadds + ndels;
+        npub++;
+        ctrace("INCRSTATS: Table %s index %s stat '%s' (%u adds, %u dels)\n",
+               tbl->tablename, ixname, stat, nadds, ndels);
+    }
+    is->lastpub = comdb2_time_epoch();
+    pthread_mutex_unlock(&is->lk);
+
+    return npub;
+}
+
+/* Write the updates in one transaction; like analyze, this runs sql, so no
+ * schema lock is held, and the table is looked up again to record what was
+ * published. */
+static int incr_publish_table(const char *tablename, struct incr_pub *pub,
+                              int npub, struct sqlclntstate *clnt)
+{
+    struct dbtable *tbl;
+    int rc;
+
+    rc = run_internal_sql_clnt(clnt, "BEGIN");
+    for (int i = 0; rc == 0 && i < npub; i++)
+        rc = run_internal_sql_clnt(clnt, pub[i].sql);
+    if (rc)
+        run_internal_sql_clnt(clnt, "ROLLBACK");
+    else
+        rc = run_internal_sql_clnt(clnt, "COMMIT");
+
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "%s: publishing %s failed rc %d\n", __func__,
+               tablename, rc);
+        return rc;
+    }
+
+    rdlock_schema_lk();
+    tbl = get_dbtable_by_name(tablename);
+    if (tbl && tbl->incr_stats) {
+        struct incr_stats *is = tbl->incr_stats;
+        pthread_mutex_lock(&is->lk);
+        for (int i = 0; i < npub; i++)
+            if (pub[i].ixnum < is->nix)
+                is->ix[pub[i].ixnum].pubops = pub[i].ops;
+        pthread_mutex_unlock(&is->lk);
+    }
+    unlock_schema_lk();
+
+    return 0;
+}
+
+/* Publish the tables that are due; runs detached from the autoanalyze
+ * poller, one instance at a time. */
+void *incr_stats_main(void *unused)
+{
+    pthread_mutex_lock(&incr_stats_lk);
+    if (incr_stats_running) {
+        pthread_mutex_unlock(&incr_stats_lk);
+        return NULL;
+    }
+    incr_stats_running = 1;
+    pthread_mutex_unlock(&incr_stats_lk);
+
+    rdlock_schema_lk();
+    int have_stat1 = get_dbtable_by_name("sqlite_stat1") != NULL;
+    unlock_schema_lk();
+    if (!have_stat1)
+        goto out;
+
+    thrman_register(THRTYPE_ANALYZE);
+    backend_thread_event(thedb, COMDB2_THR_EVENT_START_RDWR);
+    sql_mem_init(NULL);
+    thread_memcreate(1048576);
+
+    SBUF2 *sb = sbuf2open(fileno(stdout), 0);
+    struct sqlclntstate clnt;
+    start_internal_sql_clnt(&clnt);
+    clnt.osql_max_trans = 0;
+    clnt.sb = sb;
+    sbuf2settimeout(clnt.sb, 0, 0);
+    clnt.is_analyze = 1; /* make every node reload the stats on commit */
+
+    int now = comdb2_time_epoch();
+    int ndue = 0;
+    char **due = NULL;
+
+    /* like analyze, don't hold the schema lock while running sql */
+    rdlock_schema_lk();
+    due = calloc(thedb->num_dbs, sizeof(char *));
+    for (int i = 0; due && i < thedb->num_dbs; i++) {
+        struct incr_stats *is = thedb->dbs[i]->incr_stats;
+        if (is && now - is->lastpub >= gbl_incremental_stats_interval)
+            due[ndue++] = strdup(thedb->dbs[i]->tablename);
+    }
+    unlock_schema_lk();
+
+    for (int i = 0; i < ndue; i++) {
+        struct dbtable *tbl;
+        struct incr_pub *pub = NULL;
+        int npub = 0;
+
+        if (thedb->master == gbl_mynode && !gbl_schema_change_in_progress &&
+            !analyze_is_running()) {
+            rdlock_schema_lk();
+            tbl = get_dbtable_by_name(due[i]);
+            if (tbl && tbl->incr_stats &&
+                (pub = calloc(tbl->nix, sizeof(struct incr_pub))) != NULL)
+                npub = incr_prepare_table(tbl, pub);
+            unlock_schema_lk();
+        }
+
+        if (npub)
+            incr_publish_table(due[i], pub, npub, &clnt);
+
+        for (int j = 0; j < npub; j++)
+            free(pub[j].sql);
+        free(pub);
+        free(due[i]);
+    }
+    free(due);
+
+    clnt.is_analyze = 0;
+    end_internal_sql_clnt(&clnt);
+    sbuf2flush(sb);
+    sbuf2free(sb);
+
+    thread_memdestroy();
+    sql_mem_shutdown(NULL);
+    backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDWR);
+out:
+    pthread_mutex_lock(&incr_stats_lk);
+    incr_stats_running = 0;
+    pthread_mutex_unlock(&incr_stats_lk);
+    return NULL;
+}
+
+void stat_incr_stats(void)
+{
+    logmsg(LOGMSG_USER, "INCREMENTAL STATS: %s\n",
+           YESNO(gbl_incremental_stats));
+
+    for (int i = 0; i < thedb->num_dbs; i++) {
+        struct dbtable *tbl = thedb->dbs[i];
+        struct incr_stats *is = tbl->incr_stats;
+        if (!is)
+            continue;
+        for (int j = 0; j < is->nix && j < tbl->nix; j++) {
+            struct incr_ixstats *ix = &is->ix[j];
+            char stat[256] = "<no baseline>";
+            pthread_mutex_lock(&is->lk);
+            if (ix->nbase)
+                incr_format_stat1(ix, ix->nadds, ix->ndels, stat,
+                                  sizeof(stat));
+            pthread_mutex_unlock(&is->lk);
+            logmsg(LOGMSG_USER,
+                   "Table %s index %s adds %u dels %u distinct(ix) %.0f "
+                   "stat1 '%s'\n",
+                   tbl->tablename, tbl->ixschema[j]->sqlitetag, ix->nadds,
+                   ix->ndels,
+                   ix->ncols ? incr_hll_count(ix->regs[ix->ncols - 1]) : 0.0,
+                   stat);
+        }
+    }
+}
@@ -70,6 +70,7 @@
 
 int g_osql_blocksql_parallel_max = 5;
 extern int gbl_blocksql_grace;
+extern int gbl_osqlpf_readahead;
 
 typedef struct blocksql_info {
     osql_sess_t *sess; /* pointer to the osql session */
@@ -735,7 +736,7 @@ int osql_bplog_saveop(osql_sess_t *sess, char *rpl, int rplen,
         logmsg(LOGMSG_ERROR, 
             "%s: fail to put oplog rqid=%llx (%lld) seq=%llu rc=%d bdberr=%d\n",
             __func__, key.rqid, key.rqid, key.seq, rc, bdberr);
-    } else if (gbl_osqlpfault_threads) {
+    } else if (gbl_osqlpfault_threads && gbl_osqlpf_readahead <= 0) {
         osql_page_prefault(rpl, rplen, &(tran->last_db),
                            &(osql_session_get_ireq(sess)->osql_step_ix), rqid,
                            uuid, seq);
@@ -1093,6 +1094,92 @@ void osql_bplog_setlimit(int limit) { g_osql_blocksql_parallel_max = limit; }
 /************************* INTERNALS
  * ***************************************************/
 
+/* Apply time prefault: a second cursor runs up to osql_prefault_readahead
+   ops ahead of the op being applied, and queues the page faults for the ops
+   it passes over.  It stops where the prefault budget runs out and goes on
+   from there at a later op. */
+struct prefault_ahead {
+    struct temp_cursor *cur;
+    struct dbtable *db; /* table of the last OSQL_USEDB seen */
+    unsigned long long seq; /* seq of the op under cur */
+};
+
+static void prefault_ahead_open(struct ireq *iq, struct prefault_ahead *pf,
+                                const oplog_key_t *start)
+{
+    blocksql_tran_t *tran = (blocksql_tran_t *)iq->blocksql_tran;
+    oplog_key_t *key;
+    int rc, bdberr;
+
+    memset(pf, 0, sizeof(*pf));
+    if (!gbl_osqlpfault_threads || gbl_osqlpf_readahead <= 0)
+        return;
+    if (iq->osql_step_ix == NULL &&
+        osql_page_prefault_slot(&iq->osql_step_ix, start->rqid,
+                                (unsigned char *)start->uuid))
+        return;
+
+    pf->cur = bdb_temp_table_cursor(thedb->bdb_env, tran->db, NULL, &bdberr);
+    if (pf->cur == NULL)
+        return;
+
+    /* find_exact takes the key */
+    if ((key = malloc(sizeof(*key))) == NULL) {
+        bdb_temp_table_close_cursor(thedb->bdb_env, pf->cur, &bdberr);
+        pf->cur = NULL;
+        return;
+    }
+    *key = *start;
+    rc = bdb_temp_table_find_exact(thedb->bdb_env, pf->cur, key, sizeof(*key),
+                                   &bdberr);
+    if (rc != IX_FND) {
+        free(key);
+        bdb_temp_table_close_cursor(thedb->bdb_env, pf->cur, &bdberr);
+        pf->cur = NULL;
+        return;
+    }
+    pf->seq = start->seq;
+}
+
+static void prefault_ahead(struct ireq *iq, struct prefault_ahead *pf,
+                           const oplog_key_t *applying)
+{
+    oplog_key_t *k;
+    int rc, bdberr;
+
+    while (pf->cur && pf->seq <= applying->seq + gbl_osqlpf_readahead) {
+        if (osql_prefault_budget_full()) {
+            /* never wait; pick up again at a later op */
+            osql_prefault_readahead_held();
+            break;
+        }
+        osql_page_prefault_op(bdb_temp_table_data(pf->cur),
+                              bdb_temp_table_datasize(pf->cur), &pf->db,
+                              *iq->osql_step_ix, applying->rqid,
+                              (unsigned char *)applying->uuid, pf->seq);
+
+        rc = bdb_temp_table_next(thedb->bdb_env, pf->cur, &bdberr);
+        k = rc ? NULL : (oplog_key_t *)bdb_temp_table_key(pf->cur);
+        if (k == NULL || k->rqid != applying->rqid ||
+            (k->rqid == OSQL_RQID_USE_UUID &&
+             comdb2uuidcmp(k->uuid, (unsigned char *)applying->uuid))) {
+            /* end of this transaction */
+            bdb_temp_table_close_cursor(thedb->bdb_env, pf->cur, &bdberr);
+            pf->cur = NULL;
+            break;
+        }
+        pf->seq = k->seq;
+    }
+}
+
+static void prefault_ahead_close(struct prefault_ahead *pf)
+{
+    int bdberr;
+    if (pf->cur)
+        bdb_temp_table_close_cursor(thedb->bdb_env, pf->cur, &bdberr);
+    pf->cur = NULL;
+}
+
 static int process_this_session(
     struct ireq *iq, void *iq_tran, osql_sess_t *sess, int *bdberr, int *nops,
     struct block_err *err, SBUF2 *logsb, struct temp_cursor *dbc,
@@ -1119,6 +1206,7 @@ static int process_this_session(
     int flags = 0;
     uuid_t uuid;
     uuidstr_t us;
+    struct prefault_ahead pf = {0};
 
     iq->queryid = osql_sess_queryid(sess);
 
@@ -1156,6 +1244,8 @@ static int process_this_session(
         comdb2uuidstr(uuid, us);
         logmsg(LOGMSG_ERROR, "%s: session %llx %s has no update rows?\n", __func__,
                 rqid, us);
+    } else {
+        prefault_ahead_open(iq, &pf, &key_next);
     }
 
     while (!rc && !rc_out) {
@@ -1169,12 +1259,15 @@ static int process_this_session(
             err->blockop_num = 0;
             err->errcode = ERR_NOMASTER;
             err->ixnum = 0;
+            prefault_ahead_close(&pf);
             return ERR_NOMASTER /*OSQL_FAILDISPATCH*/;
         }
 
         if (iq->osql_step_ix)
             gbl_osqlpf_step[*(iq->osql_step_ix)].step = key_next.seq << 7;
 
+        prefault_ahead(iq, &pf, &key_next);
+
         lastrcv = receivedrows;
 
         /* this locks pages */
@@ -1226,6 +1319,8 @@ static int process_this_session(
         step++;
     }
 
+    prefault_ahead_close(&pf);
+
     /* if for some reason the session has not completed correctly,
        this will free the eventually allocated buffers */
     free_blob_buffers(blobs, MAXBLOBS);
@@ -449,6 +449,39 @@ int osql_chkboard_sqlsession_rc(unsigned long long rqid, uuid_t uuid, int nops,
     return rc2;
 }
 
+int osql_chkboard_sqlsession_commit_lsn(unsigned long long rqid, uuid_t uuid,
+                                        unsigned int file, unsigned int offset)
+{
+    osql_sqlthr_t *entry = NULL;
+    int rc;
+
+    if (!checkboard)
+        return 0;
+
+    if ((rc = pthread_rwlock_rdlock(&checkboard->rwlock))) {
+        logmsg(LOGMSG_ERROR, "pthread_rwlock_rdlock: error code %d\n", rc);
+        return -1;
+    }
+
+    if (rqid == OSQL_RQID_USE_UUID)
+        entry = hash_find_readonly(checkboard->rqsuuid, uuid);
+    else
+        entry = hash_find_readonly(checkboard->rqs, &rqid);
+    if (entry && entry->clnt) {
+        pthread_mutex_lock(&entry->mtx);
+        entry->clnt->commit_file = file;
+        entry->clnt->commit_offset = offset;
+        pthread_mutex_unlock(&entry->mtx);
+    }
+
+    if ((rc = pthread_rwlock_unlock(&checkboard->rwlock))) {
+        logmsg(LOGMSG_ERROR, "pthread_rwlock_unlock: error code %d\n", rc);
+        return -2;
+    }
+
+    return entry ? 0 : -1;
+}
+
 static inline void signal_master_change(osql_sqlthr_t *rq, char *host,
                                         const char *line)
 {
@@ -86,6 +86,14 @@ int osql_unregister_sqlthr(struct sqlclntstate *clnt);
 int osql_chkboard_sqlsession_rc(unsigned long long rqid, uuid_t uuid, int nops,
                                 void *data, struct errstat *errstat);
 
+/**
+ * Called before osql_chkboard_sqlsession_rc when the master sends where
+ * it logged a successful commit
+ *
+ */
+int osql_chkboard_sqlsession_commit_lsn(unsigned long long rqid, uuid_t uuid,
+                                        unsigned int file, unsigned int offset);
+
 /**
  * Wait the default time for the session to complete
  * Upon return, sqlclntstate's errstat is set
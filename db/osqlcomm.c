@@ -48,6 +48,7 @@
 #include "views.h"
 #include "str0.h"
 #include "sc_struct.h"
+#include "comdb2_atomic.h"
 
 #define BLKOUT_DEFAULT_DELTA 5
 #define MAX_CLUSTER 16
@@ -67,6 +68,20 @@ queue_type *gbl_osqlpf_stepq = NULL;
 
 pthread_mutex_t osqlpf_mutex = PTHREAD_MUTEX_INITIALIZER;
 
+/* Prefault the bplog from the apply loop this many ops ahead of the op being
+   applied, instead of as the ops arrive. 0 to prefault on arrival. */
+int gbl_osqlpf_readahead = 0;
+/* Budget for queued and running osql prefault requests, across all
+   transactions: number of requests and bytes they hold */
+int gbl_osqlpf_max_inflight = 1000;
+int gbl_osqlpf_max_bytes = 16 * 1024 * 1024;
+
+static volatile int osqlpf_inflight;
+static volatile int osqlpf_inflight_bytes;
+/* times readahead stopped at the budget, and requests dropped there */
+static int osqlpf_readahead_held;
+static int osqlpf_dropped;
+
 extern __thread int send_prefault_udp;
 extern int gbl_prefault_udp;
 
@@ -1110,6 +1125,45 @@ osqlcomm_done_uuid_rpl_get(osql_done_uuid_rpl_t *p_osql_done_uuid_rpl,
     return p_buf;
 }
 
+/* Trails an OSQL_DONE reply: where the master logged the commit, so the sql
+   thread can hand it to its client to read its writes on another node.
+   Older sql nodes ignore it, and older masters don't send it. */
+typedef struct osql_done_lsn {
+    unsigned int file;
+    unsigned int offset;
+} osql_done_lsn_t;
+
+enum { OSQLCOMM_DONE_LSN_TYPE_LEN = 4 + 4 };
+
+BB_COMPILE_TIME_ASSERT(osqlcomm_done_lsn_type_len,
+                       sizeof(osql_done_lsn_t) == OSQLCOMM_DONE_LSN_TYPE_LEN);
+
+static uint8_t *osqlcomm_done_lsn_type_put(const osql_done_lsn_t *p_lsn,
+                                           uint8_t *p_buf,
+                                           const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf || OSQLCOMM_DONE_LSN_TYPE_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_put(&(p_lsn->file), sizeof(p_lsn->file), p_buf, p_buf_end);
+    p_buf = buf_put(&(p_lsn->offset), sizeof(p_lsn->offset), p_buf, p_buf_end);
+
+    return p_buf;
+}
+
+static const uint8_t *osqlcomm_done_lsn_type_get(osql_done_lsn_t *p_lsn,
+                                                 const uint8_t *p_buf,
+                                                 const uint8_t *p_buf_end)
+{
+    if (p_buf_end < p_buf || OSQLCOMM_DONE_LSN_TYPE_LEN > (p_buf_end - p_buf))
+        return NULL;
+
+    p_buf = buf_get(&(p_lsn->file), sizeof(p_lsn->file), p_buf, p_buf_end);
+    p_buf = buf_get(&(p_lsn->offset), sizeof(p_lsn->offset), p_buf, p_buf_end);
+
+    return p_buf;
+}
+
 typedef struct osql_done_rpl_stats {
     osql_rpl_t hd;
     osql_done_t dt;
@@ -5037,7 +5091,8 @@ int osql_comm_signal_sqlthr_rc(sorese_info_t *sorese, struct errstat *xerr,
         max = OSQLCOMM_DONE_XERR_RPL_LEN;
     if (OSQLCOMM_DONE_RPL_LEN > max)
         max = OSQLCOMM_DONE_RPL_LEN;
-    buf = alloca(max);
+    buf = alloca(max + OSQLCOMM_DONE_LSN_TYPE_LEN);
+    osql_done_lsn_t commit_lsn = {sorese->commit_file, sorese->commit_offset};
 
     /* test if the sql thread was the one closing the
        request, and if so, don't send anything back
@@ -5073,9 +5128,15 @@ int osql_comm_signal_sqlthr_rc(sorese_info_t *sorese, struct errstat *xerr,
                 rpl_ok.dt.rc = 0;
                 rpl_ok.dt.nops = sorese->nops;
 
-                osqlcomm_done_uuid_rpl_put(&(rpl_ok), p_buf, p_buf_end);
+                p_buf = osqlcomm_done_uuid_rpl_put(&(rpl_ok), p_buf, p_buf_end);
 
-                msglen = OSQLCOMM_DONE_RPL_LEN;
+                msglen = OSQLCOMM_DONE_UUID_RPL_LEN;
+                if (commit_lsn.file) {
+                    osqlcomm_done_lsn_type_put(
+                        &commit_lsn, p_buf,
+                        p_buf + OSQLCOMM_DONE_LSN_TYPE_LEN);
+                    msglen += OSQLCOMM_DONE_LSN_TYPE_LEN;
+                }
             }
             type = osql_net_type_to_net_uuid_type(NET_OSQL_SIGNAL);
         } else {
@@ -5102,9 +5163,15 @@ int osql_comm_signal_sqlthr_rc(sorese_info_t *sorese, struct errstat *xerr,
                 rpl_ok.dt.rc = 0;
                 rpl_ok.dt.nops = sorese->nops;
 
-                osqlcomm_done_rpl_put(&(rpl_ok), p_buf, p_buf_end);
+                p_buf = osqlcomm_done_rpl_put(&(rpl_ok), p_buf, p_buf_end);
 
                 msglen = OSQLCOMM_DONE_RPL_LEN;
+                if (commit_lsn.file) {
+                    osqlcomm_done_lsn_type_put(
+                        &commit_lsn, p_buf,
+                        p_buf + OSQLCOMM_DONE_LSN_TYPE_LEN);
+                    msglen += OSQLCOMM_DONE_LSN_TYPE_LEN;
+                }
             }
             type = NET_OSQL_SIGNAL;
         }
@@ -5122,6 +5189,10 @@ int osql_comm_signal_sqlthr_rc(sorese_info_t *sorese, struct errstat *xerr,
     } else {
         /* local */
 
+        if (rc == 0 && commit_lsn.file)
+            osql_chkboard_sqlsession_commit_lsn(sorese->rqid, sorese->uuid,
+                                                commit_lsn.file,
+                                                commit_lsn.offset);
         irc = osql_chkboard_sqlsession_rc(sorese->rqid, sorese->uuid,
                                           sorese->nops, NULL, xerr);
     }
@@ -7502,6 +7573,16 @@ static void net_sorese_signal(void *hndl, void *uptr, char *fromhost,
 
             osql_chkboard_sqlsession_rc(rqid, uuid, 0, NULL, &errstat);
         } else {
+            int donelen = rqid == OSQL_RQID_USE_UUID
+                              ? OSQLCOMM_DONE_UUID_RPL_LEN
+                              : OSQLCOMM_DONE_RPL_LEN;
+            osql_done_lsn_t commit_lsn = {0};
+            if (osqlcomm_done_lsn_type_get(&commit_lsn,
+                                           (uint8_t *)dtap + donelen,
+                                           p_buf_end) &&
+                commit_lsn.file)
+                osql_chkboard_sqlsession_commit_lsn(
+                    rqid, uuid, commit_lsn.file, commit_lsn.offset);
             osql_chkboard_sqlsession_rc(rqid, uuid, done.nops, NULL, NULL);
         }
 
@@ -8219,6 +8300,43 @@ typedef struct osqlpf_rq {
     uuid_t uuid;
 } osqlpf_rq_t;
 
+static int osqlpf_rq_size(const osqlpf_rq_t *req)
+{
+    return sizeof(osqlpf_rq_t) + (req->record ? req->len : 0);
+}
+
+int osql_prefault_budget_full(void)
+{
+    /* racy reads are fine here; the budget is advisory */
+    return osqlpf_inflight >= gbl_osqlpf_max_inflight ||
+           osqlpf_inflight_bytes >= gbl_osqlpf_max_bytes;
+}
+
+void osql_prefault_readahead_held(void)
+{
+    ATOMIC_ADD(osqlpf_readahead_held, 1);
+}
+
+void osql_prefault_print_stats(void)
+{
+    logmsg(LOGMSG_USER,
+           "Prefault budget: %d of %d requests, %d of %d bytes in flight\n",
+           osqlpf_inflight, gbl_osqlpf_max_inflight, osqlpf_inflight_bytes,
+           gbl_osqlpf_max_bytes);
+    logmsg(LOGMSG_USER, "Readahead held by the budget %d times, %d requests "
+                        "dropped\n",
+           osqlpf_readahead_held, osqlpf_dropped);
+}
+
+static void osqlpf_rq_free(osqlpf_rq_t *req)
+{
+    ATOMIC_ADD(osqlpf_inflight, -1);
+    ATOMIC_ADD(osqlpf_inflight_bytes, -osqlpf_rq_size(req));
+    if (req->record)
+        free(req->record);
+    free(req);
+}
+
 /* osql request io prefault, code stolen from prefault.c */
 
 static int is_bad_rc(int rc)
@@ -8234,13 +8352,37 @@ static int is_bad_rc(int rc)
 static void osqlpfault_do_work_pp(struct thdpool *pool, void *work,
                                   void *thddata, int op);
 
+/* Queue a request if the budget allows; frees it if not */
+static int osqlpf_enqueue(osqlpf_rq_t *qdata)
+{
+    int rc;
+
+    if (osql_prefault_budget_full()) {
+        ATOMIC_ADD(osqlpf_dropped, 1);
+        rc = -1;
+    } else {
+        ATOMIC_ADD(osqlpf_inflight, 1);
+        ATOMIC_ADD(osqlpf_inflight_bytes, osqlpf_rq_size(qdata));
+        rc = thdpool_enqueue(gbl_osqlpfault_thdpool, osqlpfault_do_work_pp,
+                             qdata, 0, NULL);
+        if (rc == 0)
+            return 0;
+        ATOMIC_ADD(osqlpf_inflight, -1);
+        ATOMIC_ADD(osqlpf_inflight_bytes, -osqlpf_rq_size(qdata));
+    }
+
+    if (qdata->record)
+        free(qdata->record);
+    free(qdata);
+    return rc;
+}
+
 /* given a table, key   : enqueue a fault for the a single ix record */
 int enque_osqlpfault_oldkey(struct dbtable *db, void *key, int keylen, int ixnum,
-                            int i, unsigned long long rqid,
+                            int i, unsigned long long rqid, uuid_t uuid,
                             unsigned long long seq)
 {
     osqlpf_rq_t *qdata = NULL;
-    int rc;
 
     qdata = calloc(1, sizeof(osqlpf_rq_t));
     if (qdata == NULL) {
@@ -8256,26 +8398,20 @@ int enque_osqlpfault_oldkey(struct dbtable *db, void *key, int keylen, int ixnum
     qdata->i = i;
     qdata->seq = seq;
     qdata->rqid = rqid;
+    comdb2uuidcpy(qdata->uuid, uuid);
 
     if ((keylen > 0) && (keylen < MAXKEYLEN))
         memcpy(qdata->key, key, keylen);
 
-    rc = thdpool_enqueue(gbl_osqlpfault_thdpool, osqlpfault_do_work_pp, qdata,
-                         0, NULL);
-
-    if (rc != 0) {
-        free(qdata);
-    }
-    return rc;
+    return osqlpf_enqueue(qdata);
 }
 
 /* given a table, key   : enqueue a fault for the a single ix record */
 int enque_osqlpfault_newkey(struct dbtable *db, void *key, int keylen, int ixnum,
-                            int i, unsigned long long rqid,
+                            int i, unsigned long long rqid, uuid_t uuid,
                             unsigned long long seq)
 {
     osqlpf_rq_t *qdata = NULL;
-    int rc;
 
     qdata = calloc(1, sizeof(osqlpf_rq_t));
     if (qdata == NULL) {
@@ -8291,17 +8427,12 @@ int enque_osqlpfault_newkey(struct dbtable *db, void *key, int keylen, int ixnum
     qdata->i = i;
     qdata->seq = seq;
     qdata->rqid = rqid;
+    comdb2uuidcpy(qdata->uuid, uuid);
 
     if ((keylen > 0) && (keylen < MAXKEYLEN))
         memcpy(qdata->key, key, keylen);
 
-    rc = thdpool_enqueue(gbl_osqlpfault_thdpool, osqlpfault_do_work_pp, qdata,
-                         0, NULL);
-
-    if (rc != 0) {
-        free(qdata);
-    }
-    return rc;
+    return osqlpf_enqueue(qdata);
 }
 
 /* given a table, genid   : enqueue an op that faults in the dta record by
@@ -8313,7 +8444,6 @@ int enque_osqlpfault_olddata_oldkeys(struct dbtable *db, unsigned long long geni
                                      uuid_t uuid, unsigned long long seq)
 {
     osqlpf_rq_t *qdata = NULL;
-    int rc;
 
     qdata = calloc(1, sizeof(osqlpf_rq_t));
     if (qdata == NULL) {
@@ -8330,13 +8460,7 @@ int enque_osqlpfault_olddata_oldkeys(struct dbtable *db, unsigned long long geni
     qdata->rqid = rqid;
     comdb2uuidcpy(qdata->uuid, uuid);
 
-    rc = thdpool_enqueue(gbl_osqlpfault_thdpool, osqlpfault_do_work_pp, qdata,
-                         0, NULL);
-
-    if (rc != 0) {
-        free(qdata);
-    }
-    return rc;
+    return osqlpf_enqueue(qdata);
 }
 
 /* given a table, record : enqueue an op that faults in the dta record by
@@ -8348,7 +8472,6 @@ int enque_osqlpfault_newdata_newkeys(struct dbtable *db, void *record, int recle
                                      uuid_t uuid, unsigned long long seq)
 {
     osqlpf_rq_t *qdata = NULL;
-    int rc;
 
     qdata = calloc(1, sizeof(osqlpf_rq_t));
     if (qdata == NULL) {
@@ -8368,14 +8491,7 @@ int enque_osqlpfault_newdata_newkeys(struct dbtable *db, void *record, int recle
     qdata->rqid = rqid;
     comdb2uuidcpy(qdata->uuid, uuid);
 
-    rc = thdpool_enqueue(gbl_osqlpfault_thdpool, osqlpfault_do_work_pp, qdata,
-                         0, NULL);
-
-    if (rc != 0) {
-        free(qdata->record);
-        free(qdata);
-    }
-    return rc;
+    return osqlpf_enqueue(qdata);
 }
 
 /* given a                      : enqueue a an op that
@@ -8392,7 +8508,6 @@ int enque_osqlpfault_olddata_oldkeys_newkeys(
     unsigned long long rqid, uuid_t uuid, unsigned long long seq)
 {
     osqlpf_rq_t *qdata = NULL;
-    int rc;
 
     qdata = calloc(1, sizeof(osqlpf_rq_t));
     if (qdata == NULL) {
@@ -8412,14 +8527,7 @@ int enque_osqlpfault_olddata_oldkeys_newkeys(
     qdata->rqid = rqid;
     comdb2uuidcpy(qdata->uuid, uuid);
 
-    rc = thdpool_enqueue(gbl_osqlpfault_thdpool, osqlpfault_do_work_pp, qdata,
-                         0, NULL);
-
-    if (rc != 0) {
-        free(qdata->record);
-        free(qdata);
-    }
-    return rc;
+    return osqlpf_enqueue(qdata);
 }
 
 static void osqlpfault_do_work(struct thdpool *pool, void *work, void *thddata)
@@ -8571,7 +8679,7 @@ static void osqlpfault_do_work(struct thdpool *pool, void *work, void *thddata)
             }
 
             rc = enque_osqlpfault_oldkey(iq.usedb, key, keysz, ixnum, req->i,
-                                         req->rqid, req->seq);
+                                         req->rqid, req->uuid, req->seq);
         }
         if (fnddta)
             free(fnddta);
@@ -8605,7 +8713,7 @@ static void osqlpfault_do_work(struct thdpool *pool, void *work, void *thddata)
             }
 
             rc = enque_osqlpfault_newkey(iq.usedb, key, keysz, ixnum, req->i,
-                                         req->rqid, req->seq);
+                                         req->rqid, req->uuid, req->seq);
         }
     } break;
     case OSQLPFRQ_OLDDATA_OLDKEYS_NEWKEYS: {
@@ -8669,7 +8777,7 @@ static void osqlpfault_do_work(struct thdpool *pool, void *work, void *thddata)
             }
 
             rc = enque_osqlpfault_oldkey(iq.usedb, key, keysz, ixnum, req->i,
-                                         req->rqid, req->seq);
+                                         req->rqid, req->uuid, req->seq);
         }
 
         free(fnddta);
@@ -8698,7 +8806,7 @@ static void osqlpfault_do_work(struct thdpool *pool, void *work, void *thddata)
             }
 
             rc = enque_osqlpfault_newkey(iq.usedb, key, keysz, ixnum, req->i,
-                                         req->rqid, req->seq);
+                                         req->rqid, req->uuid, req->seq);
         }
     } break;
     }
@@ -8706,9 +8814,7 @@ static void osqlpfault_do_work(struct thdpool *pool, void *work, void *thddata)
 done:
     bdb_thread_event(thedb->bdb_env, 0);
     send_prefault_udp = 0;
-    if (req->record)
-        free(req->record);
-    free(req);
+    osqlpf_rq_free(req);
 }
 
 static void osqlpfault_do_work_pp(struct thdpool *pool, void *work,
@@ -8720,47 +8826,61 @@ static void osqlpfault_do_work_pp(struct thdpool *pool, void *work,
         osqlpfault_do_work(pool, work, thddata);
         break;
     case THD_FREE:
-        if (req->record)
-            free(req->record);
-        free(req);
+        osqlpf_rq_free(req);
         break;
     }
 }
 
+/* Grab a step slot for a transaction's prefaults */
+int osql_page_prefault_slot(int **iq_step_ix, unsigned long long rqid,
+                            uuid_t uuid)
+{
+    int *ii;
+    int rc;
+
+    rc = pthread_mutex_lock(&osqlpf_mutex);
+    if (rc != 0) {
+        logmsg(LOGMSG_ERROR, "%s: Failed to lock osqlpf_mutex\n", __func__);
+        return 1;
+    }
+    ii = queue_next(gbl_osqlpf_stepq);
+    rc = pthread_mutex_unlock(&osqlpf_mutex);
+    if (rc != 0) {
+        logmsg(LOGMSG_ERROR, "%s: Failed to unlock osqlpf_mutex\n", __func__);
+        return 1;
+    }
+    if (ii == NULL) {
+        logmsg(LOGMSG_ERROR, "osql io prefault got a BUG!\n");
+        exit(1);
+    }
+    *iq_step_ix = ii;
+    gbl_osqlpf_step[*ii].rqid = rqid;
+    comdb2uuidcpy(gbl_osqlpf_step[*ii].uuid, uuid);
+    return 0;
+}
+
 int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
                        int **iq_step_ix, unsigned long long rqid, uuid_t uuid,
                        unsigned long long seq)
 {
-    static int last_step_idex = 0;
-    int *ii;
-    int rc;
+    if (seq == 0 && osql_page_prefault_slot(iq_step_ix, rqid, uuid))
+        return 1;
+    if (*iq_step_ix == NULL)
+        return 0;
+    return osql_page_prefault_op(rpl, rplen, last_db, **iq_step_ix, rqid, uuid,
+                                 seq);
+}
+
+/* Queue the page faults for one bplog op; last_db tracks the OSQL_USEDBs */
+int osql_page_prefault_op(char *rpl, int rplen, struct dbtable **last_db,
+                          int step_ix, unsigned long long rqid, uuid_t uuid,
+                          unsigned long long seq)
+{
     osql_rpl_t rpl_op;
     uint8_t *p_buf = (uint8_t *)rpl;
     uint8_t *p_buf_end = p_buf + rplen;
     osqlcomm_rpl_type_get(&rpl_op, p_buf, p_buf_end);
 
-    if (seq == 0) {
-        rc = pthread_mutex_lock(&osqlpf_mutex);
-        if (rc != 0) {
-            logmsg(LOGMSG_ERROR, "osql_page_prefault: Failed to lock osqlpf_mutex\n");
-            return 1;
-        }
-        ii = queue_next(gbl_osqlpf_stepq);
-        rc = pthread_mutex_unlock(&osqlpf_mutex);
-        if (rc != 0) {
-            logmsg(LOGMSG_ERROR, "osql_page_prefault: Failed to unlock osqlpf_mutex\n");
-            return 1;
-        }
-        if (ii == NULL) {
-            logmsg(LOGMSG_ERROR, "osql io prefault got a BUG!\n");
-            exit(1);
-        }
-        last_step_idex = *ii;
-        *iq_step_ix = ii;
-        gbl_osqlpf_step[last_step_idex].rqid = rqid;
-        comdb2uuidcpy(gbl_osqlpf_step[last_step_idex].uuid, uuid);
-    }
-
     switch (rpl_op.type) {
     case OSQL_USEDB: {
         osql_usedb_t dt;
@@ -8784,7 +8904,9 @@ int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
         p_buf = (uint8_t *)&((osql_del_rpl_t *)rpl)->dt;
         p_buf = (uint8_t *)osqlcomm_del_type_get(&dt, p_buf, p_buf_end,
                                                  rpl_op.type == OSQL_DELETE);
-        enque_osqlpfault_olddata_oldkeys(*last_db, dt.genid, last_step_idex,
+        if (*last_db == NULL)
+            break;
+        enque_osqlpfault_olddata_oldkeys(*last_db, dt.genid, step_ix,
                                          rqid, uuid, seq);
     } break;
     case OSQL_INSREC:
@@ -8796,8 +8918,10 @@ int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
         uint8_t *p_buf = (uint8_t *)&((osql_ins_rpl_t *)rpl)->dt;
         pData = (uint8_t *)osqlcomm_ins_type_get(&dt, p_buf, p_buf_end,
                                                  rpl_op.type == OSQL_INSERT);
+        if (*last_db == NULL)
+            break;
         enque_osqlpfault_newdata_newkeys(*last_db, pData, dt.nData,
-                                         last_step_idex, rqid, uuid, seq);
+                                         step_ix, rqid, uuid, seq);
     } break;
     case OSQL_UPDREC:
     case OSQL_UPDATE: {
@@ -8809,8 +8933,10 @@ int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
         pData = (uint8_t *)osqlcomm_upd_type_get(&dt, p_buf, p_buf_end,
                                                  rpl_op.type == OSQL_UPDATE);
         genid = dt.genid;
+        if (*last_db == NULL)
+            break;
         enque_osqlpfault_olddata_oldkeys_newkeys(*last_db, dt.genid, pData,
-                                                 dt.nData, last_step_idex, rqid,
+                                                 dt.nData, step_ix, rqid,
                                                  uuid, seq);
     } break;
     default:
@@ -410,6 +410,14 @@ enum osqlpfrq_type {
 int osql_page_prefault(char *rpl, int rplen, struct dbtable **last_db,
                        int **iq_step_ix, unsigned long long rqid, uuid_t uuid,
                        unsigned long long seq);
+int osql_page_prefault_slot(int **iq_step_ix, unsigned long long rqid,
+                            uuid_t uuid);
+int osql_page_prefault_op(char *rpl, int rplen, struct dbtable **last_db,
+                          int step_ix, unsigned long long rqid, uuid_t uuid,
+                          unsigned long long seq);
+int osql_prefault_budget_full(void);
+void osql_prefault_readahead_held(void);
+void osql_prefault_print_stats(void);
 
 int osql_close_connection(char *host);
 
@@ -212,6 +212,7 @@ static const char *HELP_STAT[] = {
     "stat long                  - request statistics",
     "stat reql                  - dumps long request settings",
     "stat appsock               - socket request statistics",
+    "stat admit                 - sql admission lanes and queues",
     "stat fstblk                - fstblk statistics",
     "stat blob                  - blob subsystems statistics",
     "stat resources             - dump list of registered resources",
@@ -1098,6 +1099,7 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
         } else {
            logmsg(LOGMSG_USER, "Osql io prefault is DISABLED\n");
         }
+        osql_prefault_print_stats();
         thdpool_print_stats(stdout, gbl_osqlpfault_thdpool);
     } else if (tokcmp(tok, ltok, "set_udp_prefault_latency") == 0) {
         tok = segtok(line, lline, &st, &ltok);
@@ -1861,6 +1863,8 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
             request_stats(dbenv);
         } else if (tokcmp(tok, ltok, "appsock") == 0) {
             appsock_stat();
+        } else if (tokcmp(tok, ltok, "admit") == 0) {
+            sql_admit_stat();
         } else if (tokcmp(tok, ltok, "blob") == 0) {
             blob_print_stats();
         } else if (tokcmp(tok, ltok, "compr") == 0) {
@@ -2531,6 +2535,27 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
         tokcpy(tok, ltok, table);
 
         stat_bt_hash_table_reset(table);
+    } else if (tokcmp(tok, ltok, "ixhashstat") == 0) {
+        char table[MAXTABLELEN];
+        struct dbtable *db;
+
+        tok = segtok(line, lline, &st, &ltok);
+        if (ltok == 0) {
+            logmsg(LOGMSG_ERROR, "Expected db name\n");
+            return -1;
+        }
+        if (ltok >= MAXTABLELEN) {
+            logmsg(LOGMSG_ERROR, "Invalid table name: too long (max %d)\n", MAXTABLELEN);
+            return -1;
+        }
+
+        tokcpy(tok, ltok, table);
+
+        if ((db = get_dbtable_by_name(table)) == NULL) {
+            logmsg(LOGMSG_ERROR, "Invalid table %s\n", table);
+            return -1;
+        }
+        bdb_handle_dbp_ix_hash_stat(db->handle);
     } else if (tokcmp(tok, ltok, "fastinit") == 0) {
         char fname[128];
         char table[MAXTABLELEN];
@@ -2806,6 +2831,20 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
                         "%s:%d: failed to list all options rc=%d bdberr=%d\n",
                         __FILE__, __LINE__, rc, bdberr);
             }
+        } else if (tokcmp(tok, ltok, "stat") == 0) {
+            unsigned long long hits, reads;
+            unsigned nqueries = gbl_nsql + gbl_nnewsql;
+            bdb_llmeta_cache_stats(&hits, &reads);
+            logmsg(LOGMSG_USER, "llmeta cache %s\n",
+                   bdb_attr_get(thedb->bdb_attr, BDB_ATTR_LLMETA_CACHE)
+                       ? "on"
+                       : "off");
+            logmsg(LOGMSG_USER, "cache hits %llu, btree reads %llu\n", hits,
+                   reads);
+            if (nqueries)
+                logmsg(LOGMSG_USER,
+                       "per query: %.2f btree reads saved, %.2f done\n",
+                       (double)hits / nqueries, (double)reads / nqueries);
         } else {
             logmsg(LOGMSG_ERROR, "unknown option \"%.*s\"\n", ltok, tok);
         }
@@ -3407,6 +3446,11 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
         thdpool_process_message(gbl_udppfault_thdpool, line, lline, st);
     } else if (tokcmp(tok, ltok, "pgcompactpool") == 0) {
         thdpool_process_message(gbl_pgcompact_thdpool, line, lline, st);
+    } else if (tokcmp(tok, ltok, "defrag") == 0) {
+        if (thedb->master != gbl_mynode)
+            logmsg(LOGMSG_USER, "defrag only runs on the master\n");
+        else
+            defrag_run();
     } else if (tokcmp(tok, ltok, "oldestgenids") == 0) {
         int i, stripe;
         void *buf = malloc(64 * 1024);
@@ -4510,12 +4554,16 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
             FILE *f = io_override_get_std();
             SBUF2 *sb = sbuf2open(fileno((f?f:stdout)), 0);
             handle_testcompr(sb, table);
+        } else if (tokcmp(tok, ltok, "advise") == 0) {
+            compr_advisor_run();
         } else {
             logmsg(LOGMSG_USER, 
                    "testcompr table <tbl> - Test compression for table tbl\n"
                    "testcompr percent <number> - Default 10%%\n"
                    "testcompr max <number> - Set to 0 to process all records; "
-                   "Default 300,000\n");
+                   "Default 300,000\n"
+                   "testcompr advise - Run the compression advisor now; see "
+                   "comdb2_compression_stats\n");
         }
 
         logmsg(LOGMSG_USER, "Current tunables:\nCompress %d%% of the records",
@@ -5043,6 +5091,23 @@ int process_command(struct dbenv *dbenv, char *line, int lline, int st)
             tblname = tokdup(tok, ltok);
             views_do_purge(thedb->timepart_views, tblname);
             free(tblname);
+        } else if (tokcmp(tok, ltok, "freeze") == 0) {
+            struct errstat xerr = {0};
+            char *tblname;
+
+            tok = segtok(line, lline, &st, &ltok);
+            if (!tok) {
+                logmsg(LOGMSG_ERROR, "Usage: partitions freeze <shardname>");
+                return -1;
+            }
+            tblname = tokdup(tok, ltok);
+            if (!timepart_is_shard(tblname, 1)) {
+                logmsg(LOGMSG_ERROR, "%s is not a partition shard\n", tblname);
+            } else if (views_freeze_shard(tblname, &xerr) != VIEW_NOERR) {
+                logmsg(LOGMSG_ERROR, "freeze %s failed: %s\n", tblname,
+                       xerr.errstr);
+            }
+            free(tblname);
         } else {
             char *str = NULL;
             int lrc;
@@ -89,6 +89,14 @@ void free_cached_idx(uint8_t * *cached_idx);
     if (gbl_verbose_toblock_backouts)                                          \
         logmsg(LOGMSG_USER, "err line %d rc %d retrc %d\n", __LINE__, rc, retrc);           \
     goto err;
+/* Frozen time partition shards are read only, see views_freeze_shard() */
+#define CHECK_TABLE_READONLY                                                   \
+    if (iq->usedb->is_readonly && !(flags & RECFLAGS_NEW_SCHEMA)) {            \
+        reqerrstrhdr(iq, "Table '%s' ", iq->usedb->tablename);                 \
+        reqerrstr(iq, COMDB2_CSTRT_RC_INVL_TBL, "table is frozen");            \
+        retrc = ERR_BADREQ;                                                    \
+        goto err;                                                              \
+    }
 #define VERIFY_TABLE_VERSION                                                   \
     if (iq->usedb->tableversion != iq->usedbtablevers) {                       \
         if (iq->debug)                                                         \
@@ -163,6 +171,8 @@ add_record_int(struct ireq *iq, void *trans, const uint8_t *p_buf_tag_name,
         prefixes++;
     }
 
+    CHECK_TABLE_READONLY
+
     if (!(flags & RECFLAGS_NEW_SCHEMA)) {
         if (gbl_max_wr_rows_per_txn &&
             ((++iq->written_row_count) > gbl_max_wr_rows_per_txn)) {
@@ -857,6 +867,8 @@ int upd_record(struct ireq *iq, void *trans, void *primkey, int rrn,
         prefixes++;
     }
 
+    CHECK_TABLE_READONLY
+
     int d_ms = BDB_ATTR_GET(thedb->bdb_attr, DELAY_LOCK_TABLE_RECORD_C);
     if (d_ms) {
         if (iq->debug)
@@ -1823,6 +1835,8 @@ int del_record(struct ireq *iq, void *trans, void *primkey, int rrn,
         prefixes++;
     }
 
+    CHECK_TABLE_READONLY
+
     od_len_int = getdatsize(iq->usedb);
     if (od_len_int <= 0) {
         if (iq->debug)
@@ -31,6 +31,7 @@
 #include "osqlblockproc.h"
 #include "osqlblkseq.h"
 #include "logmsg.h"
+#include "autoanalyze.h"
 #include "plhash.h"
 #include "comdb2_plugin.h"
 #include "comdb2_opcode.h"
@@ -440,6 +441,12 @@ int handle_ireq(struct ireq *iq)
         }
     }
 
+    /* the keys this transaction added and removed count from now on */
+    if (rc == 0 && iq->num_incr_stats_hits > 0)
+        incr_stats_commit(iq);
+    else
+        incr_stats_abort(iq);
+
     /* Finish off logging. */
     if (iq->blocksql_tran) {
         osql_bplog_reqlog_queries(iq);
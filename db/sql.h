@@ -240,6 +240,9 @@ typedef struct sqlclntstate_fdb {
                  errors */
     int preserve_err; /* set to ignore up-stream errors when lower system sets
                          xerr */
+    int stream_unflushed; /* IN REMOTE DB: streamed rows not yet flushed */
+    int stream_flush_ms;  /* IN REMOTE DB: when streamed rows were last flushed
+                           */
     /* source side fields */
     int n_fdb_affinities; /* number of fdbs in the fdb_ids and fdb_nodes arrays
                              */
@@ -472,6 +475,8 @@ struct sqlclntstate {
     int snapshot; /* snapshot epoch placeholder */
     int snapshot_file;
     int snapshot_offset;
+    int commit_file; /* where the master logged our last commit */
+    int commit_offset;
     int is_hasql_retry;
     int is_readonly;
     int is_expert;
@@ -506,6 +511,9 @@ struct sqlclntstate {
 
     uint64_t enque_timeus;
     uint64_t deque_timeus;
+    int admit_lane; /* sql_admit lane this request waited in, 0 for none */
+    long long mem_peak; /* most memory used by a statement of this connection */
+    int mem_limit_hit;  /* last statement ran over query_mem_limit_mb */
 
     /* due to some sqlite vagaries, cursor is closed
        and I lose the side row; cache it here! */
@@ -775,6 +783,7 @@ struct sql_thread {
     int rootpage_nentries;
     unsigned char had_temptables;
     unsigned char had_tablescans;
+    comdb2ma_acct mem; /* memory used by the running statement */
 };
 
 /* makes master swing verbose */
@@ -799,6 +808,7 @@ unsigned long long osql_log_time(void);
 void osql_log_time_done(struct sqlclntstate *clnt);
 
 int dispatch_sql_query(struct sqlclntstate *clnt);
+int wait_for_read_after_lsn(struct sqlclntstate *clnt, int file, int offset);
 
 int handle_sql_begin(struct sqlthdstate *thd, struct sqlclntstate *clnt,
                      int sendresponse);
@@ -837,6 +847,8 @@ void fdb_packedsqlite_process_sqlitemaster_row(char *row, int rowlen,
                                                int new_rootpage);
 
 int fdb_packedsqlite_extract_genid(char *key, int *outlen, char *outbuf);
+long long fdb_packedsqlite_extract_int(char *row);
+int fdb_push_count_table(const char *tblname);
 
 unsigned long long comdb2_table_version(const char *tablename);
 
@@ -888,6 +900,8 @@ void sqlengine_thd_end(struct thdpool *, struct sqlthdstate *);
 
 int get_data(BtCursor *pCur, struct schema *sc, uint8_t *in, int fnum, Mem *m,
              uint8_t flip_orig, const char *tzname);
+int get_data_length_only(BtCursor *pCur, struct schema *sc, uint8_t *in,
+                         int fnum, Mem *m, int opflags);
 
 #define cur_is_remote(pCur) (pCur->cursor_class == CURSORCLASS_REMOTE)
 
@@ -0,0 +1,535 @@
+/*
+   Copyright 2018 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+/*
+** SQL admission control.
+**
+** With sql_admit on, requests don't go straight to the sql engine pool.
+** Each one is put in a lane: long if statements with the same text (literals
+** and case aside) took sql_admit_long_ms or more on average the last times
+** they ran, short otherwise. Each lane lets a limited number of requests run
+** at a time, and the long lane gets a quarter of the pool unless told
+** otherwise, so expensive queries can't take every sql thread.
+**
+** Inside a lane, requests are queued per client (argv0, user or host, see
+** sql_admit_fair_by) and picked by start-time fair queuing: a client's
+** requests are charged their expected cost divided by the client's weight
+** (sql_admit_weights), and the request with the lowest start tag goes next.
+** A client flooding a lane only delays its own requests.
+**
+** Statements inside a client transaction, retries and stored procedure
+** threads skip admission; they may hold locks others are waiting on.
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <limits.h>
+#include <inttypes.h>
+#include <pthread.h>
+
+#include <comdb2.h>
+#include <sql.h>
+#include <list.h>
+#include <plhash.h>
+#include <logmsg.h>
+
+int gbl_sql_admit = 0;
+int gbl_sql_admit_fair_by = SQL_ADMIT_BY_ARGV0;
+int gbl_sql_admit_long_ms = 1000;
+int gbl_sql_admit_long_threads = 0;
+int gbl_sql_admit_short_threads = 0;
+char *gbl_sql_admit_weights = NULL;
+
+enum { ADMIT_SHORT = 1, ADMIT_LONG = 2 };
+#define ADMIT_NLANES 2
+#define ADMIT_HIST 4096
+#define ADMIT_MAX_WEIGHTS 64
+#define ADMIT_NAME_LEN 64
+
+struct admit_flow;
+
+struct admit_req {
+    struct sqlclntstate *clnt;
+    thdpool_work_fn work_fn;
+    char *info;
+    struct admit_flow *flow;
+    uint64_t fp;
+    double start; /* virtual start tag */
+    uint64_t queued_us;
+    int expired; /* waited longer than the pool's maxqueueage */
+    LINKC_T(struct admit_req) lnk;
+};
+
+typedef LISTC_T(struct admit_req) admit_req_list;
+
+struct admit_flow {
+    char name[ADMIT_NAME_LEN];
+    int lane;
+    double finish; /* virtual finish tag of its last request */
+    int nrunning;
+    admit_req_list queue;
+    LINKC_T(struct admit_flow) lnk; /* on the lane's active list */
+};
+
+struct admit_lane {
+    hash_t *flows;
+    LISTC_T(struct admit_flow) active; /* flows with queued requests */
+    double vtime;
+    int nqueued;
+    int nrunning;
+    uint64_t nadmitted;
+    uint64_t ntimeout;
+    uint64_t queue_us;
+    uint64_t max_queue_us;
+};
+
+/* average run time of recent statements, by text */
+struct admit_hist {
+    uint64_t fp;
+    double avg_ms;
+};
+
+struct admit_weight {
+    char name[ADMIT_NAME_LEN];
+    int weight;
+};
+
+static pthread_mutex_t admit_lk = PTHREAD_MUTEX_INITIALIZER;
+static pthread_once_t admit_once = PTHREAD_ONCE_INIT;
+static struct admit_lane lanes[ADMIT_NLANES];
+static struct admit_hist hist[ADMIT_HIST];
+static struct admit_weight weights[ADMIT_MAX_WEIGHTS];
+static int nweights;
+
+static void admit_init(void)
+{
+    for (int i = 0; i < ADMIT_NLANES; i++) {
+        lanes[i].flows = hash_init_str(offsetof(struct admit_flow, name));
+        listc_init(&lanes[i].active, offsetof(struct admit_flow, lnk));
+    }
+}
+
+const char *sql_admit_lane_name(int lane)
+{
+    switch (lane) {
+    case ADMIT_SHORT:
+        return "short";
+    case ADMIT_LONG:
+        return "long";
+    default:
+        return "none";
+    }
+}
+
+/* Hash the text of a statement with literals, case and spacing folded away,
+ * so the same statement with different constants shares a history. The
+ * sqlite fingerprint would be better, but it's only known after prepare. */
+static uint64_t admit_fingerprint(const char *sql)
+{
+    const unsigned char *s = (const unsigned char *)sql;
+    uint64_t h = 14695981039346656037ULL;
+    int ident = 0;
+    unsigned char c;
+
+#define FP_ADD(ch)                                                             \
+    do {                                                                       \
+        h ^= (ch);                                                             \
+        h *= 1099511628211ULL;                                                 \
+    } while (0)
+
+    while ((c = *s) != 0) {
+        if (isspace(c)) {
+            while (isspace(*s))
+                s++;
+            FP_ADD(' ');
+            ident = 0;
+        } else if (c == '\'') {
+            for (s++; *s; s++) {
+                if (*s == '\'' && *++s != '\'')
+                    break;
+            }
+            FP_ADD('?');
+            ident = 0;
+        } else if (!ident && (isdigit(c) || (c == '.' && isdigit(s[1])))) {
+            while (isalnum(*s) || *s == '.')
+                s++;
+            FP_ADD('?');
+        } else {
+            ident = isalnum(c) || c == '_';
+            FP_ADD(tolower(c));
+            s++;
+        }
+    }
+#undef FP_ADD
+    return h;
+}
+
+static int lane_limit(int lane)
+{
+    int maxt = thdpool_get_maxthds(gbl_sqlengine_thdpool);
+    int nlong, nshort;
+
+    nlong = gbl_sql_admit_long_threads;
+    if (nlong <= 0)
+        nlong = maxt > 0 ? maxt / 4 : 0;
+    if (lane == ADMIT_LONG)
+        return nlong > 0 ? nlong : 1;
+
+    nshort = gbl_sql_admit_short_threads;
+    if (nshort <= 0) {
+        if (maxt <= 0)
+            return INT_MAX;
+        nshort = maxt - nlong;
+    }
+    return nshort > 0 ? nshort : 1;
+}
+
+static int client_weight(const char *name)
+{
+    for (int i = 0; i < nweights; i++)
+        if (strcmp(weights[i].name, name) == 0)
+            return weights[i].weight;
+    return 1;
+}
+
+static void client_name(struct sqlclntstate *clnt, char *name)
+{
+    const char *s = NULL;
+
+    switch (gbl_sql_admit_fair_by) {
+    case SQL_ADMIT_BY_ARGV0:
+        s = clnt->argv0;
+        break;
+    case SQL_ADMIT_BY_USER:
+        s = clnt->have_user ? clnt->user : NULL;
+        break;
+    }
+    if (s == NULL)
+        s = clnt->origin ? clnt->origin : "unknown";
+    snprintf(name, ADMIT_NAME_LEN, "%s", s);
+}
+
+static void admit_work_pp(struct thdpool *pool, void *work, void *thddata,
+                          int op);
+
+/* Take the requests that fit in their lane off the queues. Called with
+ * admit_lk held; the caller hands them to the sql pool after letting go of
+ * it, since the pool calls back into us with its own lock held.
+ *
+ * The pool only ages requests from the time we hand them over, so requests
+ * that waited here longer than its maxqueueage are failed the way it would
+ * fail them. They're counted as running until admit_done sees them, but
+ * don't take a slot of the lane. */
+static void admit_pick(struct admit_lane *lane, int ln,
+                       admit_req_list *out)
+{
+    int limit = lane_limit(ln);
+    uint64_t maxage_us =
+        thdpool_get_maxqueueagems(gbl_sqlengine_thdpool) * 1000ULL;
+    uint64_t now = maxage_us ? comdb2_time_epochus() : 0;
+    int nexpired = 0;
+
+    while (lane->nqueued > 0 && lane->nrunning - nexpired < limit) {
+        struct admit_flow *f, *best = NULL;
+        struct admit_req *req;
+
+        LISTC_FOR_EACH(&lane->active, f, lnk)
+        {
+            if (best == NULL || f->queue.top->start < best->queue.top->start)
+                best = f;
+        }
+        req = listc_rtl(&best->queue);
+        if (best->queue.count == 0)
+            listc_rfl(&lane->active, best);
+        lane->nqueued--;
+        lane->nrunning++;
+        best->nrunning++;
+        lane->vtime = req->start;
+        if (maxage_us && now - req->queued_us > maxage_us) {
+            req->expired = 1;
+            lane->ntimeout++;
+            nexpired++;
+        }
+        listc_abl(out, req);
+    }
+}
+
+static void admit_dispatch(admit_req_list *reqs)
+{
+    struct admit_req *req;
+
+    while ((req = listc_rtl(reqs)) != NULL) {
+        /* the lane limits keep the pool from backing up, queue regardless */
+        if (req->expired ||
+            thdpool_enqueue(gbl_sqlengine_thdpool, admit_work_pp, req, 1,
+                            req->info)) {
+            free(req->info);
+            req->info = NULL;
+            admit_work_pp(gbl_sqlengine_thdpool, req, NULL, THD_FREE);
+        }
+    }
+}
+
+static void *admit_dispatch_thd(void *arg)
+{
+    admit_req_list *reqs = arg;
+
+    admit_dispatch(reqs);
+    free(reqs);
+    return NULL;
+}
+
+/* Dispatch from a thread of its own: we may be called with the pool locked,
+ * and thdpool_enqueue would take that lock again. */
+static void admit_dispatch_async(admit_req_list *reqs)
+{
+    admit_req_list *copy;
+    struct admit_req *req;
+    pthread_t tid;
+
+    if ((copy = malloc(sizeof(*copy))) != NULL) {
+        listc_init(copy, offsetof(struct admit_req, lnk));
+        while ((req = listc_rtl(reqs)) != NULL)
+            listc_abl(copy, req);
+        if (pthread_create(&tid, &gbl_pthread_attr_detached,
+                           admit_dispatch_thd, copy) == 0)
+            return;
+        while ((req = listc_rtl(copy)) != NULL)
+            listc_abl(reqs, req);
+        free(copy);
+    }
+
+    logmsg(LOGMSG_ERROR, "%s: can't start a thread, failing %d requests\n",
+           __func__, listc_size(reqs));
+    while ((req = listc_rtl(reqs)) != NULL) {
+        free(req->info);
+        req->info = NULL;
+        admit_work_pp(gbl_sqlengine_thdpool, req, NULL, THD_FREE);
+    }
+}
+
+/* A request left the sql pool. Charge its run time to its statement's
+ * history and let the next ones in. A request that didn't run (ran == 0)
+ * was freed by the pool, maybe with the pool locked. */
+static void admit_done(struct admit_req *req, uint64_t queue_us,
+                       uint64_t run_us, int ran)
+{
+    struct admit_flow *f = req->flow;
+    int ln = f->lane;
+    struct admit_lane *lane = &lanes[ln - 1];
+    admit_req_list next;
+
+    listc_init(&next, offsetof(struct admit_req, lnk));
+
+    pthread_mutex_lock(&admit_lk);
+    if (ran) {
+        struct admit_hist *h = &hist[req->fp % ADMIT_HIST];
+        double ms = run_us / 1000.0;
+        if (h->fp != req->fp) {
+            h->fp = req->fp;
+            h->avg_ms = ms;
+        } else {
+            h->avg_ms += (ms - h->avg_ms) / 8;
+        }
+    }
+    lane->nrunning--;
+    lane->nadmitted++;
+    lane->queue_us += queue_us;
+    if (queue_us > lane->max_queue_us)
+        lane->max_queue_us = queue_us;
+    if (--f->nrunning == 0 && f->queue.count == 0) {
+        hash_del(lane->flows, f);
+        free(f);
+    }
+    admit_pick(lane, ln, &next);
+    pthread_mutex_unlock(&admit_lk);
+
+    free(req);
+    if (ran)
+        admit_dispatch(&next);
+    else if (listc_size(&next) > 0)
+        admit_dispatch_async(&next);
+}
+
+static void admit_work_pp(struct thdpool *pool, void *work, void *thddata,
+                          int op)
+{
+    struct admit_req *req = work;
+    struct sqlclntstate *clnt = req->clnt;
+    uint64_t start;
+
+    switch (op) {
+    case THD_RUN:
+        start = comdb2_time_epochus();
+        req->work_fn(pool, clnt, thddata, THD_RUN);
+        /* clnt may be running its next request already, don't touch it */
+        admit_done(req, start - req->queued_us, comdb2_time_epochus() - start,
+                   1);
+        break;
+
+    case THD_FREE:
+        /* the waiting thread may free clnt as soon as it sees it done, so
+         * mark it done under wait_mutex and leave it alone after */
+        pthread_mutex_lock(&clnt->wait_mutex);
+        req->work_fn(pool, clnt, thddata, THD_FREE);
+        clnt->done = 1;
+        pthread_cond_signal(&clnt->wait_cond);
+        pthread_mutex_unlock(&clnt->wait_mutex);
+        admit_done(req, comdb2_time_epochus() - req->queued_us, 0, 0);
+        break;
+    }
+}
+
+/* Queue a request for the sql engine pool. Returns non-0 if it couldn't be
+ * queued, like thdpool_enqueue. */
+int sql_admit_enqueue(struct sqlclntstate *clnt, thdpool_work_fn work_fn,
+                      int queue_override, char *info)
+{
+    struct admit_req *req;
+    struct admit_flow *f;
+    struct admit_lane *lane;
+    struct admit_hist *h;
+    char name[ADMIT_NAME_LEN];
+    double cost;
+    int ln, maxqueue;
+    admit_req_list next;
+
+    pthread_once(&admit_once, admit_init);
+
+    if ((req = calloc(1, sizeof(struct admit_req))) == NULL)
+        return -1;
+    req->clnt = clnt;
+    req->work_fn = work_fn;
+    req->info = info;
+    req->fp = admit_fingerprint(clnt->sql ? clnt->sql : "");
+    req->queued_us = comdb2_time_epochus();
+    client_name(clnt, name);
+    listc_init(&next, offsetof(struct admit_req, lnk));
+
+    pthread_mutex_lock(&admit_lk);
+
+    h = &hist[req->fp % ADMIT_HIST];
+    cost = h->fp == req->fp ? h->avg_ms : 0;
+    ln = (h->fp == req->fp && cost >= gbl_sql_admit_long_ms) ? ADMIT_LONG
+                                                              : ADMIT_SHORT;
+    lane = &lanes[ln - 1];
+
+    /* same limit the pool would apply to a request that has to wait */
+    maxqueue = thdpool_get_maxqueue(gbl_sqlengine_thdpool);
+    if (!queue_override && lane->nrunning >= lane_limit(ln) &&
+        lanes[0].nqueued + lanes[1].nqueued >= maxqueue) {
+        pthread_mutex_unlock(&admit_lk);
+        free(req);
+        return -1;
+    }
+
+    f = hash_find(lane->flows, name);
+    if (f == NULL) {
+        if ((f = calloc(1, sizeof(struct admit_flow))) == NULL) {
+            pthread_mutex_unlock(&admit_lk);
+            free(req);
+            return -1;
+        }
+        strcpy(f->name, name);
+        f->lane = ln;
+        listc_init(&f->queue, offsetof(struct admit_req, lnk));
+        hash_add(lane->flows, f);
+    }
+
+    req->flow = f;
+    req->start = f->finish > lane->vtime ? f->finish : lane->vtime;
+    f->finish = req->start + (cost > 1 ? cost : 1) / client_weight(name);
+    if (f->queue.count == 0)
+        listc_abl(&lane->active, f);
+    listc_abl(&f->queue, req);
+    lane->nqueued++;
+    clnt->admit_lane = ln;
+
+    admit_pick(lane, ln, &next);
+    pthread_mutex_unlock(&admit_lk);
+
+    admit_dispatch(&next);
+    return 0;
+}
+
+/* Parse sql_admit_weights: "name:weight,name:weight..." */
+int sql_admit_set_weights(const char *value)
+{
+    struct admit_weight w[ADMIT_MAX_WEIGHTS];
+    char *copy, *tok, *last = NULL;
+    int n = 0;
+
+    if ((copy = strdup(value)) == NULL)
+        return 1;
+    for (tok = strtok_r(copy, ",", &last); tok;
+         tok = strtok_r(NULL, ",", &last)) {
+        char *colon = strrchr(tok, ':');
+        int weight;
+        if (colon == NULL || colon == tok ||
+            colon - tok >= ADMIT_NAME_LEN || n == ADMIT_MAX_WEIGHTS ||
+            (weight = atoi(colon + 1)) <= 0) {
+            logmsg(LOGMSG_ERROR, "%s: bad weight '%s'\n", __func__, tok);
+            free(copy);
+            return 1;
+        }
+        *colon = '\0';
+        strcpy(w[n].name, tok);
+        w[n].weight = weight;
+        n++;
+    }
+    free(copy);
+
+    pthread_mutex_lock(&admit_lk);
+    memcpy(weights, w, n * sizeof(struct admit_weight));
+    nweights = n;
+    pthread_mutex_unlock(&admit_lk);
+    return 0;
+}
+
+void sql_admit_stat(void)
+{
+    pthread_once(&admit_once, admit_init);
+
+    logmsg(LOGMSG_USER, "sql admission %s, by %s\n",
+           gbl_sql_admit ? "on" : "off",
+           gbl_sql_admit_fair_by == SQL_ADMIT_BY_USER
+               ? "user"
+               : gbl_sql_admit_fair_by == SQL_ADMIT_BY_HOST ? "host"
+                                                            : "argv0");
+    pthread_mutex_lock(&admit_lk);
+    for (int ln = ADMIT_SHORT; ln <= ADMIT_LONG; ln++) {
+        struct admit_lane *lane = &lanes[ln - 1];
+        struct admit_flow *f;
+
+        logmsg(LOGMSG_USER,
+               "lane %-5s limit %d running %d queued %d admitted %" PRIu64
+               " timed out %" PRIu64 " avg queue %" PRIu64
+               "ms max queue %" PRIu64 "ms\n",
+               sql_admit_lane_name(ln), lane_limit(ln), lane->nrunning,
+               lane->nqueued, lane->nadmitted, lane->ntimeout,
+               lane->nadmitted ? lane->queue_us / lane->nadmitted / 1000 : 0,
+               lane->max_queue_us / 1000);
+        LISTC_FOR_EACH(&lane->active, f, lnk)
+        {
+            logmsg(LOGMSG_USER, "  %-30s weight %d running %d queued %d\n",
+                   f->name, client_weight(f->name), f->nrunning,
+                   f->queue.count);
+        }
+    }
+    pthread_mutex_unlock(&admit_lk);
+}
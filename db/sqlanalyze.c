@@ -36,6 +36,8 @@
 #include <comdb2_atomic.h>
 #include <ctrace.h>
 #include <logmsg.h>
+#include <flibc.h>
+#include <math.h>
 
 /* amount of thread-memory initialized for this thread */
 static int analyze_thread_memory = 1048576;
@@ -47,6 +49,20 @@ static int analyze_abort_requested = 0;
 /* global enable / disable switch */
 static int sampled_tables_enabled = 1;
 
+/* collect histograms for the columns that don't lead an index */
+int gbl_analyze_histograms = 0;
+
+/* buckets per histogram */
+int gbl_analyze_hist_buckets = 32;
+
+/* rows kept to build histograms from */
+int gbl_analyze_hist_sample = 100000;
+
+/* histogram columns per table; every pair of them gets a correlation row */
+#define ANALYZE_HIST_MAX_COLS 8
+#define ANALYZE_HIST_MAX_ROWS                                                  \
+    (ANALYZE_HIST_MAX_COLS + ANALYZE_HIST_MAX_COLS * (ANALYZE_HIST_MAX_COLS - 1) / 2)
+
 /* sampling threshold defaults to 100 Mb */
 long long sampling_threshold = 104857600;
 
@@ -99,7 +115,13 @@ enum {
     TABLE_SKIPPED = 5
 };
 
-/* index-descriptor */
+/* sqlite_stat1 row with column statistics (see sqlite3ColStatFind) */
+typedef struct colstat_row {
+    char idx[64];
+    char stat[4096];
+} colstat_row_t;
+
+/* index-descriptor; ix -1 samples the data for column statistics */
 typedef struct index_descriptor {
     pthread_t thread_id;
     int comp_state;
@@ -107,6 +129,8 @@ typedef struct index_descriptor {
     struct dbtable *tbl;
     int ix;
     int sampling_pct;
+    colstat_row_t *colstats;
+    int ncolstats;
 } index_descriptor_t;
 
 /* table-descriptor */
@@ -118,6 +142,7 @@ typedef struct table_descriptor {
     int scale;
     int override_llmeta;
     index_descriptor_t index[MAXINDEX];
+    index_descriptor_t columns;
 } table_descriptor_t;
 
 /* loadStat4 (analyze.c) will ignore all stat entries
@@ -199,7 +224,12 @@ void cleanup_stats(SBUF2 *sb)
                               "delete from sqlite_stat1 where idx is null");
         run_internal_sql_clnt(&clnt, "delete from sqlite_stat1 where idx not "
                                      "in (select name from sqlite_master where "
-                                     "type='index')");
+                                     "type='index') and idx not like '#%'");
+        /* column statistics of tables that are gone */
+        run_internal_sql_clnt(&clnt, "delete from sqlite_stat1 where idx like "
+                                     "'#%' and tbl not like 'cdb2.%.sav' and "
+                                     "tbl not in (select name from "
+                                     "sqlite_master where type='table')");
     }
 
     if (get_dbtable_by_name("sqlite_stat2"))
@@ -275,6 +305,278 @@ static int sample_index_int(index_descriptor_t *ix_des)
     return 0;
 }
 
+static int cmp_double(const void *a, const void *b)
+{
+    double x = *(const double *)a, y = *(const double *)b;
+    return x < y ? -1 : x > y;
+}
+
+static int cmp_double_pair(const void *a, const void *b)
+{
+    int rc = cmp_double(a, b);
+    return rc ? rc : cmp_double((const double *)a + 1, (const double *)b + 1);
+}
+
+/* Haas & Stokes' Duj1: distinct values in nrows given a sample of n of them
+ * with d distinct values, f1 of which were seen once. */
+static double estimate_distinct(double n, double d, double f1, double nrows)
+{
+    if (n >= nrows || n == 0)
+        return d;
+    double est = n * d / (n - f1 + f1 * n / nrows);
+    return est < d ? d : est;
+}
+
+/* read a numeric ondisk field; returns 1 for null, -1 if not numeric */
+static int colstat_field(struct field *f, const uint8_t *rec, double *out)
+{
+    long long ival;
+    double dval;
+    int null = 0, outdtsz, rc;
+
+    switch (f->type) {
+    case SERVER_BINT:
+        rc = SERVER_BINT_to_CLIENT_INT(rec + f->offset, f->len, NULL, NULL,
+                                       &ival, sizeof(ival), &null, &outdtsz,
+                                       NULL, NULL);
+        *out = (double)(long long)flibc_ntohll(ival);
+        break;
+    case SERVER_UINT:
+        rc = SERVER_UINT_to_CLIENT_INT(rec + f->offset, f->len, NULL, NULL,
+                                       &ival, sizeof(ival), &null, &outdtsz,
+                                       NULL, NULL);
+        *out = (double)(long long)flibc_ntohll(ival);
+        break;
+    case SERVER_BREAL:
+        rc = SERVER_BREAL_to_CLIENT_REAL(rec + f->offset, f->len, NULL, NULL,
+                                         &dval, sizeof(dval), &null, &outdtsz,
+                                         NULL, NULL);
+        *out = flibc_ntohd(dval);
+        break;
+    default:
+        return -1;
+    }
+    if (rc == -1)
+        return -1;
+    return null ? 1 : 0;
+}
+
+/* reservoir-sample one record into rows, NAN for nulls */
+static void colstat_sample(struct schema *s, int *col, int ncols,
+                           const uint8_t *dta, double *rows, int maxrows,
+                           unsigned long long *nsampled, unsigned int *seed)
+{
+    unsigned long long slot =
+        *nsampled < maxrows ? *nsampled : rand_r(seed) % (*nsampled + 1);
+    if (slot < maxrows) {
+        for (int c = 0; c < ncols; c++) {
+            double v;
+            if (colstat_field(&s->member[col[c]], dta, &v) != 0)
+                v = NAN;
+            rows[slot * ncols + c] = v;
+        }
+    }
+    (*nsampled)++;
+}
+
+/* Sample the data of a table and build a histogram for each numeric column
+ * that doesn't lead an index (those have sqlite_stat4 samples), plus the
+ * number of distinct values of every pair of them. */
+static int sample_columns_int(index_descriptor_t *ix_des)
+{
+    struct dbtable *tbl = ix_des->tbl;
+    struct schema *s = tbl->schema;
+    int col[ANALYZE_HIST_MAX_COLS];
+    int ncols = 0;
+    int maxrows = gbl_analyze_hist_sample > 0 ? gbl_analyze_hist_sample : 1;
+    int buckets = gbl_analyze_hist_buckets;
+    unsigned int seed = (unsigned int)time(NULL);
+    int rc = 0;
+
+    if (buckets < 1)
+        buckets = 1;
+    else if (buckets > 100)
+        buckets = 100;
+
+    for (int i = 0; i < s->nmembers && ncols < ANALYZE_HIST_MAX_COLS; i++) {
+        struct field *f = &s->member[i];
+        int leads = 0;
+        if (f->type != SERVER_BINT && f->type != SERVER_UINT &&
+            f->type != SERVER_BREAL)
+            continue;
+        if (strlen(f->name) > sizeof(ix_des->colstats->idx) / 2 - 4)
+            continue;
+        for (int ix = 0; ix < tbl->nix && !leads; ix++)
+            leads = tbl->ixschema[ix]->nmembers > 0 &&
+                    tbl->ixschema[ix]->member[0].idx == i;
+        if (!leads)
+            col[ncols++] = i;
+    }
+    if (ncols == 0)
+        return 0;
+
+    /* reservoir of sampled rows, NAN for nulls */
+    double *rows = malloc(sizeof(double) * ncols * maxrows);
+    double *vals = malloc(sizeof(double) * 2 * maxrows);
+    uint8_t *dta = malloc(tbl->lrl);
+    ix_des->colstats = calloc(ANALYZE_HIST_MAX_ROWS, sizeof(colstat_row_t));
+    if (!rows || !vals || !dta || !ix_des->colstats) {
+        logmsg(LOGMSG_ERROR, "%s: out of memory\n", __func__);
+        rc = -1;
+        goto done;
+    }
+
+    struct ireq iq;
+    init_fake_ireq(thedb, &iq);
+    iq.usedb = tbl;
+
+    unsigned long long nrows = 0, nsampled = 0;
+    int n = 0;
+
+    if (ix_des->sampling_pct > 0 && ix_des->sampling_pct < 100) {
+        /* pick genids off the data pages like a sampled index, and only
+         * read those records */
+        struct temp_table *tmptbl = NULL;
+        struct temp_cursor *cur = NULL;
+        unsigned long long nkeys;
+        int bdberr, crc;
+
+        rc = bdb_summarize_table(tbl->handle, -1, ix_des->sampling_pct,
+                                 &tmptbl, &nkeys, &nrows, &bdberr);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "%s: failed to sample table '%s' data\n",
+                   __func__, tbl->tablename);
+            rc = -1;
+            goto done;
+        }
+        cur = bdb_temp_table_cursor(tbl->handle, tmptbl, NULL, &bdberr);
+        rc = cur ? bdb_temp_table_first(tbl->handle, cur, &bdberr) : -1;
+        while (rc == 0) {
+            unsigned long long genid;
+            int fndlen;
+
+            if (analyze_abort_requested || db_is_stopped())
+                break;
+            memcpy(&genid, bdb_temp_table_key(cur), sizeof(genid));
+            /* skip records deleted since the pages were read */
+            if (ix_find_by_rrn_and_genid(&iq, 2, genid, dta, &fndlen,
+                                         tbl->lrl) == IX_FND)
+                colstat_sample(s, col, ncols, dta, rows, maxrows, &nsampled,
+                               &seed);
+            rc = bdb_temp_table_next(tbl->handle, cur, &bdberr);
+        }
+        if (rc == IX_EMPTY || rc == IX_PASTEOF)
+            rc = 0;
+        else
+            rc = -1;
+        if (cur)
+            bdb_temp_table_close_cursor(tbl->handle, cur, &bdberr);
+        crc = bdb_temp_table_close(tbl->handle, tmptbl, &bdberr);
+        if (rc || crc) {
+            rc = -1;
+            goto done;
+        }
+    } else {
+        unsigned long long genid, lastgenid;
+        unsigned long long fndkey, last;
+        int rrn, lastrrn, fndlen;
+
+        rc = ix_find(&iq, -1, NULL, 0, &fndkey, &rrn, &genid, dta, &fndlen,
+                     tbl->lrl);
+        while (rc == IX_FND || rc == IX_FNDMORE) {
+            if (analyze_abort_requested || db_is_stopped()) {
+                rc = -1;
+                goto done;
+            }
+            colstat_sample(s, col, ncols, dta, rows, maxrows, &nsampled, &seed);
+            nrows++;
+
+            last = fndkey;
+            lastrrn = rrn;
+            lastgenid = genid;
+            rc = ix_next(&iq, -1, NULL, 0, &last, lastrrn, lastgenid, &fndkey,
+                         &rrn, &genid, dta, &fndlen, tbl->lrl, 0);
+        }
+    }
+    rc = 0;
+    n = nsampled < maxrows ? nsampled : maxrows;
+    if (n == 0)
+        goto done;
+
+    for (int c = 0; c < ncols; c++) {
+        colstat_row_t *r = &ix_des->colstats[ix_des->ncolstats];
+        int nv = 0, d = 0, f1 = 0, len;
+
+        for (int i = 0; i < n; i++)
+            if (!isnan(rows[i * ncols + c]))
+                vals[nv++] = rows[i * ncols + c];
+        if (nv == 0)
+            continue;
+        qsort(vals, nv, sizeof(double), cmp_double);
+        for (int i = 0, run = 1; i < nv; i++, run++) {
+            if (i == nv - 1 || vals[i + 1] != vals[i]) {
+                d++;
+                f1 += run == 1;
+                run = 0;
+            }
+        }
+
+        double nonnull = (double)nrows * nv / n;
+        snprintf(r->idx, sizeof(r->idx), "#H:%s", s->member[col[c]].name);
+        len = snprintf(r->stat, sizeof(r->stat), "%llu %.0f %.0f", nrows,
+                       nrows - nonnull,
+                       estimate_distinct(nv, d, f1, nonnull));
+        int nb = buckets < nv ? buckets : nv - 1;
+        for (int b = 0; b <= nb; b++)
+            len += snprintf(r->stat + len, sizeof(r->stat) - len, " %.17g",
+                            vals[nb ? (long long)b * (nv - 1) / nb : 0]);
+        ix_des->ncolstats++;
+    }
+
+    for (int a = 0; a < ncols; a++) {
+        for (int b = a + 1; b < ncols; b++) {
+            colstat_row_t *r = &ix_des->colstats[ix_des->ncolstats];
+            int nv = 0, d = 0, f1 = 0;
+
+            for (int i = 0; i < n; i++) {
+                double x = rows[i * ncols + a], y = rows[i * ncols + b];
+                if (isnan(x) || isnan(y))
+                    continue;
+                vals[2 * nv] = x;
+                vals[2 * nv + 1] = y;
+                nv++;
+            }
+            if (nv == 0)
+                continue;
+            qsort(vals, nv, 2 * sizeof(double), cmp_double_pair);
+            for (int i = 0, run = 1; i < nv; i++, run++) {
+                if (i == nv - 1 || cmp_double_pair(&vals[2 * i],
+                                                   &vals[2 * i + 2]) != 0) {
+                    d++;
+                    f1 += run == 1;
+                    run = 0;
+                }
+            }
+            snprintf(r->idx, sizeof(r->idx), "#C:%s,%s",
+                     s->member[col[a]].name, s->member[col[b]].name);
+            snprintf(r->stat, sizeof(r->stat), "%llu %.0f", nrows,
+                     estimate_distinct(nv, d, f1, (double)nrows * nv / n));
+            ix_des->ncolstats++;
+        }
+    }
+
+done:
+    free(rows);
+    free(vals);
+    free(dta);
+    if (rc) {
+        free(ix_des->colstats);
+        ix_des->colstats = NULL;
+        ix_des->ncolstats = 0;
+    }
+    return rc;
+}
+
 /* spawn a thread to sample an index */
 static void *sampling_thread(void *arg)
 {
@@ -288,8 +590,11 @@ static void *sampling_thread(void *arg)
     /* update state */
     ix_des->comp_state = SAMPLING_RUNNING;
 
-    /* sample the index */
-    rc = sample_index_int(ix_des);
+    /* sample the index, or the data for column statistics */
+    if (ix_des->ix < 0)
+        rc = sample_columns_int(ix_des);
+    else
+        rc = sample_index_int(ix_des);
 
     /* mark the return */
     if (0 == rc) {
@@ -797,11 +1102,42 @@ static int analyze_table_int(table_descriptor_t *td,
         }
     }
 
+    /* sample the data for column statistics while sqlite does the indexes */
+    index_descriptor_t *cols = &td->columns;
+    int sampled_columns = 0;
+    if (gbl_analyze_histograms) {
+        cols->comp_state = SAMPLING_STARTUP;
+        cols->tbl = tbl;
+        cols->ix = -1;
+        cols->sampling_pct = td->scale;
+        sampled_columns = dispatch_sample_index_thread(cols) == 0;
+    }
+
     clnt.is_analyze = 1;
 
     /* run analyze as sql query */
     snprintf(sql, sizeof(sql), "analyzesqlite main.\"%s\"", td->table);
     rc = run_internal_sql_clnt(&clnt, sql);
+
+    if (sampled_columns) {
+        wait_for_index(cols);
+        for (int i = 0; rc == 0 && cols->comp_state == SAMPLING_COMPLETE &&
+                        i < cols->ncolstats;
+             i++) {
+            char *ins = sqlite3_mprintf("insert into sqlite_stat1(tbl, idx, "
+                                        "stat) values(%Q, %Q, %Q)",
+                                        td->table, cols->colstats[i].idx,
+                                        cols->colstats[i].stat);
+            rc = run_internal_sql_clnt(&clnt, ins);
+            sqlite3_free(ins);
+            if (rc)
+                snprintf(sql, sizeof(sql), "insert %s",
+                         cols->colstats[i].idx);
+        }
+        free(cols->colstats);
+        cols->colstats = NULL;
+        cols->ncolstats = 0;
+    }
     clnt.is_analyze = 0;
     if (rc)
         goto error;
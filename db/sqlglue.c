@@ -93,6 +93,7 @@
 #include <thread_malloc.h>
 #include "fdb_fend.h"
 #include "fdb_access.h"
+#include "fdb_bend_sql.h"
 #include "bdb_osqlcur.h"
 
 #include "debug_switches.h"
@@ -136,6 +137,7 @@ extern int sqldbgflag;
 extern int gbl_notimeouts;
 extern int gbl_move_deadlk_max_attempt;
 extern int gbl_fdb_track;
+extern int gbl_fdb_stream_flush_ms;
 extern int gbl_selectv_rangechk;
 extern volatile int gbl_schema_change_in_progress;
 
@@ -526,6 +528,11 @@ int get_calls_per_sec(void) { return calls_per_second; }
 
 void reset_calls_per_sec(void) { calls_per_second = 0; }
 
+/* Memory a statement may use, and how much before sorts and hashes spill to
+ * disk (0 is half the limit), in MB */
+int gbl_query_mem_limit_mb = 0;
+int gbl_query_mem_spill_mb = 0;
+
 /*
    This is called every time the db does something (find/next/etc. on a cursor).
    The query is aborted if this returns non-zero.
@@ -550,11 +557,21 @@ static int sql_tick(struct sql_thread *thd, int uses_bdb_locking)
     if (clnt->statement_timedout)
         return SQLITE_LIMIT;
 
+    /* streaming rows to a remote requester: don't let the ones already
+       found sit in the buffer while this cursor looks for more */
+    if (clnt->fdb_state.stream_unflushed &&
+        comdb2_time_epochms() - clnt->fdb_state.stream_flush_ms >=
+            gbl_fdb_stream_flush_ms)
+        fdb_svc_sql_flush(clnt);
+
     if (uses_bdb_locking && bdb_lock_desired(thedb->bdb_env)) {
         int sleepms;
 
         logmsg(LOGMSG_WARN, "bdb_lock_desired so calling recover_deadlock\n");
 
+        /* we may sleep below; ship what is already found first */
+        fdb_svc_sql_flush(clnt);
+
         /* scale by number of times we try, cap at 10 seconds */
         sleepms = 100 * clnt->deadlock_recovered;
         if (sleepms > 10000)
@@ -584,6 +601,12 @@ static int sql_tick(struct sql_thread *thd, int uses_bdb_locking)
         /* TODO: we need a nice way to set sqlite3_errmsg() */
         return SQLITE_LIMIT;
 
+    if (gbl_query_mem_limit_mb > 0 &&
+        thd->mem.used > gbl_query_mem_limit_mb * 1024LL * 1024) {
+        clnt->mem_limit_hit = 1;
+        return SQLITE_LIMIT;
+    }
+
     return 0;
 }
 
@@ -2801,6 +2824,54 @@ static int cursor_move_remote(BtCursor *pCur, int *pRes, int how)
     return SQLITE_OK;
 }
 
+extern int gbl_fdb_push_count;
+
+/* count(*) on this remote table runs in the remote db; explainSimpleCount
+   asks the same question to report it */
+int fdb_push_count_table(const char *tblname)
+{
+    return gbl_fdb_push_count && !is_sqlite_stat(tblname);
+}
+
+/* Push count(*) to the remote db instead of streaming every row back and
+   counting it here; the trailing blob is a dummy genid that the remote
+   sql backend expects at the end of each row */
+static int cursor_count_remote(BtCursor *pCur, i64 *count)
+{
+    char sql[MAXTABLELEN + 64];
+    int res = 0;
+    int rc;
+
+    snprintf(sql, sizeof(sql),
+             "SELECT count(*), x'0000000000000000' FROM \"%s\"",
+             pCur->fdbc->tblname(pCur));
+
+    if (pCur->fdbc->set_sql(pCur, sql)) {
+        /* served from a local copy of the table, count the rows here */
+        *count = 0;
+        for (rc = cursor_move_remote(pCur, &res, CFIRST); !rc && !res;
+             rc = cursor_move_remote(pCur, &res, CNEXT))
+            (*count)++;
+        return rc;
+    }
+    rc = cursor_move_remote(pCur, &res, CFIRST);
+    pCur->fdbc->set_sql(pCur, NULL);
+    if (rc)
+        return rc;
+
+    if (res) {
+        *count = 0;
+        return SQLITE_OK;
+    }
+
+    *count = fdb_packedsqlite_extract_int(
+        (pCur->ixnum == -1) ? pCur->dtabuf : pCur->keybuf);
+
+    /* the count row is not a row of the table; leave the cursor empty */
+    pCur->empty = 1;
+    return SQLITE_OK;
+}
+
 static inline int sqlite3VdbeCompareRecordPacked(KeyInfo *pKeyInfo, int k1len,
                                                  const void *key1, int k2len,
                                                  const void *key2)
@@ -6336,6 +6407,55 @@ int is_datacopy(BtCursor *pCur, int *fnum)
     return 0;
 }
 
+/* When a blob or vutf8 column is only needed by length() or typeof()
+ * (opflags has OPFLAG_LENGTHARG or OPFLAG_TYPEOFARG), answer from the length
+ * stored in the record instead of fetching the blob. Returns 0 if m was
+ * filled in, 1 if the caller has to get the column normally. */
+int get_data_length_only(BtCursor *pCur, struct schema *sc, uint8_t *in,
+                         int fnum, Mem *m, int opflags)
+{
+    struct field *f = &(sc->member[fnum]);
+    int len;
+
+    if ((opflags & (OPFLAG_LENGTHARG | OPFLAG_TYPEOFARG)) == 0)
+        return 1;
+    if (f->flags & INDEX_DESCEND)
+        return 1;
+
+    switch (f->type) {
+    case SERVER_BLOB:
+    case SERVER_BLOB2:
+    case SERVER_VUTF8:
+        break;
+    default:
+        return 1;
+    }
+
+    in += f->offset;
+    if (stype_is_null(in))
+        return 1;
+
+    memcpy(&len, &in[1], 4);
+    len = ntohl(len);
+
+    if (f->type == SERVER_VUTF8) {
+        /* length() of a string counts characters, so it needs the content */
+        if ((opflags & OPFLAG_TYPEOFARG) == 0)
+            return 1;
+        m->z = "";
+        m->n = 0;
+        m->flags = MEM_Str | MEM_Static | MEM_Term;
+        return 0;
+    }
+
+    /* a zero-filled blob of the right length, without the bytes */
+    m->z = NULL;
+    m->n = 0;
+    m->u.nZero = (len > 0) ? len : 0;
+    m->flags = MEM_Blob | MEM_Zero;
+    return 0;
+}
+
 int get_data(BtCursor *pCur, struct schema *sc, uint8_t *in, int fnum, Mem *m,
              uint8_t flip_orig, const char *tzname)
 {
@@ -7529,6 +7649,11 @@ sqlite3BtreeCursor_remote(Btree *pBt,      /* The btree */
         return SQLITE_ERROR;
     }
 
+    if (cur->fdbc->table_entry(cur) &&
+        fdb_push_count_table(
+            fdb_table_entry_tblname(cur->fdbc->table_entry(cur))))
+        cur->cursor_count = cursor_count_remote;
+
     if (gbl_fdb_track) {
         if (cur->fdbc->isuuid(cur)) {
             uuidstr_t cus, tus;
@@ -8698,6 +8823,54 @@ void sql_dump_running_statements(void)
     pthread_mutex_unlock(&gbl_sql_lock);
 }
 
+/* Snapshot of the memory used by running statements for
+ * comdb2_query_memory */
+int query_mem_stats(struct query_mem_stat **stats, int *nstats)
+{
+    struct sql_thread *thd;
+    int n = 0, i = 0;
+
+    pthread_mutex_lock(&gbl_sql_lock);
+    LISTC_FOR_EACH(&thedb->sql_threads, thd, lnk) { n++; }
+
+    *stats = calloc(n ? n : 1, sizeof(struct query_mem_stat));
+    if (*stats == NULL) {
+        pthread_mutex_unlock(&gbl_sql_lock);
+        return -1;
+    }
+    LISTC_FOR_EACH(&thedb->sql_threads, thd, lnk)
+    {
+        struct query_mem_stat *s = &(*stats)[i];
+        pthread_mutex_lock(&thd->lk);
+        if (thd->clnt && thd->clnt->sql) {
+            s->id = thd->id;
+            s->origin = strdup(thd->clnt->origin ? thd->clnt->origin : "");
+            s->sql = strdup(thd->clnt->sql);
+            s->used = thd->mem.used;
+            s->peak = thd->mem.peak;
+            s->limit = gbl_query_mem_limit_mb * 1024LL * 1024;
+            s->spills = thd->mem.nspills;
+            s->connection_peak = thd->clnt->mem_peak > thd->mem.peak
+                                     ? thd->clnt->mem_peak
+                                     : thd->mem.peak;
+            i++;
+        }
+        pthread_mutex_unlock(&thd->lk);
+    }
+    pthread_mutex_unlock(&gbl_sql_lock);
+    *nstats = i;
+    return 0;
+}
+
+void query_mem_stats_free(struct query_mem_stat *stats, int nstats)
+{
+    for (int i = 0; i < nstats; i++) {
+        free(stats[i].origin);
+        free(stats[i].sql);
+    }
+    free(stats);
+}
+
 /*
  ** Obtain a lock on the table whose root page is iTab.  The
  ** lock is a write lock if isWritelock is true or a read lock
@@ -10954,6 +11127,21 @@ int fdb_packedsqlite_extract_genid(char *key, int *outlen, char *outbuf)
     return 0;
 }
 
+/* first field of a packed sqlite row, as an integer */
+long long fdb_packedsqlite_extract_int(char *row)
+{
+    int hdroffset = 0;
+    unsigned int hdrsz;
+    unsigned int type = 0;
+    Mem m;
+
+    hdroffset = sqlite3GetVarint32((unsigned char *)row, &hdrsz);
+    sqlite3GetVarint32((unsigned char *)row + hdroffset, &type);
+    sqlite3VdbeSerialGet((unsigned char *)row + hdrsz, type, &m);
+
+    return (type >= 1 && type <= 9 && type != 7) ? m.u.i : 0;
+}
+
 /*TODO: all fields extracting for debugging; we only need name and rootpage, so
 shrink
 once tested */
@@ -149,6 +149,8 @@ extern int gbl_dump_sql_dispatched; /* dump all sql strings dispatched */
 int gbl_dump_fsql_response = 0;
 extern int gbl_time_osql; /* dump timestamps for osql steps */
 extern int gbl_time_fdb;  /* dump timestamps for remote sql */
+extern int gbl_fdb_stream_batch_rows;
+extern int gbl_fdb_stream_flush_ms;
 extern int gbl_print_syntax_err;
 extern int gbl_max_sqlcache;
 extern int gbl_track_sqlengine_states;
@@ -774,6 +776,27 @@ void clear_snapshot_info(struct sqlclntstate *clnt, const char *func, int line)
     clnt->is_hasql_retry = 0;
 }
 
+int gbl_read_your_writes_timeout_ms = 5000;
+
+/* Wait for this node to apply a commit the client made, on any node, before
+   running its next query.  Returns non-zero if that takes longer than
+   read_your_writes_timeout_ms, so the client can go to another node. */
+int wait_for_read_after_lsn(struct sqlclntstate *clnt, int file, int offset)
+{
+    unsigned int curfile, curoffset;
+
+    if (gbl_read_your_writes_timeout_ms <= 0 || file <= 0)
+        return 0;
+    if (bdb_wait_for_commit_lsn(thedb->bdb_env, file, offset,
+                                gbl_read_your_writes_timeout_ms) == 0)
+        return 0;
+    bdb_get_current_lsn(thedb->bdb_env, &curfile, &curoffset);
+    logmsg(LOGMSG_WARN, "%s: at [%u][%u] after %d ms, client wants [%d][%d]\n",
+           __func__, curfile, curoffset, gbl_read_your_writes_timeout_ms, file,
+           offset);
+    return -1;
+}
+
 static void update_snapshot_info(struct sqlclntstate *clnt)
 {
     int epoch = 0;
@@ -916,9 +939,15 @@ static void log_queue_time(struct reqlogger *logger, struct sqlclntstate *clnt)
 {
     if (!gbl_track_queue_time)
         return;
-    if (clnt->deque_timeus > clnt->enque_timeus)
-        reqlog_logf(logger, REQL_INFO, "queuetime took %dms",
-                    U2M(clnt->deque_timeus - clnt->enque_timeus));
+    if (clnt->deque_timeus > clnt->enque_timeus) {
+        if (clnt->admit_lane)
+            reqlog_logf(logger, REQL_INFO, "queuetime took %dms lane %s",
+                        U2M(clnt->deque_timeus - clnt->enque_timeus),
+                        sql_admit_lane_name(clnt->admit_lane));
+        else
+            reqlog_logf(logger, REQL_INFO, "queuetime took %dms",
+                        U2M(clnt->deque_timeus - clnt->enque_timeus));
+    }
     reqlog_set_queue_time(logger, clnt->deque_timeus - clnt->enque_timeus);
 }
 
@@ -3866,6 +3895,15 @@ void sqlengine_work_appsock(void *thddata, void *work)
     /* assign this query a unique id */
     sql_get_query_id(sqlthd);
 
+    /* charge what the statement allocates to it */
+    bzero(&sqlthd->mem, sizeof(sqlthd->mem));
+    if (gbl_query_mem_spill_mb > 0)
+        sqlthd->mem.spill = gbl_query_mem_spill_mb * 1024LL * 1024;
+    else
+        sqlthd->mem.spill = gbl_query_mem_limit_mb * 1024LL * 1024 / 2;
+    clnt->mem_limit_hit = 0;
+    comdb2ma_account(&sqlthd->mem);
+
     /* actually execute the query */
     thrman_setfd(thd->thr_self, sbuf2fileno(clnt->sb));
 
@@ -3884,6 +3922,9 @@ void sqlengine_work_appsock(void *thddata, void *work)
     }
 
     osql_shadtbl_done_query(thedb->bdb_env, clnt);
+    comdb2ma_account(NULL);
+    if (sqlthd->mem.peak > clnt->mem_peak)
+        clnt->mem_peak = sqlthd->mem.peak;
     thrman_setfd(thd->thr_self, -1);
     sql_reset_sqlthread(thd->sqldb, sqlthd);
     /* this is a compromise; we release the curtran here, even though
@@ -3994,9 +4035,19 @@ int dispatch_sql_query(struct sqlclntstate *clnt)
     clnt->enque_timeus = comdb2_time_epochus();
 
     sqlcpy = strdup(msg);
-    if ((rc = thdpool_enqueue(gbl_sqlengine_thdpool, sqlengine_work_appsock_pp,
-                              clnt, (clnt->req.flags & SQLF_QUEUE_ME) ? 1 : 0,
-                              sqlcpy)) != 0) {
+    clnt->admit_lane = 0;
+    /* statements of a client transaction and retries may hold locks, don't
+     * hold them back */
+    if (gbl_sql_admit && !clnt->in_client_trans &&
+        clnt->osql.replay == OSQL_RETRY_NONE && !clnt->exec_lua_thread)
+        rc = sql_admit_enqueue(clnt, sqlengine_work_appsock_pp,
+                               (clnt->req.flags & SQLF_QUEUE_ME) ? 1 : 0,
+                               sqlcpy);
+    else
+        rc = thdpool_enqueue(gbl_sqlengine_thdpool, sqlengine_work_appsock_pp,
+                             clnt, (clnt->req.flags & SQLF_QUEUE_ME) ? 1 : 0,
+                             sqlcpy);
+    if (rc != 0) {
         if ((clnt->in_client_trans || clnt->osql.replay == OSQL_RETRY_DO) &&
             gbl_requeue_on_tran_dispatch) {
             /* force this request to queue */
@@ -4363,6 +4414,9 @@ void reset_clnt(struct sqlclntstate *clnt, SBUF2 *sb, int initial)
     clnt->file = 0;
     clnt->offset = 0;
     clnt->enque_timeus = clnt->deque_timeus = 0;
+    clnt->admit_lane = 0;
+    clnt->mem_peak = 0;
+    clnt->mem_limit_hit = 0;
     reset_clnt_flags(clnt);
 
     clnt->ins_keys = 0ULL;
@@ -4865,7 +4919,7 @@ static int execute_sql_query_offload_inner_loop(struct sqlclntstate *clnt,
     char *cid;
     int rc = 0;
     int tmp;
-    int sent;
+    int sent; /* 1 once a row is held back, 2 once one was streamed */
 
     if (!clnt->fdb_state.remote_sql_sb) {
         while ((ret = sqlite3_step(stmt)) == SQLITE_ROW)
@@ -4879,6 +4933,8 @@ static int execute_sql_query_offload_inner_loop(struct sqlclntstate *clnt,
             cid = (char *)&clnt->osql.rqid;
 
         sent = 0;
+        clnt->fdb_state.stream_unflushed = 0;
+        clnt->fdb_state.stream_flush_ms = comdb2_time_epochms();
         while (1) {
             /* NOTE: in the recom and serial mode, the cursors look at the
             shared shadow_tran
@@ -4903,10 +4959,26 @@ static int execute_sql_query_offload_inner_loop(struct sqlclntstate *clnt,
             }
 
             if (res.z) {
+                /* stream rows ahead of the remote cursor, flushing them in
+                   batches instead of paying a write for each row; the
+                   socket buffers bound how far ahead we can run.  The first
+                   row goes out right away so the requester can start, and
+                   sql_tick flushes whatever is buffered if the cursor stalls
+                   past the deadline looking for the next one */
+                int flush = 0;
+                if (sent == 1 ||
+                    ++clnt->fdb_state.stream_unflushed >=
+                        gbl_fdb_stream_batch_rows ||
+                    comdb2_time_epochms() - clnt->fdb_state.stream_flush_ms >=
+                        gbl_fdb_stream_flush_ms) {
+                    flush = 1;
+                }
+
                 /* now we have the packed sqlite row in Mem->z */
                 rc = fdb_svc_sql_row(clnt->fdb_state.remote_sql_sb, cid, res.z,
                                      res.n, IX_FNDMORE,
-                                     clnt->osql.rqid == OSQL_RQID_USE_UUID);
+                                     clnt->osql.rqid == OSQL_RQID_USE_UUID,
+                                     flush);
                 if (rc) {
                     /*
                     fprintf(stderr, "%s: failed to send back sql row\n",
@@ -4914,6 +4986,11 @@ static int execute_sql_query_offload_inner_loop(struct sqlclntstate *clnt,
                     */
                     break;
                 }
+                if (flush) {
+                    clnt->fdb_state.stream_unflushed = 0;
+                    clnt->fdb_state.stream_flush_ms = comdb2_time_epochms();
+                }
+                sent = 2;
             }
 
             bzero(&upr, sizeof(upr));
@@ -4938,19 +5015,21 @@ static int execute_sql_query_offload_inner_loop(struct sqlclntstate *clnt,
             }
 
             sqlite3VdbeRecordPack(&upr, &res);
-            sent = 1;
+            if (!sent)
+                sent = 1;
         }
 
         /* send the last row, marking flag as such */
+        clnt->fdb_state.stream_unflushed = 0;
         if (!rc) {
-            if (sent == 1) {
+            if (sent) {
                 rc = fdb_svc_sql_row(clnt->fdb_state.remote_sql_sb, cid, res.z,
                                      res.n, IX_FND,
-                                     clnt->osql.rqid == OSQL_RQID_USE_UUID);
+                                     clnt->osql.rqid == OSQL_RQID_USE_UUID, 1);
             } else {
                 rc = fdb_svc_sql_row(clnt->fdb_state.remote_sql_sb, cid, res.z,
                                      res.n, IX_EMPTY,
-                                     clnt->osql.rqid == OSQL_RQID_USE_UUID);
+                                     clnt->osql.rqid == OSQL_RQID_USE_UUID, 1);
             }
             if (rc) {
                 /*
@@ -5126,7 +5205,10 @@ int sql_check_errors(struct sqlclntstate *clnt, sqlite3 *sqldb,
         break;
 
     case SQLITE_LIMIT:
-        *errstr = "Query exceeded set limits";
+        if (clnt->mem_limit_hit)
+            *errstr = "Query exceeded its memory limit";
+        else
+            *errstr = "Query exceeded set limits";
         break;
 
     case SQLITE_ACCESS:
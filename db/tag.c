@@ -56,6 +56,7 @@
 
 #include "utilmisc.h"
 #include "views.h"
+#include "autoanalyze.h"
 #include "debug_switches.h"
 #include "logmsg.h"
 
@@ -1579,6 +1580,9 @@ static int create_key_schema(struct dbtable *db, struct schema *schema, int alt)
         if (dyns_is_idx_datacopy(ix))
             s->flags |= SCHEMA_DATACOPY;
 
+        if (dyns_is_idx_hash(ix))
+            s->flags |= SCHEMA_HASH;
+
         s->nix = 0;
         s->ix = NULL;
         s->ixnum = ix;
@@ -6715,6 +6719,12 @@ void set_bdb_option_flags(struct dbtable *db, int odh, int ipu, int isc, int ver
     bdb_set_csc2_version(handle, ver);
     bdb_set_datacopy_odh(handle, datacopy_odh);
     bdb_set_key_compression(handle);
+    for (int ix = 0; ix < db->nix; ix++) {
+        bdb_handle_dbp_ix_hash(handle, ix,
+                               (db->ixschema[ix]->flags & SCHEMA_HASH)
+                                   ? gbl_ix_hash_size_kb
+                                   : 0);
+    }
 }
 
 /* Compute map of dbstores used in vtag_to_ondisk */
@@ -6936,6 +6946,7 @@ void freedb_int(struct dbtable *db, struct dbtable *replace)
     free(db->ixschema);
     if (db->sc_genids)
         free(db->sc_genids);
+    incr_stats_free(db);
 
     if (db->instant_schema_change) {
         for (i = 0; i < sizeof db->dbstore / sizeof db->dbstore[0]; ++i) {
@@ -93,6 +93,8 @@ enum {
     ,
     SCHEMA_DYNAMIC = 16,
     SCHEMA_DATACOPY = 32 /* datacopy flag set on index */
+    ,
+    SCHEMA_HASH = 64 /* hash flag set on index */
 };
 
 /* sql_record_member.flags */
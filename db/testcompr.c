@@ -17,6 +17,8 @@
 /*
 ** Estimate the amount of compression that can be achieved. We sample records
 ** from the main data file & blobs and compress them using both zlib and rle*.
+** Every compressed sample is also decompressed, to time what it costs to read
+** it back.
 **
 ** send dbname testcompr: print percent of records which will be sampled.
 ** send dbname testcompr NN: Set percent of records which will be sampled.
@@ -26,6 +28,14 @@
 ** then, only clre compression in performed. Additionally, the compressed
 ** record is decompressed and compared with the original record.
 **
+** The same sampling is used by the compression advisor. Every
+** compr_advisor_interval seconds (off by default) it samples every table,
+** picks the cheapest algorithm for data and blobs (size, plus decode time
+** scaled by compr_advisor_cpu_weight) and publishes the numbers in
+** comdb2_compression_stats. With compr_advisor_autoswitch on, the master
+** also switches the table to the recommended algorithm. That only affects
+** new writes: the ODH records the algorithm of every row, so old and new
+** rows can be read side by side.
 */
 
 #include <stdio.h>
@@ -46,6 +56,7 @@
 #include <comdb2rle.h>
 #include <lz4.h>
 #include <logmsg.h>
+#include <bbhrtime.h>
 
 #if LZ4_VERSION_NUMBER < 10701
 #define LZ4_compress_default LZ4_compress_limitedOutput
@@ -55,8 +66,19 @@
 int gbl_testcompr_percent = 10;
 int gbl_testcompr_max = 300000;
 
+int gbl_compr_advisor_interval = 0;
+int gbl_compr_advisor_autoswitch = 0;
+int gbl_compr_advisor_max = 10000;
+int gbl_compr_advisor_cpu_weight = 1;
+int gbl_compr_advisor_min_gain = 5;
+
 static const size_t genidsz = sizeof(unsigned long long);
 
+/* Indexed by BDB_COMPRESS_* */
+#define NUM_COMPR_ALGOS (BDB_COMPRESS_LZ4 + 1)
+static const char *algo_names[NUM_COMPR_ALGOS] = {"none", "zlib", "rle8",
+                                                  "crle", "lz4"};
+
 typedef struct {
     SBUF2 *sb;
     const char *table;
@@ -66,6 +88,8 @@ typedef struct {
 typedef struct {
     uint64_t dtasz;
     uint64_t blobsz;
+    uint64_t dtans;  /* nanoseconds spent decompressing data */
+    uint64_t blobns; /* nanoseconds spent decompressing blobs */
 } SizeEst;
 
 typedef struct {
@@ -82,9 +106,72 @@ typedef struct {
     SizeEst zlib;
     SizeEst crle;
     SizeEst lz4;
+    int nsampled;
     char just_crle;
+    char yield_schema_lk; /* caller holds the schema lock; let it go now and
+                             then */
 } CompStruct;
 
+/* records the advisor samples between letting go of the schema lock */
+#define COMPR_ADVISOR_BATCH 100
+
+static SizeEst *compr_est(CompStruct *comp, int alg)
+{
+    switch (alg) {
+    case BDB_COMPRESS_ZLIB:
+        return &comp->zlib;
+    case BDB_COMPRESS_RLE8:
+        return &comp->rle;
+    case BDB_COMPRESS_CRLE:
+        return &comp->crle;
+    case BDB_COMPRESS_LZ4:
+        return &comp->lz4;
+    default:
+        return NULL;
+    }
+}
+
+/* Decompress 'in' back into the len bytes at 'out', the way the read path
+ * does, and return how long it took in nanoseconds. */
+static uint64_t decode_ns(int alg, const void *in, size_t inlen, void *out,
+                          size_t len)
+{
+    bbhrtime_t start, end;
+    int rc = -1;
+
+    getbbhrtime(&start);
+    switch (alg) {
+    case BDB_COMPRESS_ZLIB: {
+        uLongf destLen = (uLongf)len;
+        rc = uncompress((Bytef *)out, &destLen, (const Bytef *)in,
+                        (uLong)inlen) != Z_OK || destLen != len;
+        break;
+    }
+    case BDB_COMPRESS_RLE8:
+        rc = rle8_decompress(in, inlen, out, len) != len;
+        break;
+    case BDB_COMPRESS_CRLE: {
+        Comdb2RLE d = {.in = (uint8_t *)in,
+                       .insz = inlen,
+                       .out = (uint8_t *)out,
+                       .outsz = len};
+        rc = decompressComdb2RLE(&d) || d.outsz != len;
+        break;
+    }
+    case BDB_COMPRESS_LZ4:
+        /* same as odh.c */
+        rc = LZ4_decompress_fast(in, out, len) != inlen;
+        break;
+    }
+    getbbhrtime(&end);
+
+    if (rc) {
+        logmsg(LOGMSG_ERROR, "unable to decompress %s\n", algo_names[alg]);
+        return 0;
+    }
+    return diff_bbhrtime(&end, &start);
+}
+
 static int blob_compress(CompStruct *comp)
 {
     struct dbtable *db = comp->db;
@@ -98,6 +185,7 @@ static int blob_compress(CompStruct *comp)
     char *rledta;
     char *zlibdta;
     char *lz4dta;
+    char *dbuf;
 
     for (i = 0; i < numblobs; ++i) {
         if (comp->blob_len[i] == 0)
@@ -110,9 +198,13 @@ static int blob_compress(CompStruct *comp)
         void *mallocdta = NULL;
         if (len < 4 * 1024) {
             lz4dta = crledta = rledta = zlibdta = alloca(len);
+            dbuf = alloca(len);
         } else {
-            lz4dta = crledta = rledta = zlibdta = mallocdta = malloc(len);
+            lz4dta = crledta = rledta = zlibdta = mallocdta = malloc(2 * len);
+            dbuf = mallocdta ? zlibdta + len : NULL;
         }
+        if (dbuf == NULL)
+            goto out;
 
         /* Comdb2 RLE */
         Comdb2RLE compress = {
@@ -123,6 +215,8 @@ static int blob_compress(CompStruct *comp)
         };
         if (compressComdb2RLE(&compress) == 0) {
             comp->crle.blobsz += compress.outsz;
+            comp->crle.blobns += decode_ns(BDB_COMPRESS_CRLE, crledta,
+                                           compress.outsz, dbuf, len);
         } else {
             comp->crle.blobsz += comp->blob_len[i];
         }
@@ -135,6 +229,8 @@ static int blob_compress(CompStruct *comp)
             rle8_compress(comp->blob_ptrs[i], comp->blob_len[i], rledta, len);
         if (rlesz > 0) {
             comp->rle.blobsz += rlesz;
+            comp->rle.blobns +=
+                decode_ns(BDB_COMPRESS_RLE8, rledta, rlesz, dbuf, len);
         } else { /* No RLE compression for this blob */
             comp->rle.blobsz += comp->blob_len[i];
         }
@@ -147,6 +243,8 @@ static int blob_compress(CompStruct *comp)
         rc = compress2(dest, &destLen, source, sourceLen, 6);
         if (rc == Z_OK) {
             comp->zlib.blobsz += destLen;
+            comp->zlib.blobns +=
+                decode_ns(BDB_COMPRESS_ZLIB, zlibdta, destLen, dbuf, len);
         } else { /* No zlib compression for this blob */
             comp->zlib.blobsz += comp->blob_len[i];
         }
@@ -157,6 +255,8 @@ static int blob_compress(CompStruct *comp)
             comp->lz4.blobsz += comp->blob_len[i];
         } else {
             comp->lz4.blobsz += rc;
+            comp->lz4.blobns +=
+                decode_ns(BDB_COMPRESS_LZ4, lz4dta, rc, dbuf, len);
         }
 
     out:
@@ -171,9 +271,11 @@ static int test_compress(CompStruct *comp)
 {
     int rc = 0;
     char buf[2 * MAXLRL];
+    char dbuf[MAXLRL];
 
     /* Uncompressed */
     comp->uncompressed.dtasz += comp->fndlen;
+    ++comp->nsampled;
 
     /* Comdb2 RLE */
     Comdb2RLE compress = {
@@ -197,6 +299,8 @@ static int test_compress(CompStruct *comp)
                 fsnapf(stdout, compress.in, compress.insz);
             }
         }
+        comp->crle.dtans += decode_ns(BDB_COMPRESS_CRLE, buf, compress.outsz,
+                                      dbuf, comp->fndlen);
     } else { /* No CRLE compression for this record */
         comp->crle.dtasz += comp->fndlen;
     }
@@ -208,6 +312,8 @@ static int test_compress(CompStruct *comp)
     int rlesz = rle8_compress(comp->fnddta, comp->fndlen, buf, comp->fndlen);
     if (rlesz > 0) {
         comp->rle.dtasz += rlesz;
+        comp->rle.dtans +=
+            decode_ns(BDB_COMPRESS_RLE8, buf, rlesz, dbuf, comp->fndlen);
     } else { /* No RLE compression for this record */
         comp->rle.dtasz += comp->fndlen;
     }
@@ -220,6 +326,8 @@ static int test_compress(CompStruct *comp)
     rc = compress2(dest, &destLen, source, sourceLen, 6);
     if (rc == Z_OK) {
         comp->zlib.dtasz += destLen;
+        comp->zlib.dtans +=
+            decode_ns(BDB_COMPRESS_ZLIB, buf, destLen, dbuf, comp->fndlen);
     } else { /* No zlib compression for this record */
         comp->zlib.dtasz += comp->fndlen;
     }
@@ -230,6 +338,8 @@ static int test_compress(CompStruct *comp)
         comp->lz4.dtasz += comp->fndlen;
     } else {
         comp->lz4.dtasz += rc;
+        comp->lz4.dtans +=
+            decode_ns(BDB_COMPRESS_LZ4, buf, rc, dbuf, comp->fndlen);
     }
 
 blob:
@@ -240,6 +350,12 @@ blob:
     return rc;
 }
 
+/* Decode cost in nanoseconds per byte of uncompressed data */
+static double decode_ns_per_byte(uint64_t ns, uint64_t orig)
+{
+    return orig ? (double)ns / orig : 0;
+}
+
 static void print_compr_stat(CompStruct *comp, const char *prefix, SizeEst *est)
 {
     char buf[1024];
@@ -262,8 +378,12 @@ static void print_compr_stat(CompStruct *comp, const char *prefix, SizeEst *est)
     sav_dta *= 100;
     sav_blob *= 100;
 
-    snprintf(buf, sizeof(buf) - 1, "Using %s: Data: %.2f%% Blobs %.2f%%\n",
-             prefix, sav_dta, sav_blob);
+    snprintf(buf, sizeof(buf) - 1,
+             "Using %s: Data: %.2f%% Blobs %.2f%% "
+             "(decode ns/byte: Data: %.2f Blobs %.2f)\n",
+             prefix, sav_dta, sav_blob,
+             decode_ns_per_byte(est->dtans, comp->uncompressed.dtasz),
+             decode_ns_per_byte(est->blobns, comp->uncompressed.blobsz));
     logmsg(LOGMSG_USER, "%s", buf);
     sbuf2printf(comp->sb, ">%s", buf);
 }
@@ -284,16 +404,34 @@ static void compr_stat(CompStruct *comp)
     print_compr_stat(comp, " LZ4", &comp->lz4);
 }
 
-static void *handle_comptest_thd(void *_arg)
+/* Let schema changes in between batches of samples; the table may be gone
+ * or changed when we get the lock back, in which case we stop. */
+static int yield_schema_lk(CompStruct *comp)
 {
-    CompArg *arg = _arg;
-    CompStruct comp = {0};
-    int compress;
+    struct dbtable *db = comp->db;
+    char tablename[MAXTABLELEN];
+    int version = db->tableversion;
+
+    snprintf(tablename, sizeof(tablename), "%s", db->tablename);
+    unlock_schema_lk();
+    rdlock_schema_lk();
+
+    return get_dbtable_by_name(tablename) != db ||
+           db->tableversion != version || gbl_schema_change_in_progress;
+}
+
+/* Sample 'percent' percent of the records of comp->db, walking at most 'max'
+ * records and sampling at most 'max_sampled' (0 for no limit). Returns
+ * non-zero if sampling was aborted. */
+static int sample_table(CompStruct *comp, int percent, int max,
+                        int max_sampled)
+{
+    struct dbtable *db = comp->db;
     int rc;
     int i;
     int blob_pos[MAXBLOBS];
     size_t blob_offs[MAXBLOBS];
-    int skip = round(100.0 / gbl_testcompr_percent - 1.0);
+    int skip = round(100.0 / percent - 1.0);
 
     struct ireq iq;
     int ixnum = -1;
@@ -301,8 +439,7 @@ static void *handle_comptest_thd(void *_arg)
     uint64_t fndkey;
     int lastrrn, rrn;
     unsigned long long lastgenid;
-    const int maxlen = sizeof(comp.fnddta);
-    int fndlen;
+    const int maxlen = sizeof(comp->fnddta);
     unsigned long long context = 0;
 
     int total = 1;
@@ -313,12 +450,96 @@ static void *handle_comptest_thd(void *_arg)
         skip = 0;
     }
 
-    backend_thread_event(thedb, BDBTHR_EVENT_START_RDONLY);
-    comp.sb = arg->sb;
-    comp.just_crle = 0;
     for (i = 0; i < MAXBLOBS; ++i) {
         blob_pos[i] = i;
     }
+
+    bzero(&comp->uncompressed, sizeof(comp->uncompressed));
+    bzero(&comp->crle, sizeof(comp->crle));
+    bzero(&comp->rle, sizeof(comp->rle));
+    bzero(&comp->zlib, sizeof(comp->zlib));
+    bzero(&comp->lz4, sizeof(comp->lz4));
+    comp->nsampled = 0;
+
+    iq.dbenv = thedb;
+    iq.is_fake = 1;
+    iq.usedb = db;
+    iq.opcode = OP_FIND;
+
+    rc = ix_find_blobs(&iq, ixnum, NULL, 0, &fndkey, &rrn, &comp->genid,
+                       &comp->fnddta, &comp->fndlen, maxlen, db->numblobs,
+                       blob_pos, comp->blob_len, blob_offs, comp->blob_ptrs,
+                       NULL);
+
+    while (rc == IX_FND || rc == IX_FNDMORE) {
+        if (gbl_sc_abort || db->sc_abort || db_is_stopped()) {
+            logmsg(LOGMSG_ERROR, "Abort compression testing %s\n",
+                   db->tablename);
+            return 1;
+        }
+        rc = test_compress(comp);
+        if (rc) {
+            logmsg(LOGMSG_ERROR, "Failed compressing %s, rc:%d (%s:%d)\n",
+                   db->tablename, rc, __FILE__, __LINE__);
+            return 1;
+        }
+
+        if ((max && total > max) ||
+            (max_sampled && comp->nsampled >= max_sampled)) {
+            break;
+        }
+
+        if (comp->yield_schema_lk &&
+            comp->nsampled % COMPR_ADVISOR_BATCH == 0 &&
+            yield_schema_lk(comp)) {
+            logmsg(LOGMSG_INFO, "Table %s changed, stop sampling it\n",
+                   db->tablename);
+            return 1;
+        }
+
+        last = fndkey;
+        lastrrn = rrn;
+        lastgenid = comp->genid;
+
+        int j;
+        for (j = 0; j < skip; ++j) {
+            /* Don't fetch any data */
+            rc = ix_next_blobs(&iq, ixnum, NULL, 0, &last, lastrrn, lastgenid,
+                               &fndkey, &rrn, &comp->genid, NULL, NULL, 0, 0,
+                               NULL, NULL, NULL, NULL, NULL, context);
+            if (rc != IX_FND && rc != IX_FNDMORE) {
+                break;
+            }
+            last = fndkey;
+            lastrrn = rrn;
+            lastgenid = comp->genid;
+            ++total;
+        }
+
+        if (rc != IX_FND && rc != IX_FNDMORE) {
+            break;
+        }
+
+        /* Fetch all data */
+        rc = ix_next_blobs(&iq, ixnum, NULL, 0, &last, lastrrn, lastgenid,
+                           &fndkey, &rrn, &comp->genid, &comp->fnddta,
+                           &comp->fndlen, maxlen, db->numblobs, blob_pos,
+                           comp->blob_len, blob_offs, comp->blob_ptrs, NULL,
+                           context);
+        ++total;
+    }
+    return 0;
+}
+
+static void *handle_comptest_thd(void *_arg)
+{
+    CompArg *arg = _arg;
+    CompStruct comp = {0};
+    int i;
+
+    backend_thread_event(thedb, BDBTHR_EVENT_START_RDONLY);
+    comp.sb = arg->sb;
+    comp.just_crle = 0;
     for (i = 0; i < thedb->num_dbs; i++) {
         struct dbtable *db = thedb->dbs[i];
         if (strcmp(arg->table, "cdb2justcrle") == 0) {
@@ -335,72 +556,9 @@ static void *handle_comptest_thd(void *_arg)
         logmsg(LOGMSG_DEBUG, "Processing table: %s\n", db->tablename);
 
         comp.db = db;
-        bzero(&comp.uncompressed, sizeof(comp.uncompressed));
-        bzero(&comp.crle, sizeof(comp.crle));
-        bzero(&comp.rle, sizeof(comp.rle));
-        bzero(&comp.zlib, sizeof(comp.zlib));
-        bzero(&comp.lz4, sizeof(comp.lz4));
-
-        iq.dbenv = thedb;
-        iq.is_fake = 1;
-        iq.usedb = db;
-        iq.opcode = OP_FIND;
-
-        rc = ix_find_blobs(&iq, ixnum, NULL, 0, &fndkey, &rrn, &comp.genid,
-                           &comp.fnddta, &comp.fndlen, maxlen, db->numblobs,
-                           blob_pos, comp.blob_len, blob_offs, comp.blob_ptrs,
-                           NULL);
-
-        while (rc == IX_FND || rc == IX_FNDMORE) {
-            if (gbl_sc_abort || db->sc_abort) {
-                logmsg(LOGMSG_ERROR, "Abort compression testing %s\n",
-                       db->tablename);
-                ++arg->rc;
-                break;
-            }
-            rc = test_compress(&comp);
-            if (rc) {
-                logmsg(LOGMSG_ERROR, "Failed compressing %s, rc:%d (%s:%d)\n",
-                       db->tablename, rc, __FILE__, __LINE__);
-                ++arg->rc;
-                break;
-            }
-
-            if (gbl_testcompr_max && total > gbl_testcompr_max) {
-                break;
-            }
-
-            last = fndkey;
-            lastrrn = rrn;
-            lastgenid = comp.genid;
-
-            int j;
-            for (j = 0; j < skip; ++j) {
-                /* Don't fetch any data */
-                rc = ix_next_blobs(&iq, ixnum, NULL, 0, &last, lastrrn,
-                                   lastgenid, &fndkey, &rrn, &comp.genid, NULL,
-                                   NULL, 0, 0, NULL, NULL, NULL, NULL, NULL,
-                                   context);
-                if (rc != IX_FND && rc != IX_FNDMORE) {
-                    break;
-                }
-                last = fndkey;
-                lastrrn = rrn;
-                lastgenid = comp.genid;
-                ++total;
-            }
-
-            if (rc != IX_FND && rc != IX_FNDMORE) {
-                break;
-            }
-
-            /* Fetch all data */
-            rc = ix_next_blobs(&iq, ixnum, NULL, 0, &last, lastrrn, lastgenid,
-                               &fndkey, &rrn, &comp.genid, &comp.fnddta,
-                               &comp.fndlen, maxlen, db->numblobs, blob_pos,
-                               comp.blob_len, blob_offs, comp.blob_ptrs, NULL,
-                               context);
-            ++total;
+        if (sample_table(&comp, gbl_testcompr_percent, gbl_testcompr_max,
+                         0)) {
+            ++arg->rc;
         }
         compr_stat(&comp);
     }
@@ -438,3 +596,274 @@ void handle_testcompr(SBUF2 *sb, const char *table)
     }
 }
 
+/* Results of the last advisor run for one table */
+struct compr_advice {
+    char *tablename;
+    int nsampled;
+    time_t sampled_at;
+    SizeEst uncompressed;
+    SizeEst est[NUM_COMPR_ALGOS];
+    int numblobs;
+    int cur_rec, cur_blob;   /* algorithms in use when sampled */
+    int best_rec, best_blob; /* recommended algorithms */
+    int switched;            /* did we switch to the recommendation */
+    struct compr_advice *next;
+};
+
+static pthread_mutex_t compr_advice_lk = PTHREAD_MUTEX_INITIALIZER;
+static struct compr_advice *compr_advice;
+static volatile int compr_advisor_running;
+
+/* Compressed size as a percentage of the original size */
+static double compr_pct(uint64_t sz, uint64_t orig)
+{
+    return orig ? 100.0 * sz / orig : 100;
+}
+
+static void free_advice_list(struct compr_advice *a)
+{
+    while (a) {
+        struct compr_advice *next = a->next;
+        free(a->tablename);
+        free(a);
+        a = next;
+    }
+}
+
+/* Cost of an algorithm: the compressed size in percent of the original, plus
+ * the decode time in ns/byte scaled by compr_advisor_cpu_weight. */
+static double compr_cost(uint64_t sz, uint64_t ns, uint64_t orig)
+{
+    if (orig == 0)
+        return 100;
+    return compr_pct(sz, orig) +
+           gbl_compr_advisor_cpu_weight * decode_ns_per_byte(ns, orig);
+}
+
+static int pick_algo(const struct compr_advice *a, int isblob)
+{
+    uint64_t orig = isblob ? a->uncompressed.blobsz : a->uncompressed.dtasz;
+    int cur = isblob ? a->cur_blob : a->cur_rec;
+    double cost[NUM_COMPR_ALGOS];
+    int best = BDB_COMPRESS_NONE;
+
+    if (orig == 0 || cur < 0 || cur >= NUM_COMPR_ALGOS)
+        return cur;
+
+    cost[BDB_COMPRESS_NONE] = 100;
+    for (int alg = BDB_COMPRESS_ZLIB; alg < NUM_COMPR_ALGOS; ++alg) {
+        const SizeEst *est = &a->est[alg];
+        cost[alg] = isblob ? compr_cost(est->blobsz, est->blobns, orig)
+                           : compr_cost(est->dtasz, est->dtans, orig);
+    }
+    for (int alg = BDB_COMPRESS_ZLIB; alg < NUM_COMPR_ALGOS; ++alg) {
+        /* crle is a record-only algorithm */
+        if (isblob && alg == BDB_COMPRESS_CRLE)
+            continue;
+        if (cost[alg] < cost[best])
+            best = alg;
+    }
+
+    /* Not worth the churn unless it is a clear win */
+    if (cost[cur] - cost[best] < gbl_compr_advisor_min_gain)
+        return cur;
+    return best;
+}
+
+static struct compr_advice *advise_table(CompStruct *comp)
+{
+    struct dbtable *db = comp->db;
+    int odh, compr, blob_compr;
+
+    bdb_get_compr_flags(db->handle, &odh, &compr, &blob_compr);
+    if (!odh)
+        return NULL;
+
+    if (sample_table(comp, gbl_testcompr_percent, 0, gbl_compr_advisor_max))
+        return NULL;
+
+    struct compr_advice *a = calloc(1, sizeof(struct compr_advice));
+    if (a == NULL)
+        return NULL;
+    a->tablename = strdup(db->tablename);
+    a->nsampled = comp->nsampled;
+    a->sampled_at = time(NULL);
+    a->uncompressed = comp->uncompressed;
+    for (int alg = BDB_COMPRESS_ZLIB; alg < NUM_COMPR_ALGOS; ++alg)
+        a->est[alg] = *compr_est(comp, alg);
+    a->numblobs = db->numblobs;
+    a->cur_rec = compr;
+    a->cur_blob = blob_compr;
+    a->best_rec = pick_algo(a, 0);
+    a->best_blob = db->numblobs ? pick_algo(a, 1) : blob_compr;
+    return a;
+}
+
+static void *compr_advisor_thd(void *unused)
+{
+    struct compr_advice *head = NULL, **tail = &head;
+    CompStruct *comp;
+
+    thrman_register(THRTYPE_ANALYZE);
+    backend_thread_event(thedb, COMDB2_THR_EVENT_START_RDONLY);
+
+    if ((comp = calloc(1, sizeof(CompStruct))) == NULL)
+        goto done;
+    comp->yield_schema_lk = 1;
+
+    for (int i = 0;; ++i) {
+        struct compr_advice *a = NULL;
+
+        rdlock_schema_lk();
+        if (i >= thedb->num_dbs || db_is_stopped()) {
+            unlock_schema_lk();
+            break;
+        }
+        comp->db = thedb->dbs[i];
+        if (!is_sqlite_stat(comp->db->tablename) &&
+            !gbl_schema_change_in_progress)
+            a = advise_table(comp);
+        unlock_schema_lk();
+
+        if (a == NULL)
+            continue;
+
+        if (gbl_compr_advisor_autoswitch && thedb->master == gbl_mynode &&
+            (a->best_rec != a->cur_rec || a->best_blob != a->cur_blob)) {
+            const char *rec = a->best_rec != a->cur_rec
+                                  ? algo_names[a->best_rec]
+                                  : NULL;
+            const char *blob = a->best_blob != a->cur_blob
+                                   ? algo_names[a->best_blob]
+                                   : NULL;
+            if (setcompr_table(a->tablename, rec, blob) == 0)
+                a->switched = 1;
+        } else if (a->best_rec != a->cur_rec || a->best_blob != a->cur_blob) {
+            logmsg(LOGMSG_INFO,
+                   "compression advisor: table %s would be cheaper with "
+                   "REC %s BLOB %s (currently REC %s BLOB %s)\n",
+                   a->tablename, algo_names[a->best_rec],
+                   algo_names[a->best_blob], algo_names[a->cur_rec],
+                   algo_names[a->cur_blob]);
+        }
+
+        *tail = a;
+        tail = &a->next;
+    }
+    free(comp);
+
+    /* Publish this run; tables dropped since the last run go away with it */
+    pthread_mutex_lock(&compr_advice_lk);
+    struct compr_advice *old = compr_advice;
+    compr_advice = head;
+    pthread_mutex_unlock(&compr_advice_lk);
+    free_advice_list(old);
+
+done:
+    backend_thread_event(thedb, COMDB2_THR_EVENT_DONE_RDONLY);
+    compr_advisor_running = 0;
+    return NULL;
+}
+
+/* Kick off an advisor run, unless one is already going */
+void compr_advisor_run(void)
+{
+    pthread_t t;
+
+    if (compr_advisor_running || gbl_schema_change_in_progress)
+        return;
+    compr_advisor_running = 1;
+    if (pthread_create(&t, &gbl_pthread_attr_detached, compr_advisor_thd,
+                       NULL)) {
+        logmsg(LOGMSG_ERROR, "%s: failed to start advisor thread\n",
+               __func__);
+        compr_advisor_running = 0;
+    }
+}
+
+/* Called once per second from the housekeeping thread */
+void compr_advisor_check(void)
+{
+    static int last;
+    int now = comdb2_time_epoch();
+
+    if (gbl_compr_advisor_interval <= 0)
+        return;
+    if (last == 0) {
+        /* don't sample everything the moment we come up */
+        last = now;
+        return;
+    }
+    if (now - last < gbl_compr_advisor_interval)
+        return;
+    last = now;
+    compr_advisor_run();
+}
+
+static void fill_advisor_stat(struct compr_advisor_stat *s,
+                              const struct compr_advice *a, int isblob, int alg)
+{
+    const SizeEst *est = &a->est[alg];
+    uint64_t orig = isblob ? a->uncompressed.blobsz : a->uncompressed.dtasz;
+    int cur = isblob ? a->cur_blob : a->cur_rec;
+    int best = isblob ? a->best_blob : a->best_rec;
+
+    s->tablename = strdup(a->tablename);
+    s->kind = isblob ? "blob" : "data";
+    s->algorithm = (char *)algo_names[alg];
+    s->sampled_rows = a->nsampled;
+    s->sampled_at = a->sampled_at;
+    s->original_bytes = orig;
+    if (alg == BDB_COMPRESS_NONE) {
+        s->compressed_bytes = orig;
+        s->decode_ns_per_byte = 0;
+    } else {
+        s->compressed_bytes = isblob ? est->blobsz : est->dtasz;
+        s->decode_ns_per_byte =
+            decode_ns_per_byte(isblob ? est->blobns : est->dtans, orig);
+    }
+    s->percent = compr_pct(s->compressed_bytes, orig);
+    s->current = alg == cur ? "Y" : "N";
+    s->recommended = alg == best ? "Y" : "N";
+    s->switched = (alg == best && alg != cur && a->switched) ? "Y" : "N";
+}
+
+/* Snapshot of the last advisor run for comdb2_compression_stats */
+int compr_advisor_stats(struct compr_advisor_stat **stats, int *nstats)
+{
+    struct compr_advice *a;
+    int n = 0, i = 0;
+
+    pthread_mutex_lock(&compr_advice_lk);
+    /* no crle rows for blobs */
+    for (a = compr_advice; a; a = a->next)
+        n += a->numblobs ? 2 * NUM_COMPR_ALGOS - 1 : NUM_COMPR_ALGOS;
+
+    *stats = calloc(n ? n : 1, sizeof(struct compr_advisor_stat));
+    if (*stats == NULL) {
+        pthread_mutex_unlock(&compr_advice_lk);
+        return -1;
+    }
+    for (a = compr_advice; a; a = a->next) {
+        for (int alg = 0; alg < NUM_COMPR_ALGOS; ++alg)
+            fill_advisor_stat(&(*stats)[i++], a, 0, alg);
+        if (!a->numblobs)
+            continue;
+        for (int alg = 0; alg < NUM_COMPR_ALGOS; ++alg) {
+            if (alg == BDB_COMPRESS_CRLE)
+                continue;
+            fill_advisor_stat(&(*stats)[i++], a, 1, alg);
+        }
+    }
+    pthread_mutex_unlock(&compr_advice_lk);
+
+    *nstats = n;
+    return 0;
+}
+
+void compr_advisor_stats_free(struct compr_advisor_stat *stats, int nstats)
+{
+    for (int i = 0; i < nstats; ++i)
+        free(stats[i].tablename);
+    free(stats);
+}
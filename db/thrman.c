@@ -378,6 +378,8 @@ const char *thrman_type2a(enum thrtype type)
         return "purge-old-files";
     case THRTYPE_TRIGGER:
         return "lua-trigger";
+    case THRTYPE_DEFRAG:
+        return "defrag";
     default:
         return "??";
     }
@@ -491,6 +493,7 @@ static int thrman_check_threads_stopped_ll(void *context)
             thr_type_counts[THRTYPE_SQLPOOL] +
             thr_type_counts[THRTYPE_SQLENGINEPOOL] +
             thr_type_counts[THRTYPE_VERIFY] + thr_type_counts[THRTYPE_ANALYZE] +
+            thr_type_counts[THRTYPE_DEFRAG] +
             thr_type_counts[THRTYPE_PURGEBLKSEQ])
         all_gone = 1;
 
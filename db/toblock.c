@@ -74,6 +74,7 @@
 #include "bpfunc.h"
 #include "debug_switches.h"
 #include "logmsg.h"
+#include "autoanalyze.h"
 
 #if 0
 #define TEST_OSQL
@@ -2520,6 +2521,7 @@ static int toblock_main_int(struct javasp_trans_state *javasp_trans_handle,
     /* reset queue hits stats so we don't accumulate them over several
      * retries */
     iq->num_queues_hit = 0;
+    incr_stats_begin(iq);
 
     iq->p_buf_in = p_blkstate->p_buf_req_start;
     iq->p_buf_in_end = p_blkstate->p_buf_req_end;
@@ -66,6 +66,17 @@ pthread_rwlock_t views_lk;
  */
 cron_sched_t *timepart_sched;
 
+/*
+ Retired shards are read-mostly; once a shard is rolled out, it can be rebuilt
+ with a stronger compression ("frozen").  Frozen shards are marked in llmeta
+ and reject writes.
+ */
+#define VIEWS_FROZEN_PARAM "timepart_frozen"
+
+int gbl_timepart_freeze_shards = 0;
+int gbl_timepart_freeze_lag = 300;
+int gbl_timepart_freeze_compress = BDB_COMPRESS_ZLIB;
+
 static int _start_views_cron(void);
 static timepart_view_t *_get_view(timepart_views_t *views, const char *name);
 static int _generate_new_shard_name(const char *oldname, char *newname,
@@ -91,6 +102,8 @@ void *_view_cron_phase2(uuid_t source_id, void *arg1, void *arg2, void *arg3,
                         struct errstat *err);
 void *_view_cron_phase3(uuid_t source_id, void *arg1, void *arg2, void *arg3,
                         struct errstat *err);
+void *_view_cron_freeze(uuid_t source_id, void *arg1, void *arg2, void *arg3,
+                        struct errstat *err);
 static int _views_rollout_phase1(timepart_view_t *view, char **newShardName,
                                  struct errstat *err);
 static int _views_rollout_phase2(timepart_view_t *view,
@@ -803,6 +816,67 @@ int views_do_purge(timepart_views_t *views, const char *name)
     return rc;
 }
 
+static int _shard_is_frozen(const char *shardName)
+{
+    char *str = NULL;
+    int frozen;
+
+    if (bdb_get_table_parameter(shardName, VIEWS_FROZEN_PARAM, &str))
+        return 0;
+
+    frozen = (strncmp(str, "true", 4) == 0);
+    free(str);
+
+    return frozen;
+}
+
+/**
+ * Queue a rebuild of a retired shard with gbl_timepart_freeze_compress
+ * The shard is read only from here on
+ *
+ */
+int views_freeze_shard(const char *shardName, struct errstat *err)
+{
+    struct dbtable *db;
+    int indx = 0;
+    int rc;
+
+    /* the newest shard takes all the inserts, it cannot be frozen */
+    pthread_rwlock_rdlock(&views_lk);
+    if (_check_shard_collision(thedb->timepart_views, shardName, &indx,
+                               _CHECK_ONLY_CURRENT_SHARDS) == NULL ||
+        indx == 0) {
+        pthread_rwlock_unlock(&views_lk);
+        errstat_set_strf(err, "%s is not a retired shard", shardName);
+        return err->errval = VIEW_ERR_PARAM;
+    }
+    pthread_rwlock_unlock(&views_lk);
+
+    rc = bdb_set_table_parameter(NULL, shardName, VIEWS_FROZEN_PARAM, "true");
+    if (rc) {
+        errstat_set_strf(err, "Failed to llmeta mark %s frozen", shardName);
+        return err->errval = VIEW_ERR_LLMETA;
+    }
+    db = get_dbtable_by_name(shardName);
+    if (db)
+        db->is_readonly = 1;
+
+    rc = sc_timepart_freeze_table(shardName, gbl_timepart_freeze_compress,
+                                  err);
+    if (rc != SC_VIEW_NOERR) {
+        /* not frozen after all; the next master will queue it again */
+        bdb_clear_table_parameter(NULL, shardName, VIEWS_FROZEN_PARAM);
+        if (db)
+            db->is_readonly = 0;
+        return err->errval = VIEW_ERR_SC;
+    }
+
+    logmsg(LOGMSG_INFO, "%s: queued rebuild of shard %s\n", __func__,
+           shardName);
+
+    return err->errval = VIEW_NOERR;
+}
+
 static int _shard_suffix_str_len(int maxshards)
 {
     /* we need desired #shards + 1, to facilitate decoupled
@@ -1287,6 +1361,30 @@ _view_cron_schedule_next_rollout(timepart_view_t *view, int timeCrtRollout,
     return FDB_NOERR;
 }
 
+static int _view_cron_schedule_freeze(timepart_view_t *view,
+                                      int timeCrtRollout,
+                                      char *freezeShardName,
+                                      struct errstat *err)
+{
+    int tm;
+
+    tm = timeCrtRollout + gbl_timepart_freeze_lag;
+
+    print_dbg_verbose(view->name, &view->source_id, "LLL",
+                      "Adding freeze at %d for %s\n", tm, freezeShardName);
+
+    if (cron_add_event(timepart_sched, NULL, tm, _view_cron_freeze,
+                       freezeShardName, NULL, NULL, &view->source_id,
+                       err) == NULL) {
+        logmsg(LOGMSG_ERROR, "%s: failed rc=%d errstr=%s\n", __func__,
+               err->errval, err->errstr);
+        free(freezeShardName);
+        return FDB_ERR_GENERIC;
+    }
+
+    return FDB_NOERR;
+}
+
 /**
  * Phase 2 of the rollout, add the table to the view
  *
@@ -1302,6 +1400,7 @@ void *_view_cron_phase2(uuid_t source_id, void *arg1, void *arg2, void *arg3,
     int timeNextRollout;
     int timeCrtRollout;
     char *removeShardName;
+    char *freezeShardName = NULL;
     int rc;
     int bdberr;
 
@@ -1372,6 +1471,12 @@ void *_view_cron_phase2(uuid_t source_id, void *arg1, void *arg2, void *arg3,
             }
         }
 
+        if (rc == VIEW_NOERR && gbl_timepart_freeze_shards &&
+            view->nshards > 1) {
+            /* the previous newest shard is now retired */
+            freezeShardName = strdup(view->shards[1].tblname);
+        }
+
         BDB_RELLOCK();
 
         /* tell the world */
@@ -1392,6 +1497,9 @@ done:
             rc = _view_cron_schedule_next_rollout(view, timeCrtRollout,
                                                   timeNextRollout,
                                                   removeShardName, name, err);
+            if (freezeShardName)
+                _view_cron_schedule_freeze(view, timeCrtRollout,
+                                           freezeShardName, err);
             return NULL;
         } else {
             _handle_view_event_error(view, source_id, err);
@@ -1465,6 +1573,59 @@ done:
     return NULL;
 }
 
+/**
+ * Freeze a retired shard: rebuild it with gbl_timepart_freeze_compress
+ *
+ */
+void *_view_cron_freeze(uuid_t source_id, void *arg1, void *arg2, void *arg3,
+                        struct errstat *err)
+{
+    char *pShardName = (char *)arg1;
+    int run = 0;
+    int rc;
+
+    print_dbg_verbose(NULL, NULL, "TTT",
+                      "Running freeze at %u arg1=%p arg2=%p arg3=%p\n",
+                      comdb2_time_epoch(), arg1, arg2, arg3);
+
+    if (!pShardName) {
+        errstat_set_rc(err, VIEW_ERR_BUG);
+        errstat_set_strf(err, "%s no shardname?", __func__);
+        return NULL;
+    }
+
+    run = (!gbl_exit);
+    if (run && thedb->master != gbl_mynode)
+        run = 0;
+
+    /* shard could have been dropped in the meantime, together with its
+       partition */
+    if (run && !timepart_is_shard(pShardName, 1))
+        run = 0;
+
+    /* or frozen on demand */
+    if (run && _shard_is_frozen(pShardName))
+        run = 0;
+
+    if (run) {
+        /* the rebuild runs in its own schema change thread, this only queues
+           it; schema changes are serialized per table, so a purge of this
+           shard will fail instead of racing the rebuild */
+        bdb_thread_event(thedb->bdb_env, BDBTHR_EVENT_START_RDWR);
+
+        rc = views_freeze_shard(pShardName, err);
+
+        bdb_thread_event(thedb->bdb_env, BDBTHR_EVENT_DONE_RDWR);
+
+        if (rc != VIEW_NOERR) {
+            logmsg(LOGMSG_ERROR, "%s: freeze %s failed rc=%d errstr=%s\n",
+                   __func__, pShardName, err->errval, err->errstr);
+        }
+    }
+
+    return NULL;
+}
+
 /**
  * Start a views cron thread
  *
@@ -1852,6 +2013,70 @@ static int _views_rollout_phase3(const char *oldestShardName,
 }
 
 /* done under mutex */
+/**
+ * The freeze events live only in the old master's cron queue; recover them
+ * from the llmeta marks. Retired shards that are not frozen yet get a freeze
+ * timepart_freeze_lag after the rollout that retired them, which is when
+ * they started (shard i was retired when shard i-1 started).  Also reload
+ * the read-only flag of every shard, this node may have missed it.
+ *
+ */
+static int _view_restart_freeze(timepart_view_t *view, struct errstat *err)
+{
+    struct dbtable *db;
+    char *names[view->nshards];
+    int times[view->nshards];
+    int nfreeze = 0;
+    int rc = VIEW_NOERR;
+    int i;
+
+    for (i = 0; i < view->nshards; i++) {
+        int frozen = _shard_is_frozen(view->shards[i].tblname);
+
+        db = get_dbtable_by_name(view->shards[i].tblname);
+        if (db)
+            db->is_readonly = frozen;
+
+        if (i == 0 || frozen || !gbl_timepart_freeze_shards || !db)
+            continue;
+
+        names[nfreeze] = strdup(view->shards[i].tblname);
+        if (!names[nfreeze])
+            break;
+        times[nfreeze] = view->shards[i].high + gbl_timepart_freeze_lag;
+        nfreeze++;
+    }
+    if (!nfreeze)
+        return VIEW_NOERR;
+
+    /* same as phase 3, no views lock while adding cron events */
+    pthread_rwlock_unlock(&views_lk);
+
+    for (i = 0; i < nfreeze; i++) {
+        if (rc != VIEW_NOERR) {
+            free(names[i]);
+            continue;
+        }
+
+        print_dbg_verbose(view->name, &view->source_id, "RRR",
+                          "Adding freeze at %d for %s\n", times[i],
+                          names[i]);
+
+        if (cron_add_event(timepart_sched, NULL, times[i], _view_cron_freeze,
+                           names[i], NULL, NULL, &view->source_id,
+                           err) == NULL) {
+            logmsg(LOGMSG_ERROR, "%s: failed rc=%d errstr=%s\n", __func__,
+                   err->errval, err->errstr);
+            free(names[i]);
+            rc = err->errval;
+        }
+    }
+
+    pthread_rwlock_wrlock(&views_lk);
+
+    return rc;
+}
+
 static int _view_restart(timepart_view_t *view, struct errstat *err)
 {
     int delete_lag = thedb->timepart_views->rollout_delete_lag;
@@ -2011,6 +2236,10 @@ static int _view_restart(timepart_view_t *view, struct errstat *err)
         return rc;
     }
 
+    rc = _view_restart_freeze(view, err);
+    if (rc != VIEW_NOERR)
+        return rc;
+
     errstat_set_rc(err, rc = VIEW_NOERR);
 
     return rc;
@@ -2802,6 +3031,8 @@ static const char *_events_name(FCRON func)
         name = "RollShards";
     else if (func == _view_cron_phase3)
         name = "DropShard";
+    else if (func == _view_cron_freeze)
+        name = "FreezeShard";
     else
         name = "Unknown";
 
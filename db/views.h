@@ -240,6 +240,13 @@ int views_do_rollout(timepart_views_t *views, const char *name);
  */
 int views_do_purge(timepart_views_t *views, const char *name);
 
+/**
+ * Queue a rebuild of a retired shard with the compression set by
+ * "timepart_freeze_compress", and make the shard read only
+ *
+ */
+int views_freeze_shard(const char *shardName, struct errstat *err);
+
 /**
  * Signal looping workers of views of db event like exiting
  *
@@ -218,13 +218,18 @@ static char *_views_create_view_query(timepart_view_t *view, sqlite3 *db,
         goto malloc;
     }
 
-    /* generate the select union for shards */
-    /* TODO: put conditions for shards */
+    /* generate the select union for shards; each shard exposes its time
+       range as hidden constant columns, so that sqlite pushes predicates on
+       them down in each branch as constant terms, skipping shards that
+       cannot match without opening them */
     select_str = sqlite3_mprintf("");
     for (i = 0; i < view->nshards; i++) {
-        tmp_str = sqlite3_mprintf("%s%sSELECT %s FROM \"%s\"", select_str,
-                                  (i > 0) ? " UNION ALL " : "", cols_str,
-                                  view->shards[i].tblname);
+        tmp_str = sqlite3_mprintf(
+            "%s%sSELECT %s, %d AS __hidden__shard_start, %d AS "
+            "__hidden__shard_end FROM \"%s\"",
+            select_str, (i > 0) ? " UNION ALL " : "", cols_str,
+            view->shards[i].low, view->shards[i].high,
+            view->shards[i].tblname);
         sqlite3DbFree(db, select_str);
         if (!tmp_str) {
             sqlite3DbFree(db, cols_str);
@@ -457,6 +457,7 @@ set all_graphs {
           {line
               {opt dup}
               {opt datacopy}
+              {opt hash}
               {line /string-literal = }
           }
           {stack
@@ -576,7 +577,7 @@ set all_graphs {
           {stack
               {line {or {line UNIQUE } {line KEY } }
                   {opt index-name } ( index-column-list ) }
-              {line {opt WITH DATACOPY } {opt WHERE expr } }
+              {line {opt WITH {loop {or DATACOPY HASH} {}} } {opt WHERE expr } }
           }
       }
       {line PRIMARY KEY ( index-column-list ) }
@@ -626,7 +627,7 @@ set all_graphs {
                       {stack
                           {line ADD {opt UNIQUE } INDEX index-name
                               ( index-column-list ) }
-                          {line {opt WITH DATACOPY } {opt WHERE expr } }
+                          {line {opt WITH {loop {or DATACOPY HASH} {}} } {opt WHERE expr } }
                       }
                       {line DROP INDEX index-name }
                       {line ADD PRIMARY KEY ( index-column-list ) }
@@ -647,7 +648,7 @@ set all_graphs {
       stack
       {line CREATE {opt UNIQUE } INDEX {opt IF NOT EXISTS } }
       {line {opt db-name } index-name ON table-name ( index-column-list ) }
-      {line {opt WITH DATACOPY } {opt WHERE expr } }
+      {line {opt WITH {loop {or DATACOPY HASH} {}} } {opt WHERE expr } }
   }
 
   drop-index {
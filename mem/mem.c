@@ -602,6 +602,31 @@ size_t comdb2_malloc_usable_size(void *ptr)
 }
 // root$
 
+//^accounting
+static __thread comdb2ma_acct *thd_acct;
+
+#define COMDB2MA_CHARGE(n)                                                     \
+    do {                                                                       \
+        comdb2ma_acct *acct_ = thd_acct;                                       \
+        if (acct_ != NULL) {                                                   \
+            acct_->used += (n);                                                \
+            if (acct_->used > acct_->peak)                                     \
+                acct_->peak = acct_->used;                                     \
+        }                                                                      \
+    } while (0)
+
+void comdb2ma_account(comdb2ma_acct *acct) { thd_acct = acct; }
+
+int comdb2ma_spill(void)
+{
+    comdb2ma_acct *acct = thd_acct;
+    if (acct == NULL || acct->spill <= 0 || acct->used <= acct->spill)
+        return 0;
+    ++acct->nspills;
+    return 1;
+}
+// accounting$
+
 //^dynamic
 comdb2ma comdb2ma_create_with_callback(void *base, size_t sz, size_t cap,
                                        const char *name, const char *scope,
@@ -676,6 +701,7 @@ void *comdb2_malloc(comdb2ma cm, size_t size)
 #ifdef PER_THREAD_MALLOC
             ++cm->refs;
 #endif
+            COMDB2MA_CHARGE(dlmalloc_usable_size(out));
             out[0] = COMDB2MA_SENTINEL(out, cm);
             out[1] = (void *)cm;
             out -= COMDB2MA_SENTINEL_OFS;
@@ -713,6 +739,7 @@ void *comdb2_calloc(comdb2ma cm, size_t n, size_t size)
 #ifdef PER_THREAD_MALLOC
             ++cm->refs;
 #endif
+            COMDB2MA_CHARGE(dlmalloc_usable_size(out));
             out[0] = COMDB2MA_SENTINEL(out, cm);
             out[1] = (void *)cm;
             out -= COMDB2MA_SENTINEL_OFS;
@@ -737,9 +764,12 @@ static void *comdb2_realloc_int(comdb2ma cm, void *ptr, size_t n)
             errno = ENOMEM;
             out = NULL;
         } else {
+            size_t oldsz = dlmalloc_usable_size(out + COMDB2MA_SENTINEL_OFS);
             out = mspace_realloc(cm->m, (void *)(out + COMDB2MA_SENTINEL_OFS),
                                  n + COMDB2MA_OVERHEAD);
             if (out != NULL) {
+                COMDB2MA_CHARGE((long long)dlmalloc_usable_size(out) -
+                                (long long)oldsz);
                 /* Recompute sentinel for realloc() b/c addr may be changed. */
                 out[0] = COMDB2MA_SENTINEL(out, cm);
                 out -= COMDB2MA_SENTINEL_OFS;
@@ -782,6 +812,8 @@ static void comdb2_free_int(comdb2ma cm, void *ptr)
     void **p = (void **)ptr;
 
     if (COMDB2MA_LOCK(cm) == 0) {
+        COMDB2MA_CHARGE(-(long long)dlmalloc_usable_size(p +
+                                                         COMDB2MA_SENTINEL_OFS));
         mspace_free(cm->m, p + COMDB2MA_SENTINEL_OFS);
 #ifdef PER_THREAD_MALLOC
         --cm->refs;
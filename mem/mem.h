@@ -190,6 +190,31 @@ int comdb2ma_mmap_threshold();
 */
 int comdb2ma_get_mmap_threshold(void);
 
+/*
+** Memory accounting.
+**
+** A thread can charge what it allocates and frees through comdb2
+** allocators to an account, e.g. the memory used by the sql statement the
+** thread is running. Memory freed by another thread isn't credited back.
+*/
+typedef struct comdb2ma_acct {
+    long long used;  /* bytes allocated less bytes freed */
+    long long peak;  /* highest `used' */
+    long long spill; /* ask to spill over this many bytes, 0 for never */
+    unsigned nspills;
+} comdb2ma_acct;
+
+/*
+** Charge the memory of this thread to `acct', NULL to stop.
+*/
+void comdb2ma_account(comdb2ma_acct *acct);
+
+/*
+** Return 1, and count a spill, if the account of this thread is over its
+** spill threshold. The caller should move what it holds in memory to disk.
+*/
+int comdb2ma_spill(void);
+
 /*
 ** Comdb2ma mallopt.
 **
@@ -183,6 +183,16 @@ static int fill_snapinfo(struct sqlclntstate *clnt, int *file, int *offset)
                                                                                \
     sql_response.effects = &effects;
 
+#define _has_commit_lsn(clnt, sql_response)                                    \
+    CDB2SQLRESPONSE__Snapshotinfo commitlsn =                                  \
+        CDB2__SQLRESPONSE__SNAPSHOTINFO__INIT;                                 \
+                                                                               \
+    if (clnt->commit_file) {                                                   \
+        commitlsn.file = clnt->commit_file;                                    \
+        commitlsn.offset = clnt->commit_offset;                                \
+        sql_response.commit_lsn = &commitlsn;                                  \
+    }
+
 #define _has_features(clnt, sql_response)                                      \
     CDB2ServerFeatures features[10];                                           \
     int n_features = 0;                                                        \
@@ -677,6 +687,7 @@ static int newsql_row_last(struct sqlclntstate *clnt)
     resp.response_type = RESPONSE_TYPE__LAST_ROW;
     _has_effects(clnt, resp);
     _has_snapshot(clnt, resp);
+    _has_commit_lsn(clnt, resp);
     _has_features(clnt, resp);
     return newsql_response(clnt, &resp, 1);
 }
@@ -1545,10 +1556,14 @@ retry_read:
 
 extern int gbl_allow_incoherent_sql;
 
+static void newsql_loop(struct thr_handle *thr_self,
+                        struct sqlclntstate *clnt, CDB2QUERY *query);
+static void newsql_cleanup(struct sqlclntstate *clnt);
+static void newsql_resume(struct thr_handle *thr_self, void *arg, int drop);
+
 static int handle_newsql_request(comdb2_appsock_arg_t *arg)
 {
-    int rc = 0;
-    struct sqlclntstate clnt;
+    struct sqlclntstate *clnt;
     struct thr_handle *thr_self;
     struct sbuf2 *sb;
     struct dbenv *dbenv;
@@ -1601,25 +1616,29 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
     */
     thrman_change_type(thr_self, THRTYPE_APPSOCK_SQL);
 
-    reset_clnt(&clnt, sb, 1);
-    clnt.write_response = newsql_write_response;
-    clnt.read_response = newsql_read_response;
-    clnt.tzname[0] = '\0';
-    clnt.is_newsql = 1;
+    if ((clnt = malloc(sizeof(struct sqlclntstate))) == NULL) {
+        logmsg(LOGMSG_ERROR, "%s: malloc failed\n", __func__);
+        return APPSOCK_RETURN_ERR;
+    }
+    reset_clnt(clnt, sb, 1);
+    clnt->write_response = newsql_write_response;
+    clnt->read_response = newsql_read_response;
+    clnt->tzname[0] = '\0';
+    clnt->is_newsql = 1;
 
-    pthread_mutex_init(&clnt.wait_mutex, NULL);
-    pthread_cond_init(&clnt.wait_cond, NULL);
-    pthread_mutex_init(&clnt.write_lock, NULL);
-    pthread_mutex_init(&clnt.dtran_mtx, NULL);
+    pthread_mutex_init(&clnt->wait_mutex, NULL);
+    pthread_cond_init(&clnt->wait_cond, NULL);
+    pthread_mutex_init(&clnt->write_lock, NULL);
+    pthread_mutex_init(&clnt->dtran_mtx, NULL);
 
     if (active_appsock_conns >
         bdb_attr_get(dbenv->bdb_attr, BDB_ATTR_MAXAPPSOCKSLIMIT)) {
         logmsg(LOGMSG_WARN,
                "%s: Exhausted appsock connections, total %d connections \n",
                __func__, active_appsock_conns);
-        newsql_error(&clnt, "Exhausted appsock connections.",
+        newsql_error(clnt, "Exhausted appsock connections.",
                    CDB2__ERROR_CODE__APPSOCK_LIMIT);
-        goto done;
+        goto cleanup;
     }
 
     extern int gbl_allow_incoherent_sql;
@@ -1627,26 +1646,26 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
         logmsg(LOGMSG_ERROR,
                "%s:%d td %u new query on incoherent node, dropping socket\n",
                __func__, __LINE__, (uint32_t)pthread_self());
-        goto done;
+        goto cleanup;
     }
 
-    CDB2QUERY *query = read_newsql_query(dbenv, &clnt, sb);
+    CDB2QUERY *query = read_newsql_query(dbenv, clnt, sb);
     if (query == NULL) {
         logmsg(LOGMSG_DEBUG, "Query on master, will be rejected\n");
-        goto done;
+        goto cleanup;
     }
     assert(query->sqlquery);
-    newsql_appdata(&clnt, 32);
+    newsql_appdata(clnt, 32);
 
     CDB2SQLQUERY *sql_query = query->sqlquery;
-    clnt.query = query;
+    clnt->query = query;
 
-    if (do_query_on_master_check(dbenv, &clnt, sql_query))
-        goto done;
+    if (do_query_on_master_check(dbenv, clnt, sql_query))
+        goto cleanup;
 
-    clnt.osql.count_changes = 1;
-    clnt.dbtran.mode = tdef_to_tranlevel(gbl_sql_tranlevel_default);
-    set_high_availability(&clnt, 0);
+    clnt->osql.count_changes = 1;
+    clnt->dbtran.mode = tdef_to_tranlevel(gbl_sql_tranlevel_default);
+    set_high_availability(clnt, 0);
 
     int notimeout = disable_server_sql_timeouts();
     sbuf2settimeout(
@@ -1664,7 +1683,7 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
 
     net_add_watch_warning(
         sb, bdb_attr_get(thedb->bdb_attr, BDB_ATTR_MAX_SQL_IDLE_TIME),
-        wrtimeoutsec, &clnt, watcher_warning_function);
+        wrtimeoutsec, clnt, watcher_warning_function);
 
     /* appsock threads aren't sql threads so for appsock pool threads
      * sqlthd will be NULL */
@@ -1674,31 +1693,51 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
         sqlthd->clnt->origin[0] = 0;
     }
 
+    newsql_loop(thr_self, clnt, query);
+    return APPSOCK_RETURN_OK;
+
+cleanup:
+    newsql_cleanup(clnt);
+    return APPSOCK_RETURN_OK;
+}
+
+/* Run the requests of a connection until it closes, or until it is parked
+ * between requests */
+static void newsql_loop(struct thr_handle *thr_self,
+                        struct sqlclntstate *clnt, CDB2QUERY *query)
+{
+    struct dbenv *dbenv = thedb;
+    struct sbuf2 *sb = clnt->sb;
+    CDB2SQLQUERY *sql_query;
+    int rc = 0;
+
     while (query) {
         assert(query->sqlquery);
-        struct newsql_appdata *appdata = clnt.appdata;
+        struct newsql_appdata *appdata = clnt->appdata;
         appdata->query = query->sqlquery;
-        clnt.sql_query = query->sqlquery;
-             sql_query = query->sqlquery;
-        clnt.sql = sql_query->sql_query;
-        clnt.query = query;
-        clnt.added_to_hist = 0;
+        clnt->sql_query = query->sqlquery;
+        sql_query = query->sqlquery;
+        clnt->sql = sql_query->sql_query;
+        clnt->query = query;
+        clnt->added_to_hist = 0;
         logmsg(LOGMSG_DEBUG, "Query '%s'\n", sql_query->sql_query);
 
-        if (!clnt.in_client_trans) {
-            bzero(&clnt.effects, sizeof(clnt.effects));
-            bzero(&clnt.log_effects, sizeof(clnt.log_effects));
-            clnt.trans_has_sp = 0;
+        if (!clnt->in_client_trans) {
+            bzero(&clnt->effects, sizeof(clnt->effects));
+            bzero(&clnt->log_effects, sizeof(clnt->log_effects));
+            clnt->trans_has_sp = 0;
+            clnt->commit_file = 0;
+            clnt->commit_offset = 0;
         }
-        clnt.is_newsql = 1;
-        if (clnt.dbtran.mode < TRANLEVEL_SOSQL) {
-            clnt.dbtran.mode = TRANLEVEL_SOSQL;
+        clnt->is_newsql = 1;
+        if (clnt->dbtran.mode < TRANLEVEL_SOSQL) {
+            clnt->dbtran.mode = TRANLEVEL_SOSQL;
         }
-        clnt.osql.sent_column_data = 0;
-        clnt.stop_this_statement = 0;
+        clnt->osql.sent_column_data = 0;
+        clnt->stop_this_statement = 0;
 
-        if ((clnt.tzname[0] == '\0') && sql_query->tzname)
-            strncpy(clnt.tzname, sql_query->tzname, sizeof(clnt.tzname));
+        if ((clnt->tzname[0] == '\0') && sql_query->tzname)
+            strncpy(clnt->tzname, sql_query->tzname, sizeof(clnt->tzname));
 
         if (sql_query->dbname && dbenv->envname &&
             strcasecmp(sql_query->dbname, dbenv->envname)) {
@@ -1707,56 +1746,56 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
                      "DB name mismatch query:%s actual:%s", sql_query->dbname,
                      dbenv->envname);
             logmsg(LOGMSG_ERROR, "%s\n", errstr);
-            newsql_error(&clnt, errstr, CDB2__ERROR_CODE__WRONG_DB);
+            newsql_error(clnt, errstr, CDB2__ERROR_CODE__WRONG_DB);
             goto done;
         }
 
         if (sql_query->client_info) {
-            if (clnt.rawnodestats) {
-                release_node_stats(clnt.argv0, clnt.stack, clnt.origin);
-                clnt.rawnodestats = NULL;
+            if (clnt->rawnodestats) {
+                release_node_stats(clnt->argv0, clnt->stack, clnt->origin);
+                clnt->rawnodestats = NULL;
             }
-            if (clnt.conninfo.pid &&
-                clnt.conninfo.pid != sql_query->client_info->pid) {
+            if (clnt->conninfo.pid &&
+                clnt->conninfo.pid != sql_query->client_info->pid) {
                 /* Different pid is coming without reset. */
                 logmsg(LOGMSG_WARN,
                        "Multiple processes using same socket PID 1 %d "
                        "PID 2 %d Host %.8x\n",
-                       clnt.conninfo.pid, sql_query->client_info->pid,
+                       clnt->conninfo.pid, sql_query->client_info->pid,
                        sql_query->client_info->host_id);
             }
-            clnt.conninfo.pid = sql_query->client_info->pid;
-            clnt.conninfo.node = sql_query->client_info->host_id;
-            if (clnt.argv0) {
-                free(clnt.argv0);
-                clnt.argv0 = NULL;
+            clnt->conninfo.pid = sql_query->client_info->pid;
+            clnt->conninfo.node = sql_query->client_info->host_id;
+            if (clnt->argv0) {
+                free(clnt->argv0);
+                clnt->argv0 = NULL;
             }
-            if (clnt.stack) {
-                free(clnt.stack);
-                clnt.stack = NULL;
+            if (clnt->stack) {
+                free(clnt->stack);
+                clnt->stack = NULL;
             }
             if (sql_query->client_info->argv0) {
-                clnt.argv0 = strdup(sql_query->client_info->argv0);
+                clnt->argv0 = strdup(sql_query->client_info->argv0);
             }
             if (sql_query->client_info->stack) {
-                clnt.stack = strdup(sql_query->client_info->stack);
+                clnt->stack = strdup(sql_query->client_info->stack);
             }
         }
-        if (clnt.rawnodestats == NULL) {
-            clnt.rawnodestats = get_raw_node_stats(
-                clnt.argv0, clnt.stack, clnt.origin, sbuf2fileno(clnt.sb));
+        if (clnt->rawnodestats == NULL) {
+            clnt->rawnodestats = get_raw_node_stats(
+                clnt->argv0, clnt->stack, clnt->origin, sbuf2fileno(clnt->sb));
         }
 
-        if (process_set_commands(dbenv, &clnt))
+        if (process_set_commands(dbenv, clnt))
             goto done;
 
-        if (gbl_rowlocks && clnt.dbtran.mode != TRANLEVEL_SERIAL)
-            clnt.dbtran.mode = TRANLEVEL_SNAPISOL;
+        if (gbl_rowlocks && clnt->dbtran.mode != TRANLEVEL_SERIAL)
+            clnt->dbtran.mode = TRANLEVEL_SNAPISOL;
 
         /* avoid new accepting new queries/transaction on opened connections
            if we are incoherent (and not in a transaction). */
-        if (clnt.ignore_coherency == 0 && !bdb_am_i_coherent(thedb->bdb_env) &&
-            (clnt.ctrl_sqlengine == SQLENG_NORMAL_PROCESS)) {
+        if (clnt->ignore_coherency == 0 && !bdb_am_i_coherent(thedb->bdb_env) &&
+            (clnt->ctrl_sqlengine == SQLENG_NORMAL_PROCESS)) {
             logmsg(LOGMSG_ERROR,
                    "%s line %d td %u new query on incoherent node, "
                    "dropping socket\n",
@@ -1764,116 +1803,152 @@ static int handle_newsql_request(comdb2_appsock_arg_t *arg)
             goto done;
         }
 
-        clnt.heartbeat = 1;
+        /* the client committed elsewhere and wants to read it here */
+        if (sql_query->read_after_lsn && !clnt->in_client_trans &&
+            wait_for_read_after_lsn(clnt, sql_query->read_after_lsn->file,
+                                    sql_query->read_after_lsn->offset)) {
+            newsql_error(clnt, "Node is behind the client's last commit.",
+                         CDB2ERR_CHANGENODE);
+            goto done;
+        }
 
-        if (clnt.had_errors && strncasecmp(clnt.sql, "commit", 6) &&
-            strncasecmp(clnt.sql, "rollback", 8)) {
-            if (clnt.in_client_trans == 0) {
-                clnt.had_errors = 0;
+        clnt->heartbeat = 1;
+
+        if (clnt->had_errors && strncasecmp(clnt->sql, "commit", 6) &&
+            strncasecmp(clnt->sql, "rollback", 8)) {
+            if (clnt->in_client_trans == 0) {
+                clnt->had_errors = 0;
                 /* tell blobmem that I want my priority back
                    when the sql thread is done */
                 comdb2bma_pass_priority_back(blobmem);
-                rc = dispatch_sql_query(&clnt);
+                rc = dispatch_sql_query(clnt);
             } else {
                 /* Do Nothing */
-                newsql_heartbeat(&clnt);
+                newsql_heartbeat(clnt);
             }
-        } else if (clnt.had_errors) {
+        } else if (clnt->had_errors) {
             /* Do Nothing */
-            if (clnt.ctrl_sqlengine == SQLENG_STRT_STATE)
-                clnt.ctrl_sqlengine = SQLENG_NORMAL_PROCESS;
+            if (clnt->ctrl_sqlengine == SQLENG_STRT_STATE)
+                clnt->ctrl_sqlengine = SQLENG_NORMAL_PROCESS;
 
-            clnt.had_errors = 0;
-            clnt.in_client_trans = 0;
+            clnt->had_errors = 0;
+            clnt->in_client_trans = 0;
             rc = -1;
         } else {
             /* tell blobmem that I want my priority back
                when the sql thread is done */
             comdb2bma_pass_priority_back(blobmem);
-            rc = dispatch_sql_query(&clnt);
+            rc = dispatch_sql_query(clnt);
         }
 
-        if (clnt.osql.replay == OSQL_RETRY_DO) {
-            if (clnt.trans_has_sp == 0) {
-                srs_tran_replay(&clnt, arg->thr_self);
+        if (clnt->osql.replay == OSQL_RETRY_DO) {
+            if (clnt->trans_has_sp == 0) {
+                srs_tran_replay(clnt, thr_self);
             } else {
-                osql_set_replay(__FILE__, __LINE__, &clnt, OSQL_RETRY_NONE);
-                srs_tran_destroy(&clnt);
+                osql_set_replay(__FILE__, __LINE__, clnt, OSQL_RETRY_NONE);
+                srs_tran_destroy(clnt);
             }
         } else {
             /* if this transaction is done (marked by SQLENG_NORMAL_PROCESS),
                clean transaction sql history
             */
-            if (clnt.osql.history &&
-                clnt.ctrl_sqlengine == SQLENG_NORMAL_PROCESS)
-                srs_tran_destroy(&clnt);
+            if (clnt->osql.history &&
+                clnt->ctrl_sqlengine == SQLENG_NORMAL_PROCESS)
+                srs_tran_destroy(clnt);
         }
 
-        if (rc && !clnt.in_client_trans)
+        if (rc && !clnt->in_client_trans)
             goto done;
 
-        pthread_mutex_lock(&clnt.wait_mutex);
-        if (clnt.query) {
-            if (clnt.added_to_hist == 1) {
-                clnt.query = NULL;
+        pthread_mutex_lock(&clnt->wait_mutex);
+        if (clnt->query) {
+            if (clnt->added_to_hist == 1) {
+                clnt->query = NULL;
             } else {
-                cdb2__query__free_unpacked(clnt.query, &pb_alloc);
-                clnt.query = NULL;
+                cdb2__query__free_unpacked(clnt->query, &pb_alloc);
+                clnt->query = NULL;
             }
         }
-        pthread_mutex_unlock(&clnt.wait_mutex);
+        pthread_mutex_unlock(&clnt->wait_mutex);
+
+        /* Between requests and outside a transaction, the connection
+           doesn't need this thread until its next request header is in */
+        if (!clnt->in_client_trans &&
+            clnt->ctrl_sqlengine == SQLENG_NORMAL_PROCESS &&
+            appsock_park(clnt->sb, bdb_attr_get(thedb->bdb_attr,
+                                                BDB_ATTR_MAX_SQL_IDLE_TIME),
+                         sizeof(struct newsqlheader), newsql_resume,
+                         clnt) == 0)
+            return;
 
-        query = read_newsql_query(dbenv, &clnt, sb);
+        query = read_newsql_query(dbenv, clnt, sb);
     }
 
 done:
-    if (clnt.ctrl_sqlengine == SQLENG_INTRANS_STATE) {
-        handle_sql_intrans_unrecoverable_error(&clnt);
+    newsql_cleanup(clnt);
+}
+
+static void newsql_resume(struct thr_handle *thr_self, void *arg, int drop)
+{
+    struct sqlclntstate *clnt = arg;
+    CDB2QUERY *query = NULL;
+
+    if (!drop) {
+        thrman_change_type(thr_self, THRTYPE_APPSOCK_SQL);
+        query = read_newsql_query(thedb, clnt, clnt->sb);
     }
+    newsql_loop(thr_self, clnt, query);
+}
 
-    if (clnt.rawnodestats) {
-        release_node_stats(clnt.argv0, clnt.stack, clnt.origin);
-        clnt.rawnodestats = NULL;
+static void newsql_cleanup(struct sqlclntstate *clnt)
+{
+    if (clnt->ctrl_sqlengine == SQLENG_INTRANS_STATE) {
+        handle_sql_intrans_unrecoverable_error(clnt);
+    }
+
+    if (clnt->rawnodestats) {
+        release_node_stats(clnt->argv0, clnt->stack, clnt->origin);
+        clnt->rawnodestats = NULL;
     }
 
-    if (clnt.argv0) {
-        free(clnt.argv0);
-        clnt.argv0 = NULL;
+    if (clnt->argv0) {
+        free(clnt->argv0);
+        clnt->argv0 = NULL;
     }
-    if (clnt.stack) {
-        free(clnt.stack);
-        clnt.stack = NULL;
+    if (clnt->stack) {
+        free(clnt->stack);
+        clnt->stack = NULL;
     }
 
-    close_sp(&clnt);
-    osql_clean_sqlclntstate(&clnt);
+    close_sp(clnt);
+    osql_clean_sqlclntstate(clnt);
 
-    if (clnt.dbglog) {
-        sbuf2close(clnt.dbglog);
-        clnt.dbglog = NULL;
+    if (clnt->dbglog) {
+        sbuf2close(clnt->dbglog);
+        clnt->dbglog = NULL;
     }
 
-    if (clnt.query) {
-        if (clnt.added_to_hist == 1) {
-            clnt.query = NULL;
+    if (clnt->query) {
+        if (clnt->added_to_hist == 1) {
+            clnt->query = NULL;
         } else {
-            cdb2__query__free_unpacked(clnt.query, &pb_alloc);
-            clnt.query = NULL;
+            cdb2__query__free_unpacked(clnt->query, &pb_alloc);
+            clnt->query = NULL;
         }
     }
 
-    free_newsql_appdata(&clnt);
+    free_newsql_appdata(clnt);
 
     /* XXX free logical tran?  */
-    close_appsock(sb);
-    cleanup_clnt(&clnt);
+    close_appsock(clnt->sb);
+    cleanup_clnt(clnt);
 
-    pthread_mutex_destroy(&clnt.wait_mutex);
-    pthread_cond_destroy(&clnt.wait_cond);
-    pthread_mutex_destroy(&clnt.write_lock);
-    pthread_mutex_destroy(&clnt.dtran_mtx);
+    pthread_mutex_destroy(&clnt->wait_mutex);
+    pthread_cond_destroy(&clnt->wait_cond);
+    pthread_mutex_destroy(&clnt->write_lock);
+    pthread_mutex_destroy(&clnt->dtran_mtx);
 
-    return APPSOCK_RETURN_OK;
+    free(clnt);
 }
 
 comdb2_appsock_t newsql_plugin = {
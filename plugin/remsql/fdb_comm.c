@@ -2571,7 +2571,8 @@ static enum svc_move_types move_type(int type)
 
 int fdb_bend_send_row(SBUF2 *sb, fdb_msg_t *msg, char *cid,
                         unsigned long long genid, char *data, int datalen,
-                        char *datacopy, int datacopylen, int ret, int isuuid)
+                        char *datacopy, int datacopylen, int ret, int isuuid,
+                        int flush)
 {
     int rc;
     fdb_msg_t lcl_msg;
@@ -2596,7 +2597,7 @@ int fdb_bend_send_row(SBUF2 *sb, fdb_msg_t *msg, char *cid,
     msg->dr.datacopylen = datacopylen;
     msg->dr.datacopy = datacopy;
 
-    rc = fdb_msg_write_message(sb, msg, 1);
+    rc = fdb_msg_write_message(sb, msg, flush);
 
     if (gbl_fdb_track) {
         fdb_msg_print_message(sb, msg, "sending msg");
@@ -2632,7 +2633,7 @@ int fdb_bend_cursor_move(SBUF2 *sb, fdb_msg_t *msg, svc_callback_arg_t *arg)
     }
 
     rc = fdb_bend_send_row(sb, msg, NULL, genid, data, datalen, datacopy,
-                             datacopylen, rc, arg->isuuid);
+                             datacopylen, rc, arg->isuuid, 1);
 
     return rc;
 }
@@ -2691,7 +2692,7 @@ int fdb_bend_cursor_find(SBUF2 *sb, fdb_msg_t *msg, svc_callback_arg_t *arg)
     }
 
     rc = fdb_bend_send_row(sb, msg, NULL, genid, data, datalen, datacopy,
-                             datacopylen, rc, arg->isuuid);
+                             datacopylen, rc, arg->isuuid, 1);
 
     return rc;
 }
@@ -2739,7 +2740,7 @@ int fdb_bend_run_sql(SBUF2 *sb, fdb_msg_t *msg, svc_callback_arg_t *arg)
             clnt->fdb_state.remote_sql_sb, cid,
             clnt->fdb_state.err.errstr, /* the actual row is the errstr */
             strlen(clnt->fdb_state.err.errstr) + 1, clnt->fdb_state.err.errval,
-            arg->isuuid);
+            arg->isuuid, 1);
         if (rc) {
             logmsg(LOGMSG_ERROR, "%s: fdb_send_rc failed rc=%d\n", __func__, rc);
         }
@@ -3334,7 +3335,7 @@ static int _check_code_release(SBUF2 *sb, char *cid, int code_release,
 
         /* we need to send back a rc code */
         rc = fdb_svc_sql_row(sb, cid, errstr, strlen(errstr) + 1, errval,
-                             isuuid);
+                             isuuid, 1);
         if (rc) {
             logmsg(LOGMSG_ERROR, "%s: fdb_send_rc failed rc=%d\n", __func__,
                    rc);
@@ -705,6 +705,9 @@ int finalize_alter_table(struct ireq *iq, struct schema_change_type *s,
     newdb->plan = NULL;
     db->schema = clone_schema(newdb->schema);
 
+    /* a rebuilt frozen shard is still frozen */
+    newdb->is_readonly = db->is_readonly;
+
     new_bdb_handle = newdb->handle;
     old_bdb_handle = db->handle;
 
@@ -1179,6 +1179,86 @@ error_prelock:
     return xerr->errval;
 }
 
+/* rebuild a retired shard with the given compression for data and blobs;
+   the rebuild also repacks the btrees, since nothing is written to them
+   anymore.  The rebuild runs in its own schema change thread, this only
+   queues it */
+int sc_timepart_freeze_table(const char *tableName, int compress,
+                             struct errstat *xerr)
+{
+    struct schema_change_type *sc;
+    struct dbtable *db;
+    char *schemabuf = NULL;
+    int rc;
+
+    sc = new_schemachange_type();
+    if (sc == NULL) {
+        xerr->errval = SC_VIEW_ERR_BUG;
+        snprintf(xerr->errstr, sizeof(xerr->errstr), "malloc failed\n");
+        return xerr->errval;
+    }
+
+    /* prepare sc */
+    sc->type = DBTYPE_TAGGED_TABLE;
+
+    snprintf(sc->table, sizeof(sc->table), "%s", tableName);
+    sc->table[sizeof(sc->table) - 1] = '\0';
+
+    sc->scanmode = gbl_default_sc_scanmode;
+
+    sc->live = 1;
+    sc->finalize = 1;
+
+    /* this is a full rebuild, same schema */
+    sc->force_rebuild = 1;
+    sc->same_schema = 1;
+
+    /* compression requires odh */
+    sc->headers = 1;
+    sc->compress = compress;
+    sc->compress_blobs = compress;
+
+    db = get_dbtable_by_name(tableName);
+    if (db == NULL) {
+        xerr->errval = SC_VIEW_ERR_BUG;
+        snprintf(xerr->errstr, sizeof(xerr->errstr), "table '%s' not found\n",
+                 tableName);
+        goto error;
+    }
+    if (get_csc2_file(db->tablename, -1 /*highest csc2_version*/, &schemabuf,
+                      NULL /*csc2len*/)) {
+        xerr->errval = SC_VIEW_ERR_BUG;
+        snprintf(xerr->errstr, sizeof(xerr->errstr),
+                 "could not get schema for table '%s'\n", tableName);
+        goto error;
+    }
+    sc->newcsc2 = schemabuf;
+
+    if (get_db_inplace_updates(db, &sc->ip_updates)) {
+        xerr->errval = SC_VIEW_ERR_BUG;
+        snprintf(xerr->errstr, sizeof(xerr->errstr),
+                 "could not get ipu for table '%s'\n", tableName);
+        goto error;
+    }
+    if (db->instant_schema_change) sc->instant_sc = 1;
+
+    /* start_schema_change checks we are master and that no other schema
+       change runs on the table, and owns sc from here on */
+    rc = start_schema_change(sc);
+    if (rc != SC_OK && rc != SC_ASYNC) {
+        xerr->errval = SC_VIEW_ERR_SC;
+        snprintf(xerr->errstr, sizeof(xerr->errstr),
+                 "failed to start rebuild rc %d", rc);
+        return xerr->errval;
+    }
+
+    return xerr->errval = SC_VIEW_NOERR;
+
+error:
+    free_schema_change_type(sc);
+    return xerr->errval;
+}
+
 /* shortcut for running table upgrade in a schemachange shell */
 int start_table_upgrade(struct dbenv *dbenv, const char *tbl,
                         unsigned long long genid, int full, int partial,
@@ -1272,6 +1352,34 @@ void handle_setcompr(SBUF2 *sb)
     sbuf2flush(sb);
 }
 
+/* Change the compression of new writes to tbl without a message trap. Used
+ * by the compression advisor on the master. */
+int setcompr_table(const char *tbl, const char *rec, const char *blob)
+{
+    int rc;
+    struct dbtable *db;
+    struct ireq iq;
+
+    if (thedb->master != gbl_mynode)
+        return -1;
+
+    wrlock_schema_lk();
+    if ((db = get_dbtable_by_name(tbl)) == NULL || !db->odh ||
+        gbl_schema_change_in_progress) {
+        unlock_schema_lk();
+        return -1;
+    }
+    init_fake_ireq(thedb, &iq);
+    iq.usedb = db;
+    rc = do_setcompr(&iq, rec, blob);
+    unlock_schema_lk();
+
+    if (rc)
+        logmsg(LOGMSG_ERROR, "%s: failed to set compression for %s rc %d\n",
+               __func__, tbl, rc);
+    return rc;
+}
+
 void vsb_printf(loglvl lvl, SBUF2 *sb, const char *sb_prefix,
                 const char *prefix, const char *fmt, va_list args)
 {
@@ -1656,6 +1656,94 @@ static void decodeIntArray(
   }
 }
 
+/* COMDB2 MODIFICATION
+** Column statistics.  Analyze stores them in sqlite_stat1 next to the index
+** rows, so they are replicated, backed out and reloaded the same way:
+**
+**     idx = "#H:col"       stat = "nrow nnull ndistinct b0 b1 ... bN"
+**     idx = "#C:col1,col2" stat = "nrow ndistinct"
+*/
+void sqlite3DeleteColStats(Table *pTab){
+  ColStat *p, *pNext;
+  for(p=pTab->pColStat; p; p=pNext){
+    pNext = p->pNext;
+    sqlite3_free(p->aBound);
+    sqlite3_free(p);
+  }
+  pTab->pColStat = 0;
+}
+
+ColStat *sqlite3ColStatFind(Table *pTab, int iCol, int iCol2){
+  ColStat *p;
+  for(p=pTab->pColStat; p; p=p->pNext){
+    if( p->iCol==iCol && p->iCol2==iCol2 ) return p;
+    if( p->iCol==iCol2 && p->iCol2==iCol ) return p;
+  }
+  return 0;
+}
+
+static int colStatColumn(Table *pTab, const char *zName, int n){
+  int i;
+  for(i=0; i<pTab->nCol; i++){
+    const char *z = pTab->aCol[i].zName;
+    if( sqlite3StrNICmp(z, zName, n)==0 && z[n]==0 ) return i;
+  }
+  return -1;
+}
+
+static void loadColStat(Table *pTab, const char *zIdx, const char *zStat){
+  ColStat *p;
+  const char *zComma;
+  char *zEnd;
+  int iCol, iCol2 = -1;
+  int i;
+
+  if( zIdx[1]=='H' && zIdx[2]==':' ){
+    iCol = colStatColumn(pTab, &zIdx[3], sqlite3Strlen30(&zIdx[3]));
+  }else if( zIdx[1]=='C' && zIdx[2]==':' && (zComma = strchr(zIdx, ','))!=0 ){
+    iCol = colStatColumn(pTab, &zIdx[3], (int)(zComma - &zIdx[3]));
+    iCol2 = colStatColumn(pTab, zComma+1, sqlite3Strlen30(zComma+1));
+    if( iCol2<0 ) return;
+  }else{
+    return;
+  }
+  if( iCol<0 || sqlite3ColStatFind(pTab, iCol, iCol2) ) return;
+
+  p = sqlite3MallocZero(sizeof(ColStat));
+  if( p==0 ) return;
+  p->iCol = iCol;
+  p->iCol2 = iCol2;
+  p->nRow = (tRowcnt)strtoull(zStat, &zEnd, 10);
+  if( iCol2<0 ){
+    p->nNull = (tRowcnt)strtoull(zEnd, &zEnd, 10);
+  }
+  p->nDistinct = (tRowcnt)strtoull(zEnd, &zEnd, 10);
+  if( iCol2<0 ){
+    for(i=0; zEnd[i]; i++){
+      if( zEnd[i]==' ' ) p->nBound++;
+    }
+    if( p->nBound>=2 ){
+      p->aBound = sqlite3MallocZero(sizeof(double) * p->nBound);
+      if( p->aBound==0 ){
+        sqlite3_free(p);
+        return;
+      }
+      for(i=0; i<p->nBound; i++){
+        p->aBound[i] = strtod(zEnd, &zEnd);
+      }
+    }else{
+      p->nBound = 0;
+    }
+  }
+  if( p->nRow==0 || p->nDistinct==0 ){
+    sqlite3_free(p->aBound);
+    sqlite3_free(p);
+    return;
+  }
+  p->pNext = pTab->pColStat;
+  pTab->pColStat = p;
+}
+
 /*
 ** This callback is invoked once for each index when reading the
 ** sqlite_stat1 table.
@@ -1692,6 +1780,12 @@ static int analysisLoader(void *pData, int argc, char **argv, char **NotUsed){
   }
   z = argv[2];
 
+  /* COMDB2 MODIFICATION: column statistics */
+  if( pIndex==0 && argv[1] && argv[1][0]=='#' ){
+    loadColStat(pTable, argv[1], z);
+    return 0;
+  }
+
   if( pIndex ){
     tRowcnt *aiRowEst = 0;
     int nCol = pIndex->nKeyCol+1;
@@ -2029,6 +2123,18 @@ int sqlite3AnalysisLoad(sqlite3 *db, int iDb){
       ** a index for an already attached table */
     }
   }
+  for(i=sqliteHashFirst(&db->aDb[iDb].pSchema->tblHash);i;i=sqliteHashNext(i)){
+    Table *pTab = sqliteHashData(i);
+    /* COMDB2 MODIFICATION: same rule as for the indexes above */
+    if( iDb <= 1
+     || db->init.busy==0
+     || db->init.zTblName == NULL
+     || pTab->zName == NULL
+     || sqlite3StrICmp(db->init.zTblName, pTab->zName)==0
+    ){
+      sqlite3DeleteColStats(pTab);
+    }
+  }
 
   /* Load new statistics out of the sqlite_stat1 table */
   sInfo.db = db;
@@ -853,6 +853,8 @@ static void SQLITE_NOINLINE deleteTable(sqlite3 *db, Table *pTable){
   /* Delete the Table structure itself.
   */
   sqlite3DeleteColumnNames(db, pTable);
+  /* COMDB2 MODIFICATION */
+  if( db==0 || db->pnBytesFreed==0 ) sqlite3DeleteColStats(pTable);
   sqlite3DbFree(db, pTable->zName);
   sqlite3DbFree(db, pTable->zColAff);
   sqlite3SelectDelete(db, pTable->pSelect);
@@ -1856,6 +1856,7 @@ enum {
     KEY_DUP = 1 << 0,
     KEY_DATACOPY = 1 << 1,
     KEY_DELETED = 1 << 2,
+    KEY_HASH = 1 << 3,
 };
 
 struct comdb2_key {
@@ -2384,6 +2385,10 @@ static char *format_csc2(struct comdb2_ddl_context *ctx)
             strbuf_append(csc2, "datacopy ");
         }
 
+        if ((key->flags & KEY_HASH) != 0) {
+            strbuf_append(csc2, "hash ");
+        }
+
         strbuf_appendf(csc2, "\"%s\" = ", key->name);
 
         int added = 0;
@@ -3019,6 +3024,9 @@ static int retrieve_schema(Parse *pParse, struct comdb2_ddl_context *ctx)
         if (schema->ix[i]->flags & SCHEMA_DATACOPY) {
             key->flags |= KEY_DATACOPY;
         }
+        if (schema->ix[i]->flags & SCHEMA_HASH) {
+            key->flags |= KEY_HASH;
+        }
 
         listc_init(&key->idx_col_list,
                    offsetof(struct comdb2_index_column, lnk));
@@ -3746,7 +3754,7 @@ static void comdb2AddIndexInt(
     ExprSpan *pPIWhere, /* WHERE clause for partial indices */
     int sortOrder,      /* Sort order of primary key when pList==NULL */
     u8 idxType,         /* The index type */
-    int withOpts        /* WITH options (DATACOPY) */
+    int withOpts        /* WITH options (DATACOPY, HASH) */
 )
 {
     struct comdb2_ddl_context *ctx = pParse->comdb2_ddl_ctx;
@@ -3808,10 +3816,14 @@ static void comdb2AddIndexInt(
         }
     }
 
-    if (withOpts == 1) {
+    if (withOpts & WITH_DATACOPY) {
         key->flags |= KEY_DATACOPY;
     }
 
+    if (withOpts & WITH_HASH) {
+        key->flags |= KEY_HASH;
+    }
+
     /* Initialize the index column list. */
     listc_init(&key->idx_col_list, offsetof(struct comdb2_index_column, lnk));
 
@@ -3979,7 +3991,7 @@ void comdb2AddIndex(
     ExprSpan *pPIWhere, /* WHERE clause for partial indices */
     int sortOrder,      /* Sort order of primary key when pList==NULL */
     u8 idxType,         /* The index type */
-    int withOpts        /* WITH options (DATACOPY) */
+    int withOpts        /* WITH options (DATACOPY, HASH) */
 )
 {
     struct comdb2_ddl_context *ctx = pParse->comdb2_ddl_ctx;
@@ -4041,7 +4053,7 @@ void comdb2CreateIndex(
     int sortOrder,      /* Sort order of primary key when pList==NULL */
     int ifNotExist,     /* Omit error if index already exists */
     u8 idxType,         /* The index type */
-    int withOpts,       /* WITH options (DATACOPY) */
+    int withOpts,       /* WITH options (DATACOPY, HASH) */
     int temp)
 {
     Vdbe *v;
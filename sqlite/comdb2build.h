@@ -29,6 +29,10 @@
 #define PAGE_ORDER    0x4000
 #define READ_ONLY     0x8000
 
+/* CREATE INDEX ... WITH options */
+#define WITH_DATACOPY 0x0001
+#define WITH_HASH     0x0002
+
 #define REBUILD_ALL     1
 #define REBUILD_DATA    2
 #define REBUILD_BLOB    4
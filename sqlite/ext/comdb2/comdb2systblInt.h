@@ -28,6 +28,9 @@ const sqlite3_module systblTimepartShardsModule;
 const sqlite3_module systblTimepartEventsModule;
 
 int systblTypeSamplesInit(sqlite3 *db);
+int systblCompressionStatsInit(sqlite3 *db);
+int systblDefragStatsInit(sqlite3 *db);
+int systblQueryMemoryInit(sqlite3 *db);
 
 /* Simple yes/no answer for booleans */
 #define YESNO(x) ((x) ? "Y" : "N")
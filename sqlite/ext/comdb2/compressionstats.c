@@ -0,0 +1,69 @@
+/*
+   Copyright 2018 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "cdb2api.h"
+
+/* Results of the last compression advisor run, see db/testcompr.c */
+
+static int get_compression_stats(void **data, int *npoints)
+{
+    struct compr_advisor_stat *stats = NULL;
+    int rc = compr_advisor_stats(&stats, npoints);
+    *data = stats;
+    return rc;
+}
+
+static void free_compression_stats(void *data, int npoints)
+{
+    compr_advisor_stats_free(data, npoints);
+}
+
+int systblCompressionStatsInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_compression_stats", get_compression_stats,
+        free_compression_stats, sizeof(struct compr_advisor_stat),
+        CDB2_CSTRING, "tablename",
+        offsetof(struct compr_advisor_stat, tablename),
+        CDB2_CSTRING, "kind", offsetof(struct compr_advisor_stat, kind),
+        CDB2_CSTRING, "algorithm",
+        offsetof(struct compr_advisor_stat, algorithm),
+        CDB2_INTEGER, "sampled_rows",
+        offsetof(struct compr_advisor_stat, sampled_rows),
+        CDB2_INTEGER, "sampled_at",
+        offsetof(struct compr_advisor_stat, sampled_at),
+        CDB2_INTEGER, "original_bytes",
+        offsetof(struct compr_advisor_stat, original_bytes),
+        CDB2_INTEGER, "compressed_bytes",
+        offsetof(struct compr_advisor_stat, compressed_bytes),
+        CDB2_REAL, "percent", offsetof(struct compr_advisor_stat, percent),
+        CDB2_REAL, "decode_ns_per_byte",
+        offsetof(struct compr_advisor_stat, decode_ns_per_byte),
+        CDB2_CSTRING, "current", offsetof(struct compr_advisor_stat, current),
+        CDB2_CSTRING, "recommended",
+        offsetof(struct compr_advisor_stat, recommended),
+        CDB2_CSTRING, "switched",
+        offsetof(struct compr_advisor_stat, switched),
+        SYSTABLE_END_OF_FIELDS);
+}
@@ -0,0 +1,58 @@
+/*
+   Copyright 2018 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "cdb2api.h"
+
+/* Results of the last defrag run, see db/defrag.c */
+
+static int get_defrag_stats(void **data, int *npoints)
+{
+    struct defrag_stat *stats = NULL;
+    int rc = defrag_stats(&stats, npoints);
+    *data = stats;
+    return rc;
+}
+
+static void free_defrag_stats(void *data, int npoints)
+{
+    defrag_stats_free(data, npoints);
+}
+
+int systblDefragStatsInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_defrag_stats", get_defrag_stats, free_defrag_stats,
+        sizeof(struct defrag_stat), CDB2_CSTRING, "tablename",
+        offsetof(struct defrag_stat, tablename), CDB2_CSTRING, "filename",
+        offsetof(struct defrag_stat, filename), CDB2_CSTRING, "status",
+        offsetof(struct defrag_stat, status), CDB2_INTEGER,
+        "leaf_pages_before", offsetof(struct defrag_stat, leaf_pages_before),
+        CDB2_REAL, "fill_before", offsetof(struct defrag_stat, fill_before),
+        CDB2_INTEGER, "leaf_pages_after",
+        offsetof(struct defrag_stat, leaf_pages_after), CDB2_REAL,
+        "fill_after", offsetof(struct defrag_stat, fill_after), CDB2_INTEGER,
+        "merges", offsetof(struct defrag_stat, merges), CDB2_INTEGER,
+        "defragged_at", offsetof(struct defrag_stat, defragged_at),
+        SYSTABLE_END_OF_FIELDS);
+}
@@ -0,0 +1,56 @@
+/*
+   Copyright 2018 Bloomberg Finance L.P.
+
+   Licensed under the Apache License, Version 2.0 (the "License");
+   you may not use this file except in compliance with the License.
+   You may obtain a copy of the License at
+
+       http://www.apache.org/licenses/LICENSE-2.0
+
+   Unless required by applicable law or agreed to in writing, software
+   distributed under the License is distributed on an "AS IS" BASIS,
+   WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+   See the License for the specific language governing permissions and
+   limitations under the License.
+ */
+
+#include <stdlib.h>
+#include <string.h>
+#include <stddef.h>
+
+#include "comdb2.h"
+#include "comdb2systblInt.h"
+#include "sql.h"
+#include "ezsystables.h"
+#include "cdb2api.h"
+
+/* Memory used by the running statements, see query_mem_stats() */
+
+static int get_query_mem_stats(void **data, int *npoints)
+{
+    struct query_mem_stat *stats = NULL;
+    int rc = query_mem_stats(&stats, npoints);
+    *data = stats;
+    return rc;
+}
+
+static void free_query_mem_stats(void *data, int npoints)
+{
+    query_mem_stats_free(data, npoints);
+}
+
+int systblQueryMemoryInit(sqlite3 *db)
+{
+    return create_system_table(
+        db, "comdb2_query_memory", get_query_mem_stats, free_query_mem_stats,
+        sizeof(struct query_mem_stat), CDB2_INTEGER, "id",
+        offsetof(struct query_mem_stat, id), CDB2_CSTRING, "origin",
+        offsetof(struct query_mem_stat, origin), CDB2_CSTRING, "sql",
+        offsetof(struct query_mem_stat, sql), CDB2_INTEGER, "used",
+        offsetof(struct query_mem_stat, used), CDB2_INTEGER, "peak",
+        offsetof(struct query_mem_stat, peak), CDB2_INTEGER, "mem_limit",
+        offsetof(struct query_mem_stat, limit), CDB2_INTEGER, "spills",
+        offsetof(struct query_mem_stat, spills), CDB2_INTEGER,
+        "connection_peak", offsetof(struct query_mem_stat, connection_peak),
+        SYSTABLE_END_OF_FIELDS);
+}
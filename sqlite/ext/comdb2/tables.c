@@ -257,6 +257,12 @@ int comdb2SystblInit(
     rc = sqlite3_create_module(db, "comdb2_timepartevents", &systblTimepartEventsModule, 0);
   if (rc == SQLITE_OK)
     rc = systblTypeSamplesInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblCompressionStatsInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblDefragStatsInit(db);
+  if (rc == SQLITE_OK)
+    rc = systblQueryMemoryInit(db);
 #endif
   return rc;
 }
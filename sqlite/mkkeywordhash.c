@@ -290,6 +290,7 @@ static Keyword aKeywordTable[] = {
   { "GENID48",          "TK_GENID48",       ALWAYS,                 0},
   { "GET",              "TK_GET",           ALWAYS,                 0},
   { "GRANT",            "TK_GRANT",         ALWAYS,                 0},
+  { "HASH",             "TK_HASH",          ALWAYS,                 0},
   { "IPU",              "TK_IPU",           ALWAYS,                 0},
   { "ISC",              "TK_ISC",           ALWAYS,                 0},
   { "KW",               "TK_KW",            ALWAYS,                 0},
@@ -252,7 +252,7 @@ columnname(A) ::= nm(A) typetoken(Y). {comdb2AddColumn(pParse,&A,&Y);}
 //
   ADD AGGREGATE ALIAS AUTHENTICATION BLOBFIELD BULKIMPORT CHECK
   COMMITSLEEP CONSUMER CONVERTSLEEP COVERAGE CRLE DATA DATABLOB DATACOPY DBPAD
-  DEFERRABLE DISABLE DRYRUN ENABLE FOR FUNCTION GENID48 GET GRANT
+  DEFERRABLE DISABLE DRYRUN ENABLE FOR FUNCTION GENID48 GET GRANT HASH
   IPU ISC KW LUA LZ4 NONE ODH OFF OP OPTIONS PAGEORDER PARTITION PASSWORD PERIOD
   PROCEDURE PUT REBUILD READ READONLY REC RESERVED RETENTION REVOKE RLE
   ROWLOCKS SCALAR SCHEMACHANGE SKIPSCAN START SUMMARIZE THREADS THRESHOLD TIME
@@ -1357,9 +1357,17 @@ uniqueflag(A) ::= UNIQUE.  {A = OE_Abort;}
 uniqueflag(A) ::= .        {A = OE_None;}
 
 %type with_opt {int}
-with_opt(A) ::= WITH DATACOPY. {A = 1;}
+with_opt(A) ::= WITH with_list(X). {A = X;}
 with_opt(A) ::= . {A = 0;}
 
+%type with_list {int}
+with_list(A) ::= with_list(X) with_item(Y). {A = X | Y;}
+with_list(A) ::= with_item(X). {A = X;}
+
+%type with_item {int}
+with_item(A) ::= DATACOPY. {A = WITH_DATACOPY;}
+with_item(A) ::= HASH. {A = WITH_HASH;}
+
 // The eidlist non-terminal (Expression Id List) generates an ExprList
 // from a list of identifiers.  The identifier names are in ExprList.a[].zName.
 // This list is stored in an ExprList rather than an IdList so that it
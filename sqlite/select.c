@@ -5023,6 +5023,7 @@ static void updateAccumulator(Parse *pParse, AggInfo *pAggInfo){
 ** count(*) query ("SELECT count(*) FROM pTab").
 */
 #ifndef SQLITE_OMIT_EXPLAIN
+int fdb_push_count_table(const char *tblname);
 static void explainSimpleCount(
   Parse *pParse,                  /* Parse context */
   Table *pTab,                    /* Table being queried */
@@ -5030,11 +5031,20 @@ static void explainSimpleCount(
 ){
   if( pParse->explain==2 ){
     int bCover = (pIdx!=0 && (HasRowid(pTab) || !IsPrimaryKeyIndex(pIdx)));
-    char *zEqp = sqlite3MPrintf(pParse->db, "SCAN TABLE %s%s%s",
-        pTab->zName,
-        bCover ? " USING COVERING INDEX " : "",
-        bCover ? pIdx->zName : ""
-    );
+    /* COMDB2 MODIFICATION */
+    /* count(*) on a remote table runs in the remote db */
+    int iDb = sqlite3SchemaToIndex(pParse->db, pTab->pSchema);
+    char *zEqp;
+    if( iDb>1 && fdb_push_count_table(pTab->zName) ){
+      zEqp = sqlite3MPrintf(pParse->db, "REMOTE COUNT ON %s.%s",
+          pParse->db->aDb[iDb].zDbSName, pTab->zName);
+    }else{
+      zEqp = sqlite3MPrintf(pParse->db, "SCAN TABLE %s%s%s",
+          pTab->zName,
+          bCover ? " USING COVERING INDEX " : "",
+          bCover ? pIdx->zName : ""
+      );
+    }
     sqlite3VdbeAddOp4(
         pParse->pVdbe, OP_Explain, pParse->iSelectId, 0, 0, zEqp, P4_DYNAMIC
     );
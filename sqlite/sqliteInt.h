@@ -1044,6 +1044,7 @@ typedef struct SelectDest SelectDest;
 typedef struct SrcList SrcList;
 typedef struct StrAccum StrAccum;
 typedef struct Table Table;
+typedef struct ColStat ColStat;
 typedef struct TableLock TableLock;
 typedef struct Token Token;
 typedef struct TreeView TreeView;
@@ -1893,6 +1894,25 @@ struct Table {
   /* COMDB2 MODIFICATION */
   int hasPartIdx;
   int hasExprIdx;
+  ColStat *pColStat;   /* Column histograms from sqlite_stat1 */
+};
+
+/* COMDB2 MODIFICATION
+** Statistics on a column that is not the leading column of an index, or on
+** a pair of such columns, loaded from the "#H:col" and "#C:col1,col2" rows
+** that analyze writes to sqlite_stat1.  A column has an equi-depth histogram:
+** each of the nBound-1 buckets between consecutive aBound[] values holds the
+** same share of the non-null rows.  A pair only has nDistinct.
+*/
+struct ColStat {
+  ColStat *pNext;
+  i16 iCol;            /* Column, or first column of a pair */
+  i16 iCol2;           /* Second column of a pair, or -1 */
+  tRowcnt nRow;        /* Rows in the table when collected */
+  tRowcnt nNull;       /* Rows where the column is NULL */
+  tRowcnt nDistinct;   /* Distinct non-null values */
+  int nBound;          /* Number of entries in aBound[] */
+  double *aBound;      /* Bucket boundaries, ascending */
 };
 
 /*
@@ -4102,6 +4122,8 @@ int sqlite3FindDb(sqlite3*, Token*);
 int sqlite3FindDbName(sqlite3 *, const char *);
 int sqlite3AnalysisLoad(sqlite3*,int iDB);
 void sqlite3DeleteIndexSamples(sqlite3*,Index*);
+void sqlite3DeleteColStats(Table*);
+ColStat *sqlite3ColStatFind(Table*,int,int);
 void sqlite3DefaultRowEst(Index*);
 void sqlite3RegisterLikeFunctions(sqlite3*, int);
 int sqlite3IsLikeFunction(sqlite3*,Expr*,int*,char*);
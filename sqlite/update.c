@@ -325,7 +325,10 @@ void sqlite3Update(
    */
   if(isView && strncmp(pTab->aCol[0].zName, "__hidden__rowid",
                        strlen("__hidden__rowid")+1) == 0){
-          sqlite3CreateUpdCols(v, db, pTab->nCol-1, aXRef+1);
+          /* time partition views also end with the hidden shard range */
+          int nCol = pTab->nCol;
+          while( nCol>1 && IsHiddenColumn(&pTab->aCol[nCol-1]) ) nCol--;
+          sqlite3CreateUpdCols(v, db, nCol-1, aXRef+1);
   } else {
     sqlite3CreateUpdCols(v, db, pTab->nCol, aXRef);
   }
@@ -37,6 +37,8 @@ void print_cooked_access(BtCursor *pCur, int col);
 void comdb2SetWriteFlag(int wrflag);
 int is_datacopy(BtCursor *pCur, int *fnum);
 int get_datacopy(BtCursor *pCur, int fnum, Mem *m);
+int get_data_length_only(BtCursor *pCur, struct schema *sc, uint8_t *in,
+                         int fnum, Mem *m, int opflags);
 
 
 #define cur_is_raw(pCur)                               \
@@ -2902,6 +2904,14 @@ case OP_Column: {
     else if( pC->isTable ){
       zData = (u8 *)sqlite3BtreeDataFetch(pCrsr, &avail);
       assert(zData != NULL);
+      /* Blob content is irrelevant for typeof() and length(), the record
+      ** has the length; don't fetch (or expand) it */
+      if( get_data_length_only(pCrsr, pCrsr->sc, (u8 *) zData, p2, pDest,
+                               pOp->p5)==0 ){
+        pDest->db = p->db;
+        pDest->enc = encoding;
+        goto op_column_out;
+      }
       rc = get_data(pCrsr, pCrsr->sc, (u8 *) zData, p2, pDest, 0, pCrsr->clnt->tzname);
     }else{
       datacopy = p2;
@@ -806,6 +806,7 @@ static int vdbeSorterCompare(
 }
 
 extern int gbl_sqlite_sorter_mem;
+extern int comdb2ma_spill(void);
 
 /*
 ** A specially optimized version of vdbeSorterCompare() that assumes that
@@ -1859,6 +1860,11 @@ int sqlite3VdbeSorterWrite(
        || (pSorter->list.szPMA > pSorter->mnPmaSize && sqlite3HeapNearlyFull())
       );
     }
+    /* COMDB2 MODIFICATION */
+    /* the statement is over its memory budget: go to disk */
+    if( !bFlush && pSorter->list.szPMA > pSorter->mnPmaSize ){
+      bFlush = comdb2ma_spill();
+    }
     if( bFlush ){
       rc = vdbeSorterFlushPMA(pSorter);
       pSorter->list.szPMA = 0;
@@ -27,6 +27,7 @@ static int whereLoopResize(sqlite3*, WhereLoop*, int);
 
 int is_comdb2_index_unique(const char *tbl, char *idx);
 int comdb2_get_planner_effort();
+int timepart_is_shard(const char *name, int lock);
 
 static char *comdb2IndexName(char *src, char *dest)
 {
@@ -45,6 +46,43 @@ static char *comdb2IndexName(char *src, char *dest)
   return dest;
 }
 
+/* Comdb2: value of an integer literal, possibly negated */
+static int comdb2ExprInt64(Expr *p, i64 *pVal){
+  if( p==0 ) return 0;
+  if( p->flags & EP_IntValue ){
+    *pVal = p->u.iValue;
+    return 1;
+  }
+  if( p->op==TK_INTEGER ) return sqlite3DecOrHexToI64(p->u.zToken, pVal)==0;
+  if( p->op==TK_UMINUS && comdb2ExprInt64(p->pLeft, pVal) ){
+    *pVal = -*pVal;
+    return 1;
+  }
+  return 0;
+}
+
+/* Comdb2: true if p compares two integer literals, like a shard range
+** substituted in a partition branch, and is known to fail */
+static int comdb2ExprIsFalseCompare(Expr *p){
+  i64 a, b;
+  switch( p->op ){
+    case TK_EQ: case TK_NE: case TK_LT: case TK_LE: case TK_GT: case TK_GE:
+      break;
+    default:
+      return 0;
+  }
+  if( !comdb2ExprInt64(p->pLeft, &a) || !comdb2ExprInt64(p->pRight, &b) ){
+    return 0;
+  }
+  switch( p->op ){
+    case TK_EQ: return a!=b;
+    case TK_NE: return a==b;
+    case TK_LT: return a>=b;
+    case TK_LE: return a>b;
+    case TK_GT: return a<=b;
+    default:    return a<b;
+  }
+}
 
 /*
 ** Return the estimated number of output rows from a WHERE clause
@@ -2181,7 +2219,108 @@ static int whereLoopInsert(WhereLoopBuilder *pBuilder, WhereLoop *pTemplate){
 ** "x" column is boolean or else -1 or 0 or 1 is a common default value
 ** on the "x" column and so in that case only cap the output row estimate
 ** at 1/2 instead of 1/4.
+**
+** COMDB2 MODIFICATION: terms on a column that analyze collected a histogram
+** for use it instead of the heuristics, and pairs of "x==EXPR" terms on
+** columns with a correlation statistic are not treated as independent.
 */
+static LogEst whereSelToLogEst(double sel){
+  if( sel>=1.0 ) return 0;
+  return -sqlite3LogEstFromDouble(1.0/sel);
+}
+
+/*
+** Fraction of the non-null rows of a column that equal x, from its
+** histogram.  A value that fills whole buckets is that common; any other
+** value gets an equal share of the rows those common values leave.
+*/
+static double whereColStatEq(ColStat *p, double x){
+  int nBucket = p->nBound - 1;
+  int i, j, nCommon = 0;
+  double common = 0.0, nRest;
+
+  if( x<p->aBound[0] || x>p->aBound[nBucket] ) return 0.0;
+  for(i=0; i<p->nBound; i=j){
+    for(j=i+1; j<p->nBound && p->aBound[j]==p->aBound[i]; j++){}
+    if( j-i<2 ) continue;
+    if( p->aBound[i]==x ) return (double)(j-i-1)/nBucket;
+    common += (double)(j-i-1)/nBucket;
+    nCommon++;
+  }
+  nRest = (double)p->nDistinct - nCommon;
+  if( nRest<1.0 ) nRest = 1.0;
+  return (1.0 - common)/nRest;
+}
+
+/*
+** Estimate the selectivity of a term "col <op> expr" on table pTab from
+** the histogram of col.  Return 0 and set *pSel if that was possible.
+*/
+static int whereColStatSel(
+  Parse *pParse,         /* Parsing context */
+  Table *pTab,           /* Table the term filters */
+  int iCur,              /* Cursor of pTab */
+  WhereTerm *pTerm,      /* The term */
+  double *pSel           /* OUT: fraction of the rows it keeps */
+){
+  ColStat *p;
+  Expr *pRight;
+  sqlite3_value *pVal = 0;
+  double x, frac, nonNull;
+  int i, isNum;
+
+  if( pTab==0 || pTab->pColStat==0 ) return 1;
+  if( pTerm->leftCursor!=iCur || pTerm->u.leftColumn<0 ) return 1;
+  if( (pTerm->eOperator & (WO_EQ|WO_LT|WO_LE|WO_GT|WO_GE))==0 ) return 1;
+  if( pTerm->prereqRight ) return 1;
+  p = sqlite3ColStatFind(pTab, pTerm->u.leftColumn, -1);
+  if( p==0 ) return 1;
+
+  nonNull = p->nNull<p->nRow ? (double)(p->nRow - p->nNull)/p->nRow : 0.0;
+  pRight = pTerm->pExpr->pRight;
+  isNum = 0;
+  x = 0.0;
+  if( pRight && p->nBound>=2
+   && sqlite3ValueFromExpr(pParse->db, pRight, ENC(pParse->db),
+                           SQLITE_AFF_NUMERIC, &pVal)==SQLITE_OK && pVal ){
+    if( sqlite3_value_type(pVal)==SQLITE_INTEGER
+     || sqlite3_value_type(pVal)==SQLITE_FLOAT ){
+      x = sqlite3_value_double(pVal);
+      isNum = 1;
+    }
+    sqlite3ValueFree(pVal);
+  }
+
+  if( pTerm->eOperator & WO_EQ ){
+    if( isNum ){
+      frac = whereColStatEq(p, x);
+    }else{
+      /* a bound parameter, or a value the histogram can't place: assume
+      ** an average one */
+      frac = p->nDistinct ? 1.0/p->nDistinct : 0.0;
+    }
+  }else{
+    if( !isNum ) return 1;
+
+    /* fraction of the non-null rows below x */
+    if( x<=p->aBound[0] ){
+      frac = 0.0;
+    }else if( x>=p->aBound[p->nBound-1] ){
+      frac = 1.0;
+    }else{
+      double lo, hi;
+      for(i=1; i<p->nBound-1 && p->aBound[i]<=x; i++){}
+      lo = p->aBound[i-1];
+      hi = p->aBound[i];
+      frac = (i - 1 + (hi>lo ? (x-lo)/(hi-lo) : 0.0)) / (p->nBound-1);
+    }
+    if( pTerm->eOperator & (WO_GT|WO_GE) ) frac = 1.0 - frac;
+  }
+  *pSel = frac * nonNull;
+  if( *pSel < 1.0/p->nRow ) *pSel = 1.0/p->nRow;
+  return 0;
+}
+
 static void whereLoopOutputAdjust(
   WhereClause *pWC,      /* The WHERE clause */
   WhereLoop *pLoop,      /* The loop to adjust downward */
@@ -2191,6 +2330,12 @@ static void whereLoopOutputAdjust(
   Bitmask notAllowed = ~(pLoop->prereq|pLoop->maskSelf);
   int i, j, k;
   LogEst iReduce = 0;    /* pLoop->nOut should not exceed nRow-iReduce */
+  /* COMDB2 MODIFICATION: column histograms */
+  struct SrcList_item *pItem = &pWC->pWInfo->pTabList->a[pLoop->iTab];
+  int aEqCol[8];         /* "x==EXPR" terms estimated from histograms */
+  double aEqSel[8];
+  int nEq = 0;
+  double sel;
 
   assert( (pLoop->wsFlags & WHERE_AUTO_INDEX)==0 );
   for(i=pWC->nTerm, pTerm=pWC->a; i>0; i--, pTerm++){
@@ -2208,6 +2353,13 @@ static void whereLoopOutputAdjust(
         /* If a truth probability is specified using the likelihood() hints,
         ** then use the probability provided by the application. */
         pLoop->nOut += pTerm->truthProb;
+      }else if( whereColStatSel(pWC->pWInfo->pParse, pItem->pTab,
+                                pItem->iCursor, pTerm, &sel)==0 ){
+        pLoop->nOut += whereSelToLogEst(sel);
+        if( (pTerm->eOperator & WO_EQ) && nEq<ArraySize(aEqCol) ){
+          aEqCol[nEq] = pTerm->u.leftColumn;
+          aEqSel[nEq++] = sel;
+        }
       }else{
         /* In the absence of explicit truth probabilities, use heuristics to
         ** guess a reasonable truth probability. */
@@ -2225,6 +2377,23 @@ static void whereLoopOutputAdjust(
       }
     }
   }
+  /* Correlated columns: x==1 AND y==2 keeps 1/ndistinct(x,y) of the rows,
+  ** not the product of the two.  Use each column in one pair only. */
+  for(i=0; i<nEq; i++){
+    for(j=i+1; aEqSel[i]>0.0 && j<nEq; j++){
+      ColStat *p;
+      double pairSel, indep;
+      if( aEqSel[j]<=0.0 ) continue;
+      p = sqlite3ColStatFind(pItem->pTab, aEqCol[i], aEqCol[j]);
+      if( p==0 ) continue;
+      pairSel = 1.0/p->nDistinct;
+      indep = aEqSel[i]*aEqSel[j];
+      if( pairSel>aEqSel[i] ) pairSel = aEqSel[i];
+      if( pairSel>aEqSel[j] ) pairSel = aEqSel[j];
+      if( pairSel>indep ) pLoop->nOut += sqlite3LogEstFromDouble(pairSel/indep);
+      aEqSel[i] = aEqSel[j] = 0.0;
+    }
+  }
   if( pLoop->nOut > nRow-iReduce )  pLoop->nOut = nRow - iReduce;
 }
 
@@ -4468,6 +4637,7 @@ WhereInfo *sqlite3WhereBegin(
   WhereLoop *pLoop;          /* Pointer to a single WhereLoop object */
   int ii;                    /* Loop counter */
   sqlite3 *db;               /* Database connection */
+  int bShardExplained = 0;   /* Comdb2: shard pruning was explained */
   int rc;                    /* Return code */
   u8 bFordelete = 0;         /* OPFLAG_FORDELETE or zero, as appropriate */
 
@@ -4561,6 +4731,19 @@ WhereInfo *sqlite3WhereBegin(
   */
   for(ii=0; ii<sWLB.pWC->nTerm; ii++){
     if( nTabList==0 || sqlite3ExprIsConstantNotJoin(sWLB.pWC->a[ii].pExpr) ){
+#ifndef SQLITE_OMIT_EXPLAIN
+      /* Comdb2: constant terms in a time partition branch come from the
+      ** shard range; show the shards they are known to rule out */
+      if( pParse->explain==2 && nTabList==1 && !bShardExplained
+       && pTabList->a[0].pSelect==0
+       && comdb2ExprIsFalseCompare(sWLB.pWC->a[ii].pExpr)
+       && timepart_is_shard(pTabList->a[0].zName, 1) ){
+        sqlite3VdbeAddOp4(v, OP_Explain, pParse->iSelectId, 0, 0,
+            sqlite3MPrintf(db, "SKIP SHARD %s (OUTSIDE RANGE)",
+                           pTabList->a[0].zName), P4_DYNAMIC);
+        bShardExplained = 1;
+      }
+#endif
       sqlite3ExprIfFalse(pParse, sWLB.pWC->a[ii].pExpr, pWInfo->iBreak,
                          SQLITE_JUMPIFNULL);
       sWLB.pWC->a[ii].wtFlags |= TERM_CODED;
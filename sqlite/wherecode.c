@@ -1013,6 +1013,20 @@ static void codeCursorHint(
     sqlite3VdbeAddOp4(v, OP_CursorHint, 
                       (sHint.pIdx ? sHint.iIdxCur : sHint.iTabCur), 0, 0,
                       (const char*)pExpr, P4_EXPR);
+#ifndef SQLITE_OMIT_EXPLAIN
+    /* COMDB2 MODIFICATION */
+    /* show which predicates are shipped to the remote db */
+    if( pParse->explain==2 ){
+      char *zDesc = sqlite3ExprDescribe(v, pExpr);
+      if( zDesc ){
+        char *zMsg = sqlite3MPrintf(db, "REMOTE FILTER ON %s.%s: %s",
+            pTabItem->zDatabase, pTabItem->pTab->zName, zDesc);
+        sqlite3_free(zDesc);
+        sqlite3VdbeAddOp4(v, OP_Explain, pParse->iSelectId, pLevel->iFrom, 0,
+                          zMsg, P4_DYNAMIC);
+      }
+    }
+#endif
 
   }
 }
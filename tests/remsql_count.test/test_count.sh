@@ -0,0 +1,68 @@
+#!/usr/bin/env bash
+
+# Remote count testcase for comdb2
+################################################################################
+
+# args
+# <remdbname> <remcdb2config> <dbname> <dbdir> <testdir>
+a_remdbname=$1
+a_remcdb2config=$2
+a_dbname=$3
+a_dbdir=$4
+a_testdir=$5
+
+function failexit
+{
+    echo "Failed $1"
+    exit -1
+}
+
+# Make sure we talk to the same host
+mach=`cdb2sql --tabs ${CDB2_OPTIONS} $a_dbname default "SELECT comdb2_host()"`
+
+function check
+{
+    local got=`cdb2sql --tabs --host $mach $a_dbname "$1"`
+    [[ "$got" == "$2" ]] || failexit "$1: expected '$2' got '$got'"
+}
+
+function pushed
+{
+    cdb2sql --tabs --host $mach $a_dbname "explain query plan $1" | grep -c "REMOTE COUNT ON"
+}
+
+cdb2sql --cdb2cfg $a_remcdb2config $a_remdbname default "create table t {
+schema
+{
+    int a
+}
+keys
+{
+\"A\" = a
+}
+}" || failexit "create"
+
+cdb2sql --cdb2cfg $a_remcdb2config $a_remdbname default "insert into t select value from generate_series(1, 1000)" > /dev/null || failexit "insert"
+cdb2sql --cdb2cfg $a_remcdb2config $a_remdbname default "analyze t" > /dev/null || failexit "analyze"
+nstat=`cdb2sql --tabs --cdb2cfg $a_remcdb2config $a_remdbname default "select count(*) from sqlite_stat1"`
+[[ -n "$nstat" && "$nstat" -gt 0 ]] || failexit "no remote stats"
+
+for push in 1 0; do
+    cdb2sql --host $mach $a_dbname "put tunable 'foreign_db_push_count' '$push'" > /dev/null || failexit "put tunable"
+
+    check "select count(*) from LOCAL_${a_remdbname}.t" "1000"
+    check "select count(*) from LOCAL_${a_remdbname}.t where a > 900" "100"
+    check "select a % 4, count(*) from LOCAL_${a_remdbname}.t group by a % 4 order by 1" "$(printf '0\t250\n1\t250\n2\t250\n3\t250')"
+    check "select a % 4, count(*) from LOCAL_${a_remdbname}.t where a <= 10 group by a % 4 order by 1" "$(printf '0\t2\n1\t3\n2\t3\n3\t2')"
+    check "select count(*) from LOCAL_${a_remdbname}.t group by a > 500 having count(*) > 0 order by 1" "$(printf '500\n500')"
+    check "select count(*) from LOCAL_${a_remdbname}.sqlite_stat1" "$nstat"
+
+    # the plan says remote exactly when the count is pushed
+    [[ `pushed "select count(*) from LOCAL_${a_remdbname}.t"` == "$push" ]] || failexit "count plan with push $push"
+    [[ `pushed "select count(*) from LOCAL_${a_remdbname}.t where a > 900"` == "0" ]] || failexit "filtered count plan with push $push"
+    [[ `pushed "select a % 4, count(*) from LOCAL_${a_remdbname}.t group by a % 4"` == "0" ]] || failexit "grouped count plan with push $push"
+    [[ `pushed "select count(*) from LOCAL_${a_remdbname}.sqlite_stat1"` == "0" ]] || failexit "stat count plan with push $push"
+done
+
+cdb2sql --host $mach $a_dbname "put tunable 'foreign_db_push_count' '1'" > /dev/null
+echo "Success"
@@ -0,0 +1,84 @@
+#!/usr/bin/env bash
+
+# Streamed remote sql testcase for comdb2
+################################################################################
+
+# args
+# <remdbname> <remcdb2config> <dbname> <dbdir> <testdir>
+a_remdbname=$1
+a_remcdb2config=$2
+a_dbname=$3
+a_dbdir=$4
+a_testdir=$5
+
+function failexit
+{
+    echo "Failed $1"
+    exit -1
+}
+
+if [[ -n "$CLUSTER" ]]; then
+    nodes=$CLUSTER
+else
+    nodes=`hostname`
+fi
+
+function set_stream
+{
+    for node in $nodes; do
+        cdb2sql --cdb2cfg $a_remcdb2config --host $node $a_remdbname "put tunable 'foreign_db_stream_batch_rows' '$1'" > /dev/null || failexit "put tunable"
+        cdb2sql --cdb2cfg $a_remcdb2config --host $node $a_remdbname "put tunable 'foreign_db_stream_flush_ms' '$2'" > /dev/null || failexit "put tunable"
+    done
+}
+
+cdb2sql --cdb2cfg $a_remcdb2config $a_remdbname default "create table t {
+schema
+{
+    int a
+    cstring b[32]
+}
+keys
+{
+\"A\" = a
+}
+}" || failexit "create"
+
+cdb2sql --cdb2cfg $a_remcdb2config $a_remdbname default "insert into t select value, printf('%020d', value) from generate_series(1, 200000)" > /dev/null || failexit "insert"
+
+# Make sure we talk to the same host
+mach=`cdb2sql --tabs ${CDB2_OPTIONS} $a_dbname default "SELECT comdb2_host()"`
+
+expected="200000	20000100000	4000000"
+sparse="20	2100000"
+
+for batch in 1 64 1000000; do
+    set_stream $batch 1000000
+
+    got=`cdb2sql --tabs --host $mach $a_dbname "select count(*), sum(a), sum(length(b)) from LOCAL_${a_remdbname}.t"`
+    [[ "$got" == "$expected" ]] || failexit "batch $batch: expected '$expected' got '$got'"
+
+    got=`cdb2sql --tabs --host $mach $a_dbname "select count(*), sum(a) from LOCAL_${a_remdbname}.t where b like '%0000'"`
+    [[ "$got" == "$sparse" ]] || failexit "batch $batch sparse: expected '$sparse' got '$got'"
+done
+
+# with a batch that never fills and a deadline that never passes, the first
+# row must still go out as soon as it is found, not when the scan ends
+start=`date +%s%N`
+got=`cdb2sql --tabs --host $mach $a_dbname "select a from LOCAL_${a_remdbname}.t where b like '%0000' limit 1"`
+first_ms=$(( (`date +%s%N` - start) / 1000000 ))
+[[ -n "$got" && $(( got % 10000 )) -eq 0 ]] || failexit "limit 1: got '$got'"
+
+start=`date +%s%N`
+cdb2sql --tabs --host $mach $a_dbname "select count(*) from LOCAL_${a_remdbname}.t where b like '%0000'" > /dev/null || failexit "full scan"
+scan_ms=$(( (`date +%s%N` - start) / 1000000 ))
+
+# rows already found are flushed by the deadline while the cursor keeps
+# looking for more
+set_stream 1000000 5
+got=`cdb2sql --tabs --host $mach $a_dbname "select count(*), sum(a) from LOCAL_${a_remdbname}.t where b like '%0000'"`
+[[ "$got" == "$sparse" ]] || failexit "deadline sparse: expected '$sparse' got '$got'"
+
+echo "first row in ${first_ms}ms, whole scan in ${scan_ms}ms"
+
+set_stream 64 10
+echo "Success"
@@ -0,0 +1,113 @@
+#!/usr/bin/env bash
+
+# Cached remote table testcase for comdb2
+################################################################################
+
+# args
+# <remdbname> <remcdb2config> <dbname> <dbdir> <testdir>
+a_remdbname=$1
+a_remcdb2config=$2
+a_dbname=$3
+a_dbdir=$4
+a_testdir=$5
+
+function failexit
+{
+    echo "Failed $1"
+    exit -1
+}
+
+# Make sure we talk to the same host
+mach=`cdb2sql --tabs ${CDB2_OPTIONS} $a_dbname default "SELECT comdb2_host()"`
+
+function set_cache
+{
+    cdb2sql --host $mach $a_dbname "put tunable 'foreign_db_table_cache_max_rows' '$1'" > /dev/null || failexit "put tunable"
+    cdb2sql --host $mach $a_dbname "put tunable 'foreign_db_table_cache_ttl' '$2'" > /dev/null || failexit "put tunable"
+}
+
+function remsql
+{
+    cdb2sql --cdb2cfg $a_remcdb2config $a_remdbname default "$1" > /dev/null || failexit "$1"
+}
+
+function check
+{
+    local tbl=$1
+    local expected=$2
+    local got=`cdb2sql --tabs --host $mach $a_dbname "select count(*), sum(a) from LOCAL_${a_remdbname}.$tbl"`
+    [[ "$got" == "$expected" ]] || failexit "$tbl: expected '$expected' got '$got'"
+}
+
+remsql "create table t {
+schema
+{
+    int a
+    cstring b[32]
+}
+keys
+{
+\"A\" = a
+}
+}"
+remsql "create table big {
+schema
+{
+    int a
+}
+keys
+{
+\"A\" = a
+}
+}"
+remsql "insert into t select value, printf('%020d', value) from generate_series(1, 100)"
+remsql "insert into big select value from generate_series(1, 5000)"
+
+set_cache 1000 3600
+
+# the first read loads the copy; a remote update is not seen until it expires
+check t "100	5050"
+remsql "update t set a = a + 1000"
+check t "100	5050"
+got=`cdb2sql --tabs --host $mach $a_dbname "select a, b from LOCAL_${a_remdbname}.t where a = 42"`
+[[ "$got" == "42	00000000000000000042" ]] || failexit "cached lookup: got '$got'"
+
+set_cache 1000 1
+sleep 2
+check t "100	105050"
+
+# too many rows to keep, every read goes to the remote db
+check big "5000	12502500"
+remsql "delete from big where a > 4000"
+check big "4000	8002000"
+
+# readers on the copy while a remote schema change drops the table they read
+set_cache 1000 0
+out=$a_testdir/tblcache.out
+rm -f $out.*
+for i in 1 2 3 4; do
+    (
+        for j in `seq 1 100`; do
+            got=`cdb2sql --tabs --host $mach $a_dbname "select count(*), sum(a) from LOCAL_${a_remdbname}.t" 2>&1`
+            [[ "$got" == "100	105050" ]] || echo "$got" >> $out.$i
+        done
+    ) &
+done
+for c in c1 c2 c3; do
+    remsql "alter table t add $c int dbstore 0"
+    sleep 1
+done
+wait
+
+# a reader can fail across the version change, but only with an error
+if cat $out.* 2>/dev/null | grep -v -i "error\|failed" | grep . ; then
+    failexit "wrong rows while the table changed"
+fi
+
+cdb2sql --host $mach $a_dbname "select 1" > /dev/null || failexit "db is gone"
+check t "100	105050"
+got=`cdb2sql --tabs --host $mach $a_dbname "select sum(c1 + c2 + c3) from LOCAL_${a_remdbname}.t"`
+[[ "$got" == "0" ]] || failexit "new columns: got '$got'"
+
+set_cache 0 60
+echo "Success"
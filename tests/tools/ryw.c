@@ -0,0 +1,115 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <cdb2api.h>
+
+/* Insert a row, then read it back, many times.  The read goes to another
+   node when given one, on a handle that is told where the write committed.
+   With CDB2_READ_YOUR_WRITES the read must always see the row, even on a
+   replicant that the master doesn't wait for. */
+
+static char *argv0;
+
+static void usage(FILE *f)
+{
+    fprintf(f, "Usage: %s -d <dbname> [-h <host>] [-r <host>] [-n <count>] "
+               "[-R]\n",
+            argv0);
+    fprintf(f, " -d <dbname>  - database\n");
+    fprintf(f, " -h <host>    - write on this node\n");
+    fprintf(f, " -r <host>    - read on this node (default where we write)\n");
+    fprintf(f, " -n <count>   - rows to write and read (default 1000)\n");
+    fprintf(f, " -R           - don't ask to read our writes\n");
+    exit(1);
+}
+
+static int run(cdb2_hndl_tp *hndl, const char *sql, long long *val)
+{
+    int rc;
+    if ((rc = cdb2_run_statement(hndl, sql)) != CDB2_OK) {
+        fprintf(stderr, "%s: rc %d %s\n", sql, rc, cdb2_errstr(hndl));
+        return rc;
+    }
+    while ((rc = cdb2_next_record(hndl)) == CDB2_OK) {
+        if (val)
+            *val = *(long long *)cdb2_column_value(hndl, 0);
+    }
+    if (rc != CDB2_OK_DONE) {
+        fprintf(stderr, "%s: next rc %d %s\n", sql, rc, cdb2_errstr(hndl));
+        return rc;
+    }
+    return 0;
+}
+
+static cdb2_hndl_tp *open_hndl(const char *dbname, const char *host,
+                               int flags)
+{
+    cdb2_hndl_tp *hndl;
+    const char *type = "default";
+
+    if (host) {
+        type = host;
+        flags |= CDB2_DIRECT_CPU;
+    }
+    if (cdb2_open(&hndl, dbname, type, flags) != 0) {
+        fprintf(stderr, "cdb2_open %s: %s\n", dbname, cdb2_errstr(hndl));
+        return NULL;
+    }
+    return hndl;
+}
+
+int main(int argc, char *argv[])
+{
+    char *dbname = NULL, *host = NULL, *rhost = NULL;
+    int count = 1000, flags = CDB2_READ_YOUR_WRITES, opt, i, stale = 0;
+    int file, offset;
+    cdb2_hndl_tp *hndl, *rhndl;
+    char sql[128];
+    long long n;
+
+    argv0 = argv[0];
+    while ((opt = getopt(argc, argv, "d:h:r:n:R")) != -1) {
+        switch (opt) {
+        case 'd': dbname = optarg; break;
+        case 'h': host = optarg; break;
+        case 'r': rhost = optarg; break;
+        case 'n': count = atoi(optarg); break;
+        case 'R': flags &= ~CDB2_READ_YOUR_WRITES; break;
+        default: usage(stderr);
+        }
+    }
+    if (dbname == NULL)
+        usage(stderr);
+
+    char *conf = getenv("CDB2_CONFIG");
+    if (conf)
+        cdb2_set_comdb2db_config(conf);
+    if ((hndl = open_hndl(dbname, host, flags)) == NULL)
+        return 1;
+    rhndl = hndl;
+    if (rhost && (rhndl = open_hndl(dbname, rhost, flags)) == NULL)
+        return 1;
+
+    for (i = 1; i <= count; i++) {
+        snprintf(sql, sizeof(sql), "insert into t1 values (%d)", i);
+        if (run(hndl, sql, NULL))
+            return 1;
+        if (rhndl != hndl) {
+            cdb2_commit_lsn(hndl, &file, &offset);
+            cdb2_set_commit_lsn(rhndl, file, offset);
+        }
+        n = 0;
+        snprintf(sql, sizeof(sql), "select count(*) from t1 where a = %d", i);
+        if (run(rhndl, sql, &n))
+            return 1;
+        if (n != 1)
+            stale++;
+    }
+    if (rhndl != hndl)
+        cdb2_close(rhndl);
+    cdb2_close(hndl);
+
+    printf("%d of %d reads missed the write before them\n", stale, count);
+    return (flags & CDB2_READ_YOUR_WRITES) && stale ? 1 : 0;
+}